@@ -35,9 +35,10 @@
 #include "ApproximateCoplanarFilter.hpp"
 
 #include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
+#include <pdal/KnnGraph.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include <Eigen/Dense>
 
@@ -64,6 +65,8 @@ void ApproximateCoplanarFilter::addArgs(ProgramArgs& args)
     args.add("knn", "k-Nearest Neighbors", m_knn, 8);
     args.add("thresh1", "Threshold 1", m_thresh1, 25.0);
     args.add("thresh2", "Threshold 2", m_thresh2, 6.0);
+    args.add("threads", "Number of threads used to compute neighbors and "
+        "features", m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -77,21 +80,18 @@ void ApproximateCoplanarFilter::filter(PointView& view)
 {
     using namespace Eigen;
 
-    KD3Index kdi(view);
-    kdi.build();
+    // find the k-nearest neighbors
+    point_count_t knn = (std::min)((point_count_t)m_knn, view.size());
+    KnnGraphPtr graph = KnnGraph::get(view, knn, m_threads);
 
-    for (PointId i = 0; i < view.size(); ++i)
+    graph->forEach(m_threads, [&](PointId i)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
-
         // compute covariance of the neighborhood
-        auto B = eigen::computeCovariance(view, ids);
+        Matrix3d B = graph->covariance(i, knn);
 
         // perform the eigen decomposition
-        SelfAdjointEigenSolver<Matrix3f> solver(B);
-        if (solver.info() != Success)
-            throwError("Cannot perform eigen decomposition.");
+        SelfAdjointEigenSolver<Matrix3d> solver;
+        solver.computeDirect(B, EigenvaluesOnly);
         auto ev = solver.eigenvalues();
 
         // test eigenvalues to label points that are approximately coplanar
@@ -99,7 +99,7 @@ void ApproximateCoplanarFilter::filter(PointView& view)
             view.setField(m_coplanar, i, 1u);
         else
             view.setField(m_coplanar, i, 0u);
-    }
+    });
 }
 
 } // namespace pdal
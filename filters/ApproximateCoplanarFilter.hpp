@@ -66,12 +66,15 @@ public:
 
 private:
     int m_knn;
+    uint32_t m_threads;
     double m_thresh1;
     double m_thresh2;
     Dimension::Id m_coplanar;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usesKnnGraph() const
+        { return true; }
     virtual void filter(PointView& view);
 };
 
@@ -33,6 +33,7 @@
 
 #include "ChipperFilter.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -64,14 +65,28 @@ spare since the wide array already contains the desired points partitioned
 into two blocks.  We simply need to locate the maximum and minimum values
 from the narrow array so that the approriate extrema of the block can
 be stored.
+
+The two blocks created by a split occupy disjoint ranges of the arrays, so
+large blocks are split further as independent tasks on a thread pool.
+Finished blocks are recorded and turned into point views in order once all
+splitting is done, so the output doesn't depend on the number of threads.
 **/
 
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 namespace pdal
 {
 
+namespace
+{
+
+// Blocks with fewer points than this are split on the current thread.
+const point_count_t MinTaskSize = 65536;
+
+} // unnamed namespace
+
 static PluginInfo const s_info = PluginInfo(
     "filters.chipper",
     "Organize points into spatially contiguous, squarish, and non-overlapping chips.",
@@ -85,6 +100,8 @@ void ChipperFilter::addArgs(ProgramArgs& args)
 {
     args.add("capacity", "Maximum number of points per cell", m_threshold,
         (PointId) 5000u);
+    args.add("threads", "Number of threads used to sort and split points",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -93,53 +110,103 @@ PointViewSet ChipperFilter::run(PointViewPtr view)
     if (view->size() == 0)
         return m_outViews;
 
+    ThreadPool pool(m_threads);
+    m_pool = &pool;
     m_inView = view;
     load(*view.get(), m_xvec, m_yvec, m_spare);
     partition(m_xvec.size());
     decideSplit(m_xvec, m_yvec, m_spare, 0, m_partitions.size() - 1);
+    pool.await();
+    m_pool = nullptr;
+
+    std::sort(m_chips.begin(), m_chips.end(),
+        [](const Chip& c1, const Chip& c2){ return c1.m_min < c2.m_min; });
+    for (const Chip& c : m_chips)
+        emit(*c.m_list, c.m_min, c.m_max);
+    m_chips.clear();
     return m_outViews;
 }
 
 
+// Stable sort of a reference list.  Ranges are sorted in parallel and then
+// merged pairwise, which gives the same order as a single stable sort.
+void ChipperFilter::sort(ChipRefList& list)
+{
+    std::vector<PointId> bounds;
+    m_pool->parallelFor(list.size(), MinTaskSize,
+        [&list, &bounds, this](PointId begin, PointId end)
+    {
+        std::stable_sort(list.begin() + begin, list.begin() + end);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bounds.push_back(begin);
+    });
+    std::sort(bounds.begin(), bounds.end());
+    bounds.push_back(list.size());
+
+    while (bounds.size() > 2)
+    {
+        std::vector<PointId> merged;
+        for (size_t i = 0; i + 2 < bounds.size(); i += 2)
+        {
+            auto begin = list.begin() + bounds[i];
+            auto middle = list.begin() + bounds[i + 1];
+            auto end = list.begin() + bounds[i + 2];
+            m_pool->add([begin, middle, end]()
+                { std::inplace_merge(begin, middle, end); });
+            merged.push_back(bounds[i]);
+        }
+        if (bounds.size() % 2 == 0)
+            merged.push_back(bounds[bounds.size() - 2]);
+        merged.push_back(list.size());
+        m_pool->await();
+        bounds.swap(merged);
+    }
+}
+
+
 void ChipperFilter::load(PointView& view, ChipRefList& xvec, ChipRefList& yvec,
     ChipRefList& spare)
 {
-    point_count_t idx;
-    std::vector<ChipPtRef>::iterator it;
-
-    xvec.reserve(view.size());
-    yvec.reserve(view.size());
+    xvec.resize(view.size());
+    yvec.resize(view.size());
     spare.resize(view.size());
 
-    for (PointId i = 0; i < view.size(); ++i)
+    m_pool->parallelFor(view.size(), MinTaskSize,
+        [&view, &xvec, &yvec](PointId begin, PointId end)
     {
-        ChipPtRef xref;
+        for (PointId i = begin; i < end; ++i)
+        {
+            ChipPtRef& xref = xvec[i];
 
-        xref.m_pos = view.getFieldAs<double>(Dimension::Id::X, i);
-        xref.m_ptindex = i;
-        xvec.push_back(xref);
+            xref.m_pos = view.getFieldAs<double>(Dimension::Id::X, i);
+            xref.m_ptindex = i;
 
-        ChipPtRef yref;
+            ChipPtRef& yref = yvec[i];
 
-        yref.m_pos = view.getFieldAs<double>(Dimension::Id::Y, i);
-        yref.m_ptindex = i;
-        yvec.push_back(yref);
-    }
+            yref.m_pos = view.getFieldAs<double>(Dimension::Id::Y, i);
+            yref.m_ptindex = i;
+        }
+    });
 
     // Sort xvec and assign other index in yvec to sorted indices in xvec.
-    std::stable_sort(xvec.begin(), xvec.end());
-    for (size_t i = 0; i < xvec.size(); ++i)
+    sort(xvec);
+    m_pool->parallelFor(xvec.size(), MinTaskSize,
+        [&xvec, &yvec](PointId begin, PointId end)
     {
-        idx = xvec[i].m_ptindex;
-        yvec[idx].m_oindex = i;
-    }
+        for (PointId i = begin; i < end; ++i)
+            yvec[xvec[i].m_ptindex].m_oindex = i;
+    });
 
     // Sort yvec.
-    std::stable_sort(yvec.begin(), yvec.end());
+    sort(yvec);
 
     // Iterate through the yvector, setting the xvector appropriately.
-    for (size_t i = 0; i < yvec.size(); ++i)
-        xvec[yvec[i].m_oindex].m_oindex = i;
+    m_pool->parallelFor(yvec.size(), MinTaskSize,
+        [&xvec, &yvec](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+            xvec[yvec[i].m_oindex].m_oindex = i;
+    });
 }
 
 
@@ -220,7 +287,10 @@ void ChipperFilter::split(ChipRefList& wide, ChipRefList& narrow, ChipRefList& s
     // 2) We have a distance of three between left and right.
 
     if (pright - pleft == 1)
-        emit(wide, left, right);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_chips.push_back({ &wide, left, right });
+    }
     else if (pright - pleft == 2)
         finalSplit(wide, narrow, pleft, pright);
     else
@@ -250,13 +320,14 @@ void ChipperFilter::split(ChipRefList& wide, ChipRefList& narrow, ChipRefList& s
             }
         }
 
-        // Save away the direction so we know which array is X and which is Y
-        // so that when we emit, we can properly label the max/min points.
-        Direction dir = narrow.m_dir;
-        spare.m_dir = dir;
-        decideSplit(wide, spare, narrow, pleft, pcenter);
+        // The two halves are independent.  Split the left half as a
+        // separate task if it's large enough to be worth it.
+        if (center - left >= MinTaskSize)
+            m_pool->add([this, &wide, &spare, &narrow, pleft, pcenter]()
+                { decideSplit(wide, spare, narrow, pleft, pcenter); });
+        else
+            decideSplit(wide, spare, narrow, pleft, pcenter);
         decideSplit(wide, spare, narrow, pcenter, pright);
-        narrow.m_dir = dir;
     }
 }
 
@@ -316,13 +387,10 @@ void ChipperFilter::finalSplit(ChipRefList& wide, ChipRefList& narrow,
         }
     }
 
-    // Emit results.
-    emit(wide,
-         left,
-         center - 1);
-    emit(wide,
-         center,
-         right);
+    // Record results.
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_chips.push_back({ &wide, (PointId)left, (PointId)(center - 1) });
+    m_chips.push_back({ &wide, (PointId)center, (PointId)right });
 }
 
 void ChipperFilter::emit(ChipRefList& wide, PointId widemin, PointId widemax)
@@ -44,6 +44,8 @@
 #include <pdal/plugin.hpp>
 #include <pdal/Filter.hpp>
 #include <pdal/PointView.hpp>
+
+#include <mutex>
 #include <vector>
 
 extern "C" int32_t ChipperFilter_ExitFunc();
@@ -53,6 +55,7 @@ namespace pdal
 {
 
 class Stage;
+class ThreadPool;
 
 
 class PDAL_DLL ChipperFilter;
@@ -137,7 +140,7 @@ class PDAL_DLL ChipperFilter : public pdal::Filter
 {
 public:
     ChipperFilter() : Filter(),
-        m_xvec(DIR_X), m_yvec(DIR_Y), m_spare(DIR_NONE)
+        m_xvec(DIR_X), m_yvec(DIR_Y), m_spare(DIR_NONE), m_pool(nullptr)
     {}
 
     static void * create();
@@ -145,6 +148,15 @@ public:
     std::string getName() const;
 
 private:
+    // A block of points that will become an output view: the entries
+    // [m_min, m_max] of a reference list.
+    struct Chip
+    {
+        ChipRefList *m_list;
+        PointId m_min;
+        PointId m_max;
+    };
+
     virtual void addArgs(ProgramArgs& args);
     virtual PointViewSet run(PointViewPtr view);
 
@@ -158,14 +170,19 @@ private:
     void finalSplit(ChipRefList& wide, ChipRefList& narrow,
         PointId pleft, PointId pcenter);
     void emit(ChipRefList& wide, PointId widemin, PointId widemax);
+    void sort(ChipRefList& list);
 
     PointId m_threshold;
+    uint32_t m_threads;
     PointViewPtr m_inView;
     PointViewSet m_outViews;
     std::vector<PointId> m_partitions;
     ChipRefList m_xvec;
     ChipRefList m_yvec;
     ChipRefList m_spare;
+    ThreadPool *m_pool;
+    std::vector<Chip> m_chips;
+    std::mutex m_mutex;
 
     ChipperFilter& operator=(const ChipperFilter&); // not implemented
     ChipperFilter(const ChipperFilter&); // not implemented
@@ -36,6 +36,9 @@
 
 #include <pdal/pdal_macros.hpp>
 #include <pdal/Segmentation.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
+#include <pdal/util/Utils.hpp>
 
 #include <string>
 
@@ -60,6 +63,21 @@ void ClusterFilter::addArgs(ProgramArgs& args)
     args.add("max_points", "Max points per cluster", m_maxPoints,
         std::numeric_limits<uint64_t>::max());
     args.add("tolerance", "Radius", m_tolerance, 1.0);
+    args.add("method", "Clustering method (euclidean or dbscan)", m_method,
+        "euclidean");
+    args.add("core_points", "Min neighbors of a core point (dbscan)",
+        m_corePoints, static_cast<uint64_t>(4));
+    args.add("threads", "Number of threads used to find neighbors",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+}
+
+void ClusterFilter::initialize()
+{
+    std::string method = Utils::tolower(m_method);
+    m_dbscan = (method == "dbscan");
+    if (!m_dbscan && method != "euclidean")
+        throwError("Invalid method '" + m_method + "'.  Must be "
+            "'euclidean' or 'dbscan'.");
 }
 
 void ClusterFilter::addDimensions(PointLayoutPtr layout)
@@ -70,8 +88,11 @@ void ClusterFilter::addDimensions(PointLayoutPtr layout)
 
 void ClusterFilter::filter(PointView& view)
 {
-    auto clusters = Segmentation::extractClusters(view, m_minPoints,
-        m_maxPoints, m_tolerance);
+    auto clusters = m_dbscan ?
+        Segmentation::extractDbscanClusters(view, m_corePoints, m_minPoints,
+            m_maxPoints, m_tolerance, m_threads) :
+        Segmentation::extractClusters(view, m_minPoints, m_maxPoints,
+            m_tolerance, m_threads);
 
     uint64_t id = 0;
     for (auto const& c : clusters)
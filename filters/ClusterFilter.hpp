@@ -58,12 +58,17 @@ public:
     std::string getName() const;
 
 private:
+    std::string m_method;
+    bool m_dbscan;
     uint64_t m_minPoints;
     uint64_t m_maxPoints;
+    uint64_t m_corePoints;
     double m_tolerance;
+    uint32_t m_threads;
     Dimension::Id m_cluster;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void filter(PointView& view);
 
@@ -73,6 +73,11 @@ private:
     std::vector<Polygon> m_geoms;
 
     void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const
+    {
+        dims = { "X", "Y", "Z" };
+        return true;
+    }
     virtual void initialize();
     virtual void ready(PointTableRef table);
     virtual void spatialReferenceChanged(const SpatialReference& srs);
@@ -61,6 +61,8 @@ private:
     PointId m_index;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
     void ready(PointTableRef table)
         { m_index = 0; }
     bool processOne(PointRef& point);
@@ -65,10 +65,13 @@ public:
 
 private:
     int m_knn;
+    uint32_t m_threads;
     Dimension::Id m_e0, m_e1, m_e2;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usesKnnGraph() const
+        { return true; }
     virtual void filter(PointView& view);
 };
 
@@ -35,10 +35,14 @@
 #include "EstimateRankFilter.hpp"
 
 #include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
+#include <pdal/KnnGraph.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
+#include <Eigen/Dense>
+
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -61,6 +65,8 @@ void EstimateRankFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest Neighbors", m_knn, 8);
     args.add("thresh", "Threshold", m_thresh, 0.01);
+    args.add("threads", "Number of threads used to compute neighbors and "
+        "features", m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -71,16 +77,29 @@ void EstimateRankFilter::addDimensions(PointLayoutPtr layout)
 
 void EstimateRankFilter::filter(PointView& view)
 {
-    KD3Index kdi(view);
-    kdi.build();
+    using namespace Eigen;
+
+    // find the k-nearest neighbors
+    point_count_t knn = (std::min)((point_count_t)m_knn, view.size());
+    KnnGraphPtr graph = KnnGraph::get(view, knn, m_threads);
 
-    for (PointId i = 0; i < view.size(); ++i)
+    graph->forEach(m_threads, [&](PointId i)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
+        // The singular values of the covariance matrix are its eigenvalues.
+        // As with JacobiSVD, a value is nonzero if it's greater than the
+        // threshold times the largest value.
+        SelfAdjointEigenSolver<Matrix3d> solver;
+        solver.computeDirect(graph->covariance(i, knn), EigenvaluesOnly);
+        Vector3d ev = solver.eigenvalues().cwiseAbs();
+        double thresh = (std::max)(ev.maxCoeff() * m_thresh,
+            (std::numeric_limits<double>::min)());
 
-        view.setField(m_rank, i, eigen::computeRank(view, ids, m_thresh));
-    }
+        uint8_t rank = 0;
+        for (int j = 0; j < 3; ++j)
+            if (ev[j] > thresh)
+                rank++;
+        view.setField(m_rank, i, rank);
+    });
 }
 
 } // namespace pdal
@@ -65,11 +65,14 @@ public:
 
 private:
     int m_knn;
+    uint32_t m_threads;
     double m_thresh;
     Dimension::Id m_rank;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usesKnnGraph() const
+        { return true; }
     virtual void filter(PointView& view);
 };
 
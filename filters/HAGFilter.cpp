@@ -34,9 +34,19 @@
 
 #include "HAGFilter.hpp"
 
+#include <pdal/GDALUtils.hpp>
 #include <pdal/KDIndex.hpp>
+#include <pdal/PDALUtils.hpp>
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
+#include <pdal/util/Utils.hpp>
 
+#include "private/Delaunay.hpp"
+
+#include <cmath>
+#include <deque>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -54,64 +64,438 @@ std::string HAGFilter::getName() const
     return s_info.name;
 }
 
+
+// Regular grid of ground elevations.  Cells without data hold NaN.
+struct HAGFilter::Grid
+{
+    double m_x0;    // Position of the center of cell (0, 0).
+    double m_y0;
+    double m_dx;    // Distance between cell centers.  Negative for rasters
+    double m_dy;    //   whose rows run north to south.
+    int m_width;
+    int m_height;
+    bool m_clamp;   // Whether positions off the grid use the edge cells.
+    std::vector<double> m_values;
+
+    double value(int col, int row) const
+        { return m_values[(size_t)row * m_width + col]; }
+
+    // Ground elevation at a position.
+    // \return  False if there's no data at the position.
+    bool height(double x, double y, bool bilinear, double& z) const
+    {
+        double fc = (x - m_x0) / m_dx;
+        double fr = (y - m_y0) / m_dy;
+        if (!m_clamp && (fc < -.5 || fc > m_width - .5 || fr < -.5 ||
+                fr > m_height - .5))
+            return false;
+
+        if (bilinear)
+        {
+            int c0 = Utils::clamp((int)std::floor(fc), 0,
+                (std::max)(m_width - 2, 0));
+            int r0 = Utils::clamp((int)std::floor(fr), 0,
+                (std::max)(m_height - 2, 0));
+            int c1 = (std::min)(c0 + 1, m_width - 1);
+            int r1 = (std::min)(r0 + 1, m_height - 1);
+            double tx = Utils::clamp(fc - c0, 0.0, 1.0);
+            double ty = Utils::clamp(fr - r0, 0.0, 1.0);
+
+            // Cells without data are left out and the remaining weights
+            // rescaled.
+            const double v[4] = { value(c0, r0), value(c1, r0),
+                value(c0, r1), value(c1, r1) };
+            const double w[4] = { (1 - tx) * (1 - ty), tx * (1 - ty),
+                (1 - tx) * ty, tx * ty };
+            double sum = 0;
+            double weight = 0;
+            for (int i = 0; i < 4; ++i)
+                if (!std::isnan(v[i]))
+                {
+                    sum += v[i] * w[i];
+                    weight += w[i];
+                }
+            if (weight > 0)
+            {
+                z = sum / weight;
+                return true;
+            }
+        }
+
+        int col = Utils::clamp((int)std::lround(fc), 0, m_width - 1);
+        int row = Utils::clamp((int)std::lround(fr), 0, m_height - 1);
+        z = value(col, row);
+        return !std::isnan(z);
+    }
+};
+
+
+HAGFilter::HAGFilter() : Filter()
+{}
+
+
+HAGFilter::~HAGFilter()
+{}
+
+
+void HAGFilter::addArgs(ProgramArgs& args)
+{
+    m_methodArg = &args.add("method", "Ground surface used to compute "
+        "height (nearest, tin or dem)", m_methodName, "nearest");
+    args.add("resolution", "Cell size of the ground DEM (method 'dem')",
+        m_resolution, 1.0);
+    args.add("bilinear", "Interpolate DEM cells bilinearly", m_bilinear,
+        true);
+    args.add("raster", "Ground DEM raster to use instead of ground points",
+        m_rasterFilename);
+    args.add("threads", "Number of threads used to compute height",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+}
+
+
+void HAGFilter::initialize()
+{
+    std::string method = Utils::tolower(m_methodName);
+    if (method == "nearest")
+        m_method = Method::Nearest;
+    else if (method == "tin")
+        m_method = Method::Tin;
+    else if (method == "dem")
+        m_method = Method::Dem;
+    else
+        throwError("Invalid method '" + m_methodName + "'.  Must be "
+            "'nearest', 'tin' or 'dem'.");
+
+    if (m_resolution <= 0)
+        throwError("Option 'resolution' must be greater than 0.");
+    if (m_rasterFilename.size())
+    {
+        if (m_methodArg->set() && m_method != Method::Dem)
+            throwError("Option 'raster' can only be used with method 'dem'.");
+        m_method = Method::Dem;
+        gdal::registerDrivers();
+    }
+}
+
+
 void HAGFilter::addDimensions(PointLayoutPtr layout)
 {
     layout->registerDim(Dimension::Id::HeightAboveGround);
 }
 
+
 void HAGFilter::prepared(PointTableRef table)
 {
     const PointLayoutPtr layout(table.layout());
-    if (!layout->hasDim(Dimension::Id::Classification))
+    if (m_rasterFilename.empty() &&
+            !layout->hasDim(Dimension::Id::Classification))
         throwError("Missing Classification dimension in input PointView.");
 }
 
+
+void HAGFilter::ready(PointTableRef table)
+{
+    m_missing = 0;
+    if (m_rasterFilename.empty())
+        return;
+
+    gdal::Raster raster(m_rasterFilename);
+    if (raster.open() != gdal::GDALError::None)
+        throwError(raster.errorMsg());
+
+    std::vector<uint8_t> data;
+    if (raster.readBand(data, 1) != gdal::GDALError::None)
+        throwError(raster.errorMsg());
+
+    std::unique_ptr<Grid> grid(new Grid);
+    grid->m_width = raster.width();
+    grid->m_height = raster.height();
+    grid->m_clamp = false;
+
+    // Pixel positions are cell centers.
+    std::array<double, 2> origin;
+    std::array<double, 2> col;
+    std::array<double, 2> row;
+    raster.pixelToCoord(0, 0, origin);
+    raster.pixelToCoord(1, 0, col);
+    raster.pixelToCoord(0, 1, row);
+    if (col[1] != origin[1] || row[0] != origin[0])
+        throwError("Raster '" + m_rasterFilename + "' is rotated.  "
+            "Rotated rasters aren't supported.");
+    grid->m_x0 = origin[0];
+    grid->m_y0 = origin[1];
+    grid->m_dx = col[0] - origin[0];
+    grid->m_dy = row[1] - origin[1];
+
+    Dimension::Type type = raster.getPDALDimensionTypes()[0];
+    size_t size = Dimension::size(type);
+    size_t count = (size_t)grid->m_width * grid->m_height;
+    double noData;
+    bool hasNoData = raster.noData(1, noData);
+    grid->m_values.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Everything e;
+        std::copy(data.data() + i * size, data.data() + (i + 1) * size,
+            (uint8_t *)&e);
+        double v = Utils::toDouble(e, type);
+        if (hasNoData && v == noData)
+            v = std::numeric_limits<double>::quiet_NaN();
+        grid->m_values[i] = v;
+    }
+    m_raster = std::move(grid);
+}
+
+
+void HAGFilter::forEach(const std::vector<PointId>& ids,
+    const std::function<void(PointId)>& f)
+{
+    const size_t MinRangeSize = 16384;
+
+    ThreadPool::parallelFor(m_threads, ids.size(), MinRangeSize,
+        [&ids, &f](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            f(ids[i]);
+    });
+}
+
+
+bool HAGFilter::processOne(PointRef& point)
+{
+    if (!m_raster)
+        throwError("Streaming requires a ground DEM supplied with "
+            "option 'raster'.");
+
+    double x = point.getFieldAs<double>(Dimension::Id::X);
+    double y = point.getFieldAs<double>(Dimension::Id::Y);
+    double z = point.getFieldAs<double>(Dimension::Id::Z);
+    double ground;
+    if (m_raster->height(x, y, m_bilinear, ground))
+        point.setField(Dimension::Id::HeightAboveGround, z - ground);
+    else
+    {
+        point.setField(Dimension::Id::HeightAboveGround, 0.0);
+        m_missing++;
+    }
+    return true;
+}
+
+
 void HAGFilter::filter(PointView& view)
 {
-    PointViewPtr gView = view.makeNew();
-    PointViewPtr ngView = view.makeNew();
+    if (m_raster)
+    {
+        std::vector<PointId> ids(view.size());
+        for (PointId i = 0; i < view.size(); ++i)
+            ids[i] = i;
+        fromGrid(view, *m_raster, ids);
+        return;
+    }
+
     std::vector<PointId> gIdx, ngIdx;
 
-    // First pass: Separate into ground and non-ground views.
+    // First pass: Separate into ground and non-ground points.
     for (PointId i = 0; i < view.size(); ++i)
     {
         double c = view.getFieldAs<double>(Dimension::Id::Classification, i);
         if (c == 2)
-        {
-            gView->appendPoint(view, i);
             gIdx.push_back(i);
-        }
         else
-        {
-            ngView->appendPoint(view, i);
             ngIdx.push_back(i);
-        }
     }
 
     // Bail if there weren't any points classified as ground.
-    if (gView->size() == 0)
+    if (gIdx.size() == 0)
         throwError("Input PointView does not have any points classified "
             "as ground");
 
-    // Build the 2D KD-tree.
+    // Second pass: Find Z difference between non-ground points and the
+    // ground surface.
+    if (m_method == Method::Nearest)
+        nearest(view, gIdx, ngIdx);
+    else if (m_method == Method::Tin)
+        tin(view, gIdx, ngIdx);
+    else
+        dem(view, gIdx, ngIdx);
+
+    // Final pass: Ensure that all ground points have height value pegged at 0.
+    for (auto const& i : gIdx)
+        view.setField(Dimension::Id::HeightAboveGround, i, 0.0);
+}
+
+
+// Height above the nearest (in XY) ground point.
+void HAGFilter::nearest(PointView& view, const std::vector<PointId>& ground,
+    const std::vector<PointId>& nonGround)
+{
+    PointViewPtr gView = view.makeNew();
+    for (PointId i : ground)
+        gView->appendPoint(view, i);
     KD2Index kdi(*gView);
     kdi.build();
 
-    // Second pass: Find Z difference between non-ground points and the nearest
-    // neighbor (2D) in the ground view.
-    for (PointId i = 0; i < ngView->size(); ++i)
+    forEach(nonGround, [&](PointId i)
     {
-        PointRef point = ngView->point(i);
-        double z0 = point.getFieldAs<double>(Dimension::Id::Z);
-        auto ids = kdi.neighbors(point, 1);
-        double z1 = gView->getFieldAs<double>(Dimension::Id::Z, ids[0]);
-        view.setField(Dimension::Id::HeightAboveGround, ngIdx[i], z0 - z1);
+        double x = view.getFieldAs<double>(Dimension::Id::X, i);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, i);
+        double z0 = view.getFieldAs<double>(Dimension::Id::Z, i);
+        double z1 = gView->getFieldAs<double>(Dimension::Id::Z,
+            kdi.neighbor(x, y));
+        view.setField(Dimension::Id::HeightAboveGround, i, z0 - z1);
+    });
+}
+
+
+// Height above a Delaunay triangulation of the ground points.  Points
+// outside the triangulation use the nearest ground point.
+void HAGFilter::tin(PointView& view, const std::vector<PointId>& ground,
+    const std::vector<PointId>& nonGround)
+{
+    PointViewPtr gView = view.makeNew();
+    std::vector<double> coords;
+    std::vector<double> heights;
+    coords.reserve(2 * ground.size());
+    heights.reserve(ground.size());
+    for (PointId i : ground)
+    {
+        gView->appendPoint(view, i);
+        coords.push_back(view.getFieldAs<double>(Dimension::Id::X, i));
+        coords.push_back(view.getFieldAs<double>(Dimension::Id::Y, i));
+        heights.push_back(view.getFieldAs<double>(Dimension::Id::Z, i));
     }
+    KD2Index kdi(*gView);
+    kdi.build();
+    Delaunay tri(coords);
+    const std::vector<size_t>& v = tri.triangles();
 
-    // Final pass: Ensure that all ground points have height value pegged at 0.
-    for (auto const& i : gIdx)
-        view.setField(Dimension::Id::HeightAboveGround, i, 0.0);
+    forEach(nonGround, [&](PointId i)
+    {
+        double x = view.getFieldAs<double>(Dimension::Id::X, i);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, i);
+        double z0 = view.getFieldAs<double>(Dimension::Id::Z, i);
+
+        // Walk to the containing triangle from one at the nearest ground
+        // point.
+        PointId g = kdi.neighbor(x, y);
+        size_t t = tri.locate(x, y, tri.vertexTriangle(g));
+        double z1 = heights[g];
+        if (t != Delaunay::Invalid)
+        {
+            size_t a = v[3 * t];
+            size_t b = v[3 * t + 1];
+            size_t c = v[3 * t + 2];
+            double ax = coords[2 * a], ay = coords[2 * a + 1];
+            double bx = coords[2 * b], by = coords[2 * b + 1];
+            double cx = coords[2 * c], cy = coords[2 * c + 1];
+            double area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+            double wa = ((bx - x) * (cy - y) - (by - y) * (cx - x)) / area;
+            double wb = ((cx - x) * (ay - y) - (cy - y) * (ax - x)) / area;
+            double wc = 1 - wa - wb;
+            z1 = wa * heights[a] + wb * heights[b] + wc * heights[c];
+        }
+        view.setField(Dimension::Id::HeightAboveGround, i, z0 - z1);
+    });
+}
+
+
+// Height above a DEM made from the mean elevation of the ground points in
+// each cell.  Empty cells take the value of the nearest non-empty cell.
+void HAGFilter::dem(PointView& view, const std::vector<PointId>& ground,
+    const std::vector<PointId>& nonGround)
+{
+    BOX2D bounds;
+    for (PointId i : ground)
+        bounds.grow(view.getFieldAs<double>(Dimension::Id::X, i),
+            view.getFieldAs<double>(Dimension::Id::Y, i));
+
+    Grid grid;
+    grid.m_x0 = bounds.minx + m_resolution / 2;
+    grid.m_y0 = bounds.miny + m_resolution / 2;
+    grid.m_dx = m_resolution;
+    grid.m_dy = m_resolution;
+    grid.m_width = (int)((bounds.maxx - bounds.minx) / m_resolution) + 1;
+    grid.m_height = (int)((bounds.maxy - bounds.miny) / m_resolution) + 1;
+    grid.m_clamp = true;
+
+    size_t numCells = (size_t)grid.m_width * grid.m_height;
+    std::vector<double> sums(numCells);
+    std::vector<point_count_t> counts(numCells);
+    for (PointId i : ground)
+    {
+        double x = view.getFieldAs<double>(Dimension::Id::X, i);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, i);
+        int col = (std::min)((int)((x - bounds.minx) / m_resolution),
+            grid.m_width - 1);
+        int row = (std::min)((int)((y - bounds.miny) / m_resolution),
+            grid.m_height - 1);
+        size_t cell = (size_t)row * grid.m_width + col;
+        sums[cell] += view.getFieldAs<double>(Dimension::Id::Z, i);
+        counts[cell]++;
+    }
+
+    // Fill empty cells breadth-first from the cells with data.
+    grid.m_values.assign(numCells, std::numeric_limits<double>::quiet_NaN());
+    std::deque<size_t> queue;
+    for (size_t cell = 0; cell < numCells; ++cell)
+        if (counts[cell])
+        {
+            grid.m_values[cell] = sums[cell] / counts[cell];
+            queue.push_back(cell);
+        }
+    while (queue.size())
+    {
+        size_t cell = queue.front();
+        queue.pop_front();
+        int col = (int)(cell % grid.m_width);
+        int row = (int)(cell / grid.m_width);
+        const int offsets[4][2] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+        for (auto& o : offsets)
+        {
+            int c = col + o[0];
+            int r = row + o[1];
+            if (c < 0 || c >= grid.m_width || r < 0 || r >= grid.m_height)
+                continue;
+            size_t next = (size_t)r * grid.m_width + c;
+            if (std::isnan(grid.m_values[next]))
+            {
+                grid.m_values[next] = grid.m_values[cell];
+                queue.push_back(next);
+            }
+        }
+    }
+
+    fromGrid(view, grid, nonGround);
+}
+
+
+void HAGFilter::fromGrid(PointView& view, const Grid& grid,
+    const std::vector<PointId>& ids)
+{
+    forEach(ids, [&](PointId i)
+    {
+        double x = view.getFieldAs<double>(Dimension::Id::X, i);
+        double y = view.getFieldAs<double>(Dimension::Id::Y, i);
+        double z = view.getFieldAs<double>(Dimension::Id::Z, i);
+        double ground;
+        if (grid.height(x, y, m_bilinear, ground))
+            view.setField(Dimension::Id::HeightAboveGround, i, z - ground);
+        else
+        {
+            view.setField(Dimension::Id::HeightAboveGround, i, 0.0);
+            m_missing++;
+        }
+    });
 }
 
 
+void HAGFilter::done(PointTableRef table)
+{
+    if (m_missing)
+        log()->get(LogLevel::Warning) << getName() << ": " << m_missing <<
+            " points had no ground elevation in the raster.  Their height "
+            "above ground was set to 0." << std::endl;
+    m_raster.reset();
+}
+
 } // namespace pdal
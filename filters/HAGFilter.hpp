@@ -37,7 +37,9 @@
 #include <pdal/Filter.hpp>
 #include <pdal/plugin.hpp>
 
+#include <atomic>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -54,18 +56,52 @@ class PointView;
 class PDAL_DLL HAGFilter : public Filter
 {
 public:
-    HAGFilter() : Filter()
-    {}
+    HAGFilter();
+    ~HAGFilter();
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
 
 private:
+    enum class Method
+    {
+        Nearest,
+        Tin,
+        Dem
+    };
 
+    struct Grid;
+
+    std::string m_methodName;
+    Arg *m_methodArg;
+    Method m_method;
+    double m_resolution;
+    bool m_bilinear;
+    std::string m_rasterFilename;
+    uint32_t m_threads;
+    std::unique_ptr<Grid> m_raster;
+    std::atomic<point_count_t> m_missing;
+
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
+    virtual bool processOne(PointRef& point);
     virtual void filter(PointView& view);
+    virtual void done(PointTableRef table);
+
+    void nearest(PointView& view, const std::vector<PointId>& ground,
+        const std::vector<PointId>& nonGround);
+    void tin(PointView& view, const std::vector<PointId>& ground,
+        const std::vector<PointId>& nonGround);
+    void dem(PointView& view, const std::vector<PointId>& ground,
+        const std::vector<PointId>& nonGround);
+    void fromGrid(PointView& view, const Grid& grid,
+        const std::vector<PointId>& ids);
+    void forEach(const std::vector<PointId>& ids,
+        const std::function<void(PointId)>& f);
 
     HAGFilter& operator=(const HAGFilter&); // not implemented
     HAGFilter(const HAGFilter&); // not implemented
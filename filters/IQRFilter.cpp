@@ -35,6 +35,10 @@
 #include "IQRFilter.hpp"
 
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
+
+#include "private/Selection.hpp"
 
 #include <string>
 #include <vector>
@@ -53,11 +57,22 @@ std::string IQRFilter::getName() const
     return s_info.name;
 }
 
+IQRFilter::IQRFilter() : Filter(), m_fenced(false)
+{}
+
+IQRFilter::~IQRFilter()
+{}
+
 void IQRFilter::addArgs(ProgramArgs& args)
 {
     args.add("k", "Number of deviations", m_multiplier, 1.5);
     args.add("dimension", "Dimension on which to calculate statistics",
         m_dimName);
+    args.add("threads", "Number of threads used to compute quartiles",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+    args.add("memory_limit", "Approximate memory (MB) used to hold points "
+        "when streaming before they're written to a temporary file",
+        m_memoryLimit, (uint32_t)1024);
 }
 
 void IQRFilter::prepared(PointTableRef table)
@@ -68,50 +83,86 @@ void IQRFilter::prepared(PointTableRef table)
         throwError("Dimension '" + m_dimName + "' does not exist.");
 }
 
-PointViewSet IQRFilter::run(PointViewPtr view)
+void IQRFilter::ready(PointTableRef table)
 {
-    using namespace Dimension;
-
-    PointViewPtr output = view->makeNew();
-
-    auto quartile = [](std::vector<double> vals, double percent)
-    {
-        std::nth_element(vals.begin(),
-            vals.begin() + int(vals.size() * percent), vals.end());
-
-        return *(vals.begin() + int(vals.size() * percent));
-    };
-
-    std::vector<double> z(view->size());
-    for (PointId j = 0; j < view->size(); ++j)
-        z[j] = view->getFieldAs<double>(m_dimId, j);
-
+    m_points.reset(new RetainedPoints(table.layout()->dimTypes(), m_dimId,
+        (size_t)m_memoryLimit * 1024 * 1024));
+    m_fenced = false;
+}
 
-    double pc25 = quartile(z, 0.25);
+// Quartiles are found by selection over scans of the values, either of a
+// view or of the points retained when streaming.
+void IQRFilter::computeFences(const PointView *view)
+{
+    selection::Scan scan = view ?
+        selection::viewScan(*view, m_dimId, m_threads) : m_points->scan();
+    double pc25 = selection::select(scan, 0.25);
     log()->get(LogLevel::Debug) << "25th percentile: " << pc25 << std::endl;
 
-    double pc75 = quartile(z, 0.75);
+    double pc75 = selection::select(scan, 0.75);
     log()->get(LogLevel::Debug) << "75th percentile: " << pc75 << std::endl;
 
     double iqr = pc75-pc25;
     log()->get(LogLevel::Debug) << "IQR: " << iqr << std::endl;
 
-    double low_fence = pc25 - m_multiplier * iqr;
-    double hi_fence = pc75 + m_multiplier * iqr;
+    m_lowFence = pc25 - m_multiplier * iqr;
+    m_highFence = pc75 + m_multiplier * iqr;
+    log()->get(LogLevel::Debug) << "Cropping " << m_dimName
+                                << " in the range (" << m_lowFence
+                                << "," << m_highFence << ")" << std::endl;
+}
+
+bool IQRFilter::inside(double value) const
+{
+    return value > m_lowFence && value < m_highFence;
+}
 
-    for (PointId j = 0; j < view->size(); ++j)
+PointViewSet IQRFilter::run(PointViewPtr view)
+{
+    PointViewPtr output = view->makeNew();
+    if (view->size())
     {
-        double val = view->getFieldAs<double>(m_dimId, j);
-        if (val > low_fence && val < hi_fence)
-            output->appendPoint(*view, j);
+        computeFences(view.get());
+        for (PointId j = 0; j < view->size(); ++j)
+            if (inside(view->getFieldAs<double>(m_dimId, j)))
+                output->appendPoint(*view, j);
     }
-    log()->get(LogLevel::Debug) << "Cropping " << m_dimName
-                                << " in the range (" << low_fence
-                                << "," << hi_fence << ")" << std::endl;
 
     PointViewSet viewSet;
     viewSet.insert(output);
     return viewSet;
 }
 
+// When streaming, all points are retained until the input is exhausted,
+// since the quartiles aren't known until then.
+bool IQRFilter::processOne(PointRef& point)
+{
+    m_points->add(point);
+    return false;
+}
+
+bool IQRFilter::emitOne(PointRef& point)
+{
+    if (!m_fenced && m_points->size())
+    {
+        computeFences(nullptr);
+        m_fenced = true;
+    }
+
+    double value;
+    while (m_points->next(point, value))
+        if (inside(value))
+            return true;
+
+    // Release the retained points.
+    m_points->clear();
+    m_fenced = false;
+    return false;
+}
+
+void IQRFilter::done(PointTableRef table)
+{
+    m_points.reset();
+}
+
 } // namespace pdal
@@ -37,6 +37,7 @@
 #include <pdal/Filter.hpp>
 #include <pdal/plugin.hpp>
 
+#include <memory>
 #include <string>
 
 extern "C" int32_t IQRFilter_ExitFunc();
@@ -46,14 +47,15 @@ namespace pdal
 {
 
 class ProgramArgs;
+class RetainedPoints;
 class PointTable;
 class PointView;
 
 class PDAL_DLL IQRFilter : public Filter
 {
 public:
-    IQRFilter() : Filter()
-    {}
+    IQRFilter();
+    ~IQRFilter();
 
     static void * create();
     static int32_t destroy(void *);
@@ -63,10 +65,25 @@ private:
     double m_multiplier;
     std::string m_dimName;
     Dimension::Id m_dimId;
+    uint32_t m_threads;
+    uint32_t m_memoryLimit;
+    double m_lowFence;
+    double m_highFence;
+    std::unique_ptr<RetainedPoints> m_points;
+    bool m_fenced;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
+    virtual bool processOne(PointRef& point);
+    virtual bool blocking() const
+        { return true; }
+    virtual bool emitOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    void computeFences(const PointView *view);
+    bool inside(double value) const;
 
     IQRFilter& operator=(const IQRFilter&); // not implemented
     IQRFilter(const IQRFilter&); // not implemented
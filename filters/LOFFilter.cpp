@@ -34,8 +34,10 @@
 
 #include "LOFFilter.hpp"
 
-#include <pdal/KDIndex.hpp>
+#include <pdal/KnnGraph.hpp>
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include <string>
 #include <vector>
@@ -57,6 +59,9 @@ std::string LOFFilter::getName() const
 void LOFFilter::addArgs(ProgramArgs& args)
 {
     args.add("minpts", "Minimum number of points", m_minpts, 10);
+    args.add("threads", "Number of threads used to compute neighbors and "
+        "outlier factors", m_threads,
+        (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 void LOFFilter::addDimensions(PointLayoutPtr layout)
@@ -70,66 +75,59 @@ void LOFFilter::addDimensions(PointLayoutPtr layout)
 void LOFFilter::filter(PointView& view)
 {
     using namespace Dimension;
-    
-    // Build the 3D KD-tree.
-    KD3Index index(view);
-    log()->get(LogLevel::Debug) << "Building 3D KD-tree...\n";
-    index.build();
-    
-    // Increment the minimum number of points, as knnSearch will be returning
-    // the neighbors along with the query point.
-    m_minpts++;
-  
+
+    // Increment the minimum number of points, as the neighbors include the
+    // query point.
+    point_count_t k = (std::min)((point_count_t)m_minpts + 1, view.size());
+
+    log()->get(LogLevel::Debug) << "Computing neighbors...\n";
+    KnnGraphPtr graph = KnnGraph::get(view, k, m_threads);
+
     // First pass: Compute the k-distance for each point.
     // The k-distance is the Euclidean distance to k-th nearest neighbor.
     log()->get(LogLevel::Debug) << "Computing k-distances...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    std::vector<double> kdist(view.size());
+    graph->forEach(m_threads, [&](PointId i)
     {
-        std::vector<PointId> indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
-        view.setField(m_kdist, i, std::sqrt(sqr_dists[m_minpts-1]));
-    }
-    
+        kdist[i] = std::sqrt(graph->sqrDist(i, graph->neighbors(i)[k - 1]));
+        view.setField(m_kdist, i, kdist[i]);
+    });
+
     // Second pass: Compute the local reachability distance for each point.
     // For each neighbor point, the reachability distance is the maximum value
     // of that neighbor's k-distance and the distance between the neighbor and
     // the current point. The lrd is the inverse of the mean of the reachability
     // distances.
     log()->get(LogLevel::Debug) << "Computing lrd...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    std::vector<double> lrd(view.size());
+    graph->forEach(m_threads, [&](PointId i)
     {
-        std::vector<PointId> indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
+        const uint32_t *indices = graph->neighbors(i);
         double M1 = 0.0;
         point_count_t n = 0;
-        for (PointId j = 0; j < indices.size(); ++j)
+        for (point_count_t j = 0; j < k; ++j)
         {
-            double k = view.getFieldAs<double>(m_kdist, indices[j]);
-            double reachdist = std::max(k, std::sqrt(sqr_dists[j]));
+            double reachdist = (std::max)(kdist[indices[j]],
+                std::sqrt(graph->sqrDist(i, indices[j])));
             M1 += (reachdist - M1) / ++n;
         }
-        view.setField(m_lrd, i, 1.0 / M1);
-    }
-    
+        lrd[i] = 1.0 / M1;
+        view.setField(m_lrd, i, lrd[i]);
+    });
+
     // Third pass: Compute the local outlier factor for each point.
     // The LOF is the average of the lrd's for a neighborhood of points.
     log()->get(LogLevel::Debug) << "Computing LOF...\n";
-    for (PointId i = 0; i < view.size(); ++i)
+    graph->forEach(m_threads, [&](PointId i)
     {
-        double lrdp = view.getFieldAs<double>(m_lrd, i);
-        std::vector<PointId> indices(m_minpts);
-        std::vector<double> sqr_dists(m_minpts);
-        index.knnSearch(i, m_minpts, &indices, &sqr_dists);
+        const uint32_t *indices = graph->neighbors(i);
+        double lrdp = lrd[i];
         double M1 = 0.0;
         point_count_t n = 0;
-        for (auto const& j : indices)
-        {
-            M1 += (view.getFieldAs<double>(m_lrd, j) / lrdp - M1) / ++n;
-        }
+        for (point_count_t j = 0; j < k; ++j)
+            M1 += (lrd[indices[j]] / lrdp - M1) / ++n;
         view.setField(m_lof, i, M1);
-    }
+    });
 }
 
 } // namespace pdal
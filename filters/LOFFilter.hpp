@@ -62,9 +62,12 @@ public:
 private:
     Dimension::Id m_kdist, m_lrd, m_lof;
     int m_minpts;
+    uint32_t m_threads;
     
     virtual void addArgs(ProgramArgs& args);
     virtual void addDimensions(PointLayoutPtr layout);
+    virtual bool usesKnnGraph() const
+        { return true; }
     virtual void filter(PointView& view);
 
     LOFFilter& operator=(const LOFFilter&); // not implemented
@@ -35,7 +35,12 @@
 #include "MADFilter.hpp"
 
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
+#include "private/Selection.hpp"
+
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -53,12 +58,23 @@ std::string MADFilter::getName() const
     return s_info.name;
 }
 
+MADFilter::MADFilter() : Filter(), m_fenced(false)
+{}
+
+MADFilter::~MADFilter()
+{}
+
 void MADFilter::addArgs(ProgramArgs& args)
 {
     args.add("k", "Number of deviations", m_multiplier, 2.0);
     args.add("dimension", "Dimension on which to calculate statistics",
         m_dimName);
     args.add("mad_multiplier", "MAD threshold multiplier", m_madMultiplier, 1.4862);
+    args.add("threads", "Number of threads used to compute the MAD",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+    args.add("memory_limit", "Approximate memory (MB) used to hold points "
+        "when streaming before they're written to a temporary file",
+        m_memoryLimit, (uint32_t)1024);
 }
 
 void MADFilter::prepared(PointTableRef table)
@@ -69,47 +85,89 @@ void MADFilter::prepared(PointTableRef table)
         throwError("Dimension '" + m_dimName + "' does not exist.");
 }
 
-PointViewSet MADFilter::run(PointViewPtr view)
+void MADFilter::ready(PointTableRef table)
 {
-    using namespace Dimension;
-
-    PointViewPtr output = view->makeNew();
-
-    auto estimate_median = [](std::vector<double> vals)
-    {
-        std::nth_element(vals.begin(), vals.begin()+vals.size()/2, vals.end());
-        return *(vals.begin()+vals.size()/2);
-    };
-
-    std::vector<double> z(view->size());
-    for (PointId j = 0; j < view->size(); ++j)
-        z[j] = view->getFieldAs<double>(m_dimId, j);
+    m_points.reset(new RetainedPoints(table.layout()->dimTypes(), m_dimId,
+        (size_t)m_memoryLimit * 1024 * 1024));
+    m_fenced = false;
+}
 
-    double median = estimate_median(z);
+// The median and the median of the deviations from it are found by
+// selection over scans of the values, either of a view or of the points
+// retained when streaming.
+void MADFilter::computeMad(const PointView *view)
+{
+    selection::Scan scan = view ?
+        selection::viewScan(*view, m_dimId, m_threads) : m_points->scan();
+    m_median = selection::select(scan, 0.5);
     log()->get(LogLevel::Debug) << getName() <<
-        " estimated median value: " << median << std::endl;
+        " estimated median value: " << m_median << std::endl;
 
-    std::transform(z.begin(), z.end(), z.begin(),
-       [median](double v) { return std::fabs(v - median); });
-    double mad = estimate_median(z)*m_madMultiplier;
-    log()->get(LogLevel::Debug) << getName() << " mad " << mad << std::endl;
+    double median = m_median;
+    selection::Scan deviations = selection::transform(scan,
+        [median](double v) { return std::fabs(v - median); });
+    m_mad = selection::select(deviations, 0.5) * m_madMultiplier;
+    log()->get(LogLevel::Debug) << getName() << " mad " << m_mad << std::endl;
 
-    for (PointId j = 0; j < view->size(); ++j)
-    {
-        if (z[j]/mad < m_multiplier)
-            output->appendPoint(*view, j);
-    }
-
-    double low_fence = median - m_multiplier * mad;
-    double hi_fence = median + m_multiplier * mad;
+    double low_fence = m_median - m_multiplier * m_mad;
+    double hi_fence = m_median + m_multiplier * m_mad;
 
     log()->get(LogLevel::Debug) << getName() << " cropping " << m_dimName
                                 << " in the range (" << low_fence
                                 << "," << hi_fence << ")" << std::endl;
+}
+
+bool MADFilter::inside(double value) const
+{
+    return std::fabs(value - m_median) / m_mad < m_multiplier;
+}
+
+PointViewSet MADFilter::run(PointViewPtr view)
+{
+    PointViewPtr output = view->makeNew();
+    if (view->size())
+    {
+        computeMad(view.get());
+        for (PointId j = 0; j < view->size(); ++j)
+            if (inside(view->getFieldAs<double>(m_dimId, j)))
+                output->appendPoint(*view, j);
+    }
 
     PointViewSet viewSet;
     viewSet.insert(output);
     return viewSet;
 }
 
+// When streaming, all points are retained until the input is exhausted,
+// since the median isn't known until then.
+bool MADFilter::processOne(PointRef& point)
+{
+    m_points->add(point);
+    return false;
+}
+
+bool MADFilter::emitOne(PointRef& point)
+{
+    if (!m_fenced && m_points->size())
+    {
+        computeMad(nullptr);
+        m_fenced = true;
+    }
+
+    double value;
+    while (m_points->next(point, value))
+        if (inside(value))
+            return true;
+
+    // Release the retained points.
+    m_points->clear();
+    m_fenced = false;
+    return false;
+}
+
+void MADFilter::done(PointTableRef table)
+{
+    m_points.reset();
+}
+
 } // namespace pdal
@@ -37,6 +37,7 @@
 #include <pdal/Filter.hpp>
 #include <pdal/plugin.hpp>
 
+#include <memory>
 #include <string>
 
 extern "C" int32_t MADFilter_ExitFunc();
@@ -46,14 +47,15 @@ namespace pdal
 {
 
 class ProgramArgs;
+class RetainedPoints;
 class PointTable;
 class PointView;
 
 class PDAL_DLL MADFilter : public Filter
 {
 public:
-    MADFilter() : Filter()
-    {}
+    MADFilter();
+    ~MADFilter();
 
     static void * create();
     static int32_t destroy(void *);
@@ -64,10 +66,25 @@ private:
     std::string m_dimName;
     Dimension::Id m_dimId;
     double m_madMultiplier;
+    uint32_t m_threads;
+    uint32_t m_memoryLimit;
+    double m_median;
+    double m_mad;
+    std::unique_ptr<RetainedPoints> m_points;
+    bool m_fenced;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void prepared(PointTableRef table);
+    virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
+    virtual bool processOne(PointRef& point);
+    virtual bool blocking() const
+        { return true; }
+    virtual bool emitOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    void computeMad(const PointView *view);
+    bool inside(double value) const;
 
     MADFilter& operator=(const MADFilter&); // not implemented
     MADFilter(const MADFilter&); // not implemented
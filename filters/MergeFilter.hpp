@@ -56,6 +56,8 @@ public:
 private:
     PointViewPtr m_view;
 
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
     virtual void ready(PointTableRef table);
     virtual bool processOne(PointRef& point)
         { return true; }
@@ -34,11 +34,15 @@
 
 #include "MortonOrderFilter.hpp"
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
-#include <climits>
-#include <iostream>
-#include <limits>
-#include <map>
+#include "private/ExternalSort.hpp"
+#include "private/RadixSort.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
 
 namespace pdal
 {
@@ -53,72 +57,265 @@ CREATE_STATIC_PLUGIN(1, 0, MortonOrderFilter, Filter, s_info)
 
 std::string MortonOrderFilter::getName() const { return s_info.name; }
 
-//This used to be a lambda, but the VS compiler exploded, I guess.
-typedef std::pair<double, double> Coord;
+MortonOrderFilter::MortonOrderFilter() : m_hilbert(false), m_useZ(false),
+    m_threads(1), m_codeDim(Dimension::Id::Unknown), m_memoryLimit(0),
+    m_numDims(2), m_bits(32), m_maxVal(0)
+{}
+
+MortonOrderFilter::~MortonOrderFilter()
+{}
+
 namespace
 {
-bool less_msb(const int& x, const int& y)
+
+// Spread the low 32 bits of a value so that there is a zero bit between
+// each of them.
+inline uint64_t spread2(uint64_t v)
 {
-    return x < y && x < (x ^ y);
-};
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x5555555555555555ULL);
+#else
+    v &= 0xFFFFFFFF;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v << 2)) & 0x3333333333333333ULL;
+    v = (v | (v << 1)) & 0x5555555555555555ULL;
+    return v;
+#endif
+}
 
-class CmpZOrder
+// Spread the low 21 bits of a value so that there are two zero bits
+// between each of them.
+inline uint64_t spread3(uint64_t v)
 {
-public:
-    bool operator()(const Coord& c1, const Coord& c2) const
-    {
-        int a[2] = {(int)(c1.first * INT_MAX), (int)(c1.second * INT_MAX)};
-        int b[2] = {(int)(c2.first * INT_MAX), (int)(c2.second * INT_MAX)};
+#if defined(__BMI2__)
+    return _pdep_u64(v, 0x1249249249249249ULL);
+#else
+    v &= 0x1FFFFF;
+    v = (v | (v << 32)) & 0x001F00000000FFFFULL;
+    v = (v | (v << 16)) & 0x001F0000FF0000FFULL;
+    v = (v | (v << 8)) & 0x100F00F00F00F00FULL;
+    v = (v | (v << 4)) & 0x10C30C30C30C30C3ULL;
+    v = (v | (v << 2)) & 0x1249249249249249ULL;
+    return v;
+#endif
+}
 
-        int j = 0;
-        int x = 0;
+// Interleave the bits of the coordinates, the first coordinate taking
+// the most significant bit of each group.
+inline uint64_t interleave(const uint32_t *c, int numDims)
+{
+    if (numDims == 2)
+        return (spread2(c[0]) << 1) | spread2(c[1]);
+    return (spread3(c[0]) << 2) | (spread3(c[1]) << 1) | spread3(c[2]);
+}
 
-        for (int k = 0; k < 2; k++)
+// Convert coordinates in place to the "transposed" Hilbert index, which
+// when interleaved gives the position along the Hilbert curve.  See
+// Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707 (2004).
+void hilbertTranspose(uint32_t *c, int numDims, int bits)
+{
+    const uint32_t m = 1U << (bits - 1);
+
+    // Inverse undo.
+    for (uint32_t q = m; q > 1; q >>= 1)
+    {
+        uint32_t p = q - 1;
+        for (int i = 0; i < numDims; ++i)
         {
-            int y = a[k] ^ b[k];
-            if (less_msb(x, y))
+            if (c[i] & q)
+                c[0] ^= p;
+            else
             {
-                j = k;
-                x = y;
+                uint32_t t = (c[0] ^ c[i]) & p;
+                c[0] ^= t;
+                c[i] ^= t;
             }
         }
-        return (a[j] - b[j]) < 0;
-    };
-};
+    }
+
+    // Gray encode.
+    for (int i = 1; i < numDims; ++i)
+        c[i] ^= c[i - 1];
+    uint32_t t = 0;
+    for (uint32_t q = m; q > 1; q >>= 1)
+        if (c[numDims - 1] & q)
+            t ^= q - 1;
+    for (int i = 0; i < numDims; ++i)
+        c[i] ^= t;
+}
+
+// Scale a value in [0, range] to an integer using the given number of bits.
+inline uint32_t quantize(double v, double min, double scale, uint32_t max)
+{
+    double d = (v - min) * scale;
+    if (d <= 0)
+        return 0;
+    if (d >= max)
+        return max;
+    return (uint32_t)d;
+}
+
+} // unnamed namespace
+
+
+void MortonOrderFilter::addArgs(ProgramArgs& args)
+{
+    args.add("curve", "Space-filling curve used to order points: "
+        "'morton' or 'hilbert'", m_curve, std::string("morton"));
+    args.add("use_z", "Order points in three dimensions rather than two",
+        m_useZ);
+    args.add("code_dimension", "Name of dimension to which the curve "
+        "position of each point should be written", m_codeDimName);
+    args.add("threads", "Number of threads used to compute and sort codes",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+    args.add("bounds", "Bounds over which coordinates are scaled.  "
+        "Required when streaming", m_bounds);
+    args.add("memory_limit", "Approximate memory (MB) used to hold points "
+        "when streaming before sorted runs are written to temporary files",
+        m_memoryLimit, (uint32_t)1024);
+}
+
+
+void MortonOrderFilter::initialize()
+{
+    std::string curve = Utils::tolower(m_curve);
+    if (curve == "hilbert")
+        m_hilbert = true;
+    else if (curve != "morton")
+        throwError("Invalid curve '" + m_curve + "'.  Must be 'morton' "
+            "or 'hilbert'.");
+    m_numDims = m_useZ ? 3 : 2;
+    m_bits = m_useZ ? 21 : 32;
+    m_maxVal = (uint32_t)((1ULL << m_bits) - 1);
+}
+
+
+void MortonOrderFilter::addDimensions(PointLayoutPtr layout)
+{
+    if (m_codeDimName.size())
+        m_codeDim = layout->registerOrAssignDim(m_codeDimName,
+            Dimension::Type::Unsigned64);
+}
+
+
+void MortonOrderFilter::ready(PointTableRef table)
+{
+    if (dynamic_cast<StreamPointTable *>(&table))
+    {
+        if (m_bounds.empty())
+            throwError("Option 'bounds' must be provided when streaming.");
+        setBounds(m_bounds);
+        m_sorter.reset(new ExternalSorter(table.layout()->dimTypes(), 1,
+            (size_t)m_memoryLimit * 1024 * 1024));
+    }
 }
 
+
+void MortonOrderFilter::setBounds(const BOX3D& bounds)
+{
+    m_mins[0] = bounds.minx;
+    m_mins[1] = bounds.miny;
+    m_mins[2] = bounds.minz;
+    double ranges[3] = { bounds.maxx - bounds.minx,
+        bounds.maxy - bounds.miny, bounds.maxz - bounds.minz };
+    for (int i = 0; i < 3; ++i)
+        m_scales[i] = ranges[i] > 0 ? m_maxVal / ranges[i] : 0;
+}
+
+
+// Compute the position of a point along the curve.
+uint64_t MortonOrderFilter::code(double x, double y, double z) const
+{
+    double pos[3] = { x, y, z };
+    uint32_t c[3];
+
+    for (int i = 0; i < m_numDims; ++i)
+        c[i] = quantize(pos[i], m_mins[i], m_scales[i], m_maxVal);
+    if (m_hilbert)
+        hilbertTranspose(c, m_numDims, m_bits);
+    return interleave(c, m_numDims);
+}
+
+
 PointViewSet MortonOrderFilter::run(PointViewPtr inView)
 {
     PointViewSet viewSet;
     if (!inView->size())
         return viewSet;
-    CmpZOrder compare;
-    std::multimap<Coord, PointId, CmpZOrder> sorted(compare);
 
-    BOX2D buffer_bounds;
-    inView->calculateBounds(buffer_bounds);
-    double xrange = buffer_bounds.maxx - buffer_bounds.minx;
-    double yrange = buffer_bounds.maxy - buffer_bounds.miny;
-
-    for (PointId idx = 0; idx < inView->size(); idx++)
+    if (m_bounds.empty())
     {
-        double xpos = (inView->getFieldAs<double>(Dimension::Id::X, idx) -
-            buffer_bounds.minx) / xrange;
-        double ypos = (inView->getFieldAs<double>(Dimension::Id::Y, idx) -
-            buffer_bounds.miny) / yrange;
-        Coord loc(xpos, ypos);
-        sorted.insert(std::make_pair(loc, idx));
+        BOX3D bounds;
+        inView->calculateBounds(bounds);
+        setBounds(bounds);
     }
+    else
+        setBounds(m_bounds);
+
+    // Compute the curve code of each point in contiguous ranges, then
+    // radix sort the codes.
+    const point_count_t MinRangeSize = 65536;
+
+    SortKeyList keys(inView->size());
+    ThreadPool::parallelFor(m_threads, keys.size(), MinRangeSize,
+        [this, &inView, &keys](PointId begin, PointId end)
+    {
+        for (PointId idx = begin; idx < end; ++idx)
+        {
+            keys[idx].m_key = code(
+                inView->getFieldAs<double>(Dimension::Id::X, idx),
+                inView->getFieldAs<double>(Dimension::Id::Y, idx),
+                m_useZ ?
+                    inView->getFieldAs<double>(Dimension::Id::Z, idx) : 0);
+            keys[idx].m_id = idx;
+        }
+    });
+
+    radix::sort(keys, sizeof(uint64_t), m_threads);
 
     PointViewPtr outView = inView->makeNew();
-    std::multimap<Coord, PointId, CmpZOrder>::iterator pos;
-    for (pos = sorted.begin(); pos != sorted.end(); ++pos)
+    for (const SortKey& k : keys)
     {
-        outView->appendPoint(*inView, pos->second);
+        outView->appendPoint(*inView, k.m_id);
+        if (m_codeDim != Dimension::Id::Unknown)
+            outView->setField(m_codeDim, outView->size() - 1, k.m_key);
     }
     viewSet.insert(outView);
 
     return viewSet;
 }
 
+
+// When streaming, all points are retained by the sorter and emitted in
+// order once the input is exhausted.
+bool MortonOrderFilter::processOne(PointRef& point)
+{
+    uint64_t key = code(point.getFieldAs<double>(Dimension::Id::X),
+        point.getFieldAs<double>(Dimension::Id::Y),
+        m_useZ ? point.getFieldAs<double>(Dimension::Id::Z) : 0);
+    if (m_codeDim != Dimension::Id::Unknown)
+        point.setField(m_codeDim, key);
+    m_sorter->add(&key, point);
+    return false;
+}
+
+
+bool MortonOrderFilter::emitOne(PointRef& point)
+{
+    if (m_sorter->next(point))
+        return true;
+
+    // Release the retained points.
+    m_sorter->clear();
+    return false;
+}
+
+
+void MortonOrderFilter::done(PointTableRef table)
+{
+    m_sorter.reset();
+}
+
 } // pdal
@@ -37,17 +37,21 @@
 #include <pdal/Filter.hpp>
 #include <pdal/plugin.hpp>
 
+#include <memory>
+
 extern "C" int32_t MortonOrderFilter_ExitFunc();
 extern "C" PF_ExitFunc MortonOrderFilter_InitPlugin();
 
 namespace pdal
 {
 
+class ExternalSorter;
+
 class PDAL_DLL MortonOrderFilter : public pdal::Filter
 {
 public:
-    MortonOrderFilter()
-    {}
+    MortonOrderFilter();
+    ~MortonOrderFilter();
     MortonOrderFilter& operator=(const MortonOrderFilter&) = delete;
     MortonOrderFilter(const MortonOrderFilter&) = delete;
 
@@ -56,7 +60,35 @@ public:
     std::string getName() const;
 
 private:
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
+    virtual bool processOne(PointRef& point);
+    virtual bool blocking() const
+        { return true; }
+    virtual bool emitOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    void setBounds(const BOX3D& bounds);
+    uint64_t code(double x, double y, double z) const;
+
+    std::string m_curve;
+    bool m_hilbert;
+    bool m_useZ;
+    uint32_t m_threads;
+    std::string m_codeDimName;
+    Dimension::Id m_codeDim;
+    BOX3D m_bounds;
+    uint32_t m_memoryLimit;
+
+    int m_numDims;
+    int m_bits;
+    uint32_t m_maxVal;
+    double m_mins[3];
+    double m_scales[3];
+    std::unique_ptr<ExternalSorter> m_sorter;
 };
 
 } // namespace pdal
@@ -35,9 +35,10 @@
 #include "NormalFilter.hpp"
 
 #include <pdal/EigenUtils.hpp>
-#include <pdal/KDIndex.hpp>
+#include <pdal/KnnGraph.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include <Eigen/Dense>
 
@@ -62,6 +63,8 @@ std::string NormalFilter::getName() const
 void NormalFilter::addArgs(ProgramArgs& args)
 {
     args.add("knn", "k-Nearest Neighbors", m_knn, 8);
+    args.add("threads", "Number of threads used to compute neighbors and "
+        "features", m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -78,21 +81,18 @@ void NormalFilter::filter(PointView& view)
 {
     using namespace Eigen;
 
-    KD3Index kdi(view);
-    kdi.build();
+    // find the k-nearest neighbors
+    point_count_t knn = (std::min)((point_count_t)m_knn, view.size());
+    KnnGraphPtr graph = KnnGraph::get(view, knn, m_threads);
 
-    for (PointId i = 0; i < view.size(); ++i)
+    graph->forEach(m_threads, [&](PointId i)
     {
-        // find the k-nearest neighbors
-        auto ids = kdi.neighbors(i, m_knn);
-
         // compute covariance of the neighborhood
-        auto B = eigen::computeCovariance(view, ids);
+        Matrix3d B = graph->covariance(i, knn);
 
         // perform the eigen decomposition
-        SelfAdjointEigenSolver<Matrix3f> solver(B);
-        if (solver.info() != Success)
-            throwError("Cannot perform eigen decomposition.");
+        SelfAdjointEigenSolver<Matrix3d> solver;
+        solver.computeDirect(B);
         auto eval = solver.eigenvalues();
         auto evec = solver.eigenvectors().col(0);
 
@@ -102,7 +102,7 @@ void NormalFilter::filter(PointView& view)
 
         double sum = eval[0] + eval[1] + eval[2];
         view.setField(m_curvature, i, sum ? std::fabs(eval[0] / sum) : 0);
-    }
+    });
 }
 
 } // namespace pdal
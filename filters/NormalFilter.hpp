@@ -65,10 +65,13 @@ public:
 
 private:
     int m_knn;
+    uint32_t m_threads;
     Dimension::Id m_nx, m_ny, m_nz, m_curvature;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usesKnnGraph() const
+        { return true; }
     virtual void filter(PointView& view);
 
 };
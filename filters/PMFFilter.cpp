@@ -36,12 +36,13 @@
 
 #include <pdal/EigenUtils.hpp>
 #include <pdal/KDIndex.hpp>
-#include <pdal/QuadIndex.hpp>
 #include <pdal/Segmentation.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 #include <pdal/util/Utils.hpp>
 
+#include "private/BoxExtrema.hpp"
 #include "private/DimRange.hpp"
 
 namespace pdal
@@ -68,6 +69,8 @@ void PMFFilter::addArgs(ProgramArgs& args)
     args.add("approximate", "Use approximate algorithm?", m_approximate);
     args.add("ignore", "Ignore values", m_ignored);
     args.add("last", "Consider last returns only?", m_lastOnly, true);
+    args.add("threads", "Number of threads used to filter ground",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 void PMFFilter::addDimensions(PointLayoutPtr layout)
@@ -95,126 +98,87 @@ void PMFFilter::prepared(PointTableRef table)
     }
 }
 
-std::vector<double> PMFFilter::morphOpen(PointViewPtr view, float radius)
+void PMFFilter::computeWindows(std::vector<float>& wsvec,
+                               std::vector<float>& htvec) const
 {
-    point_count_t np(view->size());
-
-    QuadIndex idx(*view);
-
-    std::vector<double> minZ(np), maxZ(np);
-
-    // erode
-    for (PointId i = 0; i < np; ++i)
+    // Window sizes grow exponentially.  The height threshold for a window
+    // grows with the difference from the previous size.
+    float ws = 0.0f;
+    for (int iter = 0; ws < m_maxWindowSize; ++iter)
     {
-        double x = view->getFieldAs<double>(Dimension::Id::X, i);
-        double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+        ws = m_cellSize * (2.0f * std::pow(2, iter) + 1.0f);
 
-        std::vector<PointId> ids =
-            idx.getPoints(x - radius, y - radius, x + radius, y + radius);
-
-        double localMin(std::numeric_limits<double>::max());
-        for (auto const& j : ids)
-        {
-            double z = view->getFieldAs<double>(Dimension::Id::Z, j);
-            if (z < localMin)
-                localMin = z;
-        }
-        minZ[i] = localMin;
-    }
-
-    // dilate
-    for (PointId i = 0; i < np; ++i)
-    {
-        double x = view->getFieldAs<double>(Dimension::Id::X, i);
-        double y = view->getFieldAs<double>(Dimension::Id::Y, i);
+        float ht = m_initialDistance;
+        if (iter > 0)
+            ht = m_slope * (ws - wsvec[iter - 1]) * m_cellSize +
+                 m_initialDistance;
 
-        std::vector<PointId> ids =
-            idx.getPoints(x - radius, y - radius, x + radius, y + radius);
+        // Enforce max distance on height threshold
+        if (ht > m_maxDistance)
+            ht = m_maxDistance;
 
-        double localMax(std::numeric_limits<double>::lowest());
-        for (auto const& j : ids)
-        {
-            double z = minZ[j];
-            if (z > localMax)
-                localMax = z;
-        }
-        maxZ[i] = localMax;
+        wsvec.push_back(ws);
+        htvec.push_back(ht);
     }
-
-    return maxZ;
 }
 
 std::vector<PointId> PMFFilter::processGround(PointViewPtr view)
 {
-    // Compute the series of window sizes and height thresholds
+    using namespace Dimension;
+
     std::vector<float> htvec;
     std::vector<float> wsvec;
-    int iter = 0;
-    float ws = 0.0f;
-    float ht = 0.0f;
+    computeWindows(wsvec, htvec);
 
-    while (ws < m_maxWindowSize)
+    point_count_t np(view->size());
+    std::vector<double> x(np), y(np), z(np);
+    for (PointId i = 0; i < np; ++i)
     {
-        // Determine the initial window size.
-        if (1) // exponential
-            ws = m_cellSize * (2.0f * std::pow(2, iter) + 1.0f);
-        else
-            ws = m_cellSize * (2.0f * (iter + 1) * 2 + 1.0f);
-
-        // Calculate the height threshold to be used in the next iteration.
-        if (iter == 0)
-            ht = m_initialDistance;
-        else
-            ht = m_slope * (ws - wsvec[iter - 1]) * m_cellSize +
-                 m_initialDistance;
-
-        // Enforce max distance on height threshold
-        if (ht > m_maxDistance)
-            ht = m_maxDistance;
-
-        wsvec.push_back(ws);
-        htvec.push_back(ht);
-
-        iter++;
+        x[i] = view->getFieldAs<double>(Id::X, i);
+        y[i] = view->getFieldAs<double>(Id::Y, i);
+        z[i] = view->getFieldAs<double>(Id::Z, i);
     }
 
-    std::vector<PointId> groundIdx;
-    for (PointId i = 0; i < view->size(); ++i)
-        groundIdx.push_back(i);
+    // The points are binned once.  Each window only changes which of them
+    // are still considered ground.
+    BoxExtrema idx(x, y, m_threads);
+    std::vector<char> ground(np, 1);
 
     // Progressively filter ground returns using morphological open
     for (size_t j = 0; j < wsvec.size(); ++j)
     {
-        // Limit filtering to those points currently considered ground returns
-        PointViewPtr ground = view->makeNew();
-        for (auto const& i : groundIdx)
-            ground->appendPoint(*view, i);
-
         log()->get(LogLevel::Debug)
             << "Iteration " << j << " (height threshold = " << htvec[j]
             << ", window size = " << wsvec[j] << ")...\n";
 
-        // Create new cloud to hold the filtered results. Apply the
-        // morphological opening operation at the current window size.
-        auto maxZ = morphOpen(ground, wsvec[j] * 0.5);
+        // Apply the morphological opening operation at the current window
+        // size to the points currently considered ground returns.
+        float radius = wsvec[j] * 0.5;
+        std::vector<double> minZ = idx.minimum(z, ground, radius);
+        std::vector<double> maxZ = idx.maximum(minZ, ground, radius);
 
-        // Find indices of the points whose difference between the source and
-        // filtered point clouds is less than the current height threshold.
-        std::vector<PointId> groundNewIdx;
-        for (PointId i = 0; i < ground->size(); ++i)
+        // Keep the points whose difference between the source and filtered
+        // point clouds is less than the current height threshold.
+        point_count_t count(0);
+        for (PointId i = 0; i < np; ++i)
         {
-            double z0 = ground->getFieldAs<double>(Dimension::Id::Z, i);
-            float diff = z0 - maxZ[i];
+            if (!ground[i])
+                continue;
+            float diff = z[i] - maxZ[i];
             if (diff < htvec[j])
-                groundNewIdx.push_back(groundIdx[i]);
+                count++;
+            else
+                ground[i] = 0;
         }
 
-        groundIdx.swap(groundNewIdx);
-
         log()->get(LogLevel::Debug)
-            << "Ground now has " << groundIdx.size() << " points.\n";
+            << "Ground now has " << count << " points.\n";
     }
 
+    std::vector<PointId> groundIdx;
+    for (PointId i = 0; i < np; ++i)
+        if (ground[i])
+            groundIdx.push_back(i);
     return groundIdx;
 }
 
@@ -285,48 +249,73 @@ std::vector<double> PMFFilter::fillNearest(PointViewPtr view, size_t rows,
     return out;
 };
 
+// Erode or dilate a column-major raster with a diamond structuring element,
+// as eigen::erodeDiamond() and eigen::dilateDiamond().  The raster is split
+// into strips of columns that are processed in parallel.  Each strip is
+// padded with a halo of 'iterations' columns from its neighbors, as each
+// iteration only spreads values by one column.
+std::vector<double> PMFFilter::morphDiamond(const std::vector<double>& data,
+                                            size_t rows, size_t cols,
+                                            int iterations, bool erode)
+{
+    if (iterations <= 0)
+        return data;
+
+    const size_t halo(iterations);
+    const size_t minStrip(4 * halo);
+    if (ThreadPool::numRanges(m_threads, cols, minStrip) <= 1)
+        return erode ? eigen::erodeDiamond(data, rows, cols, iterations)
+                     : eigen::dilateDiamond(data, rows, cols, iterations);
+
+    std::vector<double> out(data.size());
+    ThreadPool::parallelFor(m_threads, cols, minStrip,
+        [&](size_t c0, size_t c1)
+    {
+        size_t first = (c0 > halo) ? c0 - halo : 0;
+        size_t last = (std::min)(c1 + halo, cols);
+        std::vector<double> strip(data.begin() + first * rows,
+                                  data.begin() + last * rows);
+        strip = erode
+            ? eigen::erodeDiamond(strip, rows, last - first, iterations)
+            : eigen::dilateDiamond(strip, rows, last - first, iterations);
+        std::copy(strip.begin() + (c0 - first) * rows,
+                  strip.begin() + (c1 - first) * rows,
+                  out.begin() + c0 * rows);
+    });
+    return out;
+}
+
 std::vector<PointId> PMFFilter::processGroundApprox(PointViewPtr view)
 {
+    using namespace Dimension;
+
     BOX2D bounds;
     view->calculateBounds(bounds);
 
     size_t cols = ((bounds.maxx - bounds.minx) / m_cellSize) + 1;
     size_t rows = ((bounds.maxy - bounds.miny) / m_cellSize) + 1;
 
-    // Compute the series of window sizes and height thresholds
     std::vector<float> htvec;
     std::vector<float> wsvec;
-    int iter = 0;
-    float ws = 0.0f;
-    float ht = 0.0f;
+    computeWindows(wsvec, htvec);
 
-    while (ws < m_maxWindowSize)
+    // Locate each point in the raster once, up front.
+    point_count_t np(view->size());
+    std::vector<double> z(np);
+    std::vector<size_t> cell(np);
+    for (PointId i = 0; i < np; ++i)
     {
-        // Determine the initial window size.
-        if (1) // exponential
-            ws = m_cellSize * (2.0f * std::pow(2, iter) + 1.0f);
-        else
-            ws = m_cellSize * (2.0f * (iter + 1) * 2 + 1.0f);
-
-        // Calculate the height threshold to be used in the next iteration.
-        if (iter == 0)
-            ht = m_initialDistance;
-        else
-            ht = m_slope * (ws - wsvec[iter - 1]) * m_cellSize +
-                 m_initialDistance;
-
-        // Enforce max distance on height threshold
-        if (ht > m_maxDistance)
-            ht = m_maxDistance;
-
-        wsvec.push_back(ws);
-        htvec.push_back(ht);
+        double x = view->getFieldAs<double>(Id::X, i);
+        double y = view->getFieldAs<double>(Id::Y, i);
+        z[i] = view->getFieldAs<double>(Id::Z, i);
 
-        iter++;
+        int c = static_cast<int>(floor((x - bounds.minx) / m_cellSize));
+        int r = static_cast<int>(floor((y - bounds.miny) / m_cellSize));
+        cell[i] = c * rows + r;
     }
 
     std::vector<PointId> groundIdx;
-    for (PointId i = 0; i < view->size(); ++i)
+    for (PointId i = 0; i < np; ++i)
         groundIdx.push_back(i);
 
     std::vector<double> ZImin =
@@ -339,24 +328,16 @@ std::vector<PointId> PMFFilter::processGroundApprox(PointViewPtr view)
             << "Iteration " << j << " (height threshold = " << htvec[j]
             << ", window size = " << wsvec[j] << ")...\n";
 
+        int iterations = 0.5 * (wsvec[j] - 1);
         std::vector<double> me =
-            eigen::erodeDiamond(ZImin, rows, cols, 0.5 * (wsvec[j] - 1));
+            morphDiamond(ZImin, rows, cols, iterations, true);
         std::vector<double> mo =
-            eigen::dilateDiamond(me, rows, cols, 0.5 * (wsvec[j] - 1));
+            morphDiamond(me, rows, cols, iterations, false);
 
         std::vector<PointId> groundNewIdx;
         for (auto p_idx : groundIdx)
-        {
-            double x = view->getFieldAs<double>(Dimension::Id::X, p_idx);
-            double y = view->getFieldAs<double>(Dimension::Id::Y, p_idx);
-            double z = view->getFieldAs<double>(Dimension::Id::Z, p_idx);
-
-            int c = static_cast<int>(floor((x - bounds.minx) / m_cellSize));
-            int r = static_cast<int>(floor((y - bounds.miny) / m_cellSize));
-
-            if ((z - mo[c * rows + r]) < htvec[j])
+            if ((z[p_idx] - mo[cell[p_idx]]) < htvec[j])
                 groundNewIdx.push_back(p_idx);
-        }
 
         ZImin.swap(mo);
         groundIdx.swap(groundNewIdx);
@@ -390,32 +371,28 @@ PointViewSet PMFFilter::run(PointViewPtr input)
     else
         lastView->append(*keptView);
 
-    for (PointId i = 0; i < nonlastView->size(); ++i)
-        nonlastView->setField(Dimension::Id::Classification, i, 1);
-
-    for (PointId i = 0; i < lastView->size(); ++i)
-        lastView->setField(Dimension::Id::Classification, i, 1);
-
     std::vector<PointId> idx;
     if (m_approximate)
         idx = processGroundApprox(lastView);
     else
         idx = processGround(lastView);
 
+    // Label ground returns as 2 and all other considered returns as 1
+    // (corresponding to ASPRS LAS specification), writing each point once.
+    std::vector<uint8_t> labels(lastView->size(), 1);
+    for (const auto& i : idx)
+        labels[i] = 2;
+    for (PointId i = 0; i < nonlastView->size(); ++i)
+        nonlastView->setField(Dimension::Id::Classification, i, 1);
+    for (PointId i = 0; i < lastView->size(); ++i)
+        lastView->setField(Dimension::Id::Classification, i, labels[i]);
+
     PointViewPtr outView = input->makeNew();
     if (!idx.empty())
     {
-
         log()->get(LogLevel::Debug2)
             << "Labeled " << idx.size() << " ground returns!\n";
 
-        // set the classification label of ground returns as 2
-        // (corresponding to ASPRS LAS specification)
-        for (const auto& i : idx)
-        {
-            lastView->setField(Dimension::Id::Classification, i, 2);
-        }
-
         outView->append(*ignoredView);
         outView->append(*nonlastView);
         outView->append(*lastView);
@@ -72,12 +72,17 @@ private:
     bool m_approximate;
     DimRange m_ignored;
     bool m_lastOnly;
+    uint32_t m_threads;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    void computeWindows(std::vector<float>& wsvec,
+                        std::vector<float>& htvec) const;
     std::vector<double> fillNearest(PointViewPtr view, size_t rows, size_t cols,
                                     double cell_size, BOX2D bounds);
-    std::vector<double> morphOpen(PointViewPtr view, float radius);
+    std::vector<double> morphDiamond(const std::vector<double>& data,
+                                     size_t rows, size_t cols, int iterations,
+                                     bool erode);
     virtual void prepared(PointTableRef table);
     std::vector<PointId> processGround(PointViewPtr view);
     std::vector<PointId> processGroundApprox(PointViewPtr view);
@@ -75,6 +75,26 @@ void RangeFilter::addArgs(ProgramArgs& args)
 }
 
 
+bool RangeFilter::usedDimensions(StringList& dims) const
+{
+    for (auto const& r : m_rangeSpec)
+    {
+        DimRange range;
+        try
+        {
+            range.parse(r);
+        }
+        catch (const DimRange::error&)
+        {
+            // Reported by initialize().
+            return false;
+        }
+        dims.push_back(range.m_name);
+    }
+    return true;
+}
+
+
 void RangeFilter::initialize()
 {
     // Would be better to have the range know how to read from an input stream.
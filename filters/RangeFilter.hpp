@@ -64,6 +64,7 @@ private:
     std::vector<DimRange> m_range_list;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void initialize();
     virtual void prepared(PointTableRef table);
     virtual bool processOne(PointRef& point);
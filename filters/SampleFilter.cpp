@@ -34,12 +34,19 @@
 
 #include "SampleFilter.hpp"
 
-#include <pdal/KDIndex.hpp>
 #include <pdal/util/Utils.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
+#include "private/VoxelKey.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace pdal
@@ -57,9 +64,49 @@ std::string SampleFilter::getName() const
 }
 
 
+namespace
+{
+
+// Grid cells are cubes with a diagonal equal to the sample radius, so a
+// cell holds at most one sample.  Cells are grouped into square columns
+// ("tiles") of TileCells x TileCells cells, which are sampled in parallel.
+const int64_t TileCells = 32;
+
+// A sample within the radius of a point is at most two cells away along
+// each axis.
+const int64_t Reach = 2;
+
+struct Position
+{
+    double m_x;
+    double m_y;
+    double m_z;
+};
+
+struct Tile
+{
+    std::vector<PointId> m_ids;
+    std::unordered_map<VoxelKey, Position, VoxelKeyHash> m_samples;
+    std::vector<PointId> m_kept;
+};
+
+typedef std::unordered_map<VoxelKey, Tile, VoxelKeyHash> TileMap;
+
+int64_t floorDiv(int64_t v, int64_t d)
+{
+    return (v >= 0) ? v / d : -((-v + d - 1) / d);
+}
+
+} // unnamed namespace
+
+
 void SampleFilter::addArgs(ProgramArgs& args)
 {
     args.add("radius", "Radius", m_radius, 1.0);
+    m_seedArg = &args.add("seed", "Seed for the random order in which "
+        "points are considered", m_seed);
+    args.add("threads", "Number of threads used to sample",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -69,6 +116,13 @@ void SampleFilter::addDimensions(PointLayoutPtr layout)
 }
 
 
+void SampleFilter::initialize()
+{
+    if (m_radius <= 0)
+        throwError("Option 'radius' must be greater than 0.");
+}
+
+
 PointViewSet SampleFilter::run(PointViewPtr inView)
 {
     point_count_t np = inView->size();
@@ -80,38 +134,127 @@ PointViewSet SampleFilter::run(PointViewPtr inView)
         return viewSet;
     PointViewPtr outView = inView->makeNew();
 
-    // Build the 3D KD-tree.
-    KD3Index index(*inView);
-    index.build();
+    const double cell = m_radius / std::sqrt(3.0);
+    const double r2 = m_radius * m_radius;
+
+    std::vector<Position> pos(np);
+    std::vector<VoxelKey> cells(np);
+    for (PointId i = 0; i < np; ++i)
+    {
+        Position& p = pos[i];
+        p.m_x = inView->getFieldAs<double>(Dimension::Id::X, i);
+        p.m_y = inView->getFieldAs<double>(Dimension::Id::Y, i);
+        p.m_z = inView->getFieldAs<double>(Dimension::Id::Z, i);
+        cells[i] = VoxelKey { (int64_t)std::floor(p.m_x / cell),
+            (int64_t)std::floor(p.m_y / cell),
+            (int64_t)std::floor(p.m_z / cell) };
+    }
 
-    // The result looks much better if we take some time to shuffle the indices.
-    std::srand(std::time(NULL));
+    // The result looks much better if we take some time to shuffle the
+    // indices.  Each tile considers its points in the shuffled order.
     std::vector<PointId> indices(np);
     for (PointId i = 0; i < np; ++i)
         indices[i] = i;
-    std::random_shuffle(indices.begin(), indices.end());
+    std::mt19937 rng(m_seedArg->set() ? m_seed : (uint32_t)std::time(NULL));
+    std::shuffle(indices.begin(), indices.end(), rng);
 
-    // All points are marked as kept (1) by default. As they are masked by
-    // neighbors within the user-specified radius, their value is changed to 0.
-    std::vector<int> keep(np, 1);
+    TileMap tiles;
+    for (PointId i : indices)
+    {
+        VoxelKey t { floorDiv(cells[i].m_x, TileCells),
+            floorDiv(cells[i].m_y, TileCells), 0 };
+        tiles[t].m_ids.push_back(i);
+    }
 
-    // We are able to subsample in a single pass over the shuffled indices.
-    for (auto const& i : indices)
+    // A point is kept if its cell is empty and no sample in the
+    // surrounding cells is within the radius.
+    auto sampleTile = [&](const VoxelKey& tileKey, Tile& tile)
     {
-        // If a point is masked, it is forever masked, and cannot be part of the
-        // sampled cloud. Otherwise, the current index is appended to the output
-        // PointView.
-        if (keep[i] == 0)
-            continue;
-        outView->appendPoint(*inView, i);
+        // Tiles are at least Reach cells wide, so the cells checked for a
+        // point lie in this tile or in one of its eight neighbors.
+        const Tile *neighbors[3][3];
+        for (int64_t dx = -1; dx <= 1; ++dx)
+            for (int64_t dy = -1; dy <= 1; ++dy)
+            {
+                auto it = tiles.find(VoxelKey { tileKey.m_x + dx,
+                    tileKey.m_y + dy, 0 });
+                neighbors[dx + 1][dy + 1] =
+                    (it == tiles.end()) ? nullptr : &it->second;
+            }
+        const int64_t x0 = tileKey.m_x * TileCells;
+        const int64_t y0 = tileKey.m_y * TileCells;
+        auto tileIndex = [](int64_t c, int64_t c0)
+            { return (c < c0) ? 0 : ((c < c0 + TileCells) ? 1 : 2); };
+
+        for (PointId i : tile.m_ids)
+        {
+            const VoxelKey& c = cells[i];
+            if (tile.m_samples.count(c))
+                continue;
+
+            const Position& p = pos[i];
+            bool keep = true;
+            for (int64_t dx = -Reach; keep && dx <= Reach; ++dx)
+            for (int64_t dy = -Reach; keep && dy <= Reach; ++dy)
+            {
+                VoxelKey k { c.m_x + dx, c.m_y + dy, 0 };
+                const Tile *t = neighbors[tileIndex(k.m_x, x0)]
+                    [tileIndex(k.m_y, y0)];
+                if (!t || t->m_samples.empty())
+                    continue;
+                for (int64_t dz = -Reach; dz <= Reach; ++dz)
+                {
+                    k.m_z = c.m_z + dz;
+                    auto si = t->m_samples.find(k);
+                    if (si == t->m_samples.end())
+                        continue;
+                    const Position& s = si->second;
+                    double ddx = s.m_x - p.m_x;
+                    double ddy = s.m_y - p.m_y;
+                    double ddz = s.m_z - p.m_z;
+                    if (ddx * ddx + ddy * ddy + ddz * ddz <= r2)
+                    {
+                        keep = false;
+                        break;
+                    }
+                }
+            }
+            if (keep)
+            {
+                tile.m_samples[c] = p;
+                tile.m_kept.push_back(i);
+            }
+        }
+        std::vector<PointId>().swap(tile.m_ids);
+    };
 
-        // We now proceed to mask all neighbors within m_radius of the kept
-        // point.
-        auto ids = index.radius(i, m_radius);
-        for (PointId j = 1; j < ids.size(); ++j)
-            keep[ids[j]] = 0;
+    // Tiles are sampled in four passes by the parity of their X and Y
+    // positions.  Tiles sampled together are separated by a tile, so they
+    // neither read nor write each other's samples, and the result doesn't
+    // depend on the number of threads.
+    ThreadPool pool((std::max)(m_threads, 1U));
+    for (int pass = 0; pass < 4; ++pass)
+    {
+        for (auto& entry : tiles)
+        {
+            const VoxelKey& key = entry.first;
+            if ((key.m_x & 1) != (pass & 1) || (key.m_y & 1) != (pass >> 1))
+                continue;
+            Tile& tile = entry.second;
+            pool.add([&sampleTile, &key, &tile]()
+                { sampleTile(key, tile); });
+        }
+        pool.await();
     }
 
+    std::vector<PointId> kept;
+    for (auto& entry : tiles)
+        kept.insert(kept.end(), entry.second.m_kept.begin(),
+            entry.second.m_kept.end());
+    std::sort(kept.begin(), kept.end());
+    for (PointId i : kept)
+        outView->appendPoint(*inView, i);
+
     // Simply calculate the percentage of retained points.
     double frac = (double)outView->size() / (double)inView->size();
     log()->get(LogLevel::Debug2) << "Retaining "
@@ -61,9 +61,13 @@ public:
 
 private:
     double m_radius;
+    uint32_t m_seed;
+    Arg *m_seedArg;
+    uint32_t m_threads;
 
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
     virtual PointViewSet run(PointViewPtr view);
 };
 
@@ -34,42 +34,128 @@
 
 #include "SortFilter.hpp"
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ThreadPool.hpp>
+
+#include "private/ExternalSort.hpp"
+#include "private/RadixSort.hpp"
 
 namespace pdal
 {
 
 static PluginInfo const s_info = PluginInfo(
     "filters.sort",
-    "Sort data based on a given dimension.",
+    "Sort data based on one or more dimensions.",
     "http://pdal.io/stages/filters.sort.html" );
 
 CREATE_STATIC_PLUGIN(1, 0, SortFilter, Filter, s_info)
 
 std::string SortFilter::getName() const { return s_info.name; }
 
+SortFilter::SortFilter() : m_threads(1), m_memoryLimit(0)
+{}
+
+SortFilter::~SortFilter()
+{}
+
 void SortFilter::addArgs(ProgramArgs& args)
 {
-    args.add("dimension", "Dimension on which to sort", m_dimName).
+    args.add("dimension", "Dimension(s) on which to sort", m_dimNames).
         setPositional();
-    args.add("order", "Sort order ASC(ending) or DESC(ending)", m_order, SortOrder::ASC);
+    args.add("order", "Sort order ASC(ending) or DESC(ending), for all "
+        "dimensions or for each dimension", m_orderNames);
+    args.add("threads", "Number of threads used to sort", m_threads,
+        (uint32_t)ThreadPool::defaultThreadCount());
+    args.add("memory_limit", "Approximate memory (MB) used to hold points "
+        "when streaming before sorted runs are written to temporary files",
+        m_memoryLimit, (uint32_t)1024);
+}
+
+void SortFilter::initialize()
+{
+    m_orders.clear();
+    for (auto& name : m_orderNames)
+    {
+        SortOrder order;
+        if (!Utils::fromString(name, order))
+            throwError("Invalid value '" + name + "' for option 'order'.");
+        m_orders.push_back(order);
+    }
+    if (m_orders.empty())
+        m_orders.push_back(SortOrder::ASC);
+    if (m_orders.size() == 1)
+        m_orders.resize(m_dimNames.size(), m_orders.front());
+    if (m_orders.size() != m_dimNames.size())
+        throwError("Option 'order' must have a single value or a value "
+            "for each dimension.");
 }
 
 void SortFilter::prepared(PointTableRef table)
 {
-    m_dim = table.layout()->findDim(m_dimName);
-    if (m_dim == Dimension::Id::Unknown)
-        throwError("Dimension '" + m_dimName + "' not found.");
+    m_dims.clear();
+    m_types.clear();
+    for (auto& name : m_dimNames)
+    {
+        Dimension::Id dim = table.layout()->findDim(name);
+        if (dim == Dimension::Id::Unknown)
+            throwError("Dimension '" + name + "' not found.");
+        m_dims.push_back(dim);
+        m_types.push_back(table.layout()->dimType(dim));
+    }
+}
+
+void SortFilter::ready(PointTableRef table)
+{
+    m_sorter.reset(new ExternalSorter(table.layout()->dimTypes(),
+        m_dims.size(), (size_t)m_memoryLimit * 1024 * 1024));
+    m_keys.resize(m_dims.size());
 }
 
 void SortFilter::filter(PointView& view)
 {
-    auto cmp = [this](const PointIdxRef& p1, const PointIdxRef& p2)
+    SortKeyList keys(view.size());
+    for (PointId i = 0; i < view.size(); ++i)
+        keys[i].m_id = i;
+
+    // Radix sort is stable, so sorting on the least significant dimension
+    // first and the most significant last gives a multi-key sort.  Keys
+    // are extracted in the current order of the points each time.
+    for (size_t i = m_dims.size(); i-- > 0;)
     {
-        bool result = p1.compare(m_dim, p2);
-        return (m_order == SortOrder::ASC) ? result : !result;
-    };
+        size_t keyBytes = radix::extractKeys(view, m_dims[i], keys,
+            m_orders[i] == SortOrder::DESC, m_threads);
+        radix::sort(keys, keyBytes, m_threads);
+    }
+
+    std::vector<PointId> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+        order[i] = keys[i].m_id;
+    view.reorder(order);
+}
+
+// When streaming, all points are retained by the sorter and emitted in
+// order once the input is exhausted.
+bool SortFilter::processOne(PointRef& point)
+{
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        m_keys[i] = radix::pointKey(point, m_dims[i], m_types[i],
+            m_orders[i] == SortOrder::DESC);
+    m_sorter->add(m_keys.data(), point);
+    return false;
+}
+
+bool SortFilter::emitOne(PointRef& point)
+{
+    if (m_sorter->next(point))
+        return true;
 
-    std::stable_sort(view.begin(), view.end(), cmp);
+    // Release the retained points.
+    m_sorter->clear();
+    return false;
+}
+
+void SortFilter::done(PointTableRef table)
+{
+    m_sorter.reset();
 }
 
 std::istream& operator >> (std::istream& in, SortOrder& order)
@@ -93,8 +179,10 @@ std::ostream& operator<<(std::ostream& out, const SortOrder& order)
     {
     case SortOrder::ASC:
         out << "ASC";
+        break;
     case SortOrder::DESC:
         out << "DESC";
+        break;
     }
     return out;
 }
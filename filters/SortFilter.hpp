@@ -39,12 +39,16 @@
 #include <pdal/plugin.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
+#include <memory>
+
 extern "C" int32_t SortFilter_ExitFunc();
 extern "C" PF_ExitFunc SortFilter_InitPlugin();
 
 namespace pdal
 {
 
+class ExternalSorter;
+
 enum class SortOrder
 {
     ASC, // ascending
@@ -58,25 +62,49 @@ std::ostream& operator << (std::ostream& in, const SortOrder& order);
 class PDAL_DLL SortFilter : public Filter
 {
 public:
-    SortFilter()
-    {}
+    SortFilter();
+    ~SortFilter();
 
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
 
 private:
-    // Dimension on which to sort.
-    Dimension::Id m_dim;
-    // Dimension name.
-    std::string m_dimName;
-    
-    // Sort order.
-    SortOrder m_order;
+    // Dimensions on which to sort, most significant first.
+    std::vector<Dimension::Id> m_dims;
+    // Dimension types.
+    std::vector<Dimension::Type> m_types;
+    // Dimension names.
+    StringList m_dimNames;
+
+    // Sort order for each dimension.
+    std::vector<SortOrder> m_orders;
+    // Sort orders as given in the 'order' option.
+    StringList m_orderNames;
+
+    // Number of threads used to extract and sort keys.
+    uint32_t m_threads;
+
+    // Memory (MB) used to buffer points when streaming.
+    uint32_t m_memoryLimit;
+    std::unique_ptr<ExternalSorter> m_sorter;
+    std::vector<uint64_t> m_keys;
 
     virtual void addArgs(ProgramArgs& args) override;
+    virtual bool usedDimensions(StringList& dims) const override
+    {
+        dims = m_dimNames;
+        return true;
+    }
+    virtual void initialize() override;
     virtual void prepared(PointTableRef table) override;
+    virtual void ready(PointTableRef table) override;
     virtual void filter(PointView& view) override;
+    virtual bool processOne(PointRef& point) override;
+    virtual bool blocking() const override
+        { return true; }
+    virtual bool emitOne(PointRef& point) override;
+    virtual void done(PointTableRef table) override;
 
     SortFilter& operator=(const SortFilter&) = delete;
     SortFilter(const SortFilter&) = delete;
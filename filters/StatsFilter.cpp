@@ -43,6 +43,7 @@
 #include <pdal/PDALUtils.hpp>
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include <json/json.h>
 
@@ -61,6 +62,114 @@ std::string StatsFilter::getName() const { return s_info.name; }
 namespace stats
 {
 
+void Summary::insert(const double *values, point_count_t count)
+{
+    if (count == 0)
+        return;
+
+    // Min, max and sum are accumulated in four independent lanes so that
+    // the loop has no dependency between adjacent values and can be
+    // vectorized.
+    const double lowest = (std::numeric_limits<double>::lowest)();
+    const double highest = (std::numeric_limits<double>::max)();
+    double mins[4] = { highest, highest, highest, highest };
+    double maxs[4] = { lowest, lowest, lowest, lowest };
+    double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+
+    point_count_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        for (int j = 0; j < 4; ++j)
+        {
+            double v = values[i + j];
+            mins[j] = (v < mins[j]) ? v : mins[j];
+            maxs[j] = (v > maxs[j]) ? v : maxs[j];
+            sums[j] += v;
+        }
+    for (; i < count; ++i)
+    {
+        double v = values[i];
+        mins[0] = (v < mins[0]) ? v : mins[0];
+        maxs[0] = (v > maxs[0]) ? v : maxs[0];
+        sums[0] += v;
+    }
+    double min = (std::min)((std::min)(mins[0], mins[1]),
+        (std::min)(mins[2], mins[3]));
+    double max = (std::max)((std::max)(maxs[0], maxs[1]),
+        (std::max)(maxs[2], maxs[3]));
+    double mean = ((sums[0] + sums[1]) + (sums[2] + sums[3])) / count;
+
+    // With the block mean known, the central moments of the block are
+    // plain sums.
+    double m2(0.0), m3(0.0), m4(0.0);
+    for (i = 0; i < count; ++i)
+    {
+        double d = values[i] - mean;
+        double d2 = d * d;
+        m2 += d2;
+        m3 += d2 * d;
+        m4 += d2 * d2;
+    }
+
+    if (m_enumerate != NoEnum)
+        for (i = 0; i < count; ++i)
+            m_values[values[i]]++;
+    if (m_enumerate == Global)
+        m_data.insert(m_data.end(), values, values + count);
+
+    combine(count, min, max, mean, m2, m3, m4);
+}
+
+
+void Summary::merge(const Summary& s)
+{
+    if (s.m_cnt == 0)
+        return;
+
+    for (auto& v : s.m_values)
+        m_values[v.first] += v.second;
+    m_data.insert(m_data.end(), s.m_data.begin(), s.m_data.end());
+
+    combine(s.m_cnt, s.m_min, s.m_max, s.M1, s.M2, s.M3, s.M4);
+}
+
+
+// Pairwise combination of central moments.  See Pebay, "Formulas for
+// Robust, One-Pass Parallel Computation of Covariances and Arbitrary-Order
+// Statistical Moments", Sandia Report SAND2008-6212.
+void Summary::combine(point_count_t cnt, double min, double max, double mean,
+    double m2, double m3, double m4)
+{
+    m_min = (std::min)(m_min, min);
+    m_max = (std::max)(m_max, max);
+    if (m_cnt == 0)
+    {
+        m_cnt = cnt;
+        m_avg = M1 = mean;
+        M2 = m2;
+        M3 = m3;
+        M4 = m4;
+        return;
+    }
+
+    double na(static_cast<double>(m_cnt));
+    double nb(static_cast<double>(cnt));
+    double n(na + nb);
+    double delta = mean - M1;
+    double delta_n = delta / n;
+    double delta_n2 = delta_n * delta_n;
+    double term1 = delta * delta_n * na * nb;
+
+    M4 += m4 + term1 * delta_n2 * (na * na - na * nb + nb * nb) +
+        6.0 * delta_n2 * (na * na * m2 + nb * nb * M2) +
+        4.0 * delta_n * (na * m3 - nb * M3);
+    M3 += m3 + term1 * delta_n * (na - nb) +
+        3.0 * delta_n * (na * m2 - nb * M2);
+    M2 += m2 + term1;
+    M1 += delta_n * nb;
+    m_avg = M1;
+    m_cnt += cnt;
+}
+
 
 void Summary::extractMetadata(MetadataNode &m)
 {
@@ -145,12 +254,57 @@ bool StatsFilter::processOne(PointRef& point)
 
 void StatsFilter::filter(PointView& view)
 {
-    PointRef point(view, 0);
-    for (PointId idx = 0; idx < view.size(); ++idx)
+    // Statistics are computed a dimension at a time over contiguous ranges
+    // of points.  Each task fills its own summary, and the partial
+    // summaries are combined in range order so that the result doesn't
+    // depend on how tasks were scheduled.
+    const point_count_t MinRangeSize = 65536;
+    const point_count_t BlockSize = 4096;
+
+    point_count_t numPoints = view.size();
+    if (numPoints == 0)
+        return;
+
+    point_count_t numRanges =
+        ThreadPool::numRanges(m_threads, numPoints, MinRangeSize);
+    point_count_t rangeSize = (numPoints + numRanges - 1) / numRanges;
+
+    struct Task
     {
-        point.setPointId(idx);
-        processOne(point);
-    }
+        Dimension::Id m_dim;
+        Summary m_summary;
+    };
+    std::vector<Task> tasks;
+    for (auto& p : m_stats)
+        for (point_count_t r = 0; r < numRanges; ++r)
+            tasks.push_back({ p.first,
+                Summary(p.second.name(), p.second.enumerate()) });
+
+    // Tasks rather than points are handed to parallelFor() so that
+    // dimensions are summarized in parallel even when there are too few
+    // points to split into ranges.
+    ThreadPool::parallelFor(m_threads, tasks.size(), 1,
+        [&view, &tasks, numRanges, rangeSize, numPoints, BlockSize]
+        (size_t first, size_t last)
+    {
+        std::vector<double> values(BlockSize);
+        for (size_t t = first; t < last; ++t)
+        {
+            Task& task = tasks[t];
+            PointId begin = (t % numRanges) * rangeSize;
+            PointId end = (std::min)(begin + rangeSize, numPoints);
+            for (PointId idx = begin; idx < end; idx += BlockSize)
+            {
+                point_count_t count = (std::min)(BlockSize, end - idx);
+                for (point_count_t i = 0; i < count; ++i)
+                    values[i] = view.getFieldAs<double>(task.m_dim, idx + i);
+                task.m_summary.insert(values.data(), count);
+            }
+        }
+    });
+
+    for (auto& task : tasks)
+        m_stats.at(task.m_dim).merge(task.m_summary);
 }
 
 
@@ -169,6 +323,8 @@ void StatsFilter::addArgs(ProgramArgs& args)
     args.add("global", "Dimensions to compute global stats (median, mad, mode)",
         m_global);
     args.add("count", "Dimensions whose values should be counted", m_counts);
+    args.add("threads", "Number of threads used to compute statistics",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
@@ -86,6 +86,8 @@ public:
         { return m_cnt; }
     std::string name() const
         { return m_name; }
+    EnumType enumerate() const
+        { return m_enumerate; }
     const EnumMap& values() const
         { return m_values; }
 
@@ -125,7 +127,6 @@ public:
 
         // stolen from http://www.johndcook.com/blog/skewness_kurtosis/
 
-        n1 = n;
         delta = value - M1;
         delta_n = delta / n;
         delta_n2 = delta_n * delta_n;
@@ -137,7 +138,18 @@ public:
         M2 += term1;
     }
 
+    // Insert a block of values.  Equivalent to calling insert() for each
+    // value, but without the per-value divisions.
+    void insert(const double *values, point_count_t count);
+
+    // Combine the statistics of another summary of the same dimension
+    // into this one.
+    void merge(const Summary& s);
+
 private:
+    void combine(point_count_t cnt, double min, double max, double mean,
+        double m2, double m3, double m4);
+
     std::string m_name;
     EnumType m_enumerate;
     double m_max;
@@ -158,7 +170,7 @@ private:
 class PDAL_DLL StatsFilter : public Filter
 {
 public:
-    StatsFilter() : Filter()
+    StatsFilter() : Filter(), m_threads(1)
         {}
 
     static void * create();
@@ -182,6 +194,7 @@ private:
     StringList m_enums;
     StringList m_counts;
     StringList m_global;
+    uint32_t m_threads;
     std::map<Dimension::Id, stats::Summary> m_stats;
 };
 
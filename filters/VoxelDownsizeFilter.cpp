@@ -0,0 +1,349 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "VoxelDownsizeFilter.hpp"
+
+#include <pdal/PointView.hpp>
+#include <pdal/pdal_macros.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
+#include <pdal/util/Utils.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "filters.voxeldownsize",
+    "Keep one point for each occupied voxel of a regular grid",
+    "http://pdal.io/stages/filters.voxeldownsize.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, VoxelDownsizeFilter, Filter, s_info)
+
+std::string VoxelDownsizeFilter::getName() const { return s_info.name; }
+
+
+void VoxelDownsizeFilter::addArgs(ProgramArgs& args)
+{
+    args.add("cell", "Voxel edge length", m_cell, 1.0);
+    args.add("mode", "Point kept in each voxel (first, center or centroid)",
+        m_modeName, "first");
+    args.add("max_voxels", "Maximum number of voxels held in memory when "
+        "streaming", m_maxVoxels, (point_count_t)1000000);
+    args.add("threads", "Number of threads used to find voxels",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+}
+
+
+void VoxelDownsizeFilter::initialize()
+{
+    if (m_cell <= 0)
+        throwError("Option 'cell' must be greater than 0.");
+    if (m_maxVoxels == 0)
+        throwError("Option 'max_voxels' must be greater than 0.");
+
+    std::string mode = Utils::tolower(m_modeName);
+    if (mode == "first")
+        m_mode = Mode::First;
+    else if (mode == "center")
+        m_mode = Mode::Center;
+    else if (mode == "centroid")
+        m_mode = Mode::Centroid;
+    else
+        throwError("Invalid mode '" + m_modeName + "'.  Must be 'first', "
+            "'center' or 'centroid'.");
+}
+
+
+void VoxelDownsizeFilter::ready(PointTableRef table)
+{
+    m_dims = table.layout()->dimTypes();
+    m_voxels.clear();
+    m_index.clear();
+}
+
+
+VoxelKey VoxelDownsizeFilter::key(double x, double y, double z) const
+{
+    return VoxelKey { (int64_t)std::floor(x / m_cell),
+        (int64_t)std::floor(y / m_cell), (int64_t)std::floor(z / m_cell) };
+}
+
+
+double VoxelDownsizeFilter::centerDist(const VoxelKey& key, double x,
+    double y, double z) const
+{
+    double dx = x - (key.m_x + .5) * m_cell;
+    double dy = y - (key.m_y + .5) * m_cell;
+    double dz = z - (key.m_z + .5) * m_cell;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+
+PointViewSet VoxelDownsizeFilter::run(PointViewPtr view)
+{
+    // Each task finds the voxels of a contiguous range of points.  The
+    // per-range results are merged in range order, so the point kept for
+    // a voxel is the same no matter how the work was split.
+    struct Cell
+    {
+        PointId m_id;
+        double m_dist;
+        double m_sum[3];
+        point_count_t m_count;
+    };
+    typedef std::unordered_map<VoxelKey, Cell, VoxelKeyHash> CellMap;
+
+    const point_count_t MinRangeSize = 65536;
+
+    PointViewSet viewSet;
+    PointViewPtr outView = view->makeNew();
+    viewSet.insert(outView);
+
+    point_count_t numPoints = view->size();
+    if (numPoints == 0)
+        return viewSet;
+
+    point_count_t numRanges =
+        ThreadPool::numRanges(m_threads, numPoints, MinRangeSize);
+    point_count_t rangeSize = (numPoints + numRanges - 1) / numRanges;
+
+    std::vector<CellMap> cells(numRanges);
+    ThreadPool::parallelFor(m_threads, numPoints, MinRangeSize,
+        [this, &view, &cells, rangeSize](PointId begin, PointId end)
+        {
+            CellMap& map = cells[begin / rangeSize];
+            for (PointId idx = begin; idx < end; ++idx)
+            {
+                double x = view->getFieldAs<double>(Dimension::Id::X, idx);
+                double y = view->getFieldAs<double>(Dimension::Id::Y, idx);
+                double z = view->getFieldAs<double>(Dimension::Id::Z, idx);
+                VoxelKey k = key(x, y, z);
+
+                auto res = map.insert({ k, Cell() });
+                Cell& cell = res.first->second;
+                if (res.second)
+                {
+                    cell.m_id = idx;
+                    cell.m_dist = centerDist(k, x, y, z);
+                    cell.m_sum[0] = x;
+                    cell.m_sum[1] = y;
+                    cell.m_sum[2] = z;
+                    cell.m_count = 1;
+                }
+                else if (m_mode == Mode::Center)
+                {
+                    double dist = centerDist(k, x, y, z);
+                    if (dist < cell.m_dist)
+                    {
+                        cell.m_id = idx;
+                        cell.m_dist = dist;
+                    }
+                }
+                else if (m_mode == Mode::Centroid)
+                {
+                    cell.m_sum[0] += x;
+                    cell.m_sum[1] += y;
+                    cell.m_sum[2] += z;
+                    cell.m_count++;
+                }
+            }
+        });
+
+    // Earlier ranges hold lower point IDs, so an existing cell wins ties.
+    CellMap& result = cells[0];
+    for (point_count_t r = 1; r < numRanges; ++r)
+    {
+        for (auto& entry : cells[r])
+        {
+            auto res = result.insert(entry);
+            if (res.second)
+                continue;
+            Cell& cell = res.first->second;
+            const Cell& other = entry.second;
+            if (m_mode == Mode::Center && other.m_dist < cell.m_dist)
+            {
+                cell.m_id = other.m_id;
+                cell.m_dist = other.m_dist;
+            }
+            else if (m_mode == Mode::Centroid)
+            {
+                for (size_t i = 0; i < 3; ++i)
+                    cell.m_sum[i] += other.m_sum[i];
+                cell.m_count += other.m_count;
+            }
+        }
+        CellMap().swap(cells[r]);
+    }
+
+    std::vector<PointId> ids;
+    ids.reserve(result.size());
+    for (auto& entry : result)
+    {
+        const Cell& cell = entry.second;
+        if (m_mode == Mode::Centroid)
+        {
+            view->setField(Dimension::Id::X, cell.m_id,
+                cell.m_sum[0] / cell.m_count);
+            view->setField(Dimension::Id::Y, cell.m_id,
+                cell.m_sum[1] / cell.m_count);
+            view->setField(Dimension::Id::Z, cell.m_id,
+                cell.m_sum[2] / cell.m_count);
+        }
+        ids.push_back(cell.m_id);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (PointId id : ids)
+        outView->appendPoint(*view, id);
+    return viewSet;
+}
+
+
+// In streaming mode a voxel's point is written once the voxel is retired:
+// in "first" mode that's immediately, otherwise when it is evicted as the
+// least recently used voxel or when input ends.  For spatially ordered
+// input a voxel is finished by the time it is evicted, so memory is
+// bounded by 'max_voxels' without changing the result.
+void VoxelDownsizeFilter::processBlock(StreamPointTable& table,
+    std::vector<bool>& skips, point_count_t count)
+{
+    PointRef point(table, 0);
+    m_freeSlots.clear();
+    for (PointId idx = 0; idx < count; ++idx)
+    {
+        if (skips[idx])
+            continue;
+        point.setPointId(idx);
+        double x = point.getFieldAs<double>(Dimension::Id::X);
+        double y = point.getFieldAs<double>(Dimension::Id::Y);
+        double z = point.getFieldAs<double>(Dimension::Id::Z);
+        VoxelKey k = key(x, y, z);
+
+        auto it = m_index.find(k);
+        if (it != m_index.end())
+        {
+            m_voxels.splice(m_voxels.begin(), m_voxels, it->second);
+            Voxel& voxel = *it->second;
+            if (m_mode == Mode::Center)
+            {
+                double dist = centerDist(k, x, y, z);
+                if (dist < voxel.m_dist)
+                {
+                    point.getPackedData(m_dims, voxel.m_data.data());
+                    voxel.m_dist = dist;
+                }
+            }
+            else if (m_mode == Mode::Centroid)
+            {
+                voxel.m_sum[0] += x;
+                voxel.m_sum[1] += y;
+                voxel.m_sum[2] += z;
+                voxel.m_count++;
+            }
+            skips[idx] = true;
+            m_freeSlots.push_back(idx);
+            continue;
+        }
+
+        m_voxels.push_front(Voxel());
+        Voxel& voxel = m_voxels.front();
+        voxel.m_key = k;
+        m_index[k] = m_voxels.begin();
+        if (m_mode != Mode::First)
+        {
+            voxel.m_data.resize(table.layout()->pointSize());
+            point.getPackedData(m_dims, voxel.m_data.data());
+            voxel.m_dist = centerDist(k, x, y, z);
+            voxel.m_sum[0] = x;
+            voxel.m_sum[1] = y;
+            voxel.m_sum[2] = z;
+            voxel.m_count = 1;
+            skips[idx] = true;
+            m_freeSlots.push_back(idx);
+        }
+
+        // Each point consumed above frees its slot, and at most one voxel
+        // is retired per point, so there is always a slot to write to.
+        if (m_index.size() > m_maxVoxels)
+        {
+            Voxel& old = m_voxels.back();
+            if (m_mode != Mode::First)
+            {
+                PointId slot = m_freeSlots.back();
+                m_freeSlots.pop_back();
+                PointRef out(table, slot);
+                retire(old, out);
+                skips[slot] = false;
+            }
+            m_index.erase(old.m_key);
+            m_voxels.pop_back();
+        }
+    }
+}
+
+
+bool VoxelDownsizeFilter::emitOne(PointRef& point)
+{
+    if (m_mode == Mode::First || m_voxels.empty())
+        return false;
+
+    Voxel& voxel = m_voxels.back();
+    retire(voxel, point);
+    m_index.erase(voxel.m_key);
+    m_voxels.pop_back();
+    return true;
+}
+
+
+void VoxelDownsizeFilter::retire(Voxel& voxel, PointRef& point) const
+{
+    point.setPackedData(m_dims, voxel.m_data.data());
+    if (m_mode == Mode::Centroid)
+    {
+        point.setField(Dimension::Id::X, voxel.m_sum[0] / voxel.m_count);
+        point.setField(Dimension::Id::Y, voxel.m_sum[1] / voxel.m_count);
+        point.setField(Dimension::Id::Z, voxel.m_sum[2] / voxel.m_count);
+    }
+}
+
+
+void VoxelDownsizeFilter::done(PointTableRef table)
+{
+    m_voxels.clear();
+    m_index.clear();
+}
+
+} // namespace pdal
@@ -0,0 +1,111 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/Filter.hpp>
+#include <pdal/plugin.hpp>
+
+#include "private/VoxelKey.hpp"
+
+#include <list>
+#include <unordered_map>
+
+extern "C" int32_t VoxelDownsizeFilter_ExitFunc();
+extern "C" PF_ExitFunc VoxelDownsizeFilter_InitPlugin();
+
+namespace pdal
+{
+
+// Keep a single point for each occupied cube ("voxel") of a regular grid.
+class PDAL_DLL VoxelDownsizeFilter : public Filter
+{
+public:
+    VoxelDownsizeFilter()
+        {}
+    VoxelDownsizeFilter& operator=(const VoxelDownsizeFilter&) = delete;
+    VoxelDownsizeFilter(const VoxelDownsizeFilter&) = delete;
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    enum class Mode
+    {
+        First,
+        Center,
+        Centroid
+    };
+
+    // State of a voxel while streaming.  Voxels are kept in order of
+    // last use so that the least recently used can be retired when
+    // the limit on held voxels is reached.
+    struct Voxel
+    {
+        VoxelKey m_key;
+        std::vector<char> m_data;
+        double m_dist;
+        double m_sum[3];
+        point_count_t m_count;
+    };
+    typedef std::list<Voxel> VoxelList;
+
+    double m_cell;
+    std::string m_modeName;
+    Mode m_mode;
+    point_count_t m_maxVoxels;
+    uint32_t m_threads;
+
+    DimTypeList m_dims;
+    VoxelList m_voxels;
+    std::unordered_map<VoxelKey, VoxelList::iterator, VoxelKeyHash> m_index;
+    std::vector<PointId> m_freeSlots;
+
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
+    virtual void ready(PointTableRef table);
+    virtual PointViewSet run(PointViewPtr view);
+    virtual void processBlock(StreamPointTable& table,
+        std::vector<bool>& skips, point_count_t count);
+    virtual bool emitOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    VoxelKey key(double x, double y, double z) const;
+    double centerDist(const VoxelKey& key, double x, double y,
+        double z) const;
+    void retire(Voxel& voxel, PointRef& point) const;
+};
+
+} // namespace pdal
@@ -0,0 +1,286 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BoxExtrema.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pdal/util/ThreadPool.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+const double Empty = std::numeric_limits<double>::infinity();
+
+// The bin containing a position.  Positions beyond either end go in the
+// end bins.  Bins are found the same way for points and for window edges,
+// so a point lies inside a window if its bin is strictly between the bins
+// of the window's edges.
+size_t binOf(double pos, double min, double binSize, size_t bins)
+{
+    double f = (pos - min) / binSize;
+    if (!(f > 0))
+        return 0;
+    if (f >= bins)
+        return bins - 1;
+    return (size_t)f;
+}
+
+// Replace each of the first n - width + 1 of n values, spaced by stride,
+// with the minimum of it and the following width - 1 values (van Herk /
+// Gil-Werman).  The remaining values are left as they are.
+void slideMin(double *a, size_t n, size_t stride, size_t width,
+    std::vector<double>& g, std::vector<double>& h)
+{
+    if (n < width)
+        return;
+    g.resize(n);
+    h.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        double v = a[i * stride];
+        g[i] = (i % width == 0) ? v : (std::min)(g[i - 1], v);
+    }
+    for (size_t i = n; i-- > 0;)
+    {
+        double v = a[i * stride];
+        h[i] = (i % width == width - 1 || i == n - 1) ?
+            v : (std::min)(h[i + 1], v);
+    }
+    for (size_t i = 0; i + width <= n; ++i)
+        a[i * stride] = (std::min)(h[i], g[i + width - 1]);
+}
+
+} // unnamed namespace
+
+
+BoxExtrema::BoxExtrema(const std::vector<double>& x,
+        const std::vector<double>& y, size_t threads) :
+    m_pool(new ThreadPool((std::max)(threads, (size_t)1))), m_minx(0),
+    m_miny(0), m_binSize(1), m_xBins(1), m_yBins(1)
+{
+    size_t n = x.size();
+    if (n)
+    {
+        auto xr = std::minmax_element(x.begin(), x.end());
+        auto yr = std::minmax_element(y.begin(), y.end());
+        m_minx = *xr.first;
+        m_miny = *yr.first;
+        double width = *xr.second - m_minx;
+        double height = *yr.second - m_miny;
+
+        // Aim for a few points per bin.  Fewer would mean more bins to
+        // visit along the edges of a window, more would mean more points
+        // to test.
+        m_binSize = 2 * std::sqrt(width * height / n);
+        if (!(m_binSize > 0))
+            m_binSize = 2 * (std::max)(width, height) / n;
+        if (!(m_binSize > 0))
+            m_binSize = 1;
+        m_xBins = (size_t)(width / m_binSize) + 1;
+        m_yBins = (size_t)(height / m_binSize) + 1;
+    }
+
+    std::vector<size_t> bins(n);
+    m_start.assign(m_xBins * m_yBins + 1, 0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        bins[i] = binOf(y[i], m_miny, m_binSize, m_yBins) * m_xBins +
+            binOf(x[i], m_minx, m_binSize, m_xBins);
+        m_start[bins[i] + 1]++;
+    }
+    for (size_t b = 1; b < m_start.size(); ++b)
+        m_start[b] += m_start[b - 1];
+
+    std::vector<size_t> next(m_start.begin(), m_start.end() - 1);
+    m_ids.resize(n);
+    m_xs.resize(n);
+    m_ys.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t slot = next[bins[i]]++;
+        m_ids[slot] = i;
+        m_xs[slot] = x[i];
+        m_ys[slot] = y[i];
+    }
+}
+
+
+BoxExtrema::~BoxExtrema()
+{}
+
+
+std::vector<double> BoxExtrema::maximum(const std::vector<double>& v,
+    const std::vector<char>& active, double radius)
+{
+    std::vector<double> neg(v.size());
+    std::transform(v.begin(), v.end(), neg.begin(),
+        [](double d){ return -d; });
+    std::vector<double> out = minimum(neg, active, radius);
+    for (double& d : out)
+        d = -d;
+    return out;
+}
+
+
+std::vector<double> BoxExtrema::minimum(const std::vector<double>& v,
+    const std::vector<char>& active, double radius)
+{
+    const size_t numBins = m_xBins * m_yBins;
+
+    // Values by slot, with inactive points replaced so that they never
+    // win, and the minimum of each bin.
+    std::vector<double> vs(m_ids.size());
+    std::vector<double> binMin(numBins);
+    m_pool->parallelFor(numBins, 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t b = begin; b < end; ++b)
+        {
+            double m = Empty;
+            for (size_t k = m_start[b]; k < m_start[b + 1]; ++k)
+            {
+                size_t i = m_ids[k];
+                vs[k] = active[i] ? v[i] : Empty;
+                m = (std::min)(m, vs[k]);
+            }
+            binMin[b] = m;
+        }
+    });
+
+    // A window 'span' bins wide has between span - 2 and span bins
+    // strictly inside it in each direction.  The minimum over a run of w to
+    // 2w bins is the minimum of two overlapping runs of w, so with the
+    // minimum over every w x w block of bins, a query needs four lookups.
+    // Other windows, clipped by the edge of the bins, go bin by bin.
+    double span = 2 * radius / m_binSize;
+    size_t w = (span > 3) ? (size_t)span - 2 : 1;
+    std::vector<double> blockMin(binMin);
+    if (w > 1)
+        slide(blockMin, w);
+
+    std::vector<double> out(v.size(), Empty);
+    m_pool->parallelFor(m_ids.size(), 4096, [&](size_t begin, size_t end)
+    {
+        for (size_t k = begin; k < end; ++k)
+        {
+            if (!active[m_ids[k]])
+                continue;
+
+            const double x0 = m_xs[k] - radius;
+            const double x1 = m_xs[k] + radius;
+            const double y0 = m_ys[k] - radius;
+            const double y1 = m_ys[k] + radius;
+            const size_t bx0 = binOf(x0, m_minx, m_binSize, m_xBins);
+            const size_t bx1 = binOf(x1, m_minx, m_binSize, m_xBins);
+            const size_t by0 = binOf(y0, m_miny, m_binSize, m_yBins);
+            const size_t by1 = binOf(y1, m_miny, m_binSize, m_yBins);
+
+            double m = Empty;
+
+            // Points in bins on the edges of the window must be tested.
+            auto edge = [&](size_t b)
+            {
+                for (size_t s = m_start[b]; s < m_start[b + 1]; ++s)
+                    if (vs[s] < m && m_xs[s] >= x0 && m_xs[s] < x1 &&
+                            m_ys[s] >= y0 && m_ys[s] < y1)
+                        m = vs[s];
+            };
+            for (size_t bx = bx0; bx <= bx1; ++bx)
+            {
+                edge(by0 * m_xBins + bx);
+                if (by1 != by0)
+                    edge(by1 * m_xBins + bx);
+            }
+            for (size_t by = by0 + 1; by < by1; ++by)
+            {
+                edge(by * m_xBins + bx0);
+                if (bx1 != bx0)
+                    edge(by * m_xBins + bx1);
+            }
+
+            // Bins inside the window contribute their minimum.
+            if (bx1 > bx0 + 1 && by1 > by0 + 1)
+            {
+                const size_t ix = bx0 + 1;
+                const size_t iy = by0 + 1;
+                const size_t nx = bx1 - ix;
+                const size_t ny = by1 - iy;
+                if (nx >= w && nx <= 2 * w && ny >= w && ny <= 2 * w)
+                {
+                    const size_t lo = iy * m_xBins;
+                    const size_t hi = (iy + ny - w) * m_xBins;
+                    const size_t right = ix + nx - w;
+                    m = (std::min)(m, (std::min)(
+                        (std::min)(blockMin[lo + ix], blockMin[lo + right]),
+                        (std::min)(blockMin[hi + ix], blockMin[hi + right])));
+                }
+                else
+                {
+                    for (size_t by = iy; by < by1; ++by)
+                        for (size_t bx = ix; bx < bx1; ++bx)
+                            m = (std::min)(m, binMin[by * m_xBins + bx]);
+                }
+            }
+            out[m_ids[k]] = m;
+        }
+    });
+    return out;
+}
+
+
+// Replace the value of each bin with the minimum over the width x width
+// block of bins that starts there.  Blocks that would extend past the last
+// row or column are left undefined.
+void BoxExtrema::slide(std::vector<double>& data, size_t width)
+{
+    m_pool->parallelFor(m_yBins, 16, [&](size_t begin, size_t end)
+    {
+        std::vector<double> g, h;
+        for (size_t by = begin; by < end; ++by)
+            slideMin(data.data() + by * m_xBins, m_xBins, 1, width, g, h);
+    });
+    m_pool->parallelFor(m_xBins, 16, [&](size_t begin, size_t end)
+    {
+        std::vector<double> g, h;
+        for (size_t bx = begin; bx < end; ++bx)
+            slideMin(data.data() + bx, m_yBins, m_xBins, width, g, h);
+    });
+}
+
+} // namespace pdal
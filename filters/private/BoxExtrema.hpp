@@ -0,0 +1,92 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+class ThreadPool;
+
+// Finds, for each of a set of points, the minimum or maximum of a value
+// over the points within a square window centered on it.  The points are
+// binned once.  Each query reduces the value in every bin and then in every
+// window of whole bins, so only the points in the bins along the edges of a
+// window need to be tested individually.  The points that take part in a
+// query can be restricted, and the same bins can be queried with different
+// values, windows and subsets of points.  Results are exactly those of
+// testing every point.
+class PDAL_DLL BoxExtrema
+{
+public:
+    // \param x  X coordinates of the points.
+    // \param y  Y coordinates of the points.
+    // \param threads  Number of threads used to run queries.
+    BoxExtrema(const std::vector<double>& x, const std::vector<double>& y,
+        size_t threads);
+    ~BoxExtrema();
+
+    // For each active point i, the minimum of v[j] for the active points j
+    // with x[i] - radius <= x[j] < x[i] + radius, and the same in Y.
+    // Results for inactive points are undefined.
+    std::vector<double> minimum(const std::vector<double>& v,
+        const std::vector<char>& active, double radius);
+
+    // As minimum(), but the maximum.
+    std::vector<double> maximum(const std::vector<double>& v,
+        const std::vector<char>& active, double radius);
+
+private:
+    void slide(std::vector<double>& data, size_t width);
+
+    std::unique_ptr<ThreadPool> m_pool;
+    double m_minx;
+    double m_miny;
+    double m_binSize;
+    size_t m_xBins;
+    size_t m_yBins;
+    // Points by bin: the points of bin b are at slots m_start[b] up to
+    // m_start[b + 1] of m_ids, m_xs and m_ys.
+    std::vector<size_t> m_start;
+    std::vector<size_t> m_ids;
+    std::vector<double> m_xs;
+    std::vector<double> m_ys;
+};
+
+} // namespace pdal
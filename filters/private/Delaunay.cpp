@@ -0,0 +1,479 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "Delaunay.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace pdal
+{
+
+const size_t Delaunay::Invalid = (std::numeric_limits<size_t>::max)();
+
+namespace
+{
+
+double sqrDist(double ax, double ay, double bx, double by)
+{
+    double dx = ax - bx;
+    double dy = ay - by;
+    return dx * dx + dy * dy;
+}
+
+// Twice the signed area of triangle abc; positive when counter-clockwise.
+double ccw(double ax, double ay, double bx, double by, double cx, double cy)
+{
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+// Positive when d is inside the circumcircle of counter-clockwise abc.
+bool inCircle(double ax, double ay, double bx, double by, double cx,
+    double cy, double dx, double dy)
+{
+    double adx = ax - dx;
+    double ady = ay - dy;
+    double bdx = bx - dx;
+    double bdy = by - dy;
+    double cdx = cx - dx;
+    double cdy = cy - dy;
+
+    double ap = adx * adx + ady * ady;
+    double bp = bdx * bdx + bdy * bdy;
+    double cp = cdx * cdx + cdy * cdy;
+
+    return adx * (bdy * cp - bp * cdy) -
+        ady * (bdx * cp - bp * cdx) +
+        ap * (bdx * cdy - bdy * cdx) > 0;
+}
+
+double circumRadius2(double ax, double ay, double bx, double by, double cx,
+    double cy)
+{
+    double dx = bx - ax;
+    double dy = by - ay;
+    double ex = cx - ax;
+    double ey = cy - ay;
+
+    double bl = dx * dx + dy * dy;
+    double cl = ex * ex + ey * ey;
+    double d = .5 / (dx * ey - dy * ex);
+
+    double x = (ey * bl - dy * cl) * d;
+    double y = (dx * cl - ex * bl) * d;
+    return x * x + y * y;
+}
+
+void circumCenter(double ax, double ay, double bx, double by, double cx,
+    double cy, double& x, double& y)
+{
+    double dx = bx - ax;
+    double dy = by - ay;
+    double ex = cx - ax;
+    double ey = cy - ay;
+
+    double bl = dx * dx + dy * dy;
+    double cl = ex * ex + ey * ey;
+    double d = .5 / (dx * ey - dy * ex);
+
+    x = ax + (ey * bl - dy * cl) * d;
+    y = ay + (dx * cl - ex * bl) * d;
+}
+
+// Monotonic in the angle of (dx, dy), without trigonometry.  Increases
+// counter-clockwise in [0, 1).
+double pseudoAngle(double dx, double dy)
+{
+    double p = dx / (std::fabs(dx) + std::fabs(dy));
+    return (dy > 0 ? 3 - p : 1 + p) / 4;
+}
+
+} // unnamed namespace
+
+
+Delaunay::Delaunay(const std::vector<double>& coords) : m_coords(coords)
+{
+    triangulate();
+
+    m_vertexEdge.assign(m_coords.size() / 2, Invalid);
+    for (size_t e = 0; e < m_triangles.size(); ++e)
+        m_vertexEdge[m_triangles[e]] = e;
+
+    // Only needed while building.
+    std::vector<size_t>().swap(m_hullPrev);
+    std::vector<size_t>().swap(m_hullNext);
+    std::vector<size_t>().swap(m_hullTri);
+    std::vector<size_t>().swap(m_hullHash);
+    std::vector<size_t>().swap(m_edgeStack);
+}
+
+
+double Delaunay::orient(size_t i, size_t j, double x, double y) const
+{
+    return ccw(m_coords[2 * i], m_coords[2 * i + 1],
+        m_coords[2 * j], m_coords[2 * j + 1], x, y);
+}
+
+
+size_t Delaunay::hashKey(double x, double y) const
+{
+    size_t size = m_hullHash.size();
+    return (size_t)std::floor(pseudoAngle(x - m_cx, y - m_cy) * size) % size;
+}
+
+
+void Delaunay::triangulate()
+{
+    const std::vector<double>& c = m_coords;
+    size_t n = c.size() / 2;
+    if (n < 3)
+        return;
+
+    double minX = (std::numeric_limits<double>::max)();
+    double minY = (std::numeric_limits<double>::max)();
+    double maxX = std::numeric_limits<double>::lowest();
+    double maxY = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < n; ++i)
+    {
+        minX = (std::min)(minX, c[2 * i]);
+        minY = (std::min)(minY, c[2 * i + 1]);
+        maxX = (std::max)(maxX, c[2 * i]);
+        maxY = (std::max)(maxY, c[2 * i + 1]);
+    }
+    double midX = (minX + maxX) / 2;
+    double midY = (minY + maxY) / 2;
+
+    // The seed triangle is the point nearest the middle, its nearest
+    // neighbor, and the point that makes the smallest circumcircle with
+    // them.
+    size_t i0 = 0;
+    double minDist = (std::numeric_limits<double>::max)();
+    for (size_t i = 0; i < n; ++i)
+    {
+        double d = sqrDist(midX, midY, c[2 * i], c[2 * i + 1]);
+        if (d < minDist)
+        {
+            i0 = i;
+            minDist = d;
+        }
+    }
+    double i0x = c[2 * i0];
+    double i0y = c[2 * i0 + 1];
+
+    size_t i1 = Invalid;
+    minDist = (std::numeric_limits<double>::max)();
+    for (size_t i = 0; i < n; ++i)
+    {
+        double d = sqrDist(i0x, i0y, c[2 * i], c[2 * i + 1]);
+        if (d > 0 && d < minDist)
+        {
+            i1 = i;
+            minDist = d;
+        }
+    }
+    if (i1 == Invalid)
+        return;
+    double i1x = c[2 * i1];
+    double i1y = c[2 * i1 + 1];
+
+    size_t i2 = Invalid;
+    double minRadius = (std::numeric_limits<double>::max)();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i == i0 || i == i1)
+            continue;
+        if (ccw(i0x, i0y, i1x, i1y, c[2 * i], c[2 * i + 1]) == 0)
+            continue;
+        double r = circumRadius2(i0x, i0y, i1x, i1y, c[2 * i], c[2 * i + 1]);
+        if (r < minRadius)
+        {
+            i2 = i;
+            minRadius = r;
+        }
+    }
+    // All points are collinear.
+    if (i2 == Invalid)
+        return;
+    if (ccw(i0x, i0y, i1x, i1y, c[2 * i2], c[2 * i2 + 1]) < 0)
+    {
+        std::swap(i1, i2);
+        i1x = c[2 * i1];
+        i1y = c[2 * i1 + 1];
+    }
+    double i2x = c[2 * i2];
+    double i2y = c[2 * i2 + 1];
+
+    circumCenter(i0x, i0y, i1x, i1y, i2x, i2y, m_cx, m_cy);
+
+    std::vector<double> dists(n);
+    for (size_t i = 0; i < n; ++i)
+        dists[i] = sqrDist(c[2 * i], c[2 * i + 1], m_cx, m_cy);
+    std::vector<size_t> ids(n);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::sort(ids.begin(), ids.end(), [&dists](size_t a, size_t b)
+        { return dists[a] < dists[b]; });
+
+    m_hullPrev.assign(n, Invalid);
+    m_hullNext.assign(n, Invalid);
+    m_hullTri.assign(n, Invalid);
+    m_hullHash.assign((size_t)std::ceil(std::sqrt((double)n)), Invalid);
+
+    // The hull is a counter-clockwise cycle.  m_hullTri[i] is the halfedge
+    // from hull point i to the next hull point.
+    m_hullNext[i0] = m_hullPrev[i2] = i1;
+    m_hullNext[i1] = m_hullPrev[i0] = i2;
+    m_hullNext[i2] = m_hullPrev[i1] = i0;
+
+    m_triangles.reserve(6 * n);
+    m_halfedges.reserve(6 * n);
+    addTriangle(i0, i1, i2, Invalid, Invalid, Invalid);
+    m_hullTri[i0] = 0;
+    m_hullTri[i1] = 1;
+    m_hullTri[i2] = 2;
+
+    m_hullHash[hashKey(i0x, i0y)] = i0;
+    m_hullHash[hashKey(i1x, i1y)] = i1;
+    m_hullHash[hashKey(i2x, i2y)] = i2;
+
+    double xp = 0;
+    double yp = 0;
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t i = ids[k];
+        double x = c[2 * i];
+        double y = c[2 * i + 1];
+
+        // Skip duplicates of the previous point and the seed points.
+        if (k > 0 && x == xp && y == yp)
+            continue;
+        xp = x;
+        yp = y;
+        if (i == i0 || i == i1 || i == i2)
+            continue;
+
+        // Find a hull edge visible from the point, starting near the hull
+        // point at the same angle from the center.
+        size_t start = Invalid;
+        size_t key = hashKey(x, y);
+        for (size_t j = 0; j < m_hullHash.size(); ++j)
+        {
+            start = m_hullHash[(key + j) % m_hullHash.size()];
+            if (start != Invalid && start != m_hullNext[start])
+                break;
+        }
+        start = m_hullPrev[start];
+        size_t e = start;
+        while (orient(e, m_hullNext[e], x, y) >= 0)
+        {
+            e = m_hullNext[e];
+            if (e == start)
+            {
+                e = Invalid;
+                break;
+            }
+        }
+        // The point is on the hull, most likely a near-duplicate.
+        if (e == Invalid)
+            continue;
+
+        // Connect the point to the first visible edge.
+        size_t q = m_hullNext[e];
+        size_t t = addTriangle(e, i, q, Invalid, Invalid, m_hullTri[e]);
+        m_hullTri[e] = t;
+        m_hullTri[i] = t + 1;
+        legalize(t + 2);
+
+        // Connect the point to visible edges going forward.
+        size_t nx = q;
+        while (true)
+        {
+            q = m_hullNext[nx];
+            if (orient(nx, q, x, y) >= 0)
+                break;
+            t = addTriangle(i, q, nx, Invalid, m_hullTri[nx], m_hullTri[i]);
+            m_hullTri[i] = t;
+            m_hullNext[nx] = nx;
+            legalize(t + 1);
+            nx = q;
+        }
+
+        // And going backward.
+        if (e == start)
+        {
+            while (true)
+            {
+                q = m_hullPrev[e];
+                if (orient(q, e, x, y) >= 0)
+                    break;
+                t = addTriangle(q, i, e, Invalid, m_hullTri[e],
+                    m_hullTri[q]);
+                m_hullTri[q] = t;
+                m_hullNext[e] = e;
+                legalize(t + 2);
+                e = q;
+            }
+        }
+
+        m_hullPrev[i] = e;
+        m_hullNext[e] = m_hullPrev[nx] = i;
+        m_hullNext[i] = nx;
+
+        m_hullHash[hashKey(x, y)] = i;
+        m_hullHash[hashKey(c[2 * e], c[2 * e + 1])] = e;
+    }
+}
+
+
+size_t Delaunay::addTriangle(size_t i0, size_t i1, size_t i2, size_t a,
+    size_t b, size_t c)
+{
+    size_t t = m_triangles.size();
+    m_triangles.push_back(i0);
+    m_triangles.push_back(i1);
+    m_triangles.push_back(i2);
+    m_halfedges.push_back(Invalid);
+    m_halfedges.push_back(Invalid);
+    m_halfedges.push_back(Invalid);
+    link(t, a);
+    link(t + 1, b);
+    link(t + 2, c);
+    return t;
+}
+
+
+void Delaunay::link(size_t a, size_t b)
+{
+    m_halfedges[a] = b;
+    if (b != Invalid)
+        m_halfedges[b] = a;
+}
+
+
+// Flip edges, starting with halfedge 'a', until the triangles around the
+// point opposite 'a' are Delaunay.
+void Delaunay::legalize(size_t a)
+{
+    const std::vector<double>& c = m_coords;
+
+    m_edgeStack.push_back(a);
+    while (m_edgeStack.size())
+    {
+        a = m_edgeStack.back();
+        m_edgeStack.pop_back();
+
+        size_t b = m_halfedges[a];
+        if (b == Invalid)
+            continue;
+
+        // Triangle (pr, pl, p0) shares edge pr-pl with triangle
+        // (pl, pr, p1).
+        size_t a0 = a - a % 3;
+        size_t al = a0 + (a + 1) % 3;
+        size_t ar = a0 + (a + 2) % 3;
+        size_t b0 = b - b % 3;
+        size_t br = b0 + (b + 1) % 3;
+        size_t bl = b0 + (b + 2) % 3;
+
+        size_t p0 = m_triangles[ar];
+        size_t pr = m_triangles[a];
+        size_t pl = m_triangles[al];
+        size_t p1 = m_triangles[bl];
+
+        if (!inCircle(c[2 * pr], c[2 * pr + 1], c[2 * pl], c[2 * pl + 1],
+                c[2 * p0], c[2 * p0 + 1], c[2 * p1], c[2 * p1 + 1]))
+            continue;
+
+        // Flip to triangles (p1, pl, p0) and (p0, pr, p1).  Hull edges
+        // p1-pl and p0-pr change halfedges.
+        m_triangles[a] = p1;
+        m_triangles[b] = p0;
+
+        size_t hbl = m_halfedges[bl];
+        size_t har = m_halfedges[ar];
+        if (hbl == Invalid)
+            m_hullTri[p1] = a;
+        if (har == Invalid)
+            m_hullTri[p0] = b;
+        link(a, hbl);
+        link(b, har);
+        link(ar, bl);
+
+        m_edgeStack.push_back(a);
+        m_edgeStack.push_back(br);
+    }
+}
+
+
+size_t Delaunay::locate(double x, double y, size_t start) const
+{
+    size_t numTri = numTriangles();
+    if (numTri == 0)
+        return Invalid;
+
+    size_t t = (start < numTri) ? start : 0;
+    size_t prev = Invalid;
+
+    // A walk in a Delaunay triangulation doesn't cycle, but a limit
+    // guards against trouble with nearly degenerate triangles.
+    for (size_t step = 0; step < numTri; ++step)
+    {
+        size_t next = Invalid;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            size_t e = 3 * t + k;
+            size_t f = 3 * t + (k + 1) % 3;
+            if (orient(m_triangles[e], m_triangles[f], x, y) >= 0)
+                continue;
+            size_t opp = m_halfedges[e];
+            if (opp == Invalid)
+                return Invalid;
+            // Don't step straight back to the triangle we came from.
+            if (opp / 3 == prev)
+            {
+                next = opp / 3;
+                continue;
+            }
+            next = opp / 3;
+            break;
+        }
+        if (next == Invalid)
+            return t;
+        prev = t;
+        t = next;
+    }
+    return Invalid;
+}
+
+} // namespace pdal
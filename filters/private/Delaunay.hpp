@@ -0,0 +1,108 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <pdal/pdal_internal.hpp>
+
+namespace pdal
+{
+
+// Delaunay triangulation of a set of 2D points, built with a sweep-hull
+// algorithm in O(n log n).  Points are added in order of distance from
+// the center of a seed triangle; each point lies outside the current hull
+// and is connected to the hull edges visible from it, after which edges
+// are flipped until the triangulation is Delaunay.
+//
+// Triangles are stored as triples of point indices in counter-clockwise
+// order.  Halfedge e goes from point triangles()[e] to the next point of
+// its triangle; halfedges()[e] is the opposite halfedge in the adjacent
+// triangle, or Invalid on the hull.  Points that duplicate an earlier
+// point aren't triangulated.
+class PDAL_DLL Delaunay
+{
+public:
+    static const size_t Invalid;
+
+    // \param coords  Point coordinates as x0, y0, x1, y1, ...  The
+    //   coordinates must outlive the triangulation.
+    Delaunay(const std::vector<double>& coords);
+
+    const std::vector<size_t>& triangles() const
+        { return m_triangles; }
+    const std::vector<size_t>& halfedges() const
+        { return m_halfedges; }
+    size_t numTriangles() const
+        { return m_triangles.size() / 3; }
+
+    // A triangle with point 'i' as a vertex, or Invalid if the point
+    // wasn't triangulated.
+    size_t vertexTriangle(size_t i) const
+        { return m_vertexEdge[i] == Invalid ? Invalid : m_vertexEdge[i] / 3; }
+
+    // Find the triangle containing a position by walking from a starting
+    // triangle.  A triangle near the position makes for a short walk.
+    // \return  The containing triangle, or Invalid if the position is
+    //   outside the hull.
+    size_t locate(double x, double y, size_t start) const;
+
+private:
+    const std::vector<double>& m_coords;
+    std::vector<size_t> m_triangles;
+    std::vector<size_t> m_halfedges;
+    std::vector<size_t> m_vertexEdge;
+
+    // Hull state used during construction.
+    std::vector<size_t> m_hullPrev;
+    std::vector<size_t> m_hullNext;
+    std::vector<size_t> m_hullTri;
+    std::vector<size_t> m_hullHash;
+    std::vector<size_t> m_edgeStack;
+    double m_cx;
+    double m_cy;
+
+    void triangulate();
+    size_t hashKey(double x, double y) const;
+    size_t addTriangle(size_t i0, size_t i1, size_t i2, size_t a, size_t b,
+        size_t c);
+    void link(size_t a, size_t b);
+    void legalize(size_t a);
+    double orient(size_t i, size_t j, double x, double y) const;
+};
+
+} // namespace pdal
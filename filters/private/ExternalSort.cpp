@@ -0,0 +1,338 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ExternalSort.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "RadixSort.hpp"
+
+namespace pdal
+{
+
+const size_t ExternalSorter::MaxRuns;
+
+// A sorted run of records, either in memory or in a temporary file that
+// is read a buffer at a time.
+struct ExternalSorter::Run
+{
+    Run() : m_file(nullptr), m_pos(0), m_end(0)
+    {}
+
+    ~Run()
+    {
+        if (m_file)
+            fclose(m_file);
+    }
+
+    // Current record, or null if the run is exhausted.
+    const char *current() const
+        { return m_pos < m_end ? m_buf.data() + m_pos : nullptr; }
+
+    void advance(size_t recordSize)
+    {
+        m_pos += recordSize;
+        if (m_pos >= m_end)
+            fill(recordSize);
+    }
+
+    void fill(size_t recordSize)
+    {
+        m_pos = 0;
+        m_end = 0;
+        if (m_file)
+            m_end = recordSize * fread(m_buf.data(), recordSize,
+                m_buf.size() / recordSize, m_file);
+    }
+
+    FILE *m_file;
+    std::vector<char> m_buf;
+    size_t m_pos;
+    size_t m_end;
+};
+
+
+ExternalSorter::ExternalSorter(const DimTypeList& dims, size_t numKeys,
+        size_t memoryLimit) : m_dims(dims), m_numKeys(numKeys),
+    m_memoryLimit(memoryLimit), m_count(0), m_merging(false)
+{
+    m_recordSize = m_numKeys * sizeof(uint64_t);
+    for (auto& dt : m_dims)
+        m_recordSize += Dimension::size(dt.m_type);
+    m_maxRecords = (std::max)((size_t)1, m_memoryLimit / m_recordSize);
+}
+
+
+ExternalSorter::~ExternalSorter()
+{}
+
+
+void ExternalSorter::add(const uint64_t *keys, const PointRef& point)
+{
+    if (m_merging)
+        throw pdal_error("Can't add points to a sorter once points have "
+            "been retrieved.");
+
+    if (m_count == m_maxRecords)
+        spill();
+
+    // Grow the buffer geometrically, but not beyond the memory limit.
+    size_t needed = (m_count + 1) * m_recordSize;
+    if (m_records.capacity() < needed)
+        m_records.reserve((std::min)(m_maxRecords * m_recordSize,
+            (std::max)(m_records.capacity() * 2, 1024 * m_recordSize)));
+    m_records.resize(needed);
+
+    char *rec = m_records.data() + m_count * m_recordSize;
+    memcpy(rec, keys, m_numKeys * sizeof(uint64_t));
+    point.getPackedData(m_dims, rec + m_numKeys * sizeof(uint64_t));
+    m_count++;
+}
+
+
+// Sort the buffered records in place.
+void ExternalSorter::sortRecords()
+{
+    SortKeyList keys(m_count);
+    for (size_t i = 0; i < m_count; ++i)
+        keys[i].m_id = i;
+
+    // Radix sort is stable, so sort on the least significant key first.
+    for (size_t k = m_numKeys; k-- > 0;)
+    {
+        for (auto& key : keys)
+            memcpy(&key.m_key, m_records.data() + key.m_id * m_recordSize +
+                k * sizeof(uint64_t), sizeof(uint64_t));
+        radix::sort(keys, sizeof(uint64_t), 1);
+    }
+
+    // Move the records into sorted order by following the cycles of the
+    // permutation, marking each position as it's filled.
+    std::vector<char> tmp(m_recordSize);
+    auto rec = [this](size_t i){ return m_records.data() + i * m_recordSize; };
+    for (size_t i = 0; i < m_count; ++i)
+    {
+        if (keys[i].m_id == i)
+            continue;
+        memcpy(tmp.data(), rec(i), m_recordSize);
+        size_t j = i;
+        while (true)
+        {
+            size_t k = keys[j].m_id;
+            keys[j].m_id = j;
+            if (k == i)
+            {
+                memcpy(rec(j), tmp.data(), m_recordSize);
+                break;
+            }
+            memcpy(rec(j), rec(k), m_recordSize);
+            j = k;
+        }
+    }
+}
+
+
+// Sort the buffered records and write them to a temporary file.
+void ExternalSorter::spill()
+{
+    sortRecords();
+
+    RunPtr run(new Run);
+    run->m_file = std::tmpfile();
+    if (!run->m_file)
+        throw pdal_error("Unable to create temporary file for sorting.");
+    if (fwrite(m_records.data(), m_recordSize, m_count, run->m_file) !=
+        m_count)
+        throw pdal_error("Unable to write temporary file for sorting.");
+    rewind(run->m_file);
+    m_runs.push_back(std::move(run));
+    m_count = 0;
+    if (m_runs.size() >= MaxRuns)
+        mergeRuns();
+}
+
+
+// Merge all the runs into a single run in a new temporary file.  The
+// merged run precedes any later runs, so insertion order is preserved.
+void ExternalSorter::mergeRuns()
+{
+    // The buffered records have been written, so their memory is
+    // reused by the read buffers.
+    std::vector<char>().swap(m_records);
+    readRuns();
+
+    RunPtr merged(new Run);
+    merged->m_file = std::tmpfile();
+    if (!merged->m_file)
+        throw pdal_error("Unable to create temporary file for sorting.");
+    std::vector<char>& buf = merged->m_buf;
+    buf.reserve(m_runs[0]->m_buf.size());
+    auto flush = [&buf, &merged]()
+    {
+        if (fwrite(buf.data(), 1, buf.size(), merged->m_file) != buf.size())
+            throw pdal_error("Unable to write temporary file for sorting.");
+        buf.clear();
+    };
+
+    while (m_heap.size())
+    {
+        size_t r = popRun();
+        Run& run = *m_runs[r];
+        if (buf.size() == buf.capacity())
+            flush();
+        buf.insert(buf.end(), run.current(), run.current() + m_recordSize);
+        run.advance(m_recordSize);
+        if (run.current())
+            pushRun(r);
+    }
+    flush();
+    std::vector<char>().swap(buf);
+    rewind(merged->m_file);
+
+    m_runs.clear();
+    m_runs.push_back(std::move(merged));
+}
+
+
+// Split the memory limit between the read buffers of the runs, fill the
+// buffers and put the runs on the heap.
+void ExternalSorter::readRuns()
+{
+    // One more buffer than there are runs, for the output of a merge.
+    size_t bufSize = m_memoryLimit / (m_runs.size() + 1);
+    bufSize = (std::max)((size_t)1, bufSize / m_recordSize) * m_recordSize;
+    m_heap.clear();
+    for (size_t r = 0; r < m_runs.size(); ++r)
+    {
+        Run& run = *m_runs[r];
+        run.m_buf.resize(bufSize);
+        run.fill(m_recordSize);
+        if (run.current())
+            pushRun(r);
+    }
+}
+
+
+void ExternalSorter::startMerge()
+{
+    m_merging = true;
+
+    if (m_runs.empty())
+    {
+        // Everything fit in memory.
+        sortRecords();
+        RunPtr run(new Run);
+        run->m_buf.swap(m_records);
+        run->m_end = m_count * m_recordSize;
+        m_runs.push_back(std::move(run));
+        if (m_runs[0]->current())
+            pushRun(0);
+    }
+    else
+    {
+        if (m_count)
+            spill();
+        std::vector<char>().swap(m_records);
+        readRuns();
+    }
+    m_count = 0;
+}
+
+
+// Compare records by key.  Records with equal keys are ordered by run,
+// which preserves insertion order since runs are written in order.
+bool ExternalSorter::less(const char *r1, size_t run1, const char *r2,
+    size_t run2) const
+{
+    for (size_t k = 0; k < m_numKeys; ++k)
+    {
+        uint64_t k1, k2;
+        memcpy(&k1, r1 + k * sizeof(uint64_t), sizeof(uint64_t));
+        memcpy(&k2, r2 + k * sizeof(uint64_t), sizeof(uint64_t));
+        if (k1 != k2)
+            return k1 < k2;
+    }
+    return run1 < run2;
+}
+
+
+void ExternalSorter::pushRun(size_t run)
+{
+    m_heap.push_back(run);
+    std::push_heap(m_heap.begin(), m_heap.end(), [this](size_t a, size_t b)
+        { return less(m_runs[b]->current(), b, m_runs[a]->current(), a); });
+}
+
+
+// Remove the run with the least current record from the heap.
+size_t ExternalSorter::popRun()
+{
+    std::pop_heap(m_heap.begin(), m_heap.end(), [this](size_t a, size_t b)
+        { return less(m_runs[b]->current(), b, m_runs[a]->current(), a); });
+    size_t r = m_heap.back();
+    m_heap.pop_back();
+    return r;
+}
+
+
+bool ExternalSorter::next(PointRef& point)
+{
+    if (!m_merging)
+        startMerge();
+    if (m_heap.empty())
+        return false;
+
+    size_t r = popRun();
+
+    Run& run = *m_runs[r];
+    point.setPackedData(m_dims, run.current() + m_numKeys * sizeof(uint64_t));
+    run.advance(m_recordSize);
+    if (run.current())
+        pushRun(r);
+    return true;
+}
+
+
+void ExternalSorter::clear()
+{
+    m_runs.clear();
+    m_heap.clear();
+    std::vector<char>().swap(m_records);
+    m_count = 0;
+    m_merging = false;
+}
+
+} // namespace pdal
+
@@ -0,0 +1,117 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <pdal/PointRef.hpp>
+
+namespace pdal
+{
+
+// Sorts points that may not fit in memory.  Points are added along with
+// one or more 64-bit keys and are retrieved in ascending lexicographic
+// order of their keys.  Points with equal keys are retrieved in the order
+// they were added.
+//
+// Points are stored in packed form.  When the memory limit is reached,
+// the stored points are sorted and written to a temporary file as a run.
+// Once all points have been added, the runs are merged.  If all points
+// fit in memory, no temporary files are used.  So that the number of open
+// temporary files stays bounded, the runs are merged into a single run
+// whenever there are MaxRuns of them.
+class PDAL_DLL ExternalSorter
+{
+public:
+    static const size_t MaxRuns = 256;
+
+    // \param dims  Dimensions/types to store for each point.
+    // \param numKeys  Number of keys for each point.
+    // \param memoryLimit  Approximate number of bytes to use for buffering
+    //   points.
+    ExternalSorter(const DimTypeList& dims, size_t numKeys,
+        size_t memoryLimit);
+    ~ExternalSorter();
+
+    // Add a point.
+    // \param keys  Array of the point's keys, most significant first.
+    // \param point  Point to add.
+    void add(const uint64_t *keys, const PointRef& point);
+
+    // Fill a point with the next point in sorted order.  Points may not be
+    // added once points have been retrieved until the sorter is cleared.
+    // \return  False if there are no more points.
+    bool next(PointRef& point);
+
+    // Number of sorted runs.  Once retrieval has started, a sorter whose
+    // points fit in memory has a single in-memory run.
+    size_t numRuns() const
+        { return m_runs.size(); }
+
+    // Discard all points and temporary files.
+    void clear();
+
+private:
+    struct Run;
+    typedef std::unique_ptr<Run> RunPtr;
+
+    ExternalSorter(const ExternalSorter&) = delete;
+    ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+    void sortRecords();
+    void spill();
+    void startMerge();
+    void mergeRuns();
+    void readRuns();
+    size_t popRun();
+    bool less(const char *r1, size_t run1, const char *r2, size_t run2) const;
+    void pushRun(size_t run);
+
+    DimTypeList m_dims;
+    size_t m_numKeys;
+    size_t m_recordSize;
+    size_t m_maxRecords;
+    size_t m_memoryLimit;
+    std::vector<char> m_records;
+    size_t m_count;
+    std::vector<RunPtr> m_runs;
+    std::vector<size_t> m_heap;
+    bool m_merging;
+};
+
+} // namespace pdal
+
@@ -0,0 +1,238 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "RadixSort.hpp"
+
+#include <algorithm>
+
+#include <pdal/util/ThreadPool.hpp>
+
+namespace pdal
+{
+namespace radix
+{
+
+namespace
+{
+
+// Don't bother splitting work into pieces smaller than this.
+const size_t MinChunkSize = 65536;
+
+
+template<typename T>
+void extract(const PointView& view, Dimension::Id dim, SortKeyList& keys,
+    size_t begin, size_t end, bool descending)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        T t;
+        view.getRawField(dim, keys[i].m_id, &t);
+        uint64_t key = toKey(t);
+        keys[i].m_key = descending ? ~key : key;
+    }
+}
+
+} // unnamed namespace
+
+
+size_t extractKeys(const PointView& view, Dimension::Id dim,
+    SortKeyList& keys, bool descending, size_t threads)
+{
+    Dimension::Type type = view.dimType(dim);
+
+    ThreadPool::parallelFor(threads, keys.size(), MinChunkSize,
+        [&view, dim, &keys, descending, type](size_t begin, size_t end)
+    {
+        switch (type)
+        {
+        case Dimension::Type::Float:
+            extract<float>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Double:
+            extract<double>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Signed8:
+            extract<int8_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Signed16:
+            extract<int16_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Signed32:
+            extract<int32_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Signed64:
+            extract<int64_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Unsigned8:
+            extract<uint8_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Unsigned16:
+            extract<uint16_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Unsigned32:
+            extract<uint32_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::Unsigned64:
+            extract<uint64_t>(view, dim, keys, begin, end, descending);
+            break;
+        case Dimension::Type::None:
+            break;
+        }
+    });
+    return Dimension::size(type);
+}
+
+
+uint64_t pointKey(const PointRef& point, Dimension::Id dim,
+    Dimension::Type type, bool descending)
+{
+    Everything e;
+    uint64_t key = 0;
+
+    point.getField((char *)&e, dim, type);
+    switch (type)
+    {
+    case Dimension::Type::Float:
+        key = toKey(e.f);
+        break;
+    case Dimension::Type::Double:
+        key = toKey(e.d);
+        break;
+    case Dimension::Type::Signed8:
+        key = toKey(e.s8);
+        break;
+    case Dimension::Type::Signed16:
+        key = toKey(e.s16);
+        break;
+    case Dimension::Type::Signed32:
+        key = toKey(e.s32);
+        break;
+    case Dimension::Type::Signed64:
+        key = toKey(e.s64);
+        break;
+    case Dimension::Type::Unsigned8:
+        key = toKey(e.u8);
+        break;
+    case Dimension::Type::Unsigned16:
+        key = toKey(e.u16);
+        break;
+    case Dimension::Type::Unsigned32:
+        key = toKey(e.u32);
+        break;
+    case Dimension::Type::Unsigned64:
+        key = toKey(e.u64);
+        break;
+    case Dimension::Type::None:
+        break;
+    }
+    return descending ? ~key : key;
+}
+
+
+void sort(SortKeyList& keys, size_t keyBytes, size_t threads)
+{
+    size_t n = keys.size();
+    if (n < 2)
+        return;
+
+    // Chunks are the ranges of parallelFor(), numbered in order.
+    ThreadPool pool(ThreadPool::numRanges(threads, n, MinChunkSize));
+    const size_t numChunks = pool.numRanges(n, MinChunkSize);
+    const size_t chunkSize = (n + numChunks - 1) / numChunks;
+
+    // Find the bits that differ between keys.  Bytes where no bits differ
+    // don't affect the order and need no pass.
+    std::vector<uint64_t> diffs(numChunks, 0);
+    pool.parallelFor(n, MinChunkSize,
+        [&keys, &diffs, chunkSize](size_t begin, size_t end)
+    {
+        size_t c = begin / chunkSize;
+        uint64_t first = keys[0].m_key;
+        uint64_t diff = 0;
+        for (size_t i = begin; i < end; ++i)
+            diff |= keys[i].m_key ^ first;
+        diffs[c] = diff;
+    });
+    uint64_t diff = 0;
+    for (uint64_t d : diffs)
+        diff |= d;
+
+    SortKeyList tmp(n);
+    std::vector<size_t> offsets(numChunks * 256);
+    for (size_t byte = 0; byte < (std::min)(keyBytes, sizeof(uint64_t));
+        ++byte)
+    {
+        int shift = (int)byte * 8;
+        if (((diff >> shift) & 0xFF) == 0)
+            continue;
+
+        // Count the keys in each bucket for each chunk.
+        std::fill(offsets.begin(), offsets.end(), 0);
+        pool.parallelFor(n, MinChunkSize,
+            [&keys, &offsets, shift, chunkSize](size_t begin, size_t end)
+        {
+            size_t c = begin / chunkSize;
+            size_t *counts = offsets.data() + c * 256;
+            for (size_t i = begin; i < end; ++i)
+                counts[(keys[i].m_key >> shift) & 0xFF]++;
+        });
+
+        // Convert the counts to starting positions.  Within a bucket,
+        // earlier chunks go first, which keeps the sort stable.
+        size_t pos = 0;
+        for (size_t bucket = 0; bucket < 256; ++bucket)
+            for (size_t c = 0; c < numChunks; ++c)
+            {
+                size_t& off = offsets[c * 256 + bucket];
+                size_t count = off;
+                off = pos;
+                pos += count;
+            }
+
+        pool.parallelFor(n, MinChunkSize,
+            [&keys, &tmp, &offsets, shift, chunkSize](size_t begin,
+                size_t end)
+        {
+            size_t c = begin / chunkSize;
+            size_t *off = offsets.data() + c * 256;
+            for (size_t i = begin; i < end; ++i)
+                tmp[off[(keys[i].m_key >> shift) & 0xFF]++] = keys[i];
+        });
+        keys.swap(tmp);
+    }
+}
+
+} // namespace radix
+} // namespace pdal
+
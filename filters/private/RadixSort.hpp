@@ -0,0 +1,112 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <pdal/PointView.hpp>
+
+namespace pdal
+{
+
+// A point ID along with a sort key.  The key is an unsigned integer that
+// orders the same way as the value from which it was made.
+struct SortKey
+{
+    uint64_t m_key;
+    PointId m_id;
+};
+typedef std::vector<SortKey> SortKeyList;
+
+namespace radix
+{
+
+// Stable LSD radix sort of keys, a byte at a time.  Only the low 'keyBytes'
+// bytes of each key are considered.  Bytes that are the same in every key
+// are skipped.  Large lists are histogrammed and scattered in parallel.
+PDAL_DLL void sort(SortKeyList& keys, size_t keyBytes, size_t threads);
+
+// Set the keys of a list of points from the value of a dimension.
+// \return  Number of significant bytes in the keys.
+PDAL_DLL size_t extractKeys(const PointView& view, Dimension::Id dim,
+    SortKeyList& keys, bool descending, size_t threads);
+
+// Make the key of a single point from the value of a dimension.
+PDAL_DLL uint64_t pointKey(const PointRef& point, Dimension::Id dim,
+    Dimension::Type type, bool descending);
+
+// Convert a value to a key that sorts in the same order.  Signed values
+// have their sign bit flipped.  Floating point values have their sign bit
+// flipped if positive and all bits flipped if negative.
+template<typename T>
+typename std::enable_if<std::is_unsigned<T>::value, uint64_t>::type
+toKey(T v)
+{
+    return v;
+}
+
+template<typename T>
+typename std::enable_if<std::is_signed<T>::value &&
+    std::is_integral<T>::value, uint64_t>::type
+toKey(T v)
+{
+    typedef typename std::make_unsigned<T>::type U;
+
+    return (U)((U)v ^ ((U)1 << (8 * sizeof(T) - 1)));
+}
+
+inline uint64_t toKey(float v)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x80000000) ? (uint32_t)~bits : (bits | 0x80000000);
+}
+
+inline uint64_t toKey(double v)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &v, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits :
+        (bits | 0x8000000000000000ULL);
+}
+
+} // namespace radix
+} // namespace pdal
+
@@ -0,0 +1,371 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "Selection.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
+#include <pdal/util/ThreadPool.hpp>
+
+namespace pdal
+{
+
+namespace selection
+{
+
+namespace
+{
+
+const size_t NumBuckets = 4096;
+const point_count_t MaxCollect = 1 << 20;
+const size_t MaxLevels = 16;
+const point_count_t BlockSize = 16384;
+
+// A bucket chosen by a previous scan.  Only values that fall in the chosen
+// bucket of every level are still candidates.
+struct Level
+{
+    double m_lo;
+    double m_scale;
+    size_t m_bucket;
+
+    size_t bucket(double v) const
+    {
+        double b = (v - m_lo) * m_scale;
+        if (!(b > 0))
+            return 0;
+        return (std::min)((size_t)b, NumBuckets - 1);
+    }
+};
+
+bool candidate(const std::vector<Level>& levels, double v)
+{
+    for (const Level& l : levels)
+        if (l.bucket(v) != l.m_bucket)
+            return false;
+    return true;
+}
+
+} // unnamed namespace
+
+
+double select(const Scan& scan, double quantile)
+{
+    std::mutex mutex;
+
+    double lo = (std::numeric_limits<double>::max)();
+    double hi = std::numeric_limits<double>::lowest();
+    point_count_t count = 0;
+    scan([&](const double *vals, size_t n)
+    {
+        double blockLo = (std::numeric_limits<double>::max)();
+        double blockHi = std::numeric_limits<double>::lowest();
+        point_count_t blockCount = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (std::isnan(vals[i]))
+                continue;
+            blockLo = (std::min)(blockLo, vals[i]);
+            blockHi = (std::max)(blockHi, vals[i]);
+            blockCount++;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        lo = (std::min)(lo, blockLo);
+        hi = (std::max)(hi, blockHi);
+        count += blockCount;
+    });
+    if (count == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+    point_count_t k = (std::min)((point_count_t)(count * quantile),
+        count - 1);
+
+    // Values known to be less than all candidates.
+    point_count_t below = 0;
+    std::vector<Level> levels;
+    while (lo < hi && count > MaxCollect && levels.size() < MaxLevels)
+    {
+        Level level { lo, NumBuckets / (hi - lo), 0 };
+        if (!std::isfinite(level.m_scale))
+            break;
+
+        std::vector<point_count_t> counts(NumBuckets);
+        std::vector<double> mins(NumBuckets,
+            (std::numeric_limits<double>::max)());
+        std::vector<double> maxs(NumBuckets,
+            std::numeric_limits<double>::lowest());
+        scan([&](const double *vals, size_t n)
+        {
+            std::vector<point_count_t> c(NumBuckets);
+            std::vector<double> bmin(NumBuckets,
+                (std::numeric_limits<double>::max)());
+            std::vector<double> bmax(NumBuckets,
+                std::numeric_limits<double>::lowest());
+            for (size_t i = 0; i < n; ++i)
+            {
+                double v = vals[i];
+                if (std::isnan(v) || !candidate(levels, v))
+                    continue;
+                size_t b = level.bucket(v);
+                c[b]++;
+                bmin[b] = (std::min)(bmin[b], v);
+                bmax[b] = (std::max)(bmax[b], v);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t b = 0; b < NumBuckets; ++b)
+            {
+                counts[b] += c[b];
+                mins[b] = (std::min)(mins[b], bmin[b]);
+                maxs[b] = (std::max)(maxs[b], bmax[b]);
+            }
+        });
+
+        size_t b = 0;
+        while (below + counts[b] <= k)
+            below += counts[b++];
+        level.m_bucket = b;
+        levels.push_back(level);
+        count = counts[b];
+        lo = mins[b];
+        hi = maxs[b];
+    }
+    if (lo == hi)
+        return lo;
+
+    std::vector<double> vals;
+    scan([&](const double *v, size_t n)
+    {
+        std::vector<double> found;
+        for (size_t i = 0; i < n; ++i)
+            if (!std::isnan(v[i]) && candidate(levels, v[i]))
+                found.push_back(v[i]);
+        std::lock_guard<std::mutex> lock(mutex);
+        vals.insert(vals.end(), found.begin(), found.end());
+    });
+    auto kth = vals.begin() + (k - below);
+    std::nth_element(vals.begin(), kth, vals.end());
+    return *kth;
+}
+
+
+Scan viewScan(const PointView& view, Dimension::Id dim, size_t threads)
+{
+    return [&view, dim, threads](const BlockFunc& f)
+    {
+        ThreadPool::parallelFor(threads, view.size(), BlockSize,
+            [&view, &f, dim](PointId begin, PointId end)
+        {
+            std::vector<double> vals(BlockSize);
+            for (PointId i = begin; i < end; i += BlockSize)
+            {
+                size_t n = (size_t)(std::min)(BlockSize, end - i);
+                for (size_t j = 0; j < n; ++j)
+                    vals[j] = view.getFieldAs<double>(dim, i + j);
+                f(vals.data(), n);
+            }
+        });
+    };
+}
+
+
+Scan transform(const Scan& scan, const std::function<double(double)>& xform)
+{
+    return [scan, xform](const BlockFunc& f)
+    {
+        scan([&f, &xform](const double *vals, size_t n)
+        {
+            std::vector<double> out(n);
+            for (size_t i = 0; i < n; ++i)
+                out[i] = xform(vals[i]);
+            f(out.data(), n);
+        });
+    };
+}
+
+} // namespace selection
+
+
+RetainedPoints::RetainedPoints(const DimTypeList& dims, Dimension::Id dim,
+        size_t memoryLimit) : m_dims(dims), m_dim(dim), m_count(0),
+    m_size(0), m_spilled(0), m_file(nullptr), m_reading(false)
+{
+    m_recordSize = sizeof(double);
+    for (auto& dt : m_dims)
+        m_recordSize += Dimension::size(dt.m_type);
+    m_maxRecords = (std::max)((size_t)1, memoryLimit / m_recordSize);
+}
+
+
+RetainedPoints::~RetainedPoints()
+{
+    if (m_file)
+        fclose(m_file);
+}
+
+
+void RetainedPoints::add(const PointRef& point)
+{
+    if (m_reading)
+        throw pdal_error("Can't add points once points have been "
+            "retrieved.");
+
+    if (m_count == m_maxRecords)
+        spill();
+
+    // Grow the buffer geometrically, but not beyond the memory limit.
+    size_t needed = (m_count + 1) * m_recordSize;
+    if (m_records.capacity() < needed)
+        m_records.reserve((std::min)(m_maxRecords * m_recordSize,
+            (std::max)(m_records.capacity() * 2, 1024 * m_recordSize)));
+    m_records.resize(needed);
+
+    char *rec = m_records.data() + m_count * m_recordSize;
+    double value = point.getFieldAs<double>(m_dim);
+    memcpy(rec, &value, sizeof(double));
+    point.getPackedData(m_dims, rec + sizeof(double));
+    m_count++;
+    m_size++;
+}
+
+
+// Append the records held in memory to the temporary file.
+void RetainedPoints::spill()
+{
+    if (!m_file)
+    {
+        m_file = std::tmpfile();
+        if (!m_file)
+            throw pdal_error("Unable to create temporary file for points.");
+    }
+    fseek(m_file, 0, SEEK_END);
+    if (fwrite(m_records.data(), m_recordSize, m_count, m_file) != m_count)
+        throw pdal_error("Unable to write temporary file for points.");
+    m_spilled += m_count;
+    m_count = 0;
+}
+
+
+void RetainedPoints::rewindFile()
+{
+    if (m_file)
+        fseek(m_file, 0, SEEK_SET);
+    m_fileLeft = m_spilled;
+    m_buf.resize((std::max)((size_t)1, (size_t)(1 << 20) / m_recordSize) *
+        m_recordSize);
+    m_bufPos = 0;
+    m_bufEnd = 0;
+}
+
+
+// Read the next buffer of records from the temporary file.
+// \return  Number of records read.
+size_t RetainedPoints::readRecords()
+{
+    size_t n = (size_t)(std::min)((point_count_t)(m_buf.size() /
+        m_recordSize), m_fileLeft);
+    if (n && fread(m_buf.data(), m_recordSize, n, m_file) != n)
+        throw pdal_error("Unable to read temporary file for points.");
+    m_fileLeft -= n;
+    m_bufPos = 0;
+    m_bufEnd = n * m_recordSize;
+    return n;
+}
+
+
+selection::Scan RetainedPoints::scan()
+{
+    return [this](const selection::BlockFunc& f)
+    {
+        std::vector<double> vals;
+
+        auto values = [this, &vals, &f](const char *recs, size_t n)
+        {
+            vals.resize(n);
+            for (size_t i = 0; i < n; ++i)
+                memcpy(&vals[i], recs + i * m_recordSize, sizeof(double));
+            f(vals.data(), n);
+        };
+
+        rewindFile();
+        while (size_t n = readRecords())
+            values(m_buf.data(), n);
+        if (m_count)
+            values(m_records.data(), m_count);
+    };
+}
+
+
+bool RetainedPoints::next(PointRef& point, double& value)
+{
+    if (!m_reading)
+    {
+        m_reading = true;
+        rewindFile();
+        m_memPos = 0;
+    }
+
+    const char *rec;
+    if (m_bufPos < m_bufEnd || readRecords())
+    {
+        rec = m_buf.data() + m_bufPos;
+        m_bufPos += m_recordSize;
+    }
+    else if (m_memPos < m_count)
+        rec = m_records.data() + m_recordSize * m_memPos++;
+    else
+        return false;
+
+    memcpy(&value, rec, sizeof(double));
+    point.setPackedData(m_dims, rec + sizeof(double));
+    return true;
+}
+
+
+void RetainedPoints::clear()
+{
+    if (m_file)
+        fclose(m_file);
+    m_file = nullptr;
+    std::vector<char>().swap(m_records);
+    std::vector<char>().swap(m_buf);
+    m_count = 0;
+    m_size = 0;
+    m_spilled = 0;
+    m_reading = false;
+}
+
+} // namespace pdal
@@ -0,0 +1,140 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <pdal/PointView.hpp>
+
+namespace pdal
+{
+
+namespace selection
+{
+
+// Receives a block of values.  May be called concurrently from several
+// threads.
+typedef std::function<void(const double *, size_t)> BlockFunc;
+
+// Passes every value of a set to a BlockFunc, a block at a time.  A scan
+// must produce the same values each time it's run.
+typedef std::function<void(const BlockFunc&)> Scan;
+
+// Find the value at a quantile of a set without holding the set in memory.
+// Each scan histograms the values in the range known to contain the value
+// and narrows the range to a single bucket, until few enough values remain
+// to be selected in memory.  The result is exact.  NaN values are ignored.
+// \param scan  Scan of the values.
+// \param quantile  Quantile of the value to find, in [0, 1).  The value
+//   found is the k'th smallest (zero-based), where k is the quantile times
+//   the number of values, rounded down.
+// \return  The value found, or NaN if the set holds no values.
+PDAL_DLL double select(const Scan& scan, double quantile);
+
+// Scan of the values of a dimension of a view.  Ranges of points are
+// scanned in parallel.
+PDAL_DLL Scan viewScan(const PointView& view, Dimension::Id dim,
+    size_t threads);
+
+// Scan of the values of another scan, transformed.
+PDAL_DLL Scan transform(const Scan& scan,
+    const std::function<double(double)>& xform);
+
+} // namespace selection
+
+// Points retained by a blocking streaming filter, along with the value of a
+// dimension for each, so that the values can be scanned more than once
+// before the points are retrieved.  Points beyond a memory limit are
+// written to a temporary file.  Points are retrieved in the order they
+// were added.
+class PDAL_DLL RetainedPoints
+{
+public:
+    // \param dims  Dimensions/types to store for each point.
+    // \param dim  Dimension whose values are scanned.
+    // \param memoryLimit  Approximate number of bytes of points to hold in
+    //   memory.
+    RetainedPoints(const DimTypeList& dims, Dimension::Id dim,
+        size_t memoryLimit);
+    ~RetainedPoints();
+
+    // Add a point.
+    void add(const PointRef& point);
+
+    // Number of points added.
+    point_count_t size() const
+        { return m_size; }
+
+    // Scan of the values of the points.
+    selection::Scan scan();
+
+    // Fill a point with the next retained point.
+    // \param value  Set to the value of the point's dimension.
+    // \return  False if there are no more points.
+    bool next(PointRef& point, double& value);
+
+    // Discard all points.
+    void clear();
+
+private:
+    RetainedPoints(const RetainedPoints&) = delete;
+    RetainedPoints& operator=(const RetainedPoints&) = delete;
+
+    void spill();
+    void rewindFile();
+    size_t readRecords();
+
+    DimTypeList m_dims;
+    Dimension::Id m_dim;
+    size_t m_recordSize;
+    size_t m_maxRecords;
+    std::vector<char> m_records;    // Records held in memory.
+    size_t m_count;                 // Number of records in memory.
+    point_count_t m_size;
+    point_count_t m_spilled;        // Number of records in the file.
+    FILE *m_file;
+
+    // Retrieval state.
+    bool m_reading;
+    std::vector<char> m_buf;
+    size_t m_bufPos;
+    size_t m_bufEnd;
+    point_count_t m_fileLeft;
+    size_t m_memPos;
+};
+
+} // namespace pdal
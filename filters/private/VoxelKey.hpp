@@ -0,0 +1,70 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pdal
+{
+
+// Integer coordinates of a cell in a regular 3D grid.
+struct VoxelKey
+{
+    int64_t m_x;
+    int64_t m_y;
+    int64_t m_z;
+
+    bool operator==(const VoxelKey& other) const
+    {
+        return m_x == other.m_x && m_y == other.m_y &&
+            m_z == other.m_z;
+    }
+};
+
+// Mixes all three coordinates so that neighbouring cells spread across
+// the buckets of an unordered container.
+struct VoxelKeyHash
+{
+    size_t operator()(const VoxelKey& k) const
+    {
+        uint64_t h = (uint64_t)k.m_x * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 29)) + (uint64_t)k.m_y * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 29)) + (uint64_t)k.m_z * 0x94D049BB133111EBULL;
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+} // namespace pdal
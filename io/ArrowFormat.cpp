@@ -0,0 +1,702 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ArrowFormat.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Values of the enumerations and unions in the Arrow flatbuffer schemas
+// (Schema.fbs, Message.fbs and File.fbs).
+const int16_t MetadataV5 = 4;
+
+const int16_t EndianLittle = 0;
+const int16_t EndianBig = 1;
+
+const uint8_t TypeNull = 1;
+const uint8_t TypeInt = 2;
+const uint8_t TypeFloatingPoint = 3;
+const uint8_t TypeBinary = 4;
+const uint8_t TypeUtf8 = 5;
+const uint8_t TypeBool = 6;
+const uint8_t TypeDecimal = 7;
+const uint8_t TypeDate = 8;
+const uint8_t TypeTime = 9;
+const uint8_t TypeTimestamp = 10;
+const uint8_t TypeInterval = 11;
+const uint8_t TypeList = 12;
+const uint8_t TypeStruct = 13;
+const uint8_t TypeUnion = 14;
+const uint8_t TypeFixedSizeBinary = 15;
+const uint8_t TypeFixedSizeList = 16;
+const uint8_t TypeMap = 17;
+const uint8_t TypeDuration = 18;
+const uint8_t TypeLargeBinary = 19;
+const uint8_t TypeLargeUtf8 = 20;
+const uint8_t TypeLargeList = 21;
+const uint8_t TypeRunEndEncoded = 22;
+
+// Deepest nesting of child fields accepted in a schema.
+const int MaxFieldDepth = 64;
+
+const int16_t PrecisionSingle = 1;
+const int16_t PrecisionDouble = 2;
+
+const uint8_t HeaderSchema = 1;
+const uint8_t HeaderRecordBatch = 3;
+
+bool hostIsLittleEndian()
+{
+    const uint16_t one(1);
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+// Copy a scalar to or from little-endian flatbuffer data.
+template<typename T>
+void copyLe(void *dst, const void *src)
+{
+    if (hostIsLittleEndian())
+        memcpy(dst, src, sizeof(T));
+    else
+        std::reverse_copy((const char *)src, (const char *)src + sizeof(T),
+            (char *)dst);
+}
+
+
+// Flatbuffers are normally built back to front.  This builder lays data
+// out front to back instead, so tables are written before the objects
+// they refer to, which keeps all references pointing forward as required.
+class FbBuilder
+{
+public:
+    FbBuilder()
+        { put<uint32_t>(0); }  // Offset to the root table.
+
+    size_t size() const
+        { return m_buf.size(); }
+
+    void pad(size_t count)
+        { m_buf.insert(m_buf.end(), count, 0); }
+
+    void align(size_t alignment)
+        { pad((alignment - m_buf.size() % alignment) % alignment); }
+
+    template<typename T>
+    size_t put(T v)
+    {
+        size_t pos = m_buf.size();
+        pad(sizeof(T));
+        patch(pos, v);
+        return pos;
+    }
+
+    template<typename T>
+    void patch(size_t pos, T v)
+        { copyLe<T>(m_buf.data() + pos, &v); }
+
+    size_t putString(const std::string& s)
+    {
+        align(4);
+        size_t pos = put<uint32_t>((uint32_t)s.size());
+        m_buf.insert(m_buf.end(), s.begin(), s.end());
+        m_buf.push_back(0);
+        return pos;
+    }
+
+    // Start a vector whose elements are aligned to eight bytes.
+    size_t startVector8(size_t count)
+    {
+        align(4);
+        if (m_buf.size() % 8 == 0)
+            pad(4);
+        return put<uint32_t>((uint32_t)count);
+    }
+
+    std::vector<char> finish(size_t root)
+    {
+        patch<uint32_t>(0, (uint32_t)root);
+        align(8);
+        return m_buf;
+    }
+
+private:
+    std::vector<char> m_buf;
+};
+
+
+class FbTable
+{
+public:
+    typedef std::function<size_t(FbBuilder&)> ChildWriter;
+
+    template<typename T>
+    FbTable& add(int id, T value)
+    {
+        Field f(id, sizeof(T));
+        memcpy(&f.m_value, &value, sizeof(T));
+        m_fields.push_back(f);
+        return *this;
+    }
+
+    // Add a field that refers to an object written by 'writer'.
+    FbTable& addChild(int id, ChildWriter writer)
+    {
+        Field f(id, sizeof(uint32_t));
+        f.m_child = writer;
+        m_fields.push_back(f);
+        return *this;
+    }
+
+    size_t write(FbBuilder& b) const;
+
+private:
+    struct Field
+    {
+        Field(int id, size_t size) : m_id(id), m_size(size), m_value(0)
+        {}
+
+        int m_id;
+        size_t m_size;
+        uint64_t m_value;
+        ChildWriter m_child;
+    };
+
+    std::vector<Field> m_fields;
+};
+
+
+size_t FbTable::write(FbBuilder& b) const
+{
+    // Place larger fields first so that all are naturally aligned.
+    std::vector<const Field *> fields;
+    for (const Field& f : m_fields)
+        fields.push_back(&f);
+    std::stable_sort(fields.begin(), fields.end(),
+        [](const Field *f1, const Field *f2)
+        { return f1->m_size > f2->m_size; });
+
+    int slots = 0;
+    for (const Field *f : fields)
+        slots = (std::max)(slots, f->m_id + 1);
+    std::vector<uint16_t> offsets(slots);
+    size_t tableSize = sizeof(int32_t);
+    for (const Field *f : fields)
+    {
+        offsets[f->m_id] = (uint16_t)tableSize;
+        tableSize += f->m_size;
+    }
+    bool wide = fields.size() && fields.front()->m_size == 8;
+
+    // The vtable precedes the table.
+    b.align(2);
+    size_t vtable = b.put<uint16_t>((uint16_t)(4 + 2 * slots));
+    b.put<uint16_t>((uint16_t)tableSize);
+    for (uint16_t offset : offsets)
+        b.put<uint16_t>(offset);
+
+    // Eight-byte fields start just after the vtable offset.
+    b.align(4);
+    if (wide && b.size() % 8 != 4)
+        b.pad(4);
+    size_t table = b.put<int32_t>((int32_t)(b.size() - vtable));
+    b.pad(tableSize - sizeof(int32_t));
+    for (const Field *f : fields)
+    {
+        size_t pos = table + offsets[f->m_id];
+        switch (f->m_size)
+        {
+        case 1:
+            b.patch<uint8_t>(pos, (uint8_t)f->m_value);
+            break;
+        case 2:
+            b.patch<uint16_t>(pos, (uint16_t)f->m_value);
+            break;
+        case 4:
+            b.patch<uint32_t>(pos, (uint32_t)f->m_value);
+            break;
+        case 8:
+            b.patch<uint64_t>(pos, f->m_value);
+            break;
+        }
+    }
+
+    for (const Field *f : fields)
+        if (f->m_child)
+        {
+            size_t pos = table + offsets[f->m_id];
+            size_t child = f->m_child(b);
+            b.patch<uint32_t>(pos, (uint32_t)(child - pos));
+        }
+    return table;
+}
+
+
+size_t putTables(FbBuilder& b, const std::vector<FbTable>& tables)
+{
+    b.align(4);
+    size_t vec = b.put<uint32_t>((uint32_t)tables.size());
+    size_t slots = b.size();
+    b.pad(tables.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < tables.size(); ++i)
+    {
+        size_t slot = slots + i * sizeof(uint32_t);
+        size_t table = tables[i].write(b);
+        b.patch<uint32_t>(slot, (uint32_t)(table - slot));
+    }
+    return vec;
+}
+
+
+FbTable fieldTable(const ArrowColumn& column)
+{
+    FbTable field;
+
+    field.addChild(0, [&column](FbBuilder& b)
+        { return b.putString(column.m_name); });
+    field.add<uint8_t>(1, column.m_nullable);
+
+    Dimension::Type type = column.m_type;
+    if (type == Dimension::Type::None)
+        throw ArrowFormat::error("Can't write column '" + column.m_name +
+            "' without a type.");
+    if (Dimension::base(type) == Dimension::BaseType::Floating)
+    {
+        field.add<uint8_t>(2, TypeFloatingPoint);
+        field.addChild(3, [type](FbBuilder& b)
+        {
+            FbTable t;
+            t.add<int16_t>(0, type == Dimension::Type::Float ?
+                PrecisionSingle : PrecisionDouble);
+            return t.write(b);
+        });
+    }
+    else
+    {
+        field.add<uint8_t>(2, TypeInt);
+        field.addChild(3, [type](FbBuilder& b)
+        {
+            FbTable t;
+            t.add<int32_t>(0, (int32_t)(Dimension::size(type) * 8));
+            t.add<uint8_t>(1,
+                Dimension::base(type) == Dimension::BaseType::Signed);
+            return t.write(b);
+        });
+    }
+    // Readers expect a children vector, even if it's empty.
+    field.addChild(5, [](FbBuilder& b)
+        { return putTables(b, std::vector<FbTable>()); });
+    return field;
+}
+
+
+size_t putSchema(FbBuilder& b, const ArrowColumnList& columns,
+    bool littleEndian)
+{
+    FbTable schema;
+
+    schema.add<int16_t>(0, littleEndian ? EndianLittle : EndianBig);
+    schema.addChild(1, [&columns](FbBuilder& b)
+    {
+        std::vector<FbTable> fields;
+        for (const ArrowColumn& c : columns)
+            fields.push_back(fieldTable(c));
+        return putTables(b, fields);
+    });
+    return schema.write(b);
+}
+
+
+std::vector<char> message(uint8_t headerType, FbTable::ChildWriter header,
+    uint64_t bodyLength)
+{
+    FbBuilder b;
+    FbTable msg;
+
+    msg.add<int16_t>(0, MetadataV5);
+    msg.add<uint8_t>(1, headerType);
+    msg.addChild(2, header);
+    msg.add<int64_t>(3, (int64_t)bodyLength);
+    return b.finish(msg.write(b));
+}
+
+
+// Reads little-endian flatbuffer data, checking that every access is in
+// bounds.
+class FbReader
+{
+public:
+    FbReader(const char *buf, size_t size) : m_buf(buf), m_size(size)
+    {}
+
+    void check(size_t pos, size_t size) const
+    {
+        if (pos > m_size || size > m_size - pos)
+            throw ArrowFormat::error("Invalid Arrow file metadata.");
+    }
+
+    template<typename T>
+    T read(size_t pos) const
+    {
+        check(pos, sizeof(T));
+        T v;
+        copyLe<T>(&v, m_buf + pos);
+        return v;
+    }
+
+    // Follow the offset stored at 'pos'.
+    size_t offset(size_t pos) const
+    {
+        size_t target = pos + read<uint32_t>(pos);
+        check(target, 0);
+        return target;
+    }
+
+private:
+    const char *m_buf;
+    size_t m_size;
+};
+
+
+class FbTableRef
+{
+public:
+    FbTableRef(const FbReader& r, size_t pos) : m_r(r), m_pos(pos)
+    {
+        int64_t vtable = (int64_t)pos - m_r.read<int32_t>(pos);
+        if (vtable < 0)
+            throw ArrowFormat::error("Invalid Arrow file metadata.");
+        m_vtable = (size_t)vtable;
+        m_vtableSize = m_r.read<uint16_t>(m_vtable);
+    }
+
+    // Position of a field, or 0 if it's not present.
+    size_t field(int id) const
+    {
+        size_t entry = 4 + 2 * id;
+        if (entry + 2 > m_vtableSize)
+            return 0;
+        uint16_t offset = m_r.read<uint16_t>(m_vtable + entry);
+        return offset ? m_pos + offset : 0;
+    }
+
+    template<typename T>
+    T get(int id, T def) const
+    {
+        size_t pos = field(id);
+        return pos ? m_r.read<T>(pos) : def;
+    }
+
+    FbTableRef table(int id) const
+    {
+        size_t pos = field(id);
+        if (!pos)
+            throw ArrowFormat::error("Missing table in Arrow file metadata.");
+        return FbTableRef(m_r, m_r.offset(pos));
+    }
+
+    // Position of the first element of a vector.  'count' is set to the
+    // number of elements, zero if the vector isn't present.
+    size_t vector(int id, size_t eltSize, size_t& count) const
+    {
+        count = 0;
+        size_t pos = field(id);
+        if (!pos)
+            return 0;
+        size_t vec = m_r.offset(pos);
+        count = m_r.read<uint32_t>(vec);
+        m_r.check(vec + 4, count * eltSize);
+        return vec + 4;
+    }
+
+    FbTableRef tableElement(size_t vec, size_t i) const
+        { return FbTableRef(m_r, m_r.offset(vec + 4 * i)); }
+
+    std::string string(int id) const
+    {
+        size_t count;
+        size_t pos = vector(id, 1, count);
+        std::string s(count, ' ');
+        for (size_t i = 0; i < count; ++i)
+            s[i] = m_r.read<char>(pos + i);
+        return s;
+    }
+
+private:
+    const FbReader& m_r;
+    size_t m_pos;
+    size_t m_vtable;
+    uint16_t m_vtableSize;
+};
+
+
+// Fill in the type and the node and buffer counts of a column.
+void parseField(const FbTableRef& field, ArrowColumn& column, int depth = 0)
+{
+    if (depth > MaxFieldDepth)
+        throw ArrowFormat::error("Arrow schema is nested too deeply.");
+
+    column.m_name = field.string(0);
+    column.m_nullable = field.get<uint8_t>(1, 0);
+    column.m_type = Dimension::Type::None;
+    column.m_nodeCount = 1;
+
+    uint8_t type = field.get<uint8_t>(2, 0);
+    switch (type)
+    {
+    case TypeNull:
+        column.m_bufferCount = 0;
+        break;
+    case TypeInt:
+    {
+        FbTableRef t = field.table(3);
+        int32_t bits = t.get<int32_t>(0, 0);
+        bool isSigned = t.get<uint8_t>(1, 0);
+        if (bits == 8 || bits == 16 || bits == 32 || bits == 64)
+            column.m_type = Dimension::type((isSigned ? "int" : "uint") +
+                std::to_string(bits));
+        column.m_bufferCount = 2;
+        break;
+    }
+    case TypeFloatingPoint:
+    {
+        int16_t precision = field.table(3).get<int16_t>(0, 0);
+        if (precision == PrecisionSingle)
+            column.m_type = Dimension::Type::Float;
+        else if (precision == PrecisionDouble)
+            column.m_type = Dimension::Type::Double;
+        column.m_bufferCount = 2;
+        break;
+    }
+    case TypeBool:
+    case TypeDecimal:
+    case TypeDate:
+    case TypeTime:
+    case TypeTimestamp:
+    case TypeInterval:
+    case TypeFixedSizeBinary:
+    case TypeDuration:
+    case TypeList:
+    case TypeLargeList:
+    case TypeMap:
+        column.m_bufferCount = 2;
+        break;
+    case TypeBinary:
+    case TypeUtf8:
+    case TypeLargeBinary:
+    case TypeLargeUtf8:
+        column.m_bufferCount = 3;
+        break;
+    case TypeStruct:
+    case TypeFixedSizeList:
+        column.m_bufferCount = 1;
+        break;
+    case TypeUnion:
+        // Sparse unions have a type buffer, dense ones an offset buffer too.
+        column.m_bufferCount = 1 + field.table(3).get<int16_t>(0, 0);
+        break;
+    case TypeRunEndEncoded:
+        column.m_bufferCount = 0;
+        break;
+    default:
+        throw ArrowFormat::error("Unsupported type for Arrow column '" +
+            column.m_name + "'.");
+    }
+
+    // Dictionary-encoded values are stored elsewhere.
+    if (field.field(4))
+        column.m_type = Dimension::Type::None;
+
+    size_t count;
+    size_t children = field.vector(5, 4, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ArrowColumn child;
+        parseField(field.tableElement(children, i), child, depth + 1);
+        column.m_nodeCount += child.m_nodeCount;
+        column.m_bufferCount += child.m_bufferCount;
+    }
+    if (count)
+        column.m_type = Dimension::Type::None;
+}
+
+} // unnamed namespace
+
+
+namespace ArrowFormat
+{
+
+std::vector<char> schemaMessage(const ArrowColumnList& columns,
+    bool littleEndian)
+{
+    return message(HeaderSchema, [&](FbBuilder& b)
+        { return putSchema(b, columns, littleEndian); }, 0);
+}
+
+
+std::vector<char> recordBatchMessage(const ArrowRecordBatch& batch)
+{
+    auto header = [&batch](FbBuilder& b)
+    {
+        FbTable t;
+        t.add<int64_t>(0, (int64_t)batch.m_length);
+        t.addChild(1, [&batch](FbBuilder& b)
+        {
+            size_t vec = b.startVector8(batch.m_nodes.size());
+            for (const ArrowFieldNode& node : batch.m_nodes)
+            {
+                b.put<int64_t>((int64_t)node.m_length);
+                b.put<int64_t>((int64_t)node.m_nullCount);
+            }
+            return vec;
+        });
+        t.addChild(2, [&batch](FbBuilder& b)
+        {
+            size_t vec = b.startVector8(batch.m_buffers.size());
+            for (const ArrowBuffer& buf : batch.m_buffers)
+            {
+                b.put<int64_t>((int64_t)buf.m_offset);
+                b.put<int64_t>((int64_t)buf.m_length);
+            }
+            return vec;
+        });
+        return t.write(b);
+    };
+    return message(HeaderRecordBatch, header, batch.m_bodyLength);
+}
+
+
+std::vector<char> footer(const ArrowColumnList& columns, bool littleEndian,
+    const ArrowBlockList& batches)
+{
+    FbBuilder b;
+    FbTable footer;
+
+    auto putBlocks = [](FbBuilder& b, const ArrowBlockList& blocks)
+    {
+        size_t vec = b.startVector8(blocks.size());
+        for (const ArrowBlock& block : blocks)
+        {
+            b.put<int64_t>((int64_t)block.m_offset);
+            b.put<int32_t>(block.m_metadataLength);
+            b.pad(4);
+            b.put<int64_t>((int64_t)block.m_bodyLength);
+        }
+        return vec;
+    };
+
+    footer.add<int16_t>(0, MetadataV5);
+    footer.addChild(1, [&](FbBuilder& b)
+        { return putSchema(b, columns, littleEndian); });
+    footer.addChild(2, [&](FbBuilder& b)
+        { return putBlocks(b, ArrowBlockList()); });
+    footer.addChild(3, [&](FbBuilder& b)
+        { return putBlocks(b, batches); });
+    return b.finish(footer.write(b));
+}
+
+
+ArrowFooter parseFooter(const char *buf, size_t size)
+{
+    ArrowFooter footer;
+    FbReader r(buf, size);
+    FbTableRef table(r, r.offset(0));
+
+    FbTableRef schema = table.table(1);
+    footer.m_littleEndian = (schema.get<int16_t>(0, EndianLittle) ==
+        EndianLittle);
+
+    size_t count;
+    size_t fields = schema.vector(1, 4, count);
+    size_t nodeIndex = 0;
+    size_t bufferIndex = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        ArrowColumn column;
+        parseField(schema.tableElement(fields, i), column);
+        column.m_nodeIndex = nodeIndex;
+        column.m_bufferIndex = bufferIndex;
+        nodeIndex += column.m_nodeCount;
+        bufferIndex += column.m_bufferCount;
+        footer.m_columns.push_back(column);
+    }
+
+    // Blocks are 24 bytes: offset, metadata length, padding, body length.
+    size_t blocks = table.vector(3, 24, count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t pos = blocks + i * 24;
+        footer.m_batches.emplace_back(r.read<int64_t>(pos),
+            r.read<int32_t>(pos + 8), r.read<int64_t>(pos + 16));
+    }
+    return footer;
+}
+
+
+ArrowRecordBatch parseRecordBatch(const char *buf, size_t size)
+{
+    ArrowRecordBatch batch;
+    FbReader r(buf, size);
+    FbTableRef msg(r, r.offset(0));
+
+    if (msg.get<uint8_t>(1, 0) != HeaderRecordBatch)
+        throw error("Arrow message isn't a record batch.");
+    batch.m_bodyLength = msg.get<int64_t>(3, 0);
+
+    FbTableRef header = msg.table(2);
+    if (header.field(3))
+        throw error("Compressed Arrow record batches aren't supported.");
+    batch.m_length = header.get<int64_t>(0, 0);
+
+    size_t count;
+    size_t nodes = header.vector(1, 16, count);
+    for (size_t i = 0; i < count; ++i)
+        batch.m_nodes.emplace_back(r.read<int64_t>(nodes + i * 16),
+            r.read<int64_t>(nodes + i * 16 + 8));
+    size_t buffers = header.vector(2, 16, count);
+    for (size_t i = 0; i < count; ++i)
+        batch.m_buffers.emplace_back(r.read<int64_t>(buffers + i * 16),
+            r.read<int64_t>(buffers + i * 16 + 8));
+    return batch;
+}
+
+} // namespace ArrowFormat
+
+} // namespace pdal
@@ -0,0 +1,178 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pdal/Dimension.hpp>
+#include <pdal/pdal_export.hpp>
+
+namespace pdal
+{
+
+// Support for the Arrow IPC file format (also known as Feather V2).
+// Only the parts of the format needed to exchange point data are
+// handled: flat, uncompressed columns of integers and floating point
+// values.  The flatbuffer metadata is encoded and decoded directly, so
+// no Arrow or flatbuffers library is required.
+
+// A column of an Arrow file.
+struct ArrowColumn
+{
+    ArrowColumn() : m_type(Dimension::Type::None), m_nullable(false),
+        m_nodeIndex(0), m_bufferIndex(0), m_nodeCount(1), m_bufferCount(2)
+    {}
+
+    std::string m_name;
+    // Type of the column values, None if the column type isn't one that
+    // can be stored in a PDAL dimension.
+    Dimension::Type m_type;
+    bool m_nullable;
+    // Position of the column's field node and buffers in a record batch.
+    // Nested and variable-length columns use more than one node or two
+    // buffers.
+    size_t m_nodeIndex;
+    size_t m_bufferIndex;
+    size_t m_nodeCount;
+    size_t m_bufferCount;
+};
+typedef std::vector<ArrowColumn> ArrowColumnList;
+
+// Location of a message in an Arrow file.
+struct ArrowBlock
+{
+    ArrowBlock() : m_offset(0), m_metadataLength(0), m_bodyLength(0)
+    {}
+    ArrowBlock(uint64_t offset, int32_t metadataLength, uint64_t bodyLength)
+        : m_offset(offset), m_metadataLength(metadataLength),
+        m_bodyLength(bodyLength)
+    {}
+
+    uint64_t m_offset;
+    int32_t m_metadataLength;
+    uint64_t m_bodyLength;
+};
+typedef std::vector<ArrowBlock> ArrowBlockList;
+
+// Length and null count of a column in a record batch.
+struct ArrowFieldNode
+{
+    ArrowFieldNode() : m_length(0), m_nullCount(0)
+    {}
+    ArrowFieldNode(uint64_t length, uint64_t nullCount)
+        : m_length(length), m_nullCount(nullCount)
+    {}
+
+    uint64_t m_length;
+    uint64_t m_nullCount;
+};
+
+// Location of a buffer relative to the start of a record batch body.
+struct ArrowBuffer
+{
+    ArrowBuffer() : m_offset(0), m_length(0)
+    {}
+    ArrowBuffer(uint64_t offset, uint64_t length)
+        : m_offset(offset), m_length(length)
+    {}
+
+    uint64_t m_offset;
+    uint64_t m_length;
+};
+
+struct ArrowRecordBatch
+{
+    ArrowRecordBatch() : m_length(0), m_bodyLength(0)
+    {}
+
+    uint64_t m_length;
+    uint64_t m_bodyLength;
+    std::vector<ArrowFieldNode> m_nodes;
+    std::vector<ArrowBuffer> m_buffers;
+};
+
+// Description of an Arrow file taken from its footer.
+struct ArrowFooter
+{
+    ArrowFooter() : m_littleEndian(true)
+    {}
+
+    bool m_littleEndian;
+    ArrowColumnList m_columns;
+    ArrowBlockList m_batches;
+};
+
+namespace ArrowFormat
+{
+
+struct error : public std::runtime_error
+{
+    error(const std::string& err) : std::runtime_error(err)
+    {}
+};
+
+// "ARROW1" padded to eight bytes starts an Arrow file.  The unpadded
+// magic also ends it.
+static const char Magic[] = "ARROW1\0";
+static const size_t MagicSize = 6;
+static const size_t PaddedMagicSize = 8;
+
+// Messages are prefixed with a continuation marker and the metadata size.
+static const uint32_t Continuation = 0xFFFFFFFF;
+
+// Buffers in a message body are aligned to this many bytes.
+static const size_t Alignment = 8;
+
+// Flatbuffer metadata for the schema message that follows the magic.
+PDAL_DLL std::vector<char> schemaMessage(const ArrowColumnList& columns,
+    bool littleEndian);
+// Flatbuffer metadata for a record batch message.
+PDAL_DLL std::vector<char> recordBatchMessage(const ArrowRecordBatch& batch);
+// Flatbuffer metadata for the file footer.
+PDAL_DLL std::vector<char> footer(const ArrowColumnList& columns,
+    bool littleEndian, const ArrowBlockList& batches);
+
+// Decode a file footer.  Throws ArrowFormat::error on invalid data.
+PDAL_DLL ArrowFooter parseFooter(const char *buf, size_t size);
+// Decode record batch message metadata.  Throws ArrowFormat::error on
+// invalid data or if the message isn't an uncompressed record batch.
+PDAL_DLL ArrowRecordBatch parseRecordBatch(const char *buf, size_t size);
+
+} // namespace ArrowFormat
+
+} // namespace pdal
@@ -0,0 +1,367 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ArrowReader.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <pdal/PointView.hpp>
+#include <pdal/pdal_macros.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/portable_endian.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "readers.arrow",
+    "Arrow IPC (Feather) file reader",
+    "http://pdal.io/stages/readers.arrow.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, ArrowReader, Reader, s_info)
+
+std::string ArrowReader::getName() const { return s_info.name; }
+
+namespace
+{
+
+bool hostIsLittleEndian()
+{
+    const uint16_t one(1);
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+uint32_t readLe32(const char *buf)
+{
+    uint32_t v;
+    memcpy(&v, buf, sizeof(v));
+    return le32toh(v);
+}
+
+// Read the footer at the end of an Arrow file and get the file's size.
+ArrowFooter readFooter(std::istream& in, uint64_t& fileSize)
+{
+    using namespace ArrowFormat;
+
+    char magic[MagicSize];
+    in.read(magic, MagicSize);
+    if (!in || memcmp(magic, Magic, MagicSize))
+        throw error("Not an Arrow file.");
+
+    // The file ends with the footer size and the magic.
+    const size_t trailerSize = sizeof(uint32_t) + MagicSize;
+    in.seekg(0, std::istream::end);
+    fileSize = (uint64_t)in.tellg();
+    if (fileSize < PaddedMagicSize + trailerSize)
+        throw error("Arrow file is too short.");
+
+    char trailer[trailerSize];
+    in.seekg(fileSize - trailerSize);
+    in.read(trailer, trailerSize);
+    if (!in || memcmp(trailer + sizeof(uint32_t), Magic, MagicSize))
+        throw error("Arrow file is incomplete.");
+    uint32_t footerSize = readLe32(trailer);
+    if (footerSize > fileSize - PaddedMagicSize - trailerSize)
+        throw error("Invalid Arrow footer size.");
+
+    std::vector<char> footer(footerSize);
+    in.seekg(fileSize - trailerSize - footerSize);
+    in.read(footer.data(), footerSize);
+    if (!in)
+        throw error("Unable to read Arrow footer.");
+    return parseFooter(footer.data(), footer.size());
+}
+
+} // unnamed namespace
+
+
+ArrowReader::ArrowReader() : m_swap(false), m_fileSize(0), m_stream(nullptr),
+    m_batch(0), m_batchLength(0), m_batchPos(0)
+{}
+
+
+void ArrowReader::addArgs(ProgramArgs& args)
+{
+    args.add("dimensions", "Dimensions (columns) to read. Default is all "
+        "columns of a supported type", m_dimNames);
+}
+
+
+void ArrowReader::initialize()
+{
+    std::istream *in = Utils::openFile(m_filename);
+    if (!in)
+        throwError("Unable to open file '" + m_filename + "'.");
+
+    std::string err;
+    try
+    {
+        m_footer = readFooter(*in, m_fileSize);
+    }
+    catch (const ArrowFormat::error& e)
+    {
+        err = e.what();
+    }
+    Utils::closeFile(in);
+    if (err.size())
+        throwError(err + " (" + m_filename + ")");
+    m_swap = (m_footer.m_littleEndian != hostIsLittleEndian());
+
+    m_columns.clear();
+    if (m_dimNames.empty())
+    {
+        for (const ArrowColumn& col : m_footer.m_columns)
+            if (col.m_type != Dimension::Type::None)
+                m_columns.push_back(col);
+            else
+                log()->get(LogLevel::Debug) << getName() << ": Skipping "
+                    "column '" << col.m_name << "' of unsupported type.\n";
+        if (m_columns.empty())
+            throwError("No columns of a supported type in '" +
+                m_filename + "'.");
+
+        // Columns not used by later stages aren't read.  If none is used,
+        // the first is kept so that points are created.
+        std::vector<ArrowColumn> used;
+        for (const ArrowColumn& col : m_columns)
+            if (dimensionUsed(col.m_name))
+                used.push_back(col);
+        if (used.empty())
+            used.push_back(m_columns.front());
+        m_columns.swap(used);
+        return;
+    }
+
+    for (const std::string& name : m_dimNames)
+    {
+        auto it = std::find_if(m_footer.m_columns.begin(),
+            m_footer.m_columns.end(), [&name](const ArrowColumn& col)
+            { return Utils::iequals(col.m_name, name); });
+        if (it == m_footer.m_columns.end())
+            throwError("Dimension '" + name + "' not found in '" +
+                m_filename + "'.");
+        if (it->m_type == Dimension::Type::None)
+            throwError("Column '" + name + "' has a type that can't be "
+                "read into a dimension.");
+        m_columns.push_back(*it);
+    }
+}
+
+
+void ArrowReader::addDimensions(PointLayoutPtr layout)
+{
+    m_dims.clear();
+    for (const ArrowColumn& col : m_columns)
+        m_dims.push_back(layout->registerOrAssignDim(col.m_name, col.m_type));
+}
+
+
+void ArrowReader::ready(PointTableRef table)
+{
+    m_stream = Utils::openFile(m_filename);
+    if (!m_stream)
+        throwError("Unable to open file '" + m_filename + "'.");
+    m_batch = 0;
+    m_batchLength = 0;
+    m_batchPos = 0;
+    m_data.resize(m_columns.size());
+    m_validity.resize(m_columns.size());
+}
+
+
+// Check that a range of bytes lies within the file, so that sizes taken
+// from it can be trusted when allocating buffers.
+bool ArrowReader::inFile(uint64_t offset, uint64_t size) const
+{
+    return offset <= m_fileSize && size <= m_fileSize - offset;
+}
+
+
+void ArrowReader::readBytes(uint64_t offset, char *buf, uint64_t size)
+{
+    m_stream->seekg(offset);
+    m_stream->read(buf, size);
+    if (!*m_stream)
+        throw ArrowFormat::error("Unexpected end of file.");
+}
+
+
+// Read the next non-empty record batch.  Returns false when there are no
+// more.
+bool ArrowReader::loadBatch()
+{
+    try
+    {
+        while (m_batch < m_footer.m_batches.size())
+        {
+            readBatch(m_footer.m_batches[m_batch++]);
+            if (m_batchLength)
+                return true;
+        }
+    }
+    catch (const ArrowFormat::error& err)
+    {
+        throwError(std::string(err.what()) + " (" + m_filename + ")");
+    }
+    return false;
+}
+
+
+void ArrowReader::readBatch(const ArrowBlock& block)
+{
+    using namespace ArrowFormat;
+
+    if (block.m_metadataLength < 8 ||
+            !inFile(block.m_offset, block.m_metadataLength))
+        throw error("Invalid record batch metadata size.");
+    std::vector<char> metadata(block.m_metadataLength);
+    readBytes(block.m_offset, metadata.data(), metadata.size());
+
+    // Files written before the continuation marker was introduced start
+    // messages with just the metadata size.
+    size_t start = (readLe32(metadata.data()) == Continuation) ? 8 : 4;
+    ArrowRecordBatch batch = parseRecordBatch(metadata.data() + start,
+        metadata.size() - start);
+
+    uint64_t body = block.m_offset + block.m_metadataLength;
+    m_batchLength = batch.m_length;
+    m_batchPos = 0;
+    for (size_t i = 0; i < m_columns.size(); ++i)
+    {
+        const ArrowColumn& col = m_columns[i];
+        if (col.m_nodeIndex >= batch.m_nodes.size() ||
+                col.m_bufferIndex + 1 >= batch.m_buffers.size())
+            throw error("Missing data for column '" + col.m_name + "'.");
+
+        const ArrowFieldNode& node = batch.m_nodes[col.m_nodeIndex];
+        const ArrowBuffer& validity = batch.m_buffers[col.m_bufferIndex];
+        const ArrowBuffer& data = batch.m_buffers[col.m_bufferIndex + 1];
+        uint64_t typeSize = Dimension::size(col.m_type);
+        if (node.m_length != m_batchLength ||
+                m_batchLength > m_fileSize / typeSize)
+            throw error("Invalid data size for column '" + col.m_name + "'.");
+        uint64_t size = m_batchLength * typeSize;
+        if (data.m_length < size || !inFile(body, data.m_offset) ||
+                !inFile(body + data.m_offset, size))
+            throw error("Invalid data size for column '" + col.m_name + "'.");
+
+        m_data[i].resize(size);
+        readBytes(body + data.m_offset, m_data[i].data(), size);
+
+        m_validity[i].clear();
+        if (node.m_nullCount && validity.m_length)
+        {
+            m_validity[i].resize((m_batchLength + 7) / 8);
+            if (validity.m_length < m_validity[i].size() ||
+                    !inFile(body, validity.m_offset) ||
+                    !inFile(body + validity.m_offset, m_validity[i].size()))
+                throw error("Invalid null bitmap for column '" +
+                    col.m_name + "'.");
+            readBytes(body + validity.m_offset,
+                (char *)m_validity[i].data(), m_validity[i].size());
+        }
+    }
+}
+
+
+// Return a pointer to the value of a column for a row of the current batch,
+// in host byte order.  Null values are read as zero.
+const char *ArrowReader::value(size_t col, uint64_t row, char *buf) const
+{
+    static const char zero[sizeof(uint64_t)] = {};
+
+    const std::vector<uint8_t>& validity = m_validity[col];
+    if (validity.size() && !(validity[row / 8] & (1 << (row % 8))))
+        return zero;
+
+    size_t size = Dimension::size(m_columns[col].m_type);
+    const char *pos = m_data[col].data() + row * size;
+    if (m_swap)
+    {
+        std::reverse_copy(pos, pos + size, buf);
+        return buf;
+    }
+    return pos;
+}
+
+
+point_count_t ArrowReader::read(PointViewPtr view, point_count_t num)
+{
+    char buf[sizeof(uint64_t)];
+    PointId idx = view->size();
+    point_count_t count = 0;
+    while (count < num)
+    {
+        if (m_batchPos == m_batchLength && !loadBatch())
+            break;
+
+        point_count_t n = (std::min)(num - count,
+            (point_count_t)(m_batchLength - m_batchPos));
+        for (size_t i = 0; i < m_columns.size(); ++i)
+            for (point_count_t j = 0; j < n; ++j)
+                view->setField(m_dims[i], m_columns[i].m_type, idx + j,
+                    value(i, m_batchPos + j, buf));
+        m_batchPos += n;
+        idx += n;
+        count += n;
+    }
+    return count;
+}
+
+
+bool ArrowReader::processOne(PointRef& point)
+{
+    if (m_batchPos == m_batchLength && !loadBatch())
+        return false;
+
+    char buf[sizeof(uint64_t)];
+    for (size_t i = 0; i < m_columns.size(); ++i)
+        point.setField(m_dims[i], m_columns[i].m_type,
+            value(i, m_batchPos, buf));
+    m_batchPos++;
+    return true;
+}
+
+
+void ArrowReader::done(PointTableRef table)
+{
+    Utils::closeFile(m_stream);
+    m_stream = nullptr;
+    m_data.clear();
+    m_validity.clear();
+}
+
+} // namespace pdal
@@ -0,0 +1,100 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include "ArrowFormat.hpp"
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/Reader.hpp>
+#include <pdal/plugin.hpp>
+
+#include <istream>
+#include <string>
+#include <vector>
+
+extern "C" int32_t ArrowReader_ExitFunc();
+extern "C" PF_ExitFunc ArrowReader_InitPlugin();
+
+namespace pdal
+{
+
+// Reads points from the integer and floating point columns of an Arrow
+// IPC (Feather V2) file.  Only the columns of the requested dimensions are
+// read from the file.
+class PDAL_DLL ArrowReader : public Reader
+{
+public:
+    ArrowReader();
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
+    virtual void addDimensions(PointLayoutPtr layout);
+    virtual void ready(PointTableRef table);
+    virtual point_count_t read(PointViewPtr view, point_count_t num);
+    virtual bool processOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    bool loadBatch();
+    void readBatch(const ArrowBlock& block);
+    bool inFile(uint64_t offset, uint64_t size) const;
+    void readBytes(uint64_t offset, char *buf, uint64_t size);
+    const char *value(size_t col, uint64_t row, char *buf) const;
+
+    StringList m_dimNames;
+
+    ArrowFooter m_footer;
+    bool m_swap;
+    uint64_t m_fileSize;
+    // Columns read and the dimensions they're read into.
+    std::vector<ArrowColumn> m_columns;
+    Dimension::IdList m_dims;
+
+    std::istream *m_stream;
+    size_t m_batch;
+    uint64_t m_batchLength;
+    uint64_t m_batchPos;
+    std::vector<std::vector<char>> m_data;
+    std::vector<std::vector<uint8_t>> m_validity;
+
+    ArrowReader& operator=(const ArrowReader&); // not implemented
+    ArrowReader(const ArrowReader&); // not implemented
+};
+
+} // namespace pdal
@@ -0,0 +1,240 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "ArrowWriter.hpp"
+
+#include <algorithm>
+
+#include <pdal/pdal_macros.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/portable_endian.hpp>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.arrow",
+    "Arrow IPC (Feather) file writer",
+    "http://pdal.io/stages/writers.arrow.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, ArrowWriter, Writer, s_info)
+
+std::string ArrowWriter::getName() const { return s_info.name; }
+
+namespace
+{
+
+bool hostIsLittleEndian()
+{
+    const uint16_t one(1);
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+uint64_t padded(uint64_t size)
+{
+    return (size + ArrowFormat::Alignment - 1) / ArrowFormat::Alignment *
+        ArrowFormat::Alignment;
+}
+
+void writeLe32(std::ostream& out, uint32_t v)
+{
+    v = htole32(v);
+    out.write((const char *)&v, sizeof(v));
+}
+
+} // unnamed namespace
+
+
+ArrowWriter::ArrowWriter() : m_batchSize(0), m_stream(nullptr), m_count(0)
+{}
+
+
+void ArrowWriter::addArgs(ProgramArgs& args)
+{
+    args.add("filename", "Output filename", m_filename).setPositional();
+    args.add("batch_size", "Number of points in each record batch",
+        m_batchSize, (point_count_t)65536);
+}
+
+
+void ArrowWriter::initialize()
+{
+    if (m_batchSize == 0)
+        throwError("Option 'batch_size' must be greater than 0.");
+}
+
+
+void ArrowWriter::ready(PointTableRef table)
+{
+    PointLayoutPtr layout(table.layout());
+
+    m_dims = layout->dims();
+    m_columns.clear();
+    m_data.clear();
+    for (auto dim : m_dims)
+    {
+        ArrowColumn column;
+        column.m_name = layout->dimName(dim);
+        column.m_type = layout->dimType(dim);
+        m_columns.push_back(column);
+        m_data.emplace_back(m_batchSize * Dimension::size(column.m_type));
+    }
+    m_batches.clear();
+    m_count = 0;
+
+    m_stream = Utils::createFile(m_filename, true);
+    if (!m_stream)
+        throwError("Couldn't open '" + m_filename + "' for output.");
+    m_stream->write(ArrowFormat::Magic, ArrowFormat::PaddedMagicSize);
+    try
+    {
+        writeMessage(ArrowFormat::schemaMessage(m_columns,
+            hostIsLittleEndian()));
+    }
+    catch (const ArrowFormat::error& err)
+    {
+        throwError(err.what());
+    }
+}
+
+
+void ArrowWriter::writeMessage(const std::vector<char>& metadata)
+{
+    writeLe32(*m_stream, ArrowFormat::Continuation);
+    writeLe32(*m_stream, (uint32_t)metadata.size());
+    m_stream->write(metadata.data(), metadata.size());
+}
+
+
+void ArrowWriter::write(const PointViewPtr view)
+{
+    PointId idx = 0;
+    while (idx < view->size())
+    {
+        point_count_t count = (std::min)(m_batchSize - m_count,
+            view->size() - idx);
+        for (size_t i = 0; i < m_dims.size(); ++i)
+        {
+            Dimension::Id dim = m_dims[i];
+            Dimension::Type type = m_columns[i].m_type;
+            size_t size = Dimension::size(type);
+
+            char *pos = m_data[i].data() + m_count * size;
+            for (PointId j = idx; j < idx + count; ++j, pos += size)
+                view->getField(pos, dim, type, j);
+        }
+        idx += count;
+        m_count += count;
+        if (m_count == m_batchSize)
+            flushBatch();
+    }
+}
+
+
+bool ArrowWriter::processOne(PointRef& point)
+{
+    for (size_t i = 0; i < m_dims.size(); ++i)
+    {
+        Dimension::Type type = m_columns[i].m_type;
+        size_t size = Dimension::size(type);
+        point.getField(m_data[i].data() + m_count * size, m_dims[i], type);
+    }
+    if (++m_count == m_batchSize)
+        flushBatch();
+    return true;
+}
+
+
+// Write the points collected so far as a record batch.  Columns have no
+// nulls, so each has an empty validity buffer followed by its values.
+void ArrowWriter::flushBatch()
+{
+    if (m_count == 0)
+        return;
+
+    ArrowRecordBatch batch;
+    batch.m_length = m_count;
+    uint64_t offset = 0;
+    for (const ArrowColumn& column : m_columns)
+    {
+        uint64_t size = m_count * Dimension::size(column.m_type);
+        batch.m_nodes.emplace_back(m_count, 0);
+        batch.m_buffers.emplace_back(offset, 0);
+        batch.m_buffers.emplace_back(offset, size);
+        offset += padded(size);
+    }
+    batch.m_bodyLength = offset;
+
+    std::vector<char> metadata = ArrowFormat::recordBatchMessage(batch);
+    uint64_t pos = (uint64_t)m_stream->tellp();
+    writeMessage(metadata);
+
+    const char zeros[ArrowFormat::Alignment] = {};
+    for (size_t i = 0; i < m_columns.size(); ++i)
+    {
+        uint64_t size = m_count * Dimension::size(m_columns[i].m_type);
+        m_stream->write(m_data[i].data(), size);
+        m_stream->write(zeros, padded(size) - size);
+    }
+    m_batches.emplace_back(pos, (int32_t)(8 + metadata.size()),
+        batch.m_bodyLength);
+    m_count = 0;
+}
+
+
+void ArrowWriter::done(PointTableRef table)
+{
+    flushBatch();
+
+    // End-of-stream marker.
+    writeLe32(*m_stream, ArrowFormat::Continuation);
+    writeLe32(*m_stream, 0);
+
+    std::vector<char> footer = ArrowFormat::footer(m_columns,
+        hostIsLittleEndian(), m_batches);
+    m_stream->write(footer.data(), footer.size());
+    writeLe32(*m_stream, (uint32_t)footer.size());
+    m_stream->write(ArrowFormat::Magic, ArrowFormat::MagicSize);
+
+    bool ok = (bool)*m_stream;
+    Utils::closeFile(m_stream);
+    m_stream = nullptr;
+    m_data.clear();
+    if (!ok)
+        throwError("Error writing file '" + m_filename + "'.");
+    getMetadata().addList("filename", m_filename);
+}
+
+} // namespace pdal
@@ -0,0 +1,91 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include "ArrowFormat.hpp"
+
+#include <pdal/pdal_export.hpp>
+#include <pdal/Writer.hpp>
+#include <pdal/plugin.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+extern "C" int32_t ArrowWriter_ExitFunc();
+extern "C" PF_ExitFunc ArrowWriter_InitPlugin();
+
+namespace pdal
+{
+
+// Writes points as columns of an Arrow IPC (Feather V2) file.  Each
+// dimension becomes a column of the corresponding type and points are
+// written in record batches of a fixed number of rows.
+class PDAL_DLL ArrowWriter : public Writer
+{
+public:
+    ArrowWriter();
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
+    virtual void ready(PointTableRef table);
+    virtual void write(const PointViewPtr view);
+    virtual bool processOne(PointRef& point);
+    virtual void done(PointTableRef table);
+
+    void writeMessage(const std::vector<char>& metadata);
+    void flushBatch();
+
+    std::string m_filename;
+    point_count_t m_batchSize;
+
+    std::ostream *m_stream;
+    Dimension::IdList m_dims;
+    ArrowColumnList m_columns;
+    ArrowBlockList m_batches;
+    // Column data of the batch being built.
+    std::vector<std::vector<char>> m_data;
+    point_count_t m_count;
+
+    ArrowWriter& operator=(const ArrowWriter&); // not implemented
+    ArrowWriter(const ArrowWriter&); // not implemented
+};
+
+} // namespace pdal
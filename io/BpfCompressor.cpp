@@ -35,98 +35,94 @@
 #include "BpfCompressor.hpp"
 
 #include <pdal/pdal_internal.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 namespace pdal
 {
 
-void BpfCompressor::startBlock()
+BpfCompressor::BpfCompressor(OLeStream& out, size_t maxSize, int level,
+        ThreadPool& pool) :
+    m_out(out), m_maxSize(maxSize), m_level(level), m_pool(pool),
+    m_rawStream(&m_charbuf), m_numQueued(0)
 {
-    // Initialize the stream.
-    m_strm.zalloc = Z_NULL;
-    m_strm.zfree = Z_NULL;
-    m_strm.opaque = Z_NULL;
-    if (deflateInit(&m_strm, Z_DEFAULT_COMPRESSION) != Z_OK)
-        throw error("Could not initialize BPF compressor.");
-
-    m_rawSize = 0;
-    m_compressedSize = 0;
-    uint32_t rawSize = 0;
-    uint32_t compressedSize = 0;
-
-    // Initiailize the streambuf with the backing buffer.
-    m_charbuf.initialize(m_inbuf.data(), m_inbuf.size());
-
-    // Note our position so that we can rewind here.
-    m_blockStart.mark();
-    m_out << rawSize << compressedSize;
-
-    // Make a new stream from our charbuf and push it so that future writes
-    // to our stream go to the backing vector.
-    m_out.pushStream(new std::ostream(&m_charbuf));
+    // Blocks are compressed in the background while the next ones are
+    // filled, so keep enough of them to occupy all the threads.
+    m_blocks.resize(2 * m_pool.numThreads());
 }
 
 
-void BpfCompressor::compress()
+BpfCompressor::~BpfCompressor()
 {
-    // Note our position so that we know how much we've written.
-    uint32_t rawWritten = (uint32_t)m_out.position();
-
-    // Pop our temp stream so that we can write the real output file.
-    m_out.popStream();
-
-    m_rawSize += rawWritten;
-
-    // Deflate the data in the buffer and write it to the output stream.
-    m_strm.avail_in = rawWritten;
-    m_strm.next_in = (unsigned char *)m_inbuf.data();
-    m_strm.avail_out = CHUNKSIZE;
-    m_strm.next_out = m_tmpbuf;
-    while (m_strm.avail_in)
+    // Compression tasks refer to our blocks.
+    try
     {
-        int ret = ::deflate(&m_strm, Z_NO_FLUSH);
-        size_t written = CHUNKSIZE - m_strm.avail_out;
-        m_compressedSize += written;
-        m_out.put(m_tmpbuf, written);
-        m_strm.avail_out = CHUNKSIZE;
-        m_strm.next_out = m_tmpbuf;
+        m_pool.await();
     }
+    catch (...)
+    {}
+}
 
-    // All data has been written.  Reinitialize input buffer's streambuf and
-    // push it.
-    m_charbuf.initialize(m_inbuf.data(), m_inbuf.size());
-    m_out.pushStream(new std::ostream(&m_charbuf));
+
+void BpfCompressor::startBlock()
+{
+    if (m_numQueued == m_blocks.size())
+        flush();
+
+    // Direct writes to the stream to the block's buffer.
+    Block& block = m_blocks[m_numQueued];
+    block.m_raw.resize(m_maxSize);
+    m_charbuf.initialize(block.m_raw.data(), block.m_raw.size());
+    m_rawStream.clear();
+    m_out.pushStream(&m_rawStream);
 }
 
 
 void BpfCompressor::finish()
 {
-    // Pop our special stream so that we can write the the file.
+    Block& block = m_blocks[m_numQueued++];
+    block.m_rawSize = (uint32_t)m_out.position();
     m_out.popStream();
 
-    // Deflate and write the result to the output file.
-    int ret = Z_OK;
-    while (ret == Z_OK)
+    int level = m_level;
+    m_pool.add([&block, level](){ compress(block, level); });
+}
+
+
+void BpfCompressor::flush()
+{
+    m_pool.await();
+    for (size_t i = 0; i < m_numQueued; ++i)
     {
-        ret = ::deflate(&m_strm, Z_FINISH);
-        size_t written = CHUNKSIZE - m_strm.avail_out;
-        m_compressedSize += written;
-        m_out.put(m_tmpbuf, written);
-        m_strm.avail_out = CHUNKSIZE;
-        m_strm.next_out = m_tmpbuf;
+        Block& block = m_blocks[i];
+        if (!block.m_ok)
+            throw error("Couldn't compress BPF data.");
+        m_out << block.m_rawSize << block.m_compressedSize;
+        m_out.put(block.m_compressed.data(), block.m_compressedSize);
     }
-    if (ret != Z_STREAM_END)
-        throw error("Couldn't close BPF compression stream.");
-    deflateEnd(&m_strm);
-
-    // Mark our position so that we can get back here.
-    OStreamMarker blockEnd(m_out);
+    m_numQueued = 0;
+}
 
-    // Rewind to the start of the block and write the size bytes.
-    m_blockStart.rewind();
-    m_out << (uint32_t)m_rawSize << (uint32_t)m_compressedSize;
 
-    // Set the position back to the end of the block.
-    blockEnd.rewind();
+void BpfCompressor::compress(Block& block, int level)
+{
+    z_stream strm;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    block.m_ok = false;
+    if (deflateInit(&strm, level) != Z_OK)
+        return;
+
+    block.m_compressed.resize(deflateBound(&strm, block.m_rawSize));
+    strm.avail_in = block.m_rawSize;
+    strm.next_in = (unsigned char *)block.m_raw.data();
+    strm.avail_out = (uInt)block.m_compressed.size();
+    strm.next_out = block.m_compressed.data();
+
+    block.m_ok = (::deflate(&strm, Z_FINISH) == Z_STREAM_END);
+    block.m_compressedSize = (uint32_t)strm.total_out;
+    deflateEnd(&strm);
 }
 
 } // namespace pdal
@@ -36,6 +36,7 @@
 
 #include <stdexcept>
 #include <ostream>
+#include <vector>
 #include <zlib.h>
 
 #include <pdal/util/Charbuf.hpp>
@@ -44,6 +45,17 @@
 namespace pdal
 {
 
+class ThreadPool;
+
+/**
+  Compresses blocks of BPF point data written to a stream.
+
+  Data written to the stream between startBlock() and finish() makes up a
+  block.  Each block is deflated independently on a thread pool while
+  subsequent blocks are written.  Compressed blocks are written to the
+  stream, in order, preceded by their uncompressed and compressed sizes,
+  as blocks are queued and when flush() is called.
+*/
 class BpfCompressor
 {
 public:
@@ -53,25 +65,41 @@ public:
         {}
     };
 
-    BpfCompressor(OLeStream& out, size_t maxSize) :
-        m_out(out), m_inbuf(maxSize), m_blockStart(out), m_rawSize(0),
-        m_compressedSize(0)
-    {}
+    /**
+      \param out  Stream to which compressed data is written.
+      \param maxSize  Maximum size of an uncompressed block.
+      \param level  zlib compression level.
+      \param pool  Pool used to compress blocks.
+    */
+    BpfCompressor(OLeStream& out, size_t maxSize, int level,
+        ThreadPool& pool);
+    ~BpfCompressor();
+
     void startBlock();
     void finish();
-    void compress();
+    void flush();
 
 private:
-    static const int CHUNKSIZE = 1000000;
+    struct Block
+    {
+        std::vector<char> m_raw;
+        std::vector<unsigned char> m_compressed;
+        uint32_t m_rawSize;
+        uint32_t m_compressedSize;
+        bool m_ok;
+    };
 
     OLeStream& m_out;
+    size_t m_maxSize;
+    int m_level;
+    ThreadPool& m_pool;
     Charbuf m_charbuf;
-    std::vector<char> m_inbuf;
-    z_stream m_strm;
-    unsigned char m_tmpbuf[CHUNKSIZE];
-    OStreamMarker m_blockStart;
-    size_t m_rawSize;
-    size_t m_compressedSize;
+    std::ostream m_rawStream;
+    std::vector<Block> m_blocks;
+    /// Number of blocks queued for compression.
+    size_t m_numQueued;
+
+    static void compress(Block& block, int level);
 };
 
 } // namespace pdal
@@ -0,0 +1,323 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "BpfDecompressor.hpp"
+
+#include <algorithm>
+
+#include <pdal/util/ThreadPool.hpp>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Blocks no larger than this are inflated whole.
+const size_t BlockLimit = 4 << 20;
+
+// Most uncompressed data held when inflating several blocks at once.
+const size_t WindowLimit = 16 << 20;
+
+// Amount of data inflated at a time from a large block.
+const size_t StepSize = 1 << 20;
+
+// Amount of compressed data read at a time for a large block.
+const size_t InputSize = 256 << 10;
+
+} // unnamed namespace
+
+
+BpfDecompressor::BpfDecompressor(const std::string& filename,
+        const BpfCompressedBlockList& blocks, std::streamoff base,
+        ThreadPool *pool) :
+    m_blocks(blocks), m_base(base), m_pool(pool), m_winPos(0),
+    m_winSize(0), m_inflating(false), m_block(0), m_blockOut(0),
+    m_blockIn(0), m_blockBad(false)
+{
+    m_file.open(filename, std::ios::in | std::ios::binary);
+}
+
+
+BpfDecompressor::~BpfDecompressor()
+{
+    endInflate();
+}
+
+
+bool BpfDecompressor::inflateBlock(const char *in, uint32_t inSize,
+    char *out, uint32_t outSize)
+{
+    z_stream strm;
+
+    strm.zalloc = Z_NULL;
+    strm.zfree = Z_NULL;
+    strm.opaque = Z_NULL;
+    strm.avail_in = 0;
+    strm.next_in = Z_NULL;
+    if (inflateInit(&strm) != Z_OK)
+        return false;
+
+    strm.avail_in = inSize;
+    strm.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+    strm.avail_out = outSize;
+    strm.next_out = reinterpret_cast<Bytef *>(out);
+
+    int ret = ::inflate(&strm, Z_FINISH);
+    (void)inflateEnd(&strm);
+    return ret == Z_STREAM_END;
+}
+
+
+std::streamoff BpfDecompressor::rawSize() const
+{
+    if (m_blocks.empty())
+        return 0;
+    return m_blocks.back().m_rawPos + m_blocks.back().m_rawSize;
+}
+
+
+// Find the block that contains a position, or the number of blocks if
+// no block does.
+size_t BpfDecompressor::findBlock(std::streamoff pos) const
+{
+    if (pos < 0 || pos >= rawSize())
+        return m_blocks.size();
+
+    auto it = std::upper_bound(m_blocks.begin(), m_blocks.end(), pos,
+        [](std::streamoff p, const BpfCompressedBlock& b)
+            { return p < b.m_rawPos; });
+    return (it - m_blocks.begin()) - 1;
+}
+
+
+// Empty the window and set the position of the next byte to read.
+void BpfDecompressor::setWindow(std::streamoff pos)
+{
+    m_winPos = pos;
+    m_winSize = 0;
+    setg(m_window.data(), m_window.data(), m_window.data());
+}
+
+
+BpfDecompressor::int_type BpfDecompressor::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    std::streamoff pos = position();
+    size_t block = findBlock(pos);
+    if (block == m_blocks.size())
+    {
+        setWindow(pos);
+        return traits_type::eof();
+    }
+
+    if (m_blocks[block].m_rawSize <= BlockLimit)
+        inflateBlocks(block);
+    else
+        inflateStep(block, pos);
+
+    // The window may not reach the position if the data is bad.
+    std::streamoff offset = pos - m_winPos;
+    if (offset < 0 || offset >= (std::streamoff)m_winSize)
+    {
+        setWindow(pos);
+        return traits_type::eof();
+    }
+    setg(m_window.data(), m_window.data() + offset,
+        m_window.data() + m_winSize);
+    return traits_type::to_int_type(*gptr());
+}
+
+
+// Inflate a run of small blocks starting with 'block' into the window.
+void BpfDecompressor::inflateBlocks(size_t block)
+{
+    const size_t numThreads = m_pool ? m_pool->numThreads() : 1;
+
+    size_t last = block;
+    size_t size = 0;
+    while (last < m_blocks.size() && last - block < numThreads &&
+        m_blocks[last].m_rawSize <= BlockLimit &&
+        (last == block || size + m_blocks[last].m_rawSize <= WindowLimit))
+        size += m_blocks[last++].m_rawSize;
+
+    // Blocks follow one another in the file, separated only by their
+    // sizes, so the compressed data for all of them is read at once.
+    const BpfCompressedBlock& first = m_blocks[block];
+    const BpfCompressedBlock& end = m_blocks[last - 1];
+    const std::streamoff start = first.m_filePos;
+    m_input.resize((size_t)(end.m_filePos + end.m_compressedSize - start));
+    m_file.pubseekpos(start, std::ios_base::in);
+    const std::streamsize count =
+        m_file.sgetn(m_input.data(), m_input.size());
+
+    m_window.resize((std::max)(m_window.size(), size));
+    std::vector<char> ok(last - block, false);
+    for (size_t i = block; i < last; ++i)
+    {
+        const BpfCompressedBlock& b = m_blocks[i];
+        if (b.m_filePos + b.m_compressedSize - start > count)
+            break;
+
+        const char *in = m_input.data() + (b.m_filePos - start);
+        char *out = m_window.data() + (b.m_rawPos - first.m_rawPos);
+        char& success = ok[i - block];
+        auto task = [in, out, &b, &success]()
+        {
+            success = inflateBlock(in, b.m_compressedSize, out, b.m_rawSize);
+        };
+        if (m_pool)
+            m_pool->add(task);
+        else
+            task();
+    }
+    if (m_pool)
+        m_pool->await();
+
+    // Data following a bad block isn't available.
+    m_winPos = first.m_rawPos;
+    m_winSize = 0;
+    for (size_t i = block; i < last && ok[i - block]; ++i)
+        m_winSize += m_blocks[i].m_rawSize;
+}
+
+
+// Inflate part of a large block into the window so that the window
+// contains 'pos', if possible.
+void BpfDecompressor::inflateStep(size_t block, std::streamoff pos)
+{
+    const BpfCompressedBlock& b = m_blocks[block];
+
+    if (!m_inflating || m_block != block || b.m_rawPos + m_blockOut > pos)
+        startInflate(block);
+
+    m_window.resize((std::max)(m_window.size(), StepSize));
+    m_input.resize((std::max)(m_input.size(), InputSize));
+    do
+    {
+        m_winPos = b.m_rawPos + m_blockOut;
+        m_winSize = 0;
+        if (!m_inflating || m_blockBad)
+            break;
+
+        m_strm.next_out = (unsigned char *)m_window.data();
+        m_strm.avail_out = (uInt)(std::min)((std::streamoff)StepSize,
+            b.m_rawSize - m_blockOut);
+        int ret = Z_OK;
+        while (m_strm.avail_out && ret == Z_OK)
+        {
+            if (m_strm.avail_in == 0)
+            {
+                std::streamsize count = (std::min)(
+                    (std::streamoff)InputSize,
+                    b.m_compressedSize - m_blockIn);
+                m_file.pubseekpos(b.m_filePos + m_blockIn,
+                    std::ios_base::in);
+                count = m_file.sgetn(m_input.data(), count);
+                if (count <= 0)
+                    break;
+                m_blockIn += count;
+                m_strm.next_in = (unsigned char *)m_input.data();
+                m_strm.avail_in = (uInt)count;
+            }
+            ret = ::inflate(&m_strm, Z_NO_FLUSH);
+        }
+        m_winSize = (char *)m_strm.next_out - m_window.data();
+        m_blockOut += m_winSize;
+        if (ret != Z_OK && ret != Z_STREAM_END)
+            m_blockBad = true;
+    } while (m_winSize && m_winPos + (std::streamoff)m_winSize <= pos);
+}
+
+
+void BpfDecompressor::startInflate(size_t block)
+{
+    endInflate();
+
+    m_strm.zalloc = Z_NULL;
+    m_strm.zfree = Z_NULL;
+    m_strm.opaque = Z_NULL;
+    m_strm.avail_in = 0;
+    m_strm.next_in = Z_NULL;
+    m_inflating = (inflateInit(&m_strm) == Z_OK);
+    m_block = block;
+    m_blockOut = 0;
+    m_blockIn = 0;
+    m_blockBad = false;
+}
+
+
+void BpfDecompressor::endInflate()
+{
+    if (m_inflating)
+        (void)inflateEnd(&m_strm);
+    m_inflating = false;
+}
+
+
+BpfDecompressor::pos_type BpfDecompressor::seekpos(pos_type pos,
+    std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    std::streamoff raw = (std::streamoff)pos - m_base;
+    if (raw < 0)
+        return pos_type(off_type(-1));
+
+    // Stay in the window if possible.
+    if (raw >= m_winPos && raw < m_winPos + (std::streamoff)m_winSize)
+        setg(eback(), eback() + (raw - m_winPos), egptr());
+    else
+        setWindow(raw);
+    return pos;
+}
+
+
+BpfDecompressor::pos_type BpfDecompressor::seekoff(off_type off,
+    std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    std::streamoff pos;
+    if (dir == std::ios_base::beg)
+        pos = off;
+    else if (dir == std::ios_base::cur)
+        pos = m_base + position() + off;
+    else
+        pos = m_base + rawSize() + off;
+    return seekpos(pos, which);
+}
+
+} // namespace pdal
@@ -0,0 +1,153 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace pdal
+{
+
+class ThreadPool;
+
+/**
+  Location of a block of compressed BPF point data.
+*/
+struct BpfCompressedBlock
+{
+    /// File position of the compressed data.
+    std::streamoff m_filePos;
+    /// Position of the block's data in the uncompressed point data.
+    std::streamoff m_rawPos;
+    uint32_t m_rawSize;
+    uint32_t m_compressedSize;
+};
+typedef std::vector<BpfCompressedBlock> BpfCompressedBlockList;
+
+/**
+  A read-only streambuf over the uncompressed point data of a BPF file
+  whose points are stored in zlib-compressed blocks.
+
+  Only a bounded window of uncompressed data is held at once.  Runs of
+  small blocks are inflated whole, in parallel if a thread pool is
+  provided.  Large blocks are inflated incrementally, so reading a block
+  from start to end uses a fixed amount of memory no matter its size.
+
+  Positions are those of the point data in the file as if it weren't
+  compressed: the first uncompressed byte is at position 'base'.  Seeking
+  forward within a large block continues inflating from the current
+  position; seeking backward restarts at the beginning of the block.
+*/
+class BpfDecompressor : public std::streambuf
+{
+public:
+    /**
+      Open a file for reading.
+
+      \param filename  Name of file to open.
+      \param blocks  Locations of the compressed blocks, in file order.
+      \param base  Position of the start of the point data.
+      \param pool  Pool used to inflate blocks in parallel.  Blocks are
+        inflated on the calling thread if null.
+    */
+    BpfDecompressor(const std::string& filename,
+        const BpfCompressedBlockList& blocks, std::streamoff base,
+        ThreadPool *pool);
+    ~BpfDecompressor();
+
+    /**
+      Inflate a complete block.
+
+      \param in  Compressed data.
+      \param inSize  Size of the compressed data.
+      \param out  Buffer to hold the uncompressed data.
+      \param outSize  Size of the uncompressed data.
+      \return  Whether the block was inflated successfully.
+    */
+    static bool inflateBlock(const char *in, uint32_t inSize, char *out,
+        uint32_t outSize);
+
+protected:
+    int_type underflow();
+    pos_type seekpos(pos_type pos,
+        std::ios_base::openmode which = std::ios_base::in);
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in);
+
+private:
+    std::filebuf m_file;
+    const BpfCompressedBlockList& m_blocks;
+    std::streamoff m_base;
+    ThreadPool *m_pool;
+    /// Uncompressed data.
+    std::vector<char> m_window;
+    /// Position in the uncompressed data of the start of the window.
+    std::streamoff m_winPos;
+    /// Number of valid bytes in the window.
+    size_t m_winSize;
+    /// Compressed data read from the file.
+    std::vector<char> m_input;
+
+    // State of incremental inflation of a large block.
+    z_stream m_strm;
+    bool m_inflating;
+    size_t m_block;
+    /// Bytes of the block inflated so far.
+    std::streamoff m_blockOut;
+    /// Bytes of compressed data read so far.
+    std::streamoff m_blockIn;
+    /// Whether the compressed data of the block is bad.
+    bool m_blockBad;
+
+    std::streamoff position() const
+        { return m_winPos + (gptr() - eback()); }
+    std::streamoff rawSize() const;
+    size_t findBlock(std::streamoff pos) const;
+    void setWindow(std::streamoff pos);
+    void inflateBlocks(size_t block);
+    void inflateStep(size_t block, std::streamoff pos);
+    void startInflate(size_t block);
+    void endInflate();
+
+    BpfDecompressor(const BpfDecompressor&) = delete;
+    BpfDecompressor& operator=(const BpfDecompressor&) = delete;
+};
+
+} // namespace pdal
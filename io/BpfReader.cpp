@@ -36,11 +36,10 @@
 
 #include <climits>
 
-#include <zlib.h>
-
 #include <pdal/Options.hpp>
 #include <pdal/pdal_export.hpp>
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 namespace pdal
 {
@@ -56,6 +55,14 @@ CREATE_STATIC_PLUGIN(1, 0, BpfReader, Reader, s_info)
 
 std::string BpfReader::getName() const { return s_info.name; }
 
+BpfReader::BpfReader()
+{}
+
+
+BpfReader::~BpfReader()
+{}
+
+
 QuickInfo BpfReader::inspect()
 {
     QuickInfo qi;
@@ -88,6 +95,16 @@ QuickInfo BpfReader::inspect()
 }
 
 
+void BpfReader::addArgs(ProgramArgs& args)
+{
+    args.add("read_ahead", "Size in bytes of each of the two buffers "
+        "filled in the background while points are read (0 to disable)",
+        m_readAhead, (size_t)ReadAheadBuf::DefaultBufSize);
+    args.add("threads", "Number of threads used to decompress point data",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+}
+
+
 // When the stage is intialized, the schema needs to be populated with the
 // dimensions in order to allow subsequent stages to be aware of or append to
 // the dimensions in the PointView.
@@ -182,6 +199,14 @@ void BpfReader::addDimensions(PointLayoutPtr layout)
         Dimension::Type type = Dimension::Type::Float;
 
         BpfDimension& dim = m_dims[i];
+
+        // Dimensions not used by later stages are neither registered nor
+        // read when the layout of the data allows them to be skipped.
+        if (!dimensionUsed(dim.m_label))
+        {
+            dim.m_id = Dimension::Id::Unknown;
+            continue;
+        }
         if (dim.m_label == "X" ||
             dim.m_label == "Y" ||
             dim.m_label == "Z")
@@ -253,29 +278,107 @@ bool BpfReader::readPolarData()
 void BpfReader::ready(PointTableRef)
 {
     m_stream.open(m_filename);
-    m_stream.seek(m_header.m_len);
     m_index = 0;
-    m_start = m_stream.position();
+    m_pool.reset(new ThreadPool((std::max)(m_threads, 1U)));
+
     if (m_header.m_compression)
     {
-        m_deflateBuf.resize(numPoints() * m_dims.size() * sizeof(float));
-        size_t index = 0;
-        size_t bytesRead = 0;
-        do
-        {
-            bytesRead = readBlock(m_deflateBuf, index);
-            index += bytesRead;
-        } while (bytesRead > 0 && index < m_deflateBuf.size());
-        m_charbuf.initialize(m_deflateBuf.data(), m_deflateBuf.size(), m_start);
-        m_stream.pushStream(new std::istream(&m_charbuf));
+        m_stream.seek(m_header.m_len);
+        m_start = m_stream.position();
+        readBlockIndex();
+
+        // Byte-major points are assembled from bytes spread across all of
+        // the point data, so that data is inflated whole.  Otherwise
+        // blocks are inflated as the points are read.
+        if (m_header.m_pointFormat == BpfFormat::ByteMajor)
+            inflateAll();
+        else
+            m_inflateBuf.reset(new BpfDecompressor(m_filename, m_blocks,
+                m_start, m_pool.get()));
+        m_inflateStream.reset(new std::istream(m_inflateBuf.get()));
+        m_stream.pushStream(m_inflateStream.get());
+        return;
+    }
+
+    // Byte-major data is read point-at-a-time by seeking to each byte, so
+    // reading ahead would only add work.
+    if (m_readAhead && m_header.m_pointFormat != BpfFormat::ByteMajor)
+    {
+        m_readAheadBuf.reset(new ReadAheadBuf(m_filename, m_readAhead));
+        m_readAheadStream.reset(new std::istream(m_readAheadBuf.get()));
+        m_stream.pushStream(m_readAheadStream.get());
+    }
+    m_stream.seek(m_header.m_len);
+    m_start = m_stream.position();
+}
+
+
+// Find the compressed blocks of point data.  Each block is preceded by
+// its uncompressed and compressed sizes.
+void BpfReader::readBlockIndex()
+{
+    const std::streamoff rawSize = numPoints() * m_dims.size() * sizeof(float);
+
+    m_blocks.clear();
+    m_stream.seek(m_start);
+    BpfCompressedBlock block;
+    block.m_rawPos = 0;
+    while (block.m_rawPos < rawSize)
+    {
+        m_stream >> block.m_rawSize >> block.m_compressedSize;
+        if (!m_stream || block.m_rawSize == 0)
+            break;
+        block.m_filePos = m_stream.position();
+        m_blocks.push_back(block);
+        block.m_rawPos += block.m_rawSize;
+        m_stream.skip(block.m_compressedSize);
+    }
+}
+
+
+// Inflate all of the point data into memory.
+void BpfReader::inflateAll()
+{
+    m_deflateBuf.resize(numPoints() * m_dims.size() * sizeof(float));
+
+    std::vector<char> in;
+    for (const BpfCompressedBlock& b : m_blocks)
+    {
+        if (b.m_rawPos + b.m_rawSize > (std::streamoff)m_deflateBuf.size())
+            break;
+        in.resize(b.m_compressedSize);
+        m_stream.seek(b.m_filePos);
+        m_stream.get(in);
+        if (!BpfDecompressor::inflateBlock(in.data(), b.m_compressedSize,
+                m_deflateBuf.data() + b.m_rawPos, b.m_rawSize))
+            break;
     }
+
+    Charbuf *buf = new Charbuf;
+    buf->initialize(m_deflateBuf.data(), m_deflateBuf.size(), m_start);
+    m_inflateBuf.reset(buf);
 }
 
 
 void BpfReader::done(PointTableRef)
 {
-    if (auto s = m_stream.popStream())
-        delete s;
+    m_streams.clear();
+    m_dimInflateStreams.clear();
+    m_dimInflateBufs.clear();
+    if (m_inflateStream)
+    {
+        m_stream.popStream();
+        m_inflateStream.reset();
+        m_inflateBuf.reset();
+        m_deflateBuf.clear();
+    }
+    if (m_readAheadStream)
+    {
+        m_stream.popStream();
+        m_readAheadStream.reset();
+        m_readAheadBuf.reset();
+    }
+    m_pool.reset();
     m_stream.close();
 }
 
@@ -313,24 +416,6 @@ point_count_t BpfReader::read(PointViewPtr data, point_count_t count)
 }
 
 
-size_t BpfReader::readBlock(std::vector<char>& outBuf, size_t index)
-{
-    uint32_t finalBytes;
-    uint32_t compressBytes;
-
-    m_stream >> finalBytes;
-    m_stream >> compressBytes;
-
-    std::vector<char> in(compressBytes);
-
-    // Fill the input bytes from the stream.
-    m_stream.get(in);
-    int ret = inflate(in.data(), compressBytes,
-        outBuf.data() + index, finalBytes);
-    return (ret ? 0 : finalBytes);
-}
-
-
 bool BpfReader::eof()
 {
     return m_index >= numPoints();
@@ -347,6 +432,8 @@ void BpfReader::readPointMajor(PointRef& point)
         float f;
 
         m_stream >> f;
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+            continue;
         double d = f + m_dims[dim].m_offset;
         if (m_dims[dim].m_id == Dimension::Id::X)
             x = d;
@@ -379,7 +466,9 @@ point_count_t BpfReader::readPointMajor(PointViewPtr view, point_count_t count)
             float f;
 
             m_stream >> f;
-            view->setField(m_dims[d].m_id, nextId, f + m_dims[d].m_offset);
+            if (m_dims[d].m_id != Dimension::Id::Unknown)
+                view->setField(m_dims[d].m_id, nextId,
+                    f + m_dims[d].m_offset);
         }
 
         // Transformation only applies to X, Y and Z
@@ -404,28 +493,7 @@ point_count_t BpfReader::readPointMajor(PointViewPtr view, point_count_t count)
 
 void BpfReader::readDimMajor(PointRef& point)
 {
-    if (m_streams.empty())
-    {
-        for (std::size_t dim(0); dim < m_dims.size(); ++dim)
-        {
-            std::streamoff offset = sizeof(float) * dim * numPoints();
-
-            m_streams.emplace_back(new ILeStream());
-            m_streams.back()->open(m_filename);
-
-            if (m_header.m_compression)
-            {
-                m_charbufs.emplace_back(new Charbuf());
-                m_charbufs.back()->initialize(
-                        m_deflateBuf.data(), m_deflateBuf.size(), m_start);
-
-                m_streams.back()->pushStream(
-                        new std::istream(m_charbufs.back().get()));
-            }
-
-            m_streams.back()->seek(m_start + offset);
-        }
-    }
+    openDimStreams();
 
     double x(0), y(0), z(0);
     float f(0);
@@ -433,6 +501,8 @@ void BpfReader::readDimMajor(PointRef& point)
 
     for (size_t dim = 0; dim < m_dims.size(); ++dim)
     {
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+            continue;
         *m_streams[dim] >> f;
         d = f + m_dims[dim].m_offset;
         if (m_dims[dim].m_id == Dimension::Id::X)
@@ -459,18 +529,30 @@ point_count_t BpfReader::readDimMajor(PointViewPtr data, point_count_t count)
     PointId idx(0);
     PointId startId = data->size();
     point_count_t numRead = 0;
-    for (size_t d = 0; d < m_dims.size(); ++d)
+    if (m_header.m_compression)
+    {
+        numRead = readDimMajorStreams(data, count);
+        idx = m_index + numRead;
+    }
+    else
     {
-        idx = m_index;
-        PointId nextId = startId;
-        numRead = 0;
-        seekDimMajor(d, idx);
-        for (; numRead < count && idx < numPoints(); idx++, numRead++, nextId++)
+        for (size_t d = 0; d < m_dims.size(); ++d)
         {
-            float f;
+            if (m_dims[d].m_id == Dimension::Id::Unknown)
+                continue;
+            idx = m_index;
+            PointId nextId = startId;
+            numRead = 0;
+            seekDimMajor(d, idx);
+            for (; numRead < count && idx < numPoints();
+                idx++, numRead++, nextId++)
+            {
+                float f;
 
-            m_stream >> f;
-            data->setField(m_dims[d].m_id, nextId, f + m_dims[d].m_offset);
+                m_stream >> f;
+                data->setField(m_dims[d].m_id, nextId,
+                    f + m_dims[d].m_offset);
+            }
         }
     }
     m_index = idx;
@@ -494,6 +576,83 @@ point_count_t BpfReader::readDimMajor(PointViewPtr data, point_count_t count)
 }
 
 
+// Read dimension-major data through a stream per dimension.  Seeking
+// between dimensions of compressed data would restart inflation of each
+// dimension's block, so instead each stream inflates its dimension
+// sequentially.  Points are read in blocks, with the dimensions read in
+// parallel.
+point_count_t BpfReader::readDimMajorStreams(PointViewPtr data,
+    point_count_t count)
+{
+    const point_count_t BlockPoints = 65536;
+
+    openDimStreams();
+    count = (std::min)(count, numPoints() - m_index);
+
+    std::vector<std::vector<float>> values(m_dims.size());
+    PointId nextId = data->size();
+    for (point_count_t numRead = 0; numRead < count;)
+    {
+        point_count_t n = (std::min)(BlockPoints, count - numRead);
+        for (size_t d = 0; d < m_dims.size(); ++d)
+            if (m_dims[d].m_id != Dimension::Id::Unknown)
+                m_pool->add([this, &values, d, n]()
+                {
+                    std::vector<float>& v = values[d];
+                    v.resize(n);
+                    for (float& f : v)
+                        *m_streams[d] >> f;
+                });
+        m_pool->await();
+
+        for (point_count_t i = 0; i < n; ++i, ++nextId)
+            for (size_t d = 0; d < m_dims.size(); ++d)
+                if (m_dims[d].m_id != Dimension::Id::Unknown)
+                    data->setField(m_dims[d].m_id, nextId,
+                        values[d][i] + m_dims[d].m_offset);
+        numRead += n;
+    }
+    return count;
+}
+
+
+// Open a stream positioned at the current point for each dimension of
+// dimension-major data.
+void BpfReader::openDimStreams()
+{
+    if (m_streams.size())
+        return;
+
+    for (size_t dim = 0; dim < m_dims.size(); ++dim)
+    {
+        // Unused dimensions aren't read.
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+        {
+            m_streams.emplace_back();
+            continue;
+        }
+
+        std::streamoff offset = sizeof(float) * (dim * numPoints() + m_index);
+
+        if (m_header.m_compression)
+        {
+            m_dimInflateBufs.emplace_back(new BpfDecompressor(m_filename,
+                m_blocks, m_start, nullptr));
+            m_dimInflateStreams.emplace_back(
+                new std::istream(m_dimInflateBufs.back().get()));
+            m_streams.emplace_back(
+                new ILeStream(m_dimInflateStreams.back().get()));
+        }
+        else
+        {
+            m_streams.emplace_back(new ILeStream());
+            m_streams.back()->open(m_filename);
+        }
+        m_streams.back()->seek(m_start + offset);
+    }
+}
+
+
 void BpfReader::readByteMajor(PointRef& point)
 {
     // We need a temp buffer for the point data
@@ -507,6 +666,8 @@ void BpfReader::readByteMajor(PointRef& point)
 
     for (size_t dim = 0; dim < m_dims.size(); ++dim)
     {
+        if (m_dims[dim].m_id == Dimension::Id::Unknown)
+            continue;
         u.u32 = 0;
         for (size_t b = 0; b < sizeof(float); ++b)
         {
@@ -551,6 +712,8 @@ point_count_t BpfReader::readByteMajor(PointViewPtr data, point_count_t count)
 
     for (size_t d = 0; d < m_dims.size(); ++d)
     {
+        if (m_dims[d].m_id == Dimension::Id::Unknown)
+            continue;
         for (size_t b = 0; b < sizeof(float); ++b)
         {
             idx = m_index;
@@ -621,33 +784,4 @@ void BpfReader::seekByteMajor(size_t dimIdx, size_t byteIdx, PointId ptIdx)
     m_stream.seek(m_start + offset);
 }
 
-
-int BpfReader::inflate(char *buf, uint32_t insize,
-    char *outbuf, uint32_t outsize)
-{
-   if (insize == 0)
-        return 0;
-
-    int ret;
-    z_stream strm;
-
-    /* allocate inflate state */
-    strm.zalloc = Z_NULL;
-    strm.zfree = Z_NULL;
-    strm.opaque = Z_NULL;
-    strm.avail_in = 0;
-    strm.next_in = Z_NULL;
-    if (inflateInit(&strm) != Z_OK)
-        return -2;
-
-    strm.avail_in = insize;
-    strm.next_in = (unsigned char *)buf;
-    strm.avail_out = outsize;
-    strm.next_out = (unsigned char *)outbuf;
-
-    ret = ::inflate(&strm, Z_NO_FLUSH);
-    (void)inflateEnd(&strm);
-    return ret == Z_STREAM_END ? 0 : -1;
-}
-
 } //namespace pdal
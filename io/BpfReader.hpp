@@ -42,9 +42,11 @@
 #include <pdal/Reader.hpp>
 #include <pdal/util/Charbuf.hpp>
 #include <pdal/util/IStream.hpp>
+#include <pdal/util/ReadAheadBuf.hpp>
 #include <pdal/pdal_export.hpp>
 #include <pdal/plugin.hpp>
 
+#include "BpfDecompressor.hpp"
 #include "BpfHeader.hpp"
 
 #include <vector>
@@ -55,9 +57,14 @@ extern "C" PF_ExitFunc BpfReader_InitPlugin();
 namespace pdal
 {
 
+class ThreadPool;
+
 class PDAL_DLL BpfReader : public Reader
 {
 public:
+    BpfReader();
+    ~BpfReader();
+
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
@@ -77,16 +84,30 @@ private:
     std::streampos m_start;
     /// Index of the next point to read.
     point_count_t m_index;
-    /// Buffer for deflated data.
+    /// Locations of compressed blocks of point data.
+    BpfCompressedBlockList m_blocks;
+    /// Buffer for inflated byte-major data.
     std::vector<char> m_deflateBuf;
-    /// Streambuf for deflated data.
-    Charbuf m_charbuf;
+    /// Streambuf and stream for compressed point data.
+    std::unique_ptr<std::streambuf> m_inflateBuf;
+    std::unique_ptr<std::istream> m_inflateStream;
+    /// Number of threads used to inflate compressed data.
+    uint32_t m_threads;
+    std::unique_ptr<ThreadPool> m_pool;
+    /// Size of read-ahead buffers.
+    size_t m_readAhead;
+    /// Read-ahead streambuf and stream for the file, if used.
+    std::unique_ptr<ReadAheadBuf> m_readAheadBuf;
+    std::unique_ptr<std::istream> m_readAheadStream;
 
-    // For dimension-major point-at-a-time usage.
+    // For dimension-major point-at-a-time usage and reading of compressed
+    // dimension-major data.
     std::vector<std::unique_ptr<ILeStream>> m_streams;
-    std::vector<std::unique_ptr<Charbuf>> m_charbufs;
+    std::vector<std::unique_ptr<BpfDecompressor>> m_dimInflateBufs;
+    std::vector<std::unique_ptr<std::istream>> m_dimInflateStreams;
 
     virtual QuickInfo inspect();
+    virtual void addArgs(ProgramArgs& args);
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr Layout);
     virtual void ready(PointTableRef table);
@@ -104,9 +125,11 @@ private:
     point_count_t readDimMajor(PointViewPtr data, point_count_t count);
     void readByteMajor(PointRef& point);
     point_count_t readByteMajor(PointViewPtr data, point_count_t count);
-    size_t readBlock(std::vector<char>& outBuf, size_t index);
+    point_count_t readDimMajorStreams(PointViewPtr data, point_count_t count);
+    void openDimStreams();
+    void readBlockIndex();
+    void inflateAll();
     bool eof();
-    int inflate(char *inbuf, uint32_t insize, char *outbuf, uint32_t outsize);
 
     void seekPointMajor(PointId ptIdx);
     void seekDimMajor(size_t dimIdx, PointId ptIdx);
@@ -40,6 +40,7 @@
 #include <pdal/pdal_export.hpp>
 #include <pdal/util/FileUtils.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include <zlib.h>
 
@@ -62,10 +63,22 @@ CREATE_STATIC_PLUGIN(1, 0, BpfWriter, Writer, s_info)
 
 std::string BpfWriter::getName() const { return s_info.name; }
 
+BpfWriter::BpfWriter()
+{}
+
+
+BpfWriter::~BpfWriter()
+{}
+
+
 void BpfWriter::addArgs(ProgramArgs& args)
 {
     args.add("filename", "Output filename", m_filename).setPositional();
     args.add("compression", "Output compression", m_compression);
+    args.add("compression_level", "zlib compression level (0-9)",
+        m_compressionLevel, 6);
+    args.add("threads", "Number of threads used to compress point data",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
     args.add("header_data", "Base64-encoded header data", m_extraDataSpec);
     args.add("format", "Output format", m_header.m_pointFormat,
         BpfFormat::DimMajor);
@@ -77,10 +90,26 @@ void BpfWriter::addArgs(ProgramArgs& args)
 }
 
 
+// Only X, Y, Z and the dimensions listed in 'output_dims' are used when
+// the option is given.
+bool BpfWriter::usedDimensions(StringList& dims) const
+{
+    if (m_outputDims.empty())
+        return false;
+
+    dims = m_outputDims;
+    dims.insert(dims.end(), { "X", "Y", "Z" });
+    return true;
+}
+
+
 void BpfWriter::initialize()
 {
     m_header.m_compression = Utils::toNative(
             m_compression ? BpfCompression::Zlib : BpfCompression::None);
+    if (m_compressionLevel < 0 || m_compressionLevel > 9)
+        throwError("Option 'compression_level' must be in the range [0, 9].");
+    m_pool.reset(new ThreadPool((std::max)(m_threads, 1U)));
     m_extraData = Utils::base64_decode(m_extraDataSpec);
     if (m_header.m_coordId == -9999)
     {
@@ -241,7 +270,8 @@ void BpfWriter::writePointMajor(const PointView* data)
     // For compression we're going to write to a buffer so that it can be
     // compressed before it's written to the file stream.
     BpfCompressor compressor(m_stream,
-        blockpoints * sizeof(float) * m_dims.size());
+        blockpoints * sizeof(float) * m_dims.size(), m_compressionLevel,
+        *m_pool);
     PointId idx = 0;
     while (idx < data->size())
     {
@@ -258,35 +288,40 @@ void BpfWriter::writePointMajor(const PointView* data)
             }
         }
         if (m_header.m_compression)
-        {
-            compressor.compress();
             compressor.finish();
-        }
     }
+    if (m_header.m_compression)
+        compressor.flush();
 }
 
 
 void BpfWriter::writeDimMajor(const PointView* data)
 {
-    // We're going to pretend for now that we only even have one point buffer.
-    BpfCompressor compressor(m_stream, data->size() * sizeof(float));
+    // Each dimension is compressed in blocks of up to 1MB so that the
+    // blocks can be compressed in parallel.
+    size_t blockpoints = std::min<point_count_t>(1 << 18, data->size());
+    BpfCompressor compressor(m_stream, blockpoints * sizeof(float),
+        m_compressionLevel, *m_pool);
 
     for (auto & bpfDim : m_dims)
     {
-
-        if (m_header.m_compression)
-            compressor.startBlock();
-        for (PointId idx = 0; idx < data->size(); ++idx)
-        {
-            double d = getAdjustedValue(data, bpfDim, idx);
-            m_stream << (float)d;
-        }
-        if (m_header.m_compression)
+        PointId idx = 0;
+        while (idx < data->size())
         {
-            compressor.compress();
-            compressor.finish();
+            if (m_header.m_compression)
+                compressor.startBlock();
+            for (size_t blockId = 0; idx < data->size() &&
+                blockId < blockpoints; ++idx, ++blockId)
+            {
+                double d = getAdjustedValue(data, bpfDim, idx);
+                m_stream << (float)d;
+            }
+            if (m_header.m_compression)
+                compressor.finish();
         }
     }
+    if (m_header.m_compression)
+        compressor.flush();
 }
 
 
@@ -298,29 +333,35 @@ void BpfWriter::writeByteMajor(const PointView* data)
         uint32_t u32;
     } uu;
 
-    // We're going to pretend for now that we only ever have one point buffer.
-    BpfCompressor compressor(m_stream,
-        data->size() * sizeof(float) * m_dims.size());
+    // Each byte of each dimension is compressed in blocks of up to 1MB so
+    // that the blocks can be compressed in parallel.
+    size_t blockpoints = std::min<point_count_t>(1 << 20, data->size());
+    BpfCompressor compressor(m_stream, blockpoints, m_compressionLevel,
+        *m_pool);
 
-    if (m_header.m_compression)
-        compressor.startBlock();
     for (auto & bpfDim : m_dims)
     {
         for (size_t b = 0; b < sizeof(float); b++)
         {
-            for (PointId idx = 0; idx < data->size(); ++idx)
+            PointId idx = 0;
+            while (idx < data->size())
             {
-                uu.f = (float)getAdjustedValue(data, bpfDim, idx);
-                uint8_t u8 = (uint8_t)(uu.u32 >> (b * CHAR_BIT));
-                m_stream << u8;
+                if (m_header.m_compression)
+                    compressor.startBlock();
+                for (size_t blockId = 0; idx < data->size() &&
+                    blockId < blockpoints; ++idx, ++blockId)
+                {
+                    uu.f = (float)getAdjustedValue(data, bpfDim, idx);
+                    uint8_t u8 = (uint8_t)(uu.u32 >> (b * CHAR_BIT));
+                    m_stream << u8;
+                }
+                if (m_header.m_compression)
+                    compressor.finish();
             }
         }
     }
     if (m_header.m_compression)
-    {
-        compressor.compress();
-        compressor.finish();
-    }
+        compressor.flush();
 }
 
 
@@ -44,6 +44,7 @@
 #include <pdal/util/OStream.hpp>
 #include <pdal/plugin.hpp>
 
+#include <memory>
 #include <vector>
 
 extern "C" int32_t BpfWriter_ExitFunc();
@@ -52,9 +53,14 @@ extern "C" PF_ExitFunc BpfWriter_InitPlugin();
 namespace pdal
 {
 
+class ThreadPool;
+
 class PDAL_DLL BpfWriter : public FlexWriter
 {
 public:
+    BpfWriter();
+    ~BpfWriter();
+
     static void * create();
     static int32_t destroy(void *);
     std::string getName() const;
@@ -67,11 +73,15 @@ private:
     std::vector<uint8_t> m_extraData;
     std::vector<BpfUlemFile> m_bundledFiles;
     bool m_compression;
+    int m_compressionLevel;
+    uint32_t m_threads;
+    std::unique_ptr<ThreadPool> m_pool;
     std::string m_extraDataSpec;
     StringList m_bundledFilesSpec;
     std::string m_curFilename;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void initialize();
     virtual void prepared(PointTableRef table);
     virtual void readyFile(const std::string& filename,
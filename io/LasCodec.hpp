@@ -0,0 +1,306 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <cstring>
+
+#include <pdal/PointLayout.hpp>
+#include <pdal/util/portable_endian.hpp>
+
+#include "LasError.hpp"
+
+namespace pdal
+{
+
+// Point data record codecs specialized at compile time for each supported
+// point format, so that a record is read or written with fixed field
+// positions and no per-field type dispatch.  The point side uses the raw
+// memory of points whose LAS dimensions have the types the LAS reader
+// registers.
+namespace LasCodec
+{
+
+// Record layout of a point format.
+template<int FORMAT>
+struct Format
+{
+    static const bool v14 = FORMAT > 5;
+    static const bool time = FORMAT == 1 || FORMAT >= 3;
+    static const bool color = FORMAT == 2 || FORMAT == 3 || FORMAT == 7 ||
+        FORMAT == 8;
+    static const bool infrared = FORMAT == 8;
+
+    static const size_t timePos = v14 ? 22 : 20;
+    static const size_t colorPos = v14 ? 30 : (time ? 28 : 20);
+    static const size_t infraredPos = 36;
+};
+
+enum Field
+{
+    X, Y, Z, Intensity, ReturnNumber, NumberOfReturns, ScanDirectionFlag,
+    EdgeOfFlightLine, Classification, ScanAngleRank, UserData, PointSourceId,
+    GpsTime, Red, Green, Blue, Infrared, ScanChannel, ClassFlags, NumFields
+};
+
+// Positions of the LAS dimensions in the points of a layout.
+class Offsets
+{
+public:
+    // Locate the LAS dimensions of a layout.  Returns false if a dimension
+    // is present with a type other than the one the LAS reader registers,
+    // in which case points must be read and written dimension by
+    // dimension.
+    bool init(const PointLayout& layout)
+    {
+        using namespace Dimension;
+
+        static const Id ids[NumFields] =
+        {
+            Id::X, Id::Y, Id::Z, Id::Intensity, Id::ReturnNumber,
+            Id::NumberOfReturns, Id::ScanDirectionFlag, Id::EdgeOfFlightLine,
+            Id::Classification, Id::ScanAngleRank, Id::UserData,
+            Id::PointSourceId, Id::GpsTime, Id::Red, Id::Green, Id::Blue,
+            Id::Infrared, Id::ScanChannel, Id::ClassFlags
+        };
+        static const Type types[NumFields] =
+        {
+            Type::Double, Type::Double, Type::Double, Type::Unsigned16,
+            Type::Unsigned8, Type::Unsigned8, Type::Unsigned8,
+            Type::Unsigned8, Type::Unsigned8, Type::Float, Type::Unsigned8,
+            Type::Unsigned16, Type::Double, Type::Unsigned16,
+            Type::Unsigned16, Type::Unsigned16, Type::Unsigned16,
+            Type::Unsigned8, Type::Unsigned8
+        };
+
+        for (int f = 0; f < NumFields; ++f)
+        {
+            m_pos[f] = -1;
+            if (!layout.hasDim(ids[f]))
+                continue;
+            if (layout.dimType(ids[f]) != types[f])
+                return false;
+            m_pos[f] = layout.dimDetail(ids[f])->offset();
+        }
+        return true;
+    }
+
+    // Whether a dimension is in the layout.
+    bool has(Field f) const
+        { return m_pos[f] >= 0; }
+
+    int operator[](Field f) const
+        { return m_pos[f]; }
+
+private:
+    int m_pos[NumFields];
+};
+
+template<size_t SIZE> struct Bits;
+template<> struct Bits<1>
+{
+    typedef uint8_t type;
+    static type swap(type v) { return v; }
+};
+template<> struct Bits<2>
+{
+    typedef uint16_t type;
+    static type swap(type v) { return le16toh(v); }
+};
+template<> struct Bits<4>
+{
+    typedef uint32_t type;
+    static type swap(type v) { return le32toh(v); }
+};
+template<> struct Bits<8>
+{
+    typedef uint64_t type;
+    static type swap(type v) { return le64toh(v); }
+};
+
+// Read a little-endian value from a record.
+template<typename T>
+T get(const char *pos)
+{
+    typedef Bits<sizeof(T)> B;
+
+    typename B::type bits;
+    std::memcpy(&bits, pos, sizeof(T));
+    bits = B::swap(bits);
+    T v;
+    std::memcpy(&v, &bits, sizeof(T));
+    return v;
+}
+
+// Write a little-endian value to a record.
+template<typename T>
+void put(char *pos, T v)
+{
+    typedef Bits<sizeof(T)> B;
+
+    typename B::type bits;
+    std::memcpy(&bits, &v, sizeof(T));
+    bits = B::swap(bits);
+    std::memcpy(pos, &bits, sizeof(T));
+}
+
+// Read a dimension of a point.
+template<typename T>
+T load(const char *point, int offset)
+{
+    T v;
+    std::memcpy(&v, point + offset, sizeof(T));
+    return v;
+}
+
+// Write a dimension of a point if it's in the layout.
+template<typename T>
+void store(char *point, const Offsets& o, Field f, T v)
+{
+    if (o.has(f))
+        std::memcpy(point + o[f], &v, sizeof(T));
+}
+
+// Decode a record into a point.  Dimensions not in the layout are skipped.
+template<int FORMAT>
+void decode(const char *rec, char *point, const Offsets& o,
+    const double *scale, const double *offset, LasError& error)
+{
+    typedef Format<FORMAT> F;
+
+    store<double>(point, o, X, get<int32_t>(rec) * scale[0] + offset[0]);
+    store<double>(point, o, Y, get<int32_t>(rec + 4) * scale[1] + offset[1]);
+    store<double>(point, o, Z, get<int32_t>(rec + 8) * scale[2] + offset[2]);
+    store<uint16_t>(point, o, Intensity, get<uint16_t>(rec + 12));
+
+    uint8_t returnInfo = rec[14];
+    uint8_t flags = F::v14 ? rec[15] : returnInfo;
+    if (F::v14)
+    {
+        store<uint8_t>(point, o, ReturnNumber, returnInfo & 0x0F);
+        store<uint8_t>(point, o, NumberOfReturns, (returnInfo >> 4) & 0x0F);
+        store<uint8_t>(point, o, ClassFlags, flags & 0x0F);
+        store<uint8_t>(point, o, ScanChannel, (flags >> 4) & 0x03);
+        store<uint8_t>(point, o, Classification, rec[16]);
+        store<uint8_t>(point, o, UserData, rec[17]);
+        store<float>(point, o, ScanAngleRank,
+            (float)(get<int16_t>(rec + 18) * .006));
+        store<uint16_t>(point, o, PointSourceId, get<uint16_t>(rec + 20));
+    }
+    else
+    {
+        uint8_t returnNum = returnInfo & 0x07;
+        uint8_t numReturns = (returnInfo >> 3) & 0x07;
+        if (returnNum == 0 || returnNum > 5)
+            error.returnNumWarning(returnNum);
+        if (numReturns == 0 || numReturns > 5)
+            error.numReturnsWarning(numReturns);
+        store<uint8_t>(point, o, ReturnNumber, returnNum);
+        store<uint8_t>(point, o, NumberOfReturns, numReturns);
+        store<uint8_t>(point, o, Classification, rec[15]);
+        store<float>(point, o, ScanAngleRank, (float)(int8_t)rec[16]);
+        store<uint8_t>(point, o, UserData, rec[17]);
+        store<uint16_t>(point, o, PointSourceId, get<uint16_t>(rec + 18));
+    }
+    store<uint8_t>(point, o, ScanDirectionFlag, (flags >> 6) & 0x01);
+    store<uint8_t>(point, o, EdgeOfFlightLine, (flags >> 7) & 0x01);
+
+    if (F::time)
+        store<double>(point, o, GpsTime, get<double>(rec + F::timePos));
+    if (F::color)
+    {
+        store<uint16_t>(point, o, Red, get<uint16_t>(rec + F::colorPos));
+        store<uint16_t>(point, o, Green,
+            get<uint16_t>(rec + F::colorPos + 2));
+        store<uint16_t>(point, o, Blue, get<uint16_t>(rec + F::colorPos + 4));
+    }
+    if (F::infrared)
+        store<uint16_t>(point, o, Infrared,
+            get<uint16_t>(rec + F::infraredPos));
+}
+
+// Encode the fields of a point that follow the return information into
+// a record.  The caller writes the coordinates, intensity and return
+// information, which need checks.  Dimensions not in the layout are
+// written as zero.
+template<int FORMAT>
+void encode(const char *point, char *rec, const Offsets& o,
+    int8_t scanAngleRank)
+{
+    typedef Format<FORMAT> F;
+
+    auto u8 = [point, &o](Field f) -> uint8_t
+        { return o.has(f) ? load<uint8_t>(point, o[f]) : 0; };
+    auto u16 = [point, &o](Field f) -> uint16_t
+        { return o.has(f) ? load<uint16_t>(point, o[f]) : 0; };
+
+    uint8_t scanDirectionFlag = u8(ScanDirectionFlag);
+    uint8_t edgeOfFlightLine = u8(EdgeOfFlightLine);
+    if (F::v14)
+    {
+        rec[15] = (u8(ClassFlags) & 0x0F) | ((u8(ScanChannel) & 0x03) << 4) |
+            ((scanDirectionFlag & 0x01) << 6) |
+            ((edgeOfFlightLine & 0x01) << 7);
+        rec[16] = u8(Classification);
+        rec[17] = u8(UserData);
+        float angle = o.has(ScanAngleRank) ?
+            load<float>(point, o[ScanAngleRank]) : 0;
+        put<int16_t>(rec + 18, (int16_t)(angle / .006));
+        put<uint16_t>(rec + 20, u16(PointSourceId));
+    }
+    else
+    {
+        rec[14] |= (scanDirectionFlag << 6) | (edgeOfFlightLine << 7);
+        rec[15] = u8(Classification);
+        rec[16] = scanAngleRank;
+        rec[17] = u8(UserData);
+        put<uint16_t>(rec + 18, u16(PointSourceId));
+    }
+
+    if (F::time)
+        put<double>(rec + F::timePos,
+            o.has(GpsTime) ? load<double>(point, o[GpsTime]) : 0.0);
+    if (F::color)
+    {
+        put<uint16_t>(rec + F::colorPos, u16(Red));
+        put<uint16_t>(rec + F::colorPos + 2, u16(Green));
+        put<uint16_t>(rec + F::colorPos + 4, u16(Blue));
+    }
+    if (F::infrared)
+        put<uint16_t>(rec + F::infraredPos, u16(Infrared));
+}
+
+} // namespace LasCodec
+
+} // namespace pdal
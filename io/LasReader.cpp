@@ -34,6 +34,7 @@
 
 #include "LasReader.hpp"
 
+#include <algorithm>
 #include <sstream>
 #include <string.h>
 
@@ -70,6 +71,11 @@ void LasReader::addArgs(ProgramArgs& args)
     args.add("extra_dims", "Dimensions to assign to extra byte data",
         m_extraDimSpec);
     args.add("compression", "Decompressor to use", m_compression, "EITHER");
+    args.add("read_ahead", "Size in bytes of each of the two buffers "
+        "filled in the background while points are decoded (0 to disable)",
+        m_readAhead, (size_t)ReadAheadBuf::DefaultBufSize);
+    args.add("memory_map", "Decode uncompressed points directly from the "
+        "file mapped into memory", m_memoryMap);
 }
 
 
@@ -181,12 +187,70 @@ void LasReader::initializeLocal(PointTableRef table, MetadataNode& m)
 }
 
 
+namespace
+{
+
+template<int FORMAT>
+void decodeRecords(const char *buf, size_t pointLen, point_count_t count,
+    PointView& view, const LasCodec::Offsets& dims, const LasHeader& h,
+    LasError& error)
+{
+    const double scale[] = { h.scaleX(), h.scaleY(), h.scaleZ() };
+    const double offset[] = { h.offsetX(), h.offsetY(), h.offsetZ() };
+
+    for (point_count_t i = 0; i < count; ++i)
+    {
+        char *point = view.getOrAddPoint(view.size());
+        LasCodec::decode<FORMAT>(buf, point, dims, scale, offset, error);
+        buf += pointLen;
+    }
+}
+
+} // unnamed namespace
+
+
 void LasReader::ready(PointTableRef table)
 {
     createStream();
     std::istream *stream(m_streamIf->m_istream);
 
     m_index = 0;
+
+    // Uncompressed records are decoded a block at a time by the codec for
+    // the point format, unless other stages changed the type of a LAS
+    // dimension or there are extra bytes to load.
+    auto loaded = [](const ExtraDim& dim)
+        { return dim.m_dimType.m_type != Dimension::Type::None; };
+    m_decode = nullptr;
+    if (std::none_of(m_extraDims.begin(), m_extraDims.end(), loaded) &&
+        m_dims.init(*table.layout()))
+    {
+        switch (m_header.pointFormat())
+        {
+        case 0:
+            m_decode = &decodeRecords<0>;
+            break;
+        case 1:
+            m_decode = &decodeRecords<1>;
+            break;
+        case 2:
+            m_decode = &decodeRecords<2>;
+            break;
+        case 3:
+            m_decode = &decodeRecords<3>;
+            break;
+        case 6:
+            m_decode = &decodeRecords<6>;
+            break;
+        case 7:
+            m_decode = &decodeRecords<7>;
+            break;
+        case 8:
+            m_decode = &decodeRecords<8>;
+            break;
+        }
+    }
+
     if (m_header.compressed())
     {
 #ifdef PDAL_HAVE_LASZIP
@@ -470,33 +534,41 @@ void LasReader::addDimensions(PointLayoutPtr layout)
 {
     using namespace Dimension;
 
-    layout->registerDim(Id::X, Type::Double);
-    layout->registerDim(Id::Y, Type::Double);
-    layout->registerDim(Id::Z, Type::Double);
-    layout->registerDim(Id::Intensity, Type::Unsigned16);
-    layout->registerDim(Id::ReturnNumber, Type::Unsigned8);
-    layout->registerDim(Id::NumberOfReturns, Type::Unsigned8);
-    layout->registerDim(Id::ScanDirectionFlag, Type::Unsigned8);
-    layout->registerDim(Id::EdgeOfFlightLine, Type::Unsigned8);
-    layout->registerDim(Id::Classification, Type::Unsigned8);
-    layout->registerDim(Id::ScanAngleRank, Type::Float);
-    layout->registerDim(Id::UserData, Type::Unsigned8);
-    layout->registerDim(Id::PointSourceId, Type::Unsigned16);
+    // Dimensions that aren't used by later stages aren't registered, and
+    // so aren't loaded.
+    auto addDim = [this, &layout](Id id, Type type)
+    {
+        if (dimensionUsed(Dimension::name(id)))
+            layout->registerDim(id, type);
+    };
+
+    addDim(Id::X, Type::Double);
+    addDim(Id::Y, Type::Double);
+    addDim(Id::Z, Type::Double);
+    addDim(Id::Intensity, Type::Unsigned16);
+    addDim(Id::ReturnNumber, Type::Unsigned8);
+    addDim(Id::NumberOfReturns, Type::Unsigned8);
+    addDim(Id::ScanDirectionFlag, Type::Unsigned8);
+    addDim(Id::EdgeOfFlightLine, Type::Unsigned8);
+    addDim(Id::Classification, Type::Unsigned8);
+    addDim(Id::ScanAngleRank, Type::Float);
+    addDim(Id::UserData, Type::Unsigned8);
+    addDim(Id::PointSourceId, Type::Unsigned16);
 
     if (m_header.hasTime())
-        layout->registerDim(Id::GpsTime, Type::Double);
+        addDim(Id::GpsTime, Type::Double);
     if (m_header.hasColor())
     {
-        layout->registerDim(Id::Red, Type::Unsigned16);
-        layout->registerDim(Id::Green, Type::Unsigned16);
-        layout->registerDim(Id::Blue, Type::Unsigned16);
+        addDim(Id::Red, Type::Unsigned16);
+        addDim(Id::Green, Type::Unsigned16);
+        addDim(Id::Blue, Type::Unsigned16);
     }
     if (m_header.hasInfrared())
-        layout->registerDim(Id::Infrared);
+        addDim(Id::Infrared, defaultType(Id::Infrared));
     if (m_header.versionAtLeast(1, 4))
     {
-        layout->registerDim(Id::ScanChannel);
-        layout->registerDim(Id::ClassFlags);
+        addDim(Id::ScanChannel, defaultType(Id::ScanChannel));
+        addDim(Id::ClassFlags, defaultType(Id::ClassFlags));
     }
 
     for (auto& dim : m_extraDims)
@@ -504,6 +576,13 @@ void LasReader::addDimensions(PointLayoutPtr layout)
         Dimension::Type type = dim.m_dimType.m_type;
         if (type == Dimension::Type::None)
             continue;
+        // Unused extra bytes are skipped like those of undefined type.
+        if (!dimensionUsed(dim.m_name))
+        {
+            dim.m_size = Dimension::size(type);
+            dim.m_dimType.m_type = Dimension::Type::None;
+            continue;
+        }
         if (dim.m_dimType.m_xform.nonstandard())
             type = Dimension::Type::Double;
         dim.m_dimType.m_id = layout->assignDim(dim.m_name, type);
@@ -532,7 +611,8 @@ bool LasReader::processOne(PointRef& point)
                 error += std::string(err) + ".";
                 throwError(error);
             }
-            loadPoint(point, (char *)m_zipPoint->m_lz_point_data.data(),
+            loadPoint(point,
+                (const char *)m_zipPoint->m_lz_point_data.data(),
                 pointLen);
         }
 #endif
@@ -549,6 +629,13 @@ bool LasReader::processOne(PointRef& point)
             "LAZperf decompression library.");
 #endif
     } // compression
+    else if (m_streamIf->data())
+    {
+        const char *pos;
+        if (mapFileBlock(m_index, 1, pos) == 0)
+            return false;
+        loadPoint(point, pos, pointLen);
+    }
     else
     {
         std::vector<char> buf(m_header.pointLen());
@@ -589,18 +676,41 @@ point_count_t LasReader::read(PointViewPtr view, point_count_t count)
     else
     {
         point_count_t remaining = count;
+        bool mapped = m_streamIf->data();
 
-        // Make a buffer at most a meg.
+        // Make a buffer at most a meg.  Records in a mapped file are
+        // decoded in place, a buffer's worth at a time.
         size_t bufsize = std::min<size_t>((point_count_t)1000000,
             count * pointLen);
-        std::vector<char> buf(bufsize);
+        std::vector<char> buf(mapped ? 0 : bufsize);
         try
         {
             do
             {
-                point_count_t blockPoints = readFileBlock(buf, remaining);
+                const char *pos = buf.data();
+                point_count_t blockPoints;
+                if (mapped)
+                {
+                    blockPoints = mapFileBlock(m_index + i,
+                        std::min<point_count_t>(remaining, bufsize / pointLen),
+                        pos);
+                    if (blockPoints == 0)
+                        break;
+                }
+                else
+                    blockPoints = readFileBlock(buf, remaining);
                 remaining -= blockPoints;
-                char *pos = buf.data();
+                if (m_decode)
+                {
+                    PointId first = view->size();
+                    m_decode(pos, pointLen, blockPoints, *view, m_dims,
+                        m_header, m_error);
+                    if (m_cb)
+                        for (PointId id = first; id < view->size(); ++id)
+                            m_cb(*view, id);
+                    i += blockPoints;
+                    continue;
+                }
                 while (blockPoints--)
                 {
                     PointId id = view->size();
@@ -647,7 +757,27 @@ point_count_t LasReader::readFileBlock(std::vector<char>& buf,
 }
 
 
-void LasReader::loadPoint(PointRef& point, char *buf, size_t bufsize)
+// Find up to 'maxpoints' records starting with record 'index' in the mapped
+// file.  Returns the number of records found and sets 'pos' to the first.
+point_count_t LasReader::mapFileBlock(PointId index, point_count_t maxpoints,
+    const char *& pos)
+{
+    size_t ptLen = m_header.pointLen();
+    uint64_t start = m_header.pointOffset() + (uint64_t)index * ptLen;
+    uint64_t size = m_streamIf->size();
+
+    // The file may be shorter than the header claims.
+    point_count_t blockpoints = 0;
+    if (start < size)
+        blockpoints = std::min<point_count_t>(maxpoints,
+            (size - start) / ptLen);
+    pos = m_streamIf->data() + start;
+    return blockpoints;
+}
+
+
+void LasReader::loadPoint(PointRef& point, const char *buf,
+    size_t bufsize)
 {
     if (m_header.has14Format())
         loadPointV14(point, buf, bufsize);
@@ -656,7 +786,8 @@ void LasReader::loadPoint(PointRef& point, char *buf, size_t bufsize)
 }
 
 
-void LasReader::loadPointV10(PointRef& point, char *buf, size_t bufsize)
+void LasReader::loadPointV10(PointRef& point, const char *buf,
+    size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
@@ -724,7 +855,8 @@ void LasReader::loadPointV10(PointRef& point, char *buf, size_t bufsize)
 
 }
 
-void LasReader::loadPointV14(PointRef& point, char *buf, size_t bufsize)
+void LasReader::loadPointV14(PointRef& point, const char *buf,
+    size_t bufsize)
 {
     LeExtractor istream(buf, bufsize);
 
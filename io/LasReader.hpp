@@ -39,7 +39,11 @@
 #include <pdal/Compression.hpp>
 #include <pdal/PDALUtils.hpp>
 #include <pdal/Reader.hpp>
+#include <pdal/util/Charbuf.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ReadAheadBuf.hpp>
 
+#include "LasCodec.hpp"
 #include "LasError.hpp"
 #include "LasHeader.hpp"
 #include "LasUtils.hpp"
@@ -66,21 +70,62 @@ protected:
         {}
 
     public:
-        LasStreamIf(const std::string& filename)
-            { m_istream = Utils::openFile(filename); }
+        LasStreamIf(const std::string& filename, size_t readAhead = 0,
+                bool map = false) :
+            m_istream(nullptr)
+        {
+            if (map)
+            {
+                m_map = FileUtils::mapFile(filename);
+                if (m_map.addr())
+                {
+                    m_charbuf.initialize((char *)m_map.addr(), m_map.size());
+                    m_istream = new std::istream(&m_charbuf);
+                    return;
+                }
+            }
+            if (readAhead && FileUtils::fileExists(filename))
+            {
+                m_readAheadBuf.reset(new ReadAheadBuf(filename, readAhead));
+                if (m_readAheadBuf->isOpen())
+                {
+                    m_istream = new std::istream(m_readAheadBuf.get());
+                    return;
+                }
+                m_readAheadBuf.reset();
+            }
+            m_istream = Utils::openFile(filename);
+        }
 
         ~LasStreamIf()
         {
-            if (m_istream)
+            if (m_map.addr() || m_readAheadBuf)
+                delete m_istream;
+            else if (m_istream)
                 Utils::closeFile(m_istream);
+            FileUtils::unmapFile(m_map);
         }
 
+        // Contents of the file if it's memory mapped, otherwise null.
+        const char *data() const
+            { return (const char *)m_map.addr(); }
+        size_t size() const
+            { return m_map.size(); }
+        std::string mapError() const
+            { return m_map.what(); }
+
         std::istream *m_istream;
+
+    private:
+        std::unique_ptr<ReadAheadBuf> m_readAheadBuf;
+        FileUtils::MapContext m_map;
+        Charbuf m_charbuf;
     };
 
     friend class NitfReader;
 public:
-    LasReader() : pdal::Reader(), m_index(0)
+    LasReader() : pdal::Reader(), m_index(0), m_readAhead(0),
+        m_memoryMap(false), m_decode(nullptr)
         {}
 
     static void * create();
@@ -97,7 +142,9 @@ protected:
     {
         if (m_streamIf)
             std::cerr << "Attempt to create stream twice!\n";
-        m_streamIf.reset(new LasStreamIf(m_filename));
+        // Only uncompressed point data is read from a memory map.
+        bool map = m_memoryMap && !m_header.compressed();
+        m_streamIf.reset(new LasStreamIf(m_filename, m_readAhead, map));
         if (!m_streamIf->m_istream)
         {
             std::ostringstream oss;
@@ -105,11 +152,19 @@ protected:
                 << m_filename <<"' with error '" << strerror(errno) <<"'";
             throw pdal_error(oss.str());
         }
+        if (map && !m_streamIf->data())
+            log()->get(LogLevel::Warning) << m_streamIf->mapError() <<
+                "  Reading file without memory mapping.\n";
     }
 
     std::unique_ptr<LasStreamIf> m_streamIf;
 
 private:
+    // Decodes records into new points at the end of a view.
+    typedef void (*DecodeFunc)(const char *buf, size_t pointLen,
+        point_count_t count, PointView& view, const LasCodec::Offsets& dims,
+        const LasHeader& header, LasError& error);
+
     LasError m_error;
     LasHeader m_header;
     std::unique_ptr<LasZipPoint> m_zipPoint;
@@ -120,6 +175,10 @@ private:
     StringList m_extraDimSpec;
     std::vector<ExtraDim> m_extraDims;
     std::string m_compression;
+    size_t m_readAhead;
+    bool m_memoryMap;
+    LasCodec::Offsets m_dims;
+    DecodeFunc m_decode;
 
     virtual void addArgs(ProgramArgs& args);
     virtual void initialize(PointTableRef table)
@@ -138,12 +197,14 @@ private:
     void readExtraBytesVlr();
     void extractHeaderMetadata(MetadataNode& forward, MetadataNode& m);
     void extractVlrMetadata(MetadataNode& forward, MetadataNode& m);
-    void loadPoint(PointRef& point, char *buf, size_t bufsize);
-    void loadPointV10(PointRef& point, char *buf, size_t bufsize);
-    void loadPointV14(PointRef& point, char *buf, size_t bufsize);
+    void loadPoint(PointRef& point, const char *buf, size_t bufsize);
+    void loadPointV10(PointRef& point, const char *buf, size_t bufsize);
+    void loadPointV14(PointRef& point, const char *buf, size_t bufsize);
     void loadExtraDims(LeExtractor& istream, PointRef& data);
     point_count_t readFileBlock(std::vector<char>& buf,
         point_count_t maxPoints);
+    point_count_t mapFileBlock(PointId index, point_count_t maxpoints,
+        const char *& pos);
 
     LasReader& operator=(const LasReader&); // not implemented
     LasReader(const LasReader&); // not implemented
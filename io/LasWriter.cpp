@@ -66,7 +66,7 @@ CREATE_STATIC_PLUGIN(1, 0, LasWriter, Writer, s_info)
 std::string LasWriter::getName() const { return s_info.name; }
 
 LasWriter::LasWriter() : m_ostream(NULL), m_compression(LasCompression::None),
-    m_srsCnt(0)
+    m_srsCnt(0), m_fastFill(nullptr)
 {}
 
 
@@ -96,7 +96,8 @@ void LasWriter::addArgs(ProgramArgs& args)
         decltype(m_dataformatId)(3));
     args.add("format", "Point format", m_dataformatId,
         decltype(m_dataformatId)(3));
-    args.add("global_encoding", "Global encoding byte", m_globalEncoding);
+    args.add("global_encoding", "Global encoding byte", m_globalEncoding,
+        decltype(m_globalEncoding)(0));
     args.add("project_id", "Project ID", m_projectId);
     args.add("system_id", "System ID", m_systemId,
         decltype(m_systemId)(m_lasHeader.getSystemIdentifier()));
@@ -117,6 +118,41 @@ void LasWriter::addArgs(ProgramArgs& args)
     args.add("vlrs", "List of VLRs to set", m_userVLRs);
 }
 
+// The LAS dimensions and any dimensions listed in 'extra_dims' are used,
+// unless all dimensions are to be written as extra bytes.
+bool LasWriter::usedDimensions(StringList& dims) const
+{
+    using namespace Dimension;
+
+    std::vector<ExtraDim> extraDims;
+    try
+    {
+        extraDims = LasUtils::parse(m_extraDimSpec);
+    }
+    catch (const LasUtils::error&)
+    {
+        // Reported by initialize().
+        return false;
+    }
+    if (extraDims.size() == 1 && extraDims[0].m_name == "all")
+        return false;
+
+    static const Id lasDims[] =
+    {
+        Id::X, Id::Y, Id::Z, Id::Intensity, Id::ReturnNumber,
+        Id::NumberOfReturns, Id::ScanDirectionFlag, Id::EdgeOfFlightLine,
+        Id::Classification, Id::ScanAngleRank, Id::UserData,
+        Id::PointSourceId, Id::GpsTime, Id::Red, Id::Green, Id::Blue,
+        Id::Infrared, Id::ScanChannel, Id::ClassFlags
+    };
+    for (Id id : lasDims)
+        dims.push_back(Dimension::name(id));
+    for (const ExtraDim& dim : extraDims)
+        dims.push_back(dim.m_name);
+    return true;
+}
+
+
 void LasWriter::initialize()
 {
     std::string ext = FileUtils::extension(m_filename);
@@ -193,6 +229,38 @@ void LasWriter::prepared(PointTableRef table)
             "(" << Dimension::interpretationName(dim.m_dimType.m_type) <<
             ") " << " to LAS extra bytes." << std::endl;
     }
+
+    // Points are encoded by the codec for the point format unless other
+    // stages changed the type of a LAS dimension or there are extra bytes
+    // to write.
+    m_fastFill = nullptr;
+    if (m_extraDims.empty() && m_dims.init(*layout))
+    {
+        switch (m_lasHeader.pointFormat())
+        {
+        case 0:
+            m_fastFill = &LasWriter::fillWriteBufAs<0>;
+            break;
+        case 1:
+            m_fastFill = &LasWriter::fillWriteBufAs<1>;
+            break;
+        case 2:
+            m_fastFill = &LasWriter::fillWriteBufAs<2>;
+            break;
+        case 3:
+            m_fastFill = &LasWriter::fillWriteBufAs<3>;
+            break;
+        case 6:
+            m_fastFill = &LasWriter::fillWriteBufAs<6>;
+            break;
+        case 7:
+            m_fastFill = &LasWriter::fillWriteBufAs<7>;
+            break;
+        case 8:
+            m_fastFill = &LasWriter::fillWriteBufAs<8>;
+            break;
+        }
+    }
 }
 
 
@@ -734,13 +802,10 @@ void LasWriter::writeView(const PointViewPtr view)
 
     const PointView& viewRef(*view.get());
 
-    point_count_t remaining = view->size();
     PointId idx = 0;
-    while (remaining)
+    while (idx < view->size())
     {
         point_count_t filled = fillWriteBuf(viewRef, idx, m_pointBuf);
-        idx += filled;
-        remaining -= filled;
 
         if (m_compression == LasCompression::LasZip)
             writeLasZipBuf(m_pointBuf.data(), pointLen, filled);
@@ -787,6 +852,19 @@ void LasWriter::writeLazPerfBuf(char *pos, size_t pointLen,
 }
 
 
+int32_t LasWriter::toScaledInt(double d, Dimension::Id dim)
+{
+    int32_t i;
+
+    if (!Utils::numericCast(d, i))
+        throwError("Unable to convert scaled value (" +
+            Utils::toString(d) + ") to "
+            "int32 for dimension '" + Dimension::name(dim) +
+            "' when writing LAS/LAZ file " + m_curFilename + ".");
+    return i;
+}
+
+
 bool LasWriter::fillPointBuf(PointRef& point, LeInserter& ostream)
 {
     bool has14Format = m_lasHeader.has14Format();
@@ -823,18 +901,6 @@ bool LasWriter::fillPointBuf(PointRef& point, LeInserter& ostream)
             m_error.numReturnsWarning(numberOfReturns);
     }
 
-    auto converter = [this](double d, Dimension::Id dim) -> int32_t
-    {
-        int32_t i;
-
-        if (!Utils::numericCast(d, i))
-            throwError("Unable to convert scaled value (" +
-                Utils::toString(d) + ") to "
-                "int32 for dimension '" + Dimension::name(dim) +
-                "' when writing LAS/LAZ file " + m_curFilename + ".");
-        return i;
-    };
-
     double xOrig = point.getFieldAs<double>(Id::X);
     double yOrig = point.getFieldAs<double>(Id::Y);
     double zOrig = point.getFieldAs<double>(Id::Z);
@@ -842,9 +908,9 @@ bool LasWriter::fillPointBuf(PointRef& point, LeInserter& ostream)
     double y = m_scaling.m_yXform.toScaled(yOrig);
     double z = m_scaling.m_zXform.toScaled(zOrig);
 
-    ostream << converter(x, Id::X);
-    ostream << converter(y, Id::Y);
-    ostream << converter(z, Id::Z);
+    ostream << toScaledInt(x, Id::X);
+    ostream << toScaledInt(y, Id::Y);
+    ostream << toScaledInt(z, Id::Z);
 
     ostream << point.getFieldAs<uint16_t>(Id::Intensity);
 
@@ -915,21 +981,106 @@ bool LasWriter::fillPointBuf(PointRef& point, LeInserter& ostream)
 }
 
 
-point_count_t LasWriter::fillWriteBuf(const PointView& view,
-    PointId startId, std::vector<char>& buf)
+// Fill a buffer with records for points starting at 'idx', which is
+// advanced past the points used.  Returns the number of records written,
+// which is less than the number of points used if points are discarded.
+point_count_t LasWriter::fillWriteBuf(const PointView& view, PointId& idx,
+    std::vector<char>& buf)
 {
-    point_count_t blocksize = buf.size() / m_lasHeader.pointLen();
-    blocksize = std::min(blocksize, view.size() - startId);
-    PointId lastId = startId + blocksize;
+    if (m_fastFill)
+        return (this->*m_fastFill)(view, idx, buf);
+
+    point_count_t capacity = buf.size() / m_lasHeader.pointLen();
 
     LeInserter ostream(buf.data(), buf.size());
     PointRef point = (const_cast<PointView&>(view)).point(0);
-    for (PointId idx = startId; idx < lastId; idx++)
+    point_count_t filled = 0;
+    for (; idx < view.size() && filled < capacity; ++idx)
     {
         point.setPointId(idx);
-        fillPointBuf(point, ostream);
+        if (fillPointBuf(point, ostream))
+            filled++;
+    }
+    return filled;
+}
+
+
+// As fillPointBuf() for each point, using the codec for the point format.
+template<int FORMAT>
+point_count_t LasWriter::fillWriteBufAs(const PointView& view, PointId& idx,
+    std::vector<char>& buf)
+{
+    using namespace LasCodec;
+    typedef Format<FORMAT> F;
+
+    const Offsets& o = m_dims;
+    const size_t pointLen = m_lasHeader.pointLen();
+    const size_t maxReturnCount = m_lasHeader.maxReturnCount();
+    point_count_t capacity = buf.size() / pointLen;
+
+    auto coord = [&o](const char *point, Field f) -> double
+        { return o.has(f) ? load<double>(point, o[f]) : 0; };
+
+    PointView& v = const_cast<PointView&>(view);
+    char *rec = buf.data();
+    point_count_t filled = 0;
+    for (; idx < view.size() && filled < capacity; ++idx)
+    {
+        const char *point = v.getPoint(idx);
+
+        uint8_t returnNumber(1);
+        uint8_t numberOfReturns(1);
+        if (o.has(ReturnNumber))
+        {
+            returnNumber = load<uint8_t>(point, o[ReturnNumber]);
+            if (returnNumber < 1 || returnNumber > maxReturnCount)
+                m_error.returnNumWarning(returnNumber);
+        }
+        if (o.has(NumberOfReturns))
+            numberOfReturns = load<uint8_t>(point, o[NumberOfReturns]);
+        if (numberOfReturns == 0)
+            m_error.numReturnsWarning(0);
+        if (numberOfReturns > maxReturnCount)
+        {
+            if (m_discardHighReturnNumbers)
+            {
+                // If this return number is too high, pitch the point.
+                if (returnNumber > maxReturnCount)
+                    continue;
+                numberOfReturns = maxReturnCount;
+            }
+            else
+                m_error.numReturnsWarning(numberOfReturns);
+        }
+
+        double xOrig = coord(point, X);
+        double yOrig = coord(point, Y);
+        double zOrig = coord(point, Z);
+        put<int32_t>(rec, toScaledInt(m_scaling.m_xXform.toScaled(xOrig),
+            Dimension::Id::X));
+        put<int32_t>(rec + 4, toScaledInt(m_scaling.m_yXform.toScaled(yOrig),
+            Dimension::Id::Y));
+        put<int32_t>(rec + 8, toScaledInt(m_scaling.m_zXform.toScaled(zOrig),
+            Dimension::Id::Z));
+        put<uint16_t>(rec + 12, o.has(Intensity) ?
+            load<uint16_t>(point, o[Intensity]) : 0);
+        rec[14] = returnNumber | (numberOfReturns << (F::v14 ? 4 : 3));
+
+        int8_t scanAngleRank(0);
+        if (!F::v14 && o.has(ScanAngleRank))
+        {
+            double angle = load<float>(point, o[ScanAngleRank]);
+            if (!Utils::numericCast(angle, scanAngleRank))
+                // Throws the same error as other dimension conversions.
+                view.getFieldAs<int8_t>(Dimension::Id::ScanAngleRank, idx);
+        }
+        encode<FORMAT>(point, rec, o, scanAngleRank);
+
+        m_summaryData->addPoint(xOrig, yOrig, zOrig, returnNumber);
+        rec += pointLen;
+        filled++;
     }
-    return blocksize;
+    return filled;
 }
 
 
@@ -39,6 +39,7 @@
 #include <pdal/plugin.hpp>
 
 #include "HeaderVal.hpp"
+#include "LasCodec.hpp"
 #include "LasError.hpp"
 #include "LasHeader.hpp"
 #include "LasUtils.hpp"
@@ -106,6 +107,11 @@ private:
     std::vector<char> m_pointBuf;
     SpatialReference m_aSrs;
     int m_srsCnt;
+    LasCodec::Offsets m_dims;
+    // Fills the write buffer using the codec for the point format, if the
+    // layout allows.
+    point_count_t (LasWriter::*m_fastFill)(const PointView& view,
+        PointId& idx, std::vector<char>& buf);
 
     NumHeaderVal<uint8_t, 1, 1> m_majorVersion;
     NumHeaderVal<uint8_t, 1, 4> m_minorVersion;
@@ -132,6 +138,7 @@ private:
     Json::Value m_userVLRs;
 
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void initialize();
     virtual void prepared(PointTableRef table);
     virtual void readyTable(PointTableRef table);
@@ -149,8 +156,12 @@ private:
         const MetadataNode& base);
     void handleHeaderForwards(MetadataNode& forward);
     void fillHeader();
+    int32_t toScaledInt(double d, Dimension::Id dim);
     bool fillPointBuf(PointRef& point, LeInserter& ostream);
-    point_count_t fillWriteBuf(const PointView& view, PointId startId,
+    point_count_t fillWriteBuf(const PointView& view, PointId& idx,
+        std::vector<char>& buf);
+    template<int FORMAT>
+    point_count_t fillWriteBufAs(const PointView& view, PointId& idx,
         std::vector<char>& buf);
     void writeLasZipBuf(char *data, size_t pointLen, point_count_t numPts);
     void writeLazPerfBuf(char *data, size_t pointLen, point_count_t numPts);
@@ -51,6 +51,8 @@ public:
     static int32_t destroy(void *);
     std::string getName() const;
 private:
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return true; }
     virtual void write(const PointViewPtr /*view*/)
         {}
 };
@@ -34,10 +34,13 @@
 
 #include "PlyReader.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include <pdal/PointView.hpp>
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/FileUtils.hpp>
 
 namespace pdal
 {
@@ -104,6 +107,53 @@ int readPlyCallback(p_ply_argument argument)
     return 1;
 }
 
+
+bool hostIsLittleEndian()
+{
+    const uint16_t one(1);
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+
+Dimension::Type plyType(const std::string& name)
+{
+    static std::map<std::string, Dimension::Type> types =
+    {
+        { "int8", Dimension::Type::Signed8 },
+        { "uint8", Dimension::Type::Unsigned8 },
+        { "int16", Dimension::Type::Signed16 },
+        { "uint16", Dimension::Type::Unsigned16 },
+        { "int32", Dimension::Type::Signed32 },
+        { "uint32", Dimension::Type::Unsigned32 },
+        { "float32", Dimension::Type::Float },
+        { "float64", Dimension::Type::Double },
+
+        { "char", Dimension::Type::Signed8 },
+        { "uchar", Dimension::Type::Unsigned8 },
+        { "short", Dimension::Type::Signed16 },
+        { "ushort", Dimension::Type::Unsigned16 },
+        { "int", Dimension::Type::Signed32 },
+        { "uint", Dimension::Type::Unsigned32 },
+        { "float", Dimension::Type::Float },
+        { "double", Dimension::Type::Double }
+    };
+
+    auto it = types.find(name);
+    return it == types.end() ? Dimension::Type::None : it->second;
+}
+
+
+template<typename T>
+uint64_t countAs(const char *buf)
+{
+    T t;
+    memcpy(&t, buf, sizeof(T));
+    return (uint64_t)(std::max)(t, (T)0);
+}
+
+// Size of the buffer used for binary input.
+const std::size_t BufSize = 1 << 20;
+
 } // unnamed namespace
 
 
@@ -125,76 +175,138 @@ std::string PlyReader::getName() const
 PlyReader::PlyReader()
     : m_ply(nullptr)
     , m_vertexDimensions()
+    , m_format(Format::Ascii)
+    , m_vertexElt(0)
+    , m_dataOffset(0)
+    , m_stream(nullptr)
+    , m_bufPos(0)
+    , m_bufEnd(0)
+    , m_swap(false)
+    , m_index(0)
+    , m_recordSize(0)
 {}
 
 
-void PlyReader::initialize()
+void PlyReader::readHeader(std::istream& in)
 {
-    try
+    std::string line;
+    auto nextLine = [&in, &line]()
+    {
+        if (!std::getline(in, line))
+            return false;
+        if (line.size() && line.back() == '\r')
+            line.pop_back();
+        return true;
+    };
+    auto isspace = [](char c){ return std::isspace((unsigned char)c) != 0; };
+
+    m_elements.clear();
+    if (nextLine())
+        Utils::trim(line);
+    if (line != "ply")
+        throwError("File " + m_filename + " is not a PLY file.");
+
+    bool haveFormat = false;
+    while (true)
     {
-        p_ply ply = openPly(m_filename);
-        p_ply_element vertex_element = nullptr;
-        bool found_vertex_element = false;
-        const char* element_name;
-        long element_count;
-        while ((vertex_element = ply_get_next_element(ply, vertex_element)))
+        if (!nextLine())
+            throwError("Unexpected end of header in " + m_filename + ".");
+
+        StringList words = Utils::split2(line, isspace);
+        if (words.empty() || words[0] == "comment" || words[0] == "obj_info")
+            continue;
+        if (words[0] == "end_header")
+            break;
+
+        if (words[0] == "format" && words.size() == 3)
         {
-            if (!ply_get_element_info(vertex_element, &element_name,
-                        &element_count))
-                throwError("Error reading element info in " + m_filename + ".");
-            if (strcmp(element_name, "vertex") == 0)
-            {
-                found_vertex_element = true;
-                break;
-            }
+            if (words[1] == "ascii")
+                m_format = Format::Ascii;
+            else if (words[1] == "binary_little_endian")
+                m_format = Format::BinaryLe;
+            else if (words[1] == "binary_big_endian")
+                m_format = Format::BinaryBe;
+            else
+                throwError("Unknown PLY format '" + words[1] + "' in " +
+                    m_filename + ".");
+            haveFormat = true;
         }
-        if (!found_vertex_element)
-            throwError("File " + m_filename + " does not contain a vertex "
-                    "element.");
-
-        static std::map<int, Dimension::Type> types =
+        else if (words[0] == "element" && words.size() == 3)
         {
-            { PLY_INT8, Dimension::Type::Signed8 },
-            { PLY_UINT8, Dimension::Type::Unsigned8 },
-            { PLY_INT16, Dimension::Type::Signed16 },
-            { PLY_UINT16, Dimension::Type::Unsigned16 },
-            { PLY_INT32, Dimension::Type::Signed32 },
-            { PLY_UINT32, Dimension::Type::Unsigned32 },
-            { PLY_FLOAT32, Dimension::Type::Float },
-            { PLY_FLOAT64, Dimension::Type::Double },
-
-            { PLY_CHAR, Dimension::Type::Signed8 },
-            { PLY_UCHAR, Dimension::Type::Unsigned8 },
-            { PLY_SHORT, Dimension::Type::Signed16 },
-            { PLY_USHORT, Dimension::Type::Unsigned16 },
-            { PLY_INT, Dimension::Type::Signed32 },
-            { PLY_UINT, Dimension::Type::Unsigned32 },
-            { PLY_FLOAT, Dimension::Type::Float },
-            { PLY_DOUBLE, Dimension::Type::Double }
-        };
-
-        p_ply_property property = nullptr;
-        while ((property = ply_get_next_property(vertex_element, property)))
+            point_count_t count;
+            if (!Utils::fromString(words[2], count))
+                throwError("Invalid count for element '" + words[1] +
+                    "' in " + m_filename + ".");
+            m_elements.emplace_back(words[1], count);
+        }
+        else if (words[0] == "property" && m_elements.size() &&
+            (words.size() == 3 || words.size() == 5))
         {
-            const char* name;
-            e_ply_type type;
-            e_ply_type length_type;
-            e_ply_type value_type;
-            if (!ply_get_property_info(property, &name, &type,
-                        &length_type, &value_type))
-                throwError("Error reading property info in " +
+            Element& elt = m_elements.back();
+            if (words.size() == 5 && words[1] == "list")
+            {
+                Dimension::Type countType = plyType(words[2]);
+                Dimension::Type type = plyType(words[3]);
+                if (type == Dimension::Type::None ||
+                    countType == Dimension::Type::None ||
+                    countType == Dimension::Type::Float ||
+                    countType == Dimension::Type::Double)
+                    throwError("Invalid list property '" + words[4] +
+                        "' in " + m_filename + ".");
+                elt.m_properties.emplace_back(words[4], type, countType);
+            }
+            else if (words.size() == 3)
+            {
+                Dimension::Type type = plyType(words[1]);
+                if (type == Dimension::Type::None)
+                    throwError("Unknown type '" + words[1] +
+                        "' for property '" + words[2] + "' in " +
+                        m_filename + ".");
+                elt.m_properties.emplace_back(words[2], type);
+            }
+            else
+                throwError("Invalid header line '" + line + "' in " +
                     m_filename + ".");
-            // For now, we'll just use PDAL's built in dimension matching.
-            // We could be smarter about this, e.g. by using the length
-            // and value type attributes.
-            m_vertexTypes[name] = types[type];
         }
-        ply_close(ply);
+        else
+            throwError("Invalid header line '" + line + "' in " +
+                m_filename + ".");
     }
-    catch (const error& err)
+    if (!haveFormat)
+        throwError("No format specified in " + m_filename + ".");
+    m_dataOffset = in.tellg();
+}
+
+
+void PlyReader::initialize()
+{
+    std::istream *in = Utils::openFile(m_filename);
+    if (!in)
+        throwError("Unable to open file " + m_filename + " for reading.");
+    try
     {
-        throwError(err.what());
+        readHeader(*in);
     }
+    catch (...)
+    {
+        Utils::closeFile(in);
+        throw;
+    }
+    Utils::closeFile(in);
+
+    auto it = std::find_if(m_elements.begin(), m_elements.end(),
+        [](const Element& elt){ return elt.m_name == "vertex"; });
+    if (it == m_elements.end())
+        throwError("File " + m_filename + " does not contain a vertex "
+            "element.");
+    m_vertexElt = std::distance(m_elements.begin(), it);
+
+    // For now, we'll just use PDAL's built in dimension matching.
+    // We could be smarter about this, e.g. by using the length
+    // and value type attributes.  List properties are skipped.
+    for (const Property& prop : it->m_properties)
+        if (prop.m_countType == Dimension::Type::None)
+            m_vertexTypes[prop.m_name] = prop.m_type;
 }
 
 
@@ -207,24 +319,226 @@ void PlyReader::addDimensions(PointLayoutPtr layout)
 
         m_vertexDimensions[name] = layout->registerOrAssignDim(name, type);
     }
+    for (Property& prop : m_elements[m_vertexElt].m_properties)
+    {
+        auto it = m_vertexDimensions.find(prop.m_name);
+        if (it != m_vertexDimensions.end() &&
+                prop.m_countType == Dimension::Type::None)
+            prop.m_dim = it->second;
+    }
 }
 
 
 void PlyReader::ready(PointTableRef table)
 {
-    try
+    m_index = 0;
+    if (m_format == Format::Ascii)
     {
-        m_ply = openPly(m_filename);
+        try
+        {
+            m_ply = openPly(m_filename);
+        }
+        catch (const error& err)
+        {
+            throwError(err.what());
+        }
+        return;
     }
-    catch (const error& err)
+
+    m_stream = Utils::openFile(m_filename);
+    if (!m_stream)
+        throwError("Unable to open file " + m_filename + " for reading.");
+    m_stream->seekg(m_dataOffset);
+    m_buf.resize(BufSize);
+    m_bufPos = 0;
+    m_bufEnd = 0;
+    m_swap = ((m_format == Format::BinaryLe) != hostIsLittleEndian());
+    m_recordSize = 0;
+    if (initCopies(*table.layout()))
+        for (const Property& prop : m_elements[m_vertexElt].m_properties)
+            m_recordSize += Dimension::size(prop.m_type);
+    for (std::size_t i = 0; i < m_vertexElt; ++i)
+        skipElement(m_elements[i]);
+}
+
+
+// Find where each vertex property is copied from a record into point data.
+// Records can only be copied this way if they have a fixed size and each
+// property has the type of its dimension in the layout.
+bool PlyReader::initCopies(const PointLayout& layout)
+{
+    m_copies.clear();
+    std::size_t pos = 0;
+    for (const Property& prop : m_elements[m_vertexElt].m_properties)
     {
-        throwError(err.what());
+        if (prop.m_countType != Dimension::Type::None)
+            return false;
+        std::size_t size = Dimension::size(prop.m_type);
+        if (prop.m_dim != Dimension::Id::Unknown)
+        {
+            if (layout.dimType(prop.m_dim) != prop.m_type)
+                return false;
+            m_copies.push_back({ pos, layout.dimDetail(prop.m_dim)->offset(),
+                size });
+        }
+        pos += size;
+    }
+    return pos && pos <= BufSize;
+}
+
+
+// Return a pointer to the next 'size' bytes of binary data, refilling the
+// buffer from the file as necessary.
+const char *PlyReader::need(std::size_t size)
+{
+    if (m_bufEnd - m_bufPos < size)
+    {
+        std::size_t left = m_bufEnd - m_bufPos;
+        memmove(m_buf.data(), m_buf.data() + m_bufPos, left);
+        m_stream->read(m_buf.data() + left, m_buf.size() - left);
+        m_bufPos = 0;
+        m_bufEnd = left + (std::size_t)m_stream->gcount();
+        if (m_bufEnd < size)
+            throwError("Unexpected end of file reading " + m_filename + ".");
+    }
+    const char *pos = m_buf.data() + m_bufPos;
+    m_bufPos += size;
+    return pos;
+}
+
+
+void PlyReader::skip(uint64_t size)
+{
+    while (size)
+    {
+        if (m_bufPos == m_bufEnd)
+        {
+            need(1);
+            m_bufPos--;
+        }
+        uint64_t avail = (std::min)((uint64_t)(m_bufEnd - m_bufPos), size);
+        m_bufPos += (std::size_t)avail;
+        size -= avail;
+    }
+}
+
+
+void PlyReader::skipList(const Property& prop)
+{
+    std::size_t size = Dimension::size(prop.m_countType);
+    const char *pos = need(size);
+    char buf[sizeof(uint64_t)];
+    if (m_swap)
+    {
+        std::reverse_copy(pos, pos + size, buf);
+        pos = buf;
+    }
+
+    uint64_t count = 0;
+    switch (prop.m_countType)
+    {
+    case Dimension::Type::Signed8:
+        count = countAs<int8_t>(pos);
+        break;
+    case Dimension::Type::Unsigned8:
+        count = countAs<uint8_t>(pos);
+        break;
+    case Dimension::Type::Signed16:
+        count = countAs<int16_t>(pos);
+        break;
+    case Dimension::Type::Unsigned16:
+        count = countAs<uint16_t>(pos);
+        break;
+    case Dimension::Type::Signed32:
+        count = countAs<int32_t>(pos);
+        break;
+    case Dimension::Type::Unsigned32:
+        count = countAs<uint32_t>(pos);
+        break;
+    default:
+        break;
+    }
+    skip(count * Dimension::size(prop.m_type));
+}
+
+
+void PlyReader::skipElement(const Element& elt)
+{
+    bool fixed = true;
+    uint64_t recordSize = 0;
+    for (const Property& prop : elt.m_properties)
+    {
+        if (prop.m_countType != Dimension::Type::None)
+            fixed = false;
+        recordSize += Dimension::size(prop.m_type);
+    }
+
+    if (fixed)
+    {
+        skip(recordSize * elt.m_count);
+        return;
+    }
+    for (point_count_t i = 0; i < elt.m_count; ++i)
+        for (const Property& prop : elt.m_properties)
+        {
+            if (prop.m_countType != Dimension::Type::None)
+                skipList(prop);
+            else
+                skip(Dimension::size(prop.m_type));
+        }
+}
+
+
+// Decode up to 'num' fixed-size vertex records, as many as fit in the
+// buffer at a time, copying property values straight into point data.
+point_count_t PlyReader::readRecords(PointView& view, point_count_t num)
+{
+    const Element& vertex = m_elements[m_vertexElt];
+    num = (std::min)(num, vertex.m_count - m_index);
+
+    point_count_t left = num;
+    while (left)
+    {
+        std::size_t count = (std::size_t)(std::min)(left,
+            (point_count_t)(BufSize / m_recordSize));
+        const char *rec = need(count * m_recordSize);
+        for (std::size_t i = 0; i < count; ++i, rec += m_recordSize)
+        {
+            char *point = view.getOrAddPoint(view.size());
+            for (const Copy& c : m_copies)
+                if (m_swap)
+                    std::reverse_copy(rec + c.m_src, rec + c.m_src + c.m_size,
+                        point + c.m_dst);
+                else
+                    memcpy(point + c.m_dst, rec + c.m_src, c.m_size);
+        }
+        left -= count;
     }
+    m_index += num;
+    return num;
 }
 
 
 point_count_t PlyReader::read(PointViewPtr view, point_count_t num)
 {
+    if (m_stream && m_recordSize)
+        return readRecords(*view, num);
+    if (m_stream)
+    {
+        PointId idx = view->size();
+        point_count_t cnt = 0;
+        PointRef point(*view, idx);
+        while (cnt < num)
+        {
+            point.setPointId(idx);
+            if (!processOne(point))
+                break;
+            idx++;
+            cnt++;
+        }
+        return cnt;
+    }
+
     CallbackContext context;
     context.view = view;
     context.dimensionMap = m_vertexDimensions;
@@ -253,12 +567,55 @@ point_count_t PlyReader::read(PointViewPtr view, point_count_t num)
 }
 
 
+bool PlyReader::processOne(PointRef& point)
+{
+    if (!m_stream)
+        throwError("Streaming mode is only supported for binary PLY files.");
+
+    const Element& vertex = m_elements[m_vertexElt];
+    if (m_index >= vertex.m_count)
+        return false;
+
+    char buf[sizeof(double)];
+    for (const Property& prop : vertex.m_properties)
+    {
+        if (prop.m_countType != Dimension::Type::None)
+        {
+            skipList(prop);
+            continue;
+        }
+
+        std::size_t size = Dimension::size(prop.m_type);
+        const char *pos = need(size);
+        if (prop.m_dim == Dimension::Id::Unknown)
+            continue;
+        if (m_swap)
+        {
+            std::reverse_copy(pos, pos + size, buf);
+            pos = buf;
+        }
+        point.setField(prop.m_dim, prop.m_type, pos);
+    }
+    m_index++;
+    return true;
+}
+
+
 void PlyReader::done(PointTableRef table)
 {
+    if (m_stream)
+    {
+        Utils::closeFile(m_stream);
+        m_stream = nullptr;
+        m_buf.clear();
+        return;
+    }
+
     try
     {
         if (!ply_close(m_ply))
             throwError("Error closing " + m_filename + ".");
+        m_ply = nullptr;
     }
     catch (const error& err)
     {
@@ -34,7 +34,9 @@
 
 #pragma once
 
+#include <istream>
 #include <string>
+#include <vector>
 
 #include <rply/rply.h>
 
@@ -69,16 +71,84 @@ public:
     static Dimension::IdList getDefaultDimensions();
 
 private:
+    enum class Format
+    {
+        Ascii,
+        BinaryLe,
+        BinaryBe
+    };
+
+    struct Property
+    {
+        Property(const std::string& name, Dimension::Type type,
+                Dimension::Type countType = Dimension::Type::None) :
+            m_name(name), m_type(type), m_countType(countType),
+            m_dim(Dimension::Id::Unknown)
+        {}
+
+        std::string m_name;
+        Dimension::Type m_type;
+        // Type of the element count for list properties, None otherwise.
+        Dimension::Type m_countType;
+        Dimension::Id m_dim;
+    };
+
+    struct Element
+    {
+        Element(const std::string& name, point_count_t count) :
+            m_name(name), m_count(count)
+        {}
+
+        std::string m_name;
+        point_count_t m_count;
+        std::vector<Property> m_properties;
+    };
+
+    // A vertex property copied unchanged from a record into point data
+    // when records are decoded a block at a time.
+    struct Copy
+    {
+        std::size_t m_src;      // Offset in the record.
+        std::size_t m_dst;      // Offset in the point.
+        std::size_t m_size;
+    };
+
     virtual void initialize();
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
     virtual point_count_t read(PointViewPtr view, point_count_t num);
+    virtual bool processOne(PointRef& point);
     virtual void done(PointTableRef table);
 
+    void readHeader(std::istream& in);
+    const char *need(std::size_t size);
+    void skip(uint64_t size);
+    void skipList(const Property& prop);
+    void skipElement(const Element& elt);
+    bool initCopies(const PointLayout& layout);
+    point_count_t readRecords(PointView& view, point_count_t num);
+
     p_ply m_ply;
 
     DimensionMap m_vertexDimensions;
     std::map<std::string, Dimension::Type> m_vertexTypes;
+
+    Format m_format;
+    std::vector<Element> m_elements;
+    std::size_t m_vertexElt;
+    std::streamoff m_dataOffset;
+
+    // Binary input is decoded directly from a buffer rather than by rply.
+    std::istream *m_stream;
+    std::vector<char> m_buf;
+    std::size_t m_bufPos;
+    std::size_t m_bufEnd;
+    bool m_swap;
+    point_count_t m_index;
+    // Size of a vertex record when records are decoded a block at a time,
+    // zero otherwise.
+    std::size_t m_recordSize;
+    std::vector<Copy> m_copies;
 };
 }
 
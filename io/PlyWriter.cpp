@@ -34,9 +34,12 @@
 
 #include "PlyWriter.hpp"
 
+#include <algorithm>
+#include <iomanip>
 #include <sstream>
 
 #include <pdal/pdal_macros.hpp>
+#include <pdal/util/FileUtils.hpp>
 #include <pdal/util/ProgramArgs.hpp>
 
 namespace pdal
@@ -67,6 +70,54 @@ e_ply_type getPlyType(Dimension::Type type)
     return types[type];
 }
 
+
+std::string getPlyTypeName(Dimension::Type type)
+{
+    static std::map<Dimension::Type, std::string> names =
+    {
+        { Dimension::Type::Unsigned8, "uint8" },
+        { Dimension::Type::Signed8, "int8" },
+        { Dimension::Type::Unsigned16, "uint16" },
+        { Dimension::Type::Signed16, "int16" },
+        { Dimension::Type::Unsigned32, "uint32" },
+        { Dimension::Type::Signed32, "int32" },
+        { Dimension::Type::Float, "float32" },
+        { Dimension::Type::Double, "float64" }
+    };
+
+    return names[type];
+}
+
+
+// PLY has no 64-bit integer types, so those are written as doubles, as are
+// dimensions without a default type whose layout type doesn't fit.
+Dimension::Type plyDimType(PointLayoutPtr layout, Dimension::Id dim)
+{
+    Dimension::Type type = Dimension::defaultType(dim);
+    if (type == Dimension::Type::None)
+        type = layout->dimType(dim);
+    if (type == Dimension::Type::None ||
+            type == Dimension::Type::Signed64 ||
+            type == Dimension::Type::Unsigned64)
+        type = Dimension::Type::Double;
+    return type;
+}
+
+
+bool hostIsLittleEndian()
+{
+    const uint16_t one(1);
+    return *reinterpret_cast<const uint8_t *>(&one) == 1;
+}
+
+// Width of the vertex count in the header of binary files.  The count isn't
+// known until all points are written, so space is reserved for it and the
+// count is padded with leading zeros to fill it.
+const int CountWidth = 20;
+
+// Approximate size of the output buffer for binary files.
+const std::size_t FlushSize = 1 << 20;
+
 } // unnamed namespace
 
 
@@ -85,6 +136,12 @@ PlyWriter::PlyWriter()
     : m_ply(nullptr)
     , m_pointCollector(nullptr)
     , m_storageMode(PLY_DEFAULT)
+    , m_stream(nullptr)
+    , m_countPos(0)
+    , m_bufPos(0)
+    , m_recordSize(0)
+    , m_count(0)
+    , m_swap(false)
 {}
 
 
@@ -127,6 +184,16 @@ void PlyWriter::initialize()
 
 void PlyWriter::ready(PointTableRef table)
 {
+    if (m_storageMode != PLY_ASCII)
+    {
+        m_stream = Utils::createFile(m_filename, true);
+        if (!m_stream)
+            throwError("Could not open file '" + m_filename +
+                "' for writing.");
+        writeHeader(table.layout());
+        return;
+    }
+
     try
     {
         m_ply = ply_create(m_filename.c_str(), m_storageMode,
@@ -142,14 +209,112 @@ void PlyWriter::ready(PointTableRef table)
 }
 
 
+void PlyWriter::writeHeader(PointLayoutPtr layout)
+{
+    bool littleEndian = (m_storageMode == PLY_LITTLE_ENDIAN ||
+        (m_storageMode == PLY_DEFAULT && hostIsLittleEndian()));
+    m_swap = (littleEndian != hostIsLittleEndian());
+
+    m_dims = layout->dims();
+    m_types.clear();
+    m_recordSize = 0;
+
+    std::ostream& out = *m_stream;
+    out << "ply\n";
+    out << "format " << (littleEndian ? "binary_little_endian" :
+        "binary_big_endian") << " 1.0\n";
+    out << "comment Generated by PDAL\n";
+    out << "element vertex ";
+    m_countPos = out.tellp();
+    out << std::string(CountWidth, '0') << "\n";
+    for (auto dim : m_dims)
+    {
+        Dimension::Type type = plyDimType(layout, dim);
+        out << "property " << getPlyTypeName(type) << " " <<
+            layout->dimName(dim) << "\n";
+        m_types.push_back(type);
+        m_recordSize += Dimension::size(type);
+    }
+    out << "end_header\n";
+
+    std::size_t records = (std::max)(FlushSize / m_recordSize, (size_t)1);
+    m_buf.resize(records * m_recordSize);
+    m_bufPos = 0;
+    m_count = 0;
+}
+
+
 void PlyWriter::write(const PointViewPtr data)
 {
-    m_pointCollector->append(*data);
+    if (!m_stream)
+    {
+        m_pointCollector->append(*data);
+        return;
+    }
+
+    PointRef point(*data, 0);
+    for (PointId idx = 0; idx < data->size(); ++idx)
+    {
+        point.setPointId(idx);
+        writePoint(point);
+    }
+}
+
+
+bool PlyWriter::processOne(PointRef& point)
+{
+    if (!m_stream)
+        throwError("Streaming mode is only supported for binary PLY files.");
+    writePoint(point);
+    return true;
+}
+
+
+void PlyWriter::writePoint(const PointRef& point)
+{
+    if (m_bufPos == m_buf.size())
+        flush();
+
+    char *pos = m_buf.data() + m_bufPos;
+    for (std::size_t i = 0; i < m_dims.size(); ++i)
+    {
+        Dimension::Type type = m_types[i];
+        std::size_t size = Dimension::size(type);
+        point.getField(pos, m_dims[i], type);
+        if (m_swap)
+            std::reverse(pos, pos + size);
+        pos += size;
+    }
+    m_bufPos += m_recordSize;
+    m_count++;
+}
+
+
+void PlyWriter::flush()
+{
+    m_stream->write(m_buf.data(), m_bufPos);
+    m_bufPos = 0;
 }
 
 
 void PlyWriter::done(PointTableRef table)
 {
+    if (m_stream)
+    {
+        flush();
+        m_stream->seekp(m_countPos);
+        *m_stream << std::right << std::setfill('0') <<
+            std::setw(CountWidth) << m_count;
+        bool ok = (bool)*m_stream;
+        Utils::closeFile(m_stream);
+        m_stream = nullptr;
+        m_buf.clear();
+        if (!ok)
+            throwError("Error writing file '" + m_filename + "'.");
+        getMetadata().addList("filename", m_filename);
+        return;
+    }
+
     try
     {
     if (!ply_add_element(m_ply, "vertex", m_pointCollector->size()))
@@ -158,7 +323,7 @@ void PlyWriter::done(PointTableRef table)
     auto dimensions = table.layout()->dims();
     for (auto dim : dimensions) {
         std::string name = table.layout()->dimName(dim);
-        e_ply_type plyType = getPlyType(Dimension::defaultType(dim));
+        e_ply_type plyType = getPlyType(plyDimType(table.layout(), dim));
         if (!ply_add_scalar_property(m_ply, name.c_str(), plyType))
             throwError("Could not add scalar property '" + name  + "'");
     }
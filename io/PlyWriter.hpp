@@ -32,6 +32,9 @@
 * OF SUCH DAMAGE.
 ****************************************************************************/
 
+#include <ostream>
+#include <vector>
+
 #include <rply/rply.h>
 
 #include <pdal/PointView.hpp>
@@ -65,13 +68,29 @@ private:
     virtual void initialize();
     virtual void ready(PointTableRef table);
     virtual void write(const PointViewPtr data);
+    virtual bool processOne(PointRef& point);
     virtual void done(PointTableRef table);
 
+    void writeHeader(PointLayoutPtr layout);
+    void writePoint(const PointRef& point);
+    void flush();
+
     std::string m_filename;
     p_ply m_ply;
     PointViewPtr m_pointCollector;
     std::string m_storageModeSpec;
     e_ply_storage_mode m_storageMode;
+
+    // Binary output is encoded directly rather than through rply.
+    std::ostream *m_stream;
+    std::streamoff m_countPos;
+    Dimension::IdList m_dims;
+    std::vector<Dimension::Type> m_types;
+    std::vector<char> m_buf;
+    std::size_t m_bufPos;
+    std::size_t m_recordSize;
+    point_count_t m_count;
+    bool m_swap;
 };
 
 }
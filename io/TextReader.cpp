@@ -34,6 +34,7 @@
 
 #include <pdal/PDALUtils.hpp>
 #include <pdal/util/Algorithm.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include "TextReader.hpp"
 
@@ -43,6 +44,123 @@
 namespace pdal
 {
 
+namespace
+{
+
+// Amount of text converted by each thread per batch.
+const size_t ChunkSize = 1 << 20;
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' ||
+        c == '\f';
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Convert text that is a plain decimal number but for surrounding
+// whitespace.  The result doesn't depend on the locale and is correctly
+// rounded: the significand must fit exactly in a double and the power of
+// ten must be exact, so a single multiply or divide gives the nearest
+// double.  Anything else returns false and is left to Utils::fromString().
+bool parseDouble(const char *pos, const char *end, double& d)
+{
+    static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+        1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+        1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    while (pos < end && isSpace(*pos))
+        pos++;
+
+    bool negative = false;
+    if (pos < end && (*pos == '-' || *pos == '+'))
+        negative = (*pos++ == '-');
+
+    uint64_t significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; pos < end && isDigit(*pos); ++pos)
+    {
+        any = true;
+        if (significand || *pos != '0')
+        {
+            significand = significand * 10 + (*pos - '0');
+            digits++;
+        }
+    }
+    if (pos < end && *pos == '.')
+    {
+        for (++pos; pos < end && isDigit(*pos); ++pos)
+        {
+            any = true;
+            if (significand || *pos != '0')
+            {
+                significand = significand * 10 + (*pos - '0');
+                digits++;
+            }
+            exponent--;
+        }
+    }
+    if (!any || digits > 19)
+        return false;
+
+    if (pos < end && (*pos == 'e' || *pos == 'E'))
+    {
+        pos++;
+        bool negExp = false;
+        if (pos < end && (*pos == '-' || *pos == '+'))
+            negExp = (*pos++ == '-');
+        if (pos == end || !isDigit(*pos))
+            return false;
+        int e = 0;
+        for (; pos < end && isDigit(*pos); ++pos)
+            if (e < 10000)
+                e = e * 10 + (*pos - '0');
+        exponent += negExp ? -e : e;
+    }
+
+    while (pos < end && isSpace(*pos))
+        pos++;
+    if (pos != end)
+        return false;
+
+    if (significand > (1ULL << 53) || exponent < -22 || exponent > 22)
+        return false;
+
+    double v = (double)significand;
+    v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+    d = negative ? -v : v;
+    return true;
+}
+
+} // unnamed namespace
+
+// Values and problems found converting a range of lines.
+struct TextReader::Chunk
+{
+    Chunk() : m_lines(0)
+    {}
+
+    struct Error
+    {
+        // Line number within the chunk (1-based).
+        size_t m_line;
+        // Text of a field that couldn't be converted, if m_badCount is false.
+        std::string m_field;
+        // Whether the line had the wrong number of fields.
+        bool m_badCount;
+        size_t m_count;
+    };
+
+    std::vector<double> m_values;
+    size_t m_lines;
+    std::vector<Error> m_errors;
+};
+
 static PluginInfo const s_info = PluginInfo(
     "readers.text",
     "Text Reader",
@@ -52,6 +170,14 @@ CREATE_STATIC_PLUGIN(1, 0, TextReader, Reader, s_info)
 
 std::string TextReader::getName() const { return s_info.name; }
 
+TextReader::TextReader() : m_istream(NULL), m_nextPoint(0)
+{}
+
+
+TextReader::~TextReader()
+{}
+
+
 void TextReader::initialize(PointTableRef table)
 {
     m_istream = Utils::openFile(m_filename);
@@ -89,14 +215,30 @@ void TextReader::addArgs(ProgramArgs& args)
 {
     args.add("separator", "Separator character that overrides special "
         "character in header line", m_separator, ' ');
+    args.add("threads", "Number of threads used to convert text to points",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
 }
 
 
 void TextReader::addDimensions(PointLayoutPtr layout)
 {
-    for (auto name : m_dimNames)
+    // Fields of dimensions not used by later stages aren't converted.
+    // If no field is used, the first is loaded so that points are created.
+    m_dims.clear();
+    m_fieldUsed.clear();
+    for (auto& name : m_dimNames)
     {
         Utils::trim(name);
+        m_fieldUsed.push_back(dimensionUsed(name));
+    }
+    if (!Utils::contains(m_fieldUsed, true) && m_fieldUsed.size())
+        m_fieldUsed[0] = true;
+
+    for (size_t i = 0; i < m_dimNames.size(); ++i)
+    {
+        if (!m_fieldUsed[i])
+            continue;
+        const std::string& name = m_dimNames[i];
         Dimension::Id id = layout->registerOrAssignDim(name,
             Dimension::Type::Double);
         if (Utils::contains(m_dims, id))
@@ -117,6 +259,11 @@ void TextReader::ready(PointTableRef table)
     std::string buf;
     std::getline(*m_istream, buf);
     m_line = 1;
+
+    m_text.clear();
+    m_values.clear();
+    m_nextPoint = 0;
+    m_pool.reset(new ThreadPool((std::max)(m_threads, 1U)));
 }
 
 
@@ -139,55 +286,176 @@ point_count_t TextReader::read(PointViewPtr view, point_count_t numPts)
 
 bool TextReader::processOne(PointRef& point)
 {
-    if (!fillFields())
-        return false;
+    if (m_nextPoint * m_dims.size() == m_values.size())
+        if (!fillBatch())
+            return false;
+
+    const double *v = m_values.data() + m_nextPoint * m_dims.size();
+    for (size_t i = 0; i < m_dims.size(); ++i)
+        point.setField(m_dims[i], v[i]);
+    m_nextPoint++;
+    return true;
+}
 
-    double d;
-    for (size_t i = 0; i < m_fields.size(); ++i)
+
+bool TextReader::fillBatch()
+{
+    m_values.clear();
+    m_nextPoint = 0;
+    const size_t numThreads = m_pool->numThreads();
+
+    // Lines that don't convert produce no points, so keep going until we
+    // have some points or the input is exhausted.
+    while (m_values.empty())
     {
-        if (!Utils::fromString(m_fields[i], d))
+        // Text left over from the last batch is an incomplete line.  Add
+        // text until we have a batch's worth and at least one full line.
+        size_t size = m_text.size();
+        bool eof = !m_istream->good();
+        const char *endLine = nullptr;
+        do
+        {
+            if (eof)
+                break;
+            size_t want = (std::max)(numThreads * ChunkSize, size);
+            m_text.resize(size + want);
+            m_istream->read(m_text.data() + size, want);
+            size_t got = (size_t)m_istream->gcount();
+            eof = !m_istream->good();
+            for (const char *p = m_text.data() + size + got;
+                    p != m_text.data() + size;)
+                if (*--p == '\n')
+                {
+                    endLine = p;
+                    break;
+                }
+            size += got;
+        } while (!endLine);
+        m_text.resize(size);
+        if (m_text.empty())
+            return false;
+
+        // Convert complete lines, plus the final line at the end of input.
+        const char *begin = m_text.data();
+        const char *end = eof ? begin + size : endLine + 1;
+
+        // Split the text into a chunk per thread at line boundaries.
+        std::vector<const char *> bounds { begin };
+        for (size_t t = 1; t < numThreads; ++t)
         {
-            log()->get(LogLevel::Error) << "Can't convert "
-                "field '" << m_fields[i] << "' to numeric value on line " <<
-                m_line << " in '" << m_filename << "'.  Setting to 0." <<
-                std::endl;
-            d = 0;
+            const char *pos = begin + (end - begin) * t / numThreads;
+            pos = (std::max)(pos, bounds.back());
+            pos = std::find(pos, end, '\n');
+            bounds.push_back(pos == end ? end : pos + 1);
         }
-        point.setField(m_dims[i], d);
+        bounds.push_back(end);
+
+        std::vector<Chunk> chunks(numThreads);
+        for (size_t t = 0; t < numThreads; ++t)
+            m_pool->add([this, &bounds, &chunks, t]()
+                { parseLines(bounds[t], bounds[t + 1], chunks[t]); });
+        m_pool->await();
+
+        // Report problems in line order and gather the values.
+        for (Chunk& c : chunks)
+        {
+            for (const Chunk::Error& e : c.m_errors)
+            {
+                size_t line = m_line + e.m_line;
+                if (e.m_badCount)
+                    log()->get(LogLevel::Error) << "Line " << line <<
+                        " in '" << m_filename << "' contains " << e.m_count <<
+                        " fields when " << m_fieldUsed.size() << " were "
+                        "expected.  Ignoring." << std::endl;
+                else
+                    log()->get(LogLevel::Error) << "Can't convert "
+                        "field '" << e.m_field << "' to numeric value on "
+                        "line " << line << " in '" << m_filename <<
+                        "'.  Setting to 0." << std::endl;
+            }
+            m_line += c.m_lines;
+            m_values.insert(m_values.end(), c.m_values.begin(),
+                c.m_values.end());
+        }
+        m_text.erase(m_text.begin(), m_text.begin() + (end - begin));
     }
     return true;
 }
 
 
-bool TextReader::fillFields()
+void TextReader::parseLines(const char *pos, const char *end,
+    Chunk& chunk) const
 {
-    while (true)
+    std::vector<std::pair<const char *, const char *>> fields;
+    while (pos < end)
     {
-        if (!m_istream->good())
-            return false;
+        const char *eol = std::find(pos, end, '\n');
+        const char *line = pos;
+        pos = (eol == end) ? end : eol + 1;
+        chunk.m_lines++;
 
-        std::string buf;
-
-        std::getline(*m_istream, buf);
-        m_line++;
-        if (buf.empty())
+        // Blank lines are skipped.
+        if (eol == line)
             continue;
-        if (m_separator != ' ')
+
+        // Split the line.  With a space separator, runs of spaces separate
+        // fields.  Otherwise spaces are ignored.
+        fields.clear();
+        if (m_separator == ' ')
+        {
+            const char *p = line;
+            while (true)
+            {
+                const char *next = std::find(p, eol, ' ');
+                if (next != p)
+                    fields.emplace_back(p, next);
+                if (next == eol)
+                    break;
+                p = next + 1;
+            }
+        }
+        else if (std::find_if(line, eol, [](char c){ return c != ' '; }) !=
+            eol)
         {
-            Utils::remove(buf, ' ');
-            m_fields = Utils::split(buf, m_separator);
+            const char *p = line;
+            while (true)
+            {
+                const char *next = std::find(p, eol, m_separator);
+                fields.emplace_back(p, next);
+                if (next == eol)
+                    break;
+                p = next + 1;
+            }
         }
-        else
-            m_fields = Utils::split2(buf, m_separator);
-        if (m_fields.size() != m_dims.size())
+
+        if (fields.size() != m_fieldUsed.size())
         {
-            log()->get(LogLevel::Error) << "Line " << m_line <<
-                " in '" << m_filename << "' contains " << m_fields.size() <<
-                " fields when " << m_dims.size() << " were expected.  "
-                "Ignoring." << std::endl;
+            chunk.m_errors.push_back(
+                { chunk.m_lines, std::string(), true, fields.size() });
             continue;
         }
-        return true;
+
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            if (!m_fieldUsed[i])
+                continue;
+
+            auto& f = fields[i];
+            double d;
+            if (!parseDouble(f.first, f.second, d))
+            {
+                std::string field(f.first, f.second);
+                if (m_separator != ' ')
+                    Utils::remove(field, ' ');
+                if (!Utils::fromString(field, d))
+                {
+                    chunk.m_errors.push_back(
+                        { chunk.m_lines, field, false, 0 });
+                    d = 0;
+                }
+            }
+            chunk.m_values.push_back(d);
+        }
     }
 }
 
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <istream>
+#include <memory>
 
 #include <pdal/Reader.hpp>
 #include <pdal/plugin.hpp>
@@ -45,6 +46,8 @@ extern "C" PF_ExitFunc TextReader_InitPlugin();
 namespace pdal
 {
 
+class ThreadPool;
+
 class PDAL_DLL TextReader : public Reader
 {
 public:
@@ -52,8 +55,8 @@ public:
     static int32_t destroy(void *);
     std::string getName() const;
 
-    TextReader() : m_istream(NULL)
-    {}
+    TextReader();
+    ~TextReader();
 
 private:
     /**
@@ -108,15 +111,42 @@ private:
     */
     virtual bool processOne(PointRef& point);
 
-    bool fillFields();
+    /**
+      Read the next block of text from the input and convert its lines
+      to point values, splitting the work among threads.
+
+      \return  False if the input is exhausted and no points were read.
+    */
+    bool fillBatch();
+
+    struct Chunk;
+
+    /**
+      Convert the lines in a range of text to point values.
+
+      \param pos  Start of the range.
+      \param end  End of the range.
+      \param chunk  Chunk in which to store values and errors.
+    */
+    void parseLines(const char *pos, const char *end, Chunk& chunk) const;
 
 private:
     char m_separator;
+    uint32_t m_threads;
     std::istream *m_istream;
     StringList m_dimNames;
+    /// Whether the field for each name in m_dimNames is loaded.
+    std::vector<bool> m_fieldUsed;
+    /// Dimensions of the loaded fields.
     Dimension::IdList m_dims;
-    StringList m_fields;
     size_t m_line;
+    /// Text read from the input that hasn't been converted.
+    std::vector<char> m_text;
+    /// Point values converted from text, m_dims.size() per point.
+    std::vector<double> m_values;
+    /// Index of next point in m_values to be returned.
+    point_count_t m_nextPoint;
+    std::unique_ptr<ThreadPool> m_pool;
 };
 
 } // namespace pdal
@@ -40,7 +40,10 @@
 #include <pdal/pdal_macros.hpp>
 #include <pdal/util/Algorithm.hpp>
 #include <pdal/util/ProgramArgs.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 
 namespace pdal
@@ -55,6 +58,129 @@ CREATE_STATIC_PLUGIN(1, 0, TextWriter, Writer, s_info)
 
 std::string TextWriter::getName() const { return s_info.name; }
 
+namespace
+{
+
+// Number of points formatted by a single task.
+const point_count_t ChunkSize = 16384;
+
+// Size at which text buffered while streaming is written out.
+const size_t FlushSize = 1 << 20;
+
+// Append 'v' to 'out' with 'precision' digits after the decimal point,
+// exactly as printf("%.*f") (and so std::fixed) would.  The value is
+// split into an integer significand and a power of two, scaled by a power
+// of ten in 128 bits and rounded half-to-even, so no digit is ever
+// guessed.  Values too large for that fall back to snprintf().
+void appendFixed(std::string& out, double v, int precision)
+{
+    static const uint64_t pow10[] =
+    {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+        10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+        100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+        100000000000000ULL, 1000000000000000ULL
+    };
+    const int maxPrecision = 15;
+
+    const double a = std::fabs(v);
+    if (precision < 0 || precision > maxPrecision || !(a < 1e18) ||
+        a * pow10[precision] >= 1e19)
+    {
+        int len = std::snprintf(nullptr, 0, "%.*f", precision, v);
+        size_t pos = out.size();
+        out.resize(pos + len + 1);
+        std::snprintf(&out[pos], len + 1, "%.*f", precision, v);
+        out.resize(pos + len);
+        return;
+    }
+
+    // a == m * 2^e exactly.
+    int exp;
+    const double f = std::frexp(a, &exp);
+    const uint64_t m = (uint64_t)std::ldexp(f, 53);
+    const int e = exp - 53;
+    const uint64_t p = pow10[precision];
+
+    uint64_t q;
+    if (e >= 0)
+        q = (m << e) * p;
+    else
+    {
+        // m * p as a 128 bit value (hi, lo).  m < 2^53 and p < 2^50.
+        const uint64_t mask = 0xFFFFFFFF;
+        const uint64_t p00 = (m & mask) * (p & mask);
+        const uint64_t p01 = (m & mask) * (p >> 32);
+        const uint64_t p10 = (m >> 32) * (p & mask);
+        const uint64_t p11 = (m >> 32) * (p >> 32);
+        const uint64_t mid = (p00 >> 32) + (p01 & mask) + (p10 & mask);
+        const uint64_t lo = (p00 & mask) | (mid << 32);
+        const uint64_t hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+
+        // Shift right by s, keeping the remainder to compare against
+        // one half: 2^(s - 1).
+        const int s = -e;
+        bool above;
+        bool equal;
+        if (s > 104)
+        {
+            // The product is below 2^103, less than half of 2^s.
+            q = 0;
+            above = equal = false;
+        }
+        else if (s < 64)
+        {
+            q = (lo >> s) | (hi << (64 - s));
+            const uint64_t rem = lo & ((1ULL << s) - 1);
+            const uint64_t half = 1ULL << (s - 1);
+            above = rem > half;
+            equal = rem == half;
+        }
+        else if (s == 64)
+        {
+            q = hi;
+            above = lo > (1ULL << 63);
+            equal = lo == (1ULL << 63);
+        }
+        else
+        {
+            q = hi >> (s - 64);
+            const uint64_t rem = hi & ((1ULL << (s - 64)) - 1);
+            const uint64_t half = 1ULL << (s - 65);
+            above = rem > half || (rem == half && lo);
+            equal = rem == half && !lo;
+        }
+        if (above || (equal && (q & 1)))
+            q++;
+    }
+
+    // Write the digits backwards, with at least one before the point.
+    char buf[32];
+    char *pos = buf + sizeof(buf);
+    int digits = 0;
+    do
+    {
+        if (digits == precision && precision)
+            *--pos = '.';
+        *--pos = (char)('0' + q % 10);
+        q /= 10;
+        digits++;
+    } while (q || digits <= precision);
+    if (std::signbit(v))
+        *--pos = '-';
+    out.append(pos, buf + sizeof(buf));
+}
+
+} // unnamed namespace
+
+TextWriter::TextWriter()
+{}
+
+
+TextWriter::~TextWriter()
+{}
+
+
 struct FileStreamDeleter
 {
 
@@ -84,6 +210,27 @@ void TextWriter::addArgs(ProgramArgs& args)
     args.add("quote_header", "Whether a header should be quoted",
         m_quoteHeader, true);
     args.add("precision", "Output precision", m_precision, 3);
+    args.add("threads", "Number of threads used to format points",
+        m_threads, (uint32_t)ThreadPool::defaultThreadCount());
+}
+
+
+// Only the dimensions listed in 'order' are used unless the rest are
+// written as well.
+bool TextWriter::usedDimensions(StringList& dims) const
+{
+    if (m_dimOrder.empty() || m_writeAllDims)
+        return false;
+
+    StringList dimNames = Utils::split2(m_dimOrder, ',');
+    for (std::string dim : dimNames)
+    {
+        Utils::trim(dim);
+        dims.push_back(dim);
+    }
+    if (Utils::iequals(m_outputType, "GEOJSON"))
+        dims.insert(dims.end(), { "X", "Y", "Z" });
+    return true;
 }
 
 
@@ -99,9 +246,6 @@ void TextWriter::initialize(PointTableRef table)
 
 void TextWriter::ready(PointTableRef table)
 {
-    m_stream->precision(m_precision);
-    *m_stream << std::fixed;
-
     // Find the dimensions listed and put them on the id list.
     StringList dimNames = Utils::split2(m_dimOrder, ',');
     for (std::string dim : dimNames)
@@ -122,6 +266,13 @@ void TextWriter::ready(PointTableRef table)
             if (!Utils::contains(m_dims, *di))
                 m_dims.push_back(*di);
     }
+    m_dimNames.clear();
+    for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
+        m_dimNames.push_back(table.layout()->dimName(*di));
+
+    m_pool.reset(new ThreadPool((std::max)(m_threads, 1U)));
+    m_buf.clear();
+    m_separate = false;
 
     if (!m_writeHeader)
         log()->get(LogLevel::Debug) << "Not writing header" << std::endl;
@@ -177,63 +328,129 @@ void TextWriter::writeCSVHeader(PointTableRef table)
     *m_stream << m_newline;
 }
 
-void TextWriter::writeCSVBuffer(const PointViewPtr view)
+void TextWriter::formatCSVPoint(PointRef& point, std::string& out) const
 {
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
     {
-        for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
-        {
-            if (di != m_dims.begin())
-                *m_stream << m_delimiter;
-            *m_stream << view->getFieldAs<double>(*di, idx);
-        }
-        *m_stream << m_newline;
+        if (di != m_dims.begin())
+            out += m_delimiter;
+        appendFixed(out, point.getFieldAs<double>(*di), m_precision);
     }
+    out += m_newline;
 }
 
-void TextWriter::writeGeoJSONBuffer(const PointViewPtr view)
+
+void TextWriter::formatGeoJSONPoint(PointRef& point, std::string& out) const
 {
     using namespace Dimension;
 
-    for (PointId idx = 0; idx < view->size(); ++idx)
+    out += "{ \"type\":\"Feature\",\"geometry\": "
+        "{ \"type\": \"Point\", \"coordinates\": [";
+    appendFixed(out, point.getFieldAs<double>(Id::X), m_precision);
+    out += ',';
+    appendFixed(out, point.getFieldAs<double>(Id::Y), m_precision);
+    out += ',';
+    appendFixed(out, point.getFieldAs<double>(Id::Z), m_precision);
+    out += "]},";
+
+    out += "\"properties\": {";
+    for (size_t i = 0; i < m_dims.size(); ++i)
+    {
+        if (i)
+            out += ',';
+        out += '"';
+        out += m_dimNames[i];
+        out += "\":\"";
+        appendFixed(out, point.getFieldAs<double>(m_dims[i]), m_precision);
+        out += '"';
+    }
+    out += "}"; // end properties
+    out += "}"; // end feature
+}
+
+
+// Append one point to 'out'.  'separate' indicates that a GeoJSON feature
+// has already been written and the point needs a separator.
+void TextWriter::formatPoint(PointRef& point, bool separate,
+    std::string& out) const
+{
+    if (m_outputType == "CSV")
+        formatCSVPoint(point, out);
+    else if (m_outputType == "GEOJSON")
     {
-        if (idx)
-            *m_stream << ",";
+        if (separate)
+            out += ',';
+        formatGeoJSONPoint(point, out);
+    }
+}
 
-        *m_stream << "{ \"type\":\"Feature\",\"geometry\": "
-            "{ \"type\": \"Point\", \"coordinates\": [";
-        *m_stream << view->getFieldAs<double>(Id::X, idx) << ",";
-        *m_stream << view->getFieldAs<double>(Id::Y, idx) << ",";
-        *m_stream << view->getFieldAs<double>(Id::Z, idx) << "]},";
 
-        *m_stream << "\"properties\": {";
+// Format the points [begin, end) of a view into 'out', replacing its
+// contents.
+void TextWriter::formatPoints(PointView& view, PointId begin, PointId end,
+    bool separate, std::string& out) const
+{
+    out.clear();
+    PointRef point(view, begin);
+    for (PointId idx = begin; idx < end; ++idx)
+    {
+        point.setPointId(idx);
+        formatPoint(point, separate || idx != begin, out);
+    }
+}
 
-        for (auto di = m_dims.begin(); di != m_dims.end(); ++di)
-        {
-            if (di != m_dims.begin())
-                *m_stream << ",";
 
-            *m_stream << "\"" << view->dimName(*di) << "\":";
-            *m_stream << "\"";
-            *m_stream << view->getFieldAs<double>(*di, idx);
-            *m_stream <<"\"";
+void TextWriter::write(const PointViewPtr view)
+{
+    // Chunks of points are formatted in parallel and written in order.
+    // The buffers are reused so their memory is allocated only once.
+    const size_t numThreads = m_pool->numThreads();
+    std::vector<std::string> bufs(numThreads);
+    for (PointId begin = 0; begin < view->size();
+        begin += ChunkSize * numThreads)
+    {
+        size_t tasks = 0;
+        for (size_t t = 0; t < numThreads; ++t)
+        {
+            PointId first = begin + t * ChunkSize;
+            if (first >= view->size())
+                break;
+            PointId last = (std::min)(first + ChunkSize, view->size());
+            bool separate = m_separate || first > 0;
+            std::string& buf = bufs[t];
+            m_pool->add([this, &view, first, last, separate, &buf]()
+                { formatPoints(*view, first, last, separate, buf); });
+            tasks++;
         }
-        *m_stream << "}"; // end properties
-        *m_stream << "}"; // end feature
+        m_pool->await();
+        for (size_t t = 0; t < tasks; ++t)
+            m_stream->write(bufs[t].data(), bufs[t].size());
     }
+    if (view->size())
+        m_separate = true;
 }
 
-void TextWriter::write(const PointViewPtr view)
+
+bool TextWriter::processOne(PointRef& point)
 {
-    if (m_outputType == "CSV")
-        writeCSVBuffer(view);
-    else if (m_outputType == "GEOJSON")
-        writeGeoJSONBuffer(view);
+    formatPoint(point, m_separate, m_buf);
+    m_separate = true;
+    if (m_buf.size() >= FlushSize)
+        flush();
+    return true;
+}
+
+
+void TextWriter::flush()
+{
+    m_stream->write(m_buf.data(), m_buf.size());
+    m_buf.clear();
 }
 
 
 void TextWriter::done(PointTableRef /*table*/)
 {
+    flush();
     writeFooter();
     getMetadata().addList("filename", m_filename);
 }
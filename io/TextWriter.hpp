@@ -50,13 +50,15 @@ extern "C" PF_ExitFunc TextWriter_InitPlugin();
 namespace pdal
 {
 
+class ThreadPool;
+
 typedef std::shared_ptr<std::ostream> FileStreamPtr;
 
 class PDAL_DLL TextWriter : public Writer
 {
 public:
-    TextWriter()
-    {}
+    TextWriter();
+    ~TextWriter();
 
     static void * create();
     static int32_t destroy(void *);
@@ -64,9 +66,11 @@ public:
 
 private:
     virtual void addArgs(ProgramArgs& args);
+    virtual bool usedDimensions(StringList& dims) const;
     virtual void initialize(PointTableRef table);
     virtual void ready(PointTableRef table);
     virtual void write(const PointViewPtr view);
+    virtual bool processOne(PointRef& point);
     virtual void done(PointTableRef table);
 
     void writeHeader(PointTableRef table);
@@ -74,8 +78,12 @@ private:
     void writeGeoJSONHeader();
     void writeCSVHeader(PointTableRef table);
 
-    void writeGeoJSONBuffer(const PointViewPtr view);
-    void writeCSVBuffer(const PointViewPtr view);
+    void formatPoints(PointView& view, PointId begin, PointId end,
+        bool separate, std::string& out) const;
+    void formatPoint(PointRef& point, bool separate, std::string& out) const;
+    void formatCSVPoint(PointRef& point, std::string& out) const;
+    void formatGeoJSONPoint(PointRef& point, std::string& out) const;
+    void flush();
 
     std::string m_filename;
     std::string m_outputType;
@@ -88,9 +96,14 @@ private:
     bool m_quoteHeader;
     bool m_packRgb;
     int m_precision;
+    uint32_t m_threads;
 
     FileStreamPtr m_stream;
     Dimension::IdList m_dims;
+    StringList m_dimNames;
+    std::unique_ptr<ThreadPool> m_pool;
+    std::string m_buf;
+    bool m_separate;
 
     TextWriter& operator=(const TextWriter&); // not implemented
     TextWriter(const TextWriter&); // not implemented
@@ -0,0 +1,327 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include "TileWriter.hpp"
+
+#include <io/BufferReader.hpp>
+#include <pdal/pdal_macros.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ProgramArgs.hpp>
+
+#include <cmath>
+#include <limits>
+
+namespace pdal
+{
+
+static PluginInfo const s_info = PluginInfo(
+    "writers.tile",
+    "Write points to a file per XY tile in a single pass.",
+    "http://pdal.io/stages/writers.tile.html" );
+
+CREATE_STATIC_PLUGIN(1, 0, TileWriter, Writer, s_info)
+
+std::string TileWriter::getName() const { return s_info.name; }
+
+
+TileWriter::TileWriter() : m_hashPos(std::string::npos), m_pointSize(0),
+    m_buffered(0)
+{}
+
+
+// Remove spill files left behind if writing was interrupted.
+TileWriter::~TileWriter()
+{
+    for (auto& t : m_tiles)
+    {
+        Tile& tile = t.second;
+        if (tile.m_spilled || tile.m_spill)
+        {
+            tile.m_spill.reset();
+            FileUtils::deleteFile(tile.m_filename + ".spill");
+        }
+    }
+}
+
+
+void TileWriter::addArgs(ProgramArgs& args)
+{
+    args.add("filename", "Output filename template.  '#' is replaced with "
+        "the tile's column and row", m_filename).setPositional();
+    args.add("length", "Edge length of tiles", m_length, 1000.0);
+    args.add("origin_x", "X origin of the tile grid", m_xOrigin,
+        std::numeric_limits<double>::quiet_NaN());
+    args.add("origin_y", "Y origin of the tile grid", m_yOrigin,
+        std::numeric_limits<double>::quiet_NaN());
+    args.add("writer", "Driver used to write tiles", m_driver);
+    args.add("buffer_size", "Number of points held in memory before tile "
+        "data is spilled to disk", m_bufferSize, (point_count_t)1000000);
+    args.add("max_open_files", "Maximum number of spill files open at once",
+        m_maxOpen, 64U);
+    args.add("writer_options", "JSON object of options passed to the "
+        "writer of each tile", m_writerOptions);
+}
+
+
+void TileWriter::initialize()
+{
+    m_hashPos = handleFilenameTemplate(m_filename);
+    if (m_hashPos == std::string::npos)
+        throwError("Filename must contain a '#' placeholder for the tile.");
+    if (m_length <= 0)
+        throwError("Option 'length' must be greater than 0.");
+    if (m_bufferSize == 0)
+        throwError("Option 'buffer_size' must be greater than 0.");
+    if (m_maxOpen == 0)
+        throwError("Option 'max_open_files' must be greater than 0.");
+    if (m_driver.empty())
+        m_driver = StageFactory::inferWriterDriver(m_filename);
+    if (m_driver.empty())
+        throwError("Can't infer writer for '" + m_filename + "'.  Use "
+            "option 'writer' to specify one.");
+
+    if (!m_writerOptions.isNull() && !m_writerOptions.isObject())
+        throwError("Option 'writer_options' must be a JSON object.");
+    m_tileOptions = Options();
+    for (const std::string& name : m_writerOptions.getMemberNames())
+    {
+        if (name == "filename")
+            throwError("Option 'writer_options' can't set 'filename'.");
+        const Json::Value& val = m_writerOptions[name];
+        if (val.isArray())
+        {
+            for (const Json::Value& v : val)
+            {
+                if (!v.isConvertibleTo(Json::stringValue))
+                    throwError("Invalid value in 'writer_options' for '" +
+                        name + "'.");
+                m_tileOptions.add(name, v.asString());
+            }
+        }
+        else if (val.isConvertibleTo(Json::stringValue))
+            m_tileOptions.add(name, val.asString());
+        else
+            throwError("Invalid value in 'writer_options' for '" +
+                name + "'.");
+    }
+}
+
+
+void TileWriter::ready(PointTableRef table)
+{
+    m_dimTypes = table.layout()->dimTypes();
+    m_pointSize = 0;
+    for (auto& dt : m_dimTypes)
+        m_pointSize += Dimension::size(dt.m_type);
+    m_buffered = 0;
+}
+
+
+bool TileWriter::processOne(PointRef& point)
+{
+    double x = point.getFieldAs<double>(Dimension::Id::X);
+    double y = point.getFieldAs<double>(Dimension::Id::Y);
+
+    // Use the location of the first point as the origin, unless specified.
+    if (std::isnan(m_xOrigin))
+        m_xOrigin = x;
+    if (std::isnan(m_yOrigin))
+        m_yOrigin = y;
+
+    Coord loc((int)std::floor((x - m_xOrigin) / m_length),
+        (int)std::floor((y - m_yOrigin) / m_length));
+    Tile& tile = m_tiles[loc];
+    if (tile.m_filename.empty())
+    {
+        tile.m_filename = m_filename;
+        tile.m_filename.replace(m_hashPos, 1, std::to_string(loc.first) +
+            "_" + std::to_string(loc.second));
+    }
+
+    size_t pos = tile.m_buf.size();
+    tile.m_buf.resize(pos + m_pointSize);
+    point.getPackedData(m_dimTypes, tile.m_buf.data() + pos);
+    tile.m_count++;
+    if (++m_buffered >= m_bufferSize)
+        spill();
+    return true;
+}
+
+
+void TileWriter::write(const PointViewPtr view)
+{
+    for (PointId idx = 0; idx < view->size(); ++idx)
+    {
+        PointRef point(view->point(idx));
+        processOne(point);
+    }
+}
+
+
+// Append the points held in memory to each tile's spill file.
+void TileWriter::spill()
+{
+    for (auto& t : m_tiles)
+    {
+        Tile& tile = t.second;
+        if (!tile.m_count)
+            continue;
+
+        std::ofstream& out = spillFile(tile);
+        out.write(tile.m_buf.data(), tile.m_buf.size());
+        if (!out)
+            throwError("Error writing spill file for '" +
+                tile.m_filename + "'.");
+        tile.m_spilled += tile.m_count;
+        tile.m_count = 0;
+        std::vector<char>().swap(tile.m_buf);
+    }
+    m_buffered = 0;
+}
+
+
+// Get the open spill file of a tile, closing the least-recently used spill
+// file if too many are open.
+std::ofstream& TileWriter::spillFile(Tile& tile)
+{
+    if (tile.m_spill)
+    {
+        m_open.splice(m_open.begin(), m_open, tile.m_lruPos);
+        return *tile.m_spill;
+    }
+
+    if (m_open.size() >= m_maxOpen)
+        closeSpill(*m_open.back());
+
+    std::ios::openmode mode = std::ios::out | std::ios::binary |
+        (tile.m_spilled ? std::ios::app : std::ios::trunc);
+    std::string filename(tile.m_filename + ".spill");
+    tile.m_spill.reset(new std::ofstream(filename, mode));
+    if (!*tile.m_spill)
+        throwError("Unable to open spill file '" + filename + "'.");
+    m_open.push_front(&tile);
+    tile.m_lruPos = m_open.begin();
+    return *tile.m_spill;
+}
+
+
+void TileWriter::closeSpill(Tile& tile)
+{
+    if (!tile.m_spill)
+        return;
+    tile.m_spill.reset();
+    m_open.erase(tile.m_lruPos);
+}
+
+
+void TileWriter::done(PointTableRef table)
+{
+    for (auto& t : m_tiles)
+        writeTile(t.second, table);
+    log()->get(LogLevel::Debug) << getName() << ": wrote " <<
+        m_tiles.size() << " tiles." << std::endl;
+    m_tiles.clear();
+}
+
+
+// Write the points of a tile, read back from its spill file and memory,
+// with a writer of its own.  The writer runs in standard mode, so all of
+// the tile's points are loaded at once.
+void TileWriter::writeTile(Tile& tile, PointTableRef table)
+{
+    point_count_t count = tile.m_spilled + tile.m_count;
+    if (count > m_bufferSize)
+        log()->get(LogLevel::Warning) << getName() << ": tile '" <<
+            tile.m_filename << "' has " << count << " points, more than "
+            "'buffer_size'.  All are held in memory while it's written." <<
+            std::endl;
+
+    PointTable tileTable;
+    PointLayoutPtr layout(tileTable.layout());
+    for (auto& dt : m_dimTypes)
+        layout->registerOrAssignDim(table.layout()->dimName(dt.m_id),
+            dt.m_type);
+
+    BufferReader reader;
+    reader.setSpatialReference(table.anySpatialReference());
+    Stage *writer = m_factory.createStage(m_driver);
+    if (!writer)
+        throwError("Unable to create writer '" + m_driver + "'.");
+    Options opts(m_tileOptions);
+    opts.add("filename", tile.m_filename);
+    writer->setOptions(opts);
+    writer->setInput(reader);
+    writer->prepare(tileTable);
+
+    DimTypeList dimTypes;
+    for (auto& dt : m_dimTypes)
+        dimTypes.push_back(DimType(
+            layout->findDim(table.layout()->dimName(dt.m_id)), dt.m_type));
+
+    PointViewPtr view(new PointView(tileTable));
+    PointId idx = 0;
+    if (tile.m_spilled)
+    {
+        closeSpill(tile);
+        std::string filename(tile.m_filename + ".spill");
+        std::istream *in = FileUtils::openFile(filename);
+        if (!in)
+            throwError("Unable to open spill file '" + filename + "'.");
+        std::vector<char> buf(m_pointSize);
+        for (point_count_t i = 0; i < tile.m_spilled; ++i)
+        {
+            in->read(buf.data(), m_pointSize);
+            if (!*in)
+            {
+                FileUtils::closeFile(in);
+                throwError("Error reading spill file '" + filename + "'.");
+            }
+            view->setPackedPoint(dimTypes, idx++, buf.data());
+        }
+        FileUtils::closeFile(in);
+        FileUtils::deleteFile(filename);
+        tile.m_spilled = 0;
+    }
+    for (point_count_t i = 0; i < tile.m_count; ++i)
+        view->setPackedPoint(dimTypes, idx++,
+            tile.m_buf.data() + i * m_pointSize);
+    std::vector<char>().swap(tile.m_buf);
+    tile.m_count = 0;
+
+    reader.addView(view);
+    writer->execute(tileTable);
+    m_factory.destroyStage(writer);
+}
+
+} // namespace pdal
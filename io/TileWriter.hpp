@@ -0,0 +1,123 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/plugin.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/Writer.hpp>
+
+#include <json/json.h>
+
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+
+extern "C" int32_t TileWriter_ExitFunc();
+extern "C" PF_ExitFunc TileWriter_InitPlugin();
+
+namespace pdal
+{
+
+/**
+  Writes points to a file per square XY tile.  Points are routed to their
+  tile as they arrive, so the writer works in streaming mode.  Tile data is
+  held in memory up to a limit and then appended to a spill file per tile.
+  The output file for each tile is written once all points have been seen.
+  Writing a tile holds all of its points in memory, so the memory used at
+  that point is bounded by the size of the largest tile rather than by
+  'buffer_size'.
+*/
+class PDAL_DLL TileWriter : public Writer
+{
+public:
+    TileWriter();
+    ~TileWriter();
+
+    static void * create();
+    static int32_t destroy(void *);
+    std::string getName() const;
+
+private:
+    typedef std::pair<int, int> Coord;
+
+    struct Tile
+    {
+        Tile() : m_count(0), m_spilled(0)
+        {}
+
+        std::string m_filename;
+        std::vector<char> m_buf;    // Packed points not yet spilled.
+        point_count_t m_count;      // Points in m_buf.
+        point_count_t m_spilled;    // Points in the spill file.
+        std::unique_ptr<std::ofstream> m_spill;
+        std::list<Tile *>::iterator m_lruPos;
+    };
+
+    std::string m_filename;
+    std::string m_driver;
+    double m_length;
+    double m_xOrigin;
+    double m_yOrigin;
+    point_count_t m_bufferSize;
+    uint32_t m_maxOpen;
+    Json::Value m_writerOptions;
+    Options m_tileOptions;      // Options for each tile's writer.
+
+    std::string::size_type m_hashPos;
+    DimTypeList m_dimTypes;
+    size_t m_pointSize;
+    point_count_t m_buffered;
+    std::map<Coord, Tile> m_tiles;
+    std::list<Tile *> m_open;       // Open spill files, most recent first.
+    StageFactory m_factory;
+
+    virtual void addArgs(ProgramArgs& args);
+    virtual void initialize();
+    virtual void ready(PointTableRef table);
+    virtual bool processOne(PointRef& point);
+    virtual void write(const PointViewPtr view);
+    virtual void done(PointTableRef table);
+
+    void spill();
+    std::ofstream& spillFile(Tile& tile);
+    void closeSpill(Tile& tile);
+    void writeTile(Tile& tile, PointTableRef table);
+
+    TileWriter& operator=(const TileWriter&); // not implemented
+    TileWriter(const TileWriter&); // not implemented
+};
+
+} // namespace pdal
@@ -38,6 +38,8 @@
 #include <pdal/StageFactory.hpp>
 #include <pdal/pdal_macros.hpp>
 
+#include <json/json.h>
+
 namespace pdal
 {
 
@@ -62,6 +64,7 @@ void SplitKernel::addSwitches(ProgramArgs& args)
         std::numeric_limits<double>::quiet_NaN());
     args.add("origin_y", "Origin in Y axis for splitter cells", m_yOrigin,
         std::numeric_limits<double>::quiet_NaN());
+    args.add("stream", "Split by length in streaming mode", m_stream);
 }
 
 
@@ -84,20 +87,54 @@ void SplitKernel::validateSwitches(ProgramArgs& args)
 
 namespace
 {
-std::string makeFilename(const std::string& s, int i)
+std::string makeFilename(const std::string& s, const std::string& suffix)
 {
     std::string out = s;
     auto pos = out.find_last_of('.');
     if (pos == out.npos)
         pos = out.length();
-    out.insert(pos, std::string("_") + std::to_string(i));
+    out.insert(pos, std::string("_") + suffix);
     return out;
 }
 }
 
 
+// Split by length in a single streaming pass by routing points to per-tile
+// writers as they're read.  Options given on the command line for the
+// output driver are passed along to the writer of each tile.
+int SplitKernel::splitByLength()
+{
+    Stage& reader = makeReader(m_inputFile, m_driverOverride);
+
+    std::string driver = StageFactory::inferWriterDriver(m_outputFile);
+    Json::Value driverOpts(Json::objectValue);
+    OptionsMap& stageOptions = m_manager.stageOptions();
+    auto oi = stageOptions.find(driver);
+    if (oi != stageOptions.end())
+        for (const Option& op : oi->second.getOptions())
+            driverOpts[op.getName()].append(op.getValue());
+
+    Options writerOpts;
+    writerOpts.add("length", m_length);
+    writerOpts.add("origin_x", m_xOrigin);
+    writerOpts.add("origin_y", m_yOrigin);
+    writerOpts.add("writer", driver);
+    writerOpts.add("writer_options", Json::FastWriter().write(driverOpts));
+    Stage& writer = makeWriter(makeFilename(m_outputFile, "#"), reader,
+        "writers.tile", writerOpts);
+
+    FixedPointTable table(10000);
+    writer.prepare(table);
+    writer.execute(table);
+    return 0;
+}
+
+
 int SplitKernel::execute()
 {
+    if (m_length && m_stream)
+        return splitByLength();
+
     PointTable table;
 
     Stage& reader = makeReader(m_inputFile, m_driverOverride);
@@ -124,7 +161,8 @@ int SplitKernel::execute()
         BufferReader reader;
         reader.addView(pvp);
 
-        std::string filename = makeFilename(m_outputFile, filenum++);
+        std::string filename = makeFilename(m_outputFile,
+            std::to_string(filenum++));
         Stage& writer = makeWriter(filename, reader, "");
 
         writer.prepare(table);
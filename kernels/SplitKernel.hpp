@@ -50,6 +50,7 @@ public:
     static int32_t destroy(void *);
     std::string getName() const;
     int execute();
+    int splitByLength();
 
 private:
     void addSwitches(ProgramArgs& args);
@@ -61,6 +62,7 @@ private:
     double m_length;
     double m_xOrigin;
     double m_yOrigin;
+    bool m_stream;
 };
 
 } // namespace pdal
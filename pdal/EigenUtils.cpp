@@ -52,7 +52,8 @@ namespace pdal
 namespace eigen
 {
 
-Eigen::Vector3f computeCentroid(PointView& view, std::vector<PointId> ids)
+Eigen::Vector3f computeCentroid(PointView& view,
+    const std::vector<PointId>& ids)
 {
     using namespace Eigen;
 
@@ -73,29 +74,51 @@ Eigen::Vector3f computeCentroid(PointView& view, std::vector<PointId> ids)
     return centroid;
 }
 
-Eigen::Matrix3f computeCovariance(PointView& view, std::vector<PointId> ids)
+Eigen::Matrix3f computeCovariance(PointView& view,
+    const std::vector<PointId>& ids)
 {
     using namespace Eigen;
 
-    auto n = ids.size();
+    Matrix3f cov = Matrix3f::Zero();
+    if (ids.empty())
+        return cov;
 
-    Vector3f centroid = computeCentroid(view, ids);
+    // Accumulate sums and products in a single pass, relative to the
+    // first point to avoid losing precision with large coordinates.
+    double cx = view.getFieldAs<double>(Dimension::Id::X, ids[0]);
+    double cy = view.getFieldAs<double>(Dimension::Id::Y, ids[0]);
+    double cz = view.getFieldAs<double>(Dimension::Id::Z, ids[0]);
 
-    // demean the neighborhood
-    MatrixXf A(3, n);
-    size_t k = 0;
+    double sx = 0, sy = 0, sz = 0;
+    double sxx = 0, sxy = 0, sxz = 0, syy = 0, syz = 0, szz = 0;
     for (auto const& j : ids)
     {
-        A(0, k) = view.getFieldAs<double>(Dimension::Id::X, j) - centroid[0];
-        A(1, k) = view.getFieldAs<double>(Dimension::Id::Y, j) - centroid[1];
-        A(2, k) = view.getFieldAs<double>(Dimension::Id::Z, j) - centroid[2];
-        k++;
+        double dx = view.getFieldAs<double>(Dimension::Id::X, j) - cx;
+        double dy = view.getFieldAs<double>(Dimension::Id::Y, j) - cy;
+        double dz = view.getFieldAs<double>(Dimension::Id::Z, j) - cz;
+        sx += dx;
+        sy += dy;
+        sz += dz;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        sxz += dx * dz;
+        syy += dy * dy;
+        syz += dy * dz;
+        szz += dz * dz;
     }
 
-    return A * A.transpose();
+    double n = (double)ids.size();
+    cov(0, 0) = sxx - sx * sx / n;
+    cov(0, 1) = cov(1, 0) = sxy - sx * sy / n;
+    cov(0, 2) = cov(2, 0) = sxz - sx * sz / n;
+    cov(1, 1) = syy - sy * sy / n;
+    cov(1, 2) = cov(2, 1) = syz - sy * sz / n;
+    cov(2, 2) = szz - sz * sz / n;
+    return cov;
 }
 
-uint8_t computeRank(PointView& view, std::vector<PointId> ids, double threshold)
+uint8_t computeRank(PointView& view, const std::vector<PointId>& ids,
+    double threshold)
 {
     using namespace Eigen;
 
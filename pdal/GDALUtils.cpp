@@ -805,6 +805,21 @@ GDALError Raster::read(double x, double y, std::vector<double>& data)
 }
 
 
+bool Raster::noData(int nBand, double& value) const
+{
+    if (!m_ds)
+        return false;
+
+    GDALRasterBand *band = m_ds->GetRasterBand(nBand);
+    if (!band)
+        return false;
+
+    int success(0);
+    value = band->GetNoDataValue(&success);
+    return success;
+}
+
+
 SpatialReference Raster::getSpatialRef() const
 {
     SpatialReference srs;
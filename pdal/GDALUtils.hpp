@@ -363,6 +363,15 @@ public:
     */
     GDALError read(double x, double y, std::vector<double>& data);
 
+    /**
+      Get the value that indicates no data in a raster band.
+
+      \param nBand  Band number.  Band numbers start at 1.
+      \param[out] value  No-data value of the band.
+      \return  Whether the band has a no-data value.
+    */
+    bool noData(int nBand, double& value) const;
+
     /**
       Get a vector of dimensions that map to the bands of a raster.
     */
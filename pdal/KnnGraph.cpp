@@ -0,0 +1,171 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/KnnGraph.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/util/ThreadPool.hpp>
+
+#include <limits>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Fewest points worth processing on a separate thread.
+const point_count_t MinRangeSize = 4096;
+
+} // unnamed namespace
+
+
+KnnGraph::KnnGraph(PointView& view, point_count_t k) : m_size(view.size()),
+    m_k(k), m_xyz(3 * view.size())
+{
+    double *p = m_xyz.data();
+    for (PointId i = 0; i < m_size; ++i)
+    {
+        *p++ = view.getFieldAs<double>(Dimension::Id::X, i);
+        *p++ = view.getFieldAs<double>(Dimension::Id::Y, i);
+        *p++ = view.getFieldAs<double>(Dimension::Id::Z, i);
+    }
+}
+
+
+KnnGraphPtr KnnGraph::get(PointView& view, point_count_t k, size_t threads)
+{
+    k = (std::min)(k, view.size());
+
+    KnnGraphPtr cached = view.m_knnGraph;
+    if (cached && cached->m_k >= k && cached->m_size == view.size())
+        return cached;
+
+    // Drop the old graph before building its replacement.
+    cached.reset();
+    view.m_knnGraph.reset();
+
+    if (view.size() > (std::numeric_limits<uint32_t>::max)())
+        throw pdal_error("Can't compute neighbors of a view with more than "
+            "4294967295 points.");
+
+    std::shared_ptr<KnnGraph> graph(new KnnGraph(view, k));
+    graph->compute(view, threads);
+    view.m_knnGraph = graph;
+    return graph;
+}
+
+
+void KnnGraph::release(PointView& view)
+{
+    view.m_knnGraph.reset();
+}
+
+
+void KnnGraph::compute(PointView& view, size_t threads)
+{
+    KD3Index kdi(view);
+    kdi.build();
+
+    m_ids.resize(m_size * m_k);
+    ThreadPool::parallelFor(threads, m_size, MinRangeSize,
+        [this, &kdi](PointId begin, PointId end)
+    {
+        std::vector<PointId> indices(m_k);
+        std::vector<double> sqrDists(m_k);
+        for (PointId i = begin; i < end; ++i)
+        {
+            const double *p = point(i);
+            kdi.knnSearch(p[0], p[1], p[2], m_k, &indices, &sqrDists);
+            std::copy(indices.begin(), indices.end(),
+                m_ids.begin() + i * m_k);
+        }
+    });
+}
+
+
+Eigen::Matrix3d KnnGraph::covariance(PointId id, point_count_t k) const
+{
+    // Accumulate sums relative to the point itself to avoid losing
+    // precision with large coordinates.
+    const double *c = point(id);
+    const uint32_t *ids = neighbors(id);
+
+    double sx = 0, sy = 0, sz = 0;
+    double sxx = 0, sxy = 0, sxz = 0, syy = 0, syz = 0, szz = 0;
+    for (point_count_t j = 0; j < k; ++j)
+    {
+        const double *p = point(ids[j]);
+        double dx = p[0] - c[0];
+        double dy = p[1] - c[1];
+        double dz = p[2] - c[2];
+        sx += dx;
+        sy += dy;
+        sz += dz;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        sxz += dx * dz;
+        syy += dy * dy;
+        syz += dy * dz;
+        szz += dz * dz;
+    }
+
+    Eigen::Matrix3d cov;
+    if (k)
+    {
+        double n = (double)k;
+        cov(0, 0) = sxx - sx * sx / n;
+        cov(0, 1) = cov(1, 0) = sxy - sx * sy / n;
+        cov(0, 2) = cov(2, 0) = sxz - sx * sz / n;
+        cov(1, 1) = syy - sy * sy / n;
+        cov(1, 2) = cov(2, 1) = syz - sy * sz / n;
+        cov(2, 2) = szz - sz * sz / n;
+    }
+    else
+        cov.setZero();
+    return cov;
+}
+
+
+void KnnGraph::forEach(size_t threads,
+    const std::function<void(PointId)>& f) const
+{
+    ThreadPool::parallelFor(threads, m_size, MinRangeSize,
+        [&f](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+            f(i);
+    });
+}
+
+} // namespace pdal
@@ -0,0 +1,164 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <pdal/pdal_internal.hpp>
+#include <pdal/PointView.hpp>
+
+#include <Eigen/Dense>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace pdal
+{
+
+class KnnGraph;
+typedef std::shared_ptr<const KnnGraph> KnnGraphPtr;
+
+/**
+  The k nearest neighbors of each point of a view.
+
+  The graph is computed from a single KD-tree with the neighbor queries run
+  in parallel.  It's cached on the view so that stages that need the same
+  (or fewer) neighbors of the same points share a single neighbor search.
+  The cached graph is recomputed if the view's size has changed or if more
+  neighbors are needed.
+
+  The graph holds a copy of the coordinates and k PointIds per point.
+  When run in a pipeline, it's released before the view reaches a stage
+  that doesn't use it (see Stage::usesKnnGraph()).  Code that changes the
+  coordinates of a view directly must call release() before asking for
+  the graph again.
+*/
+class PDAL_DLL KnnGraph
+{
+public:
+    /**
+      Get the neighbor graph of a view.
+
+      \param view  View whose points are searched.
+      \param k  Number of neighbors of each point, including the point
+        itself.
+      \param threads  Number of threads used to compute a new graph.
+      \return  A graph with at least k neighbors of each point.
+    */
+    static KnnGraphPtr get(PointView& view, point_count_t k,
+        size_t threads = 1);
+
+    /**
+      Drop the graph cached on a view, if any.  Its memory is freed once
+      no caller of get() holds it.
+
+      \param view  View whose graph should be released.
+    */
+    static void release(PointView& view);
+
+    /**
+      Number of points in the graph.
+    */
+    point_count_t size() const
+        { return m_size; }
+
+    /**
+      Number of neighbors stored for each point.
+    */
+    point_count_t k() const
+        { return m_k; }
+
+    /**
+      Neighbors of a point, nearest first.  The point itself is included,
+      usually as the first neighbor.
+
+      \param id  ID of the point.
+      \return  Pointer to the k() PointIds of the neighbors.
+    */
+    const uint32_t *neighbors(PointId id) const
+        { return m_ids.data() + id * m_k; }
+
+    /**
+      Coordinates of a point.
+
+      \param id  ID of the point.
+      \return  Pointer to the X, Y and Z values of the point.
+    */
+    const double *point(PointId id) const
+        { return m_xyz.data() + 3 * id; }
+
+    /**
+      Squared distance between two points.
+    */
+    double sqrDist(PointId id1, PointId id2) const
+    {
+        const double *p1 = point(id1);
+        const double *p2 = point(id2);
+        double dx = p1[0] - p2[0];
+        double dy = p1[1] - p2[1];
+        double dz = p1[2] - p2[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    /**
+      Compute the covariance matrix of the nearest neighbors of a point in
+      a single pass.  As with eigen::computeCovariance(), the matrix isn't
+      normalized by the number of points.
+
+      \param id  ID of the point.
+      \param k  Number of neighbors to use.  Must be no more than k().
+      \return  The covariance matrix of the XYZ dimensions.
+    */
+    Eigen::Matrix3d covariance(PointId id, point_count_t k) const;
+
+    /**
+      Run a function for each point of the graph using multiple threads.
+
+      \param threads  Number of threads to use.
+      \param f  Function to run, passed the ID of a point.
+    */
+    void forEach(size_t threads, const std::function<void(PointId)>& f) const;
+
+private:
+    KnnGraph(PointView& view, point_count_t k);
+
+    void compute(PointView& view, size_t threads);
+
+    point_count_t m_size;
+    point_count_t m_k;
+    std::vector<double> m_xyz;
+    std::vector<uint32_t> m_ids;
+};
+
+} // namespace pdal
@@ -66,6 +66,11 @@ public:
     void setProgressFd(int fd)
         { m_progressFd = fd; }
 
+    // Set the number of points in each block of the point table.  Views
+    // that fit in a block are contiguous in memory.
+    void setBlockSize(point_count_t blockPoints)
+        { m_tablePtr->setBlockSize(blockPoints); }
+
     void readPipeline(std::istream& input);
     void readPipeline(const std::string& filename);
 
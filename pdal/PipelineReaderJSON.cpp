@@ -150,6 +150,14 @@ void PipelineReaderJSON::readPipeline(std::istream& input)
     Json::Value& subtree = root["pipeline"];
     if (!subtree)
         throw pdal_error("JSON pipeline: Root element is not a Pipeline");
+    if (root.isMember("block_size"))
+    {
+        Json::Value& val = root["block_size"];
+        if (!val.isUInt64() || val.asUInt64() == 0)
+            throw pdal_error("JSON pipeline: 'block_size' must be a "
+                "positive integer.");
+        m_manager.setBlockSize(val.asUInt64());
+    }
     parsePipeline(subtree);
 }
 
@@ -80,6 +80,25 @@ void SimplePointTable::getFieldInternal(Dimension::Id id, PointId idx,
 }
 
 
+PointTable::PointTable(point_count_t blockPoints) :
+    SimplePointTable(m_layout), m_numPts(0), m_blockShift(0)
+{
+    setBlockSize(blockPoints);
+}
+
+
+void PointTable::setBlockSize(point_count_t blockPoints)
+{
+    if (m_numPts)
+        throw pdal_error("Can't change the block size of a point table "
+            "that holds points.");
+    m_blockShift = 0;
+    while (m_blockShift < 62 &&
+        (point_count_t(1) << m_blockShift) < blockPoints)
+        m_blockShift++;
+}
+
+
 PointTable::~PointTable()
 {
     for (auto vi = m_blocks.begin(); vi != m_blocks.end(); ++vi)
@@ -88,9 +107,10 @@ PointTable::~PointTable()
 
 PointId PointTable::addPoint()
 {
-    if (m_numPts % m_blockPtCnt == 0)
+    const point_count_t blockPtCnt = point_count_t(1) << m_blockShift;
+    if ((m_numPts & (blockPtCnt - 1)) == 0)
     {
-        size_t size = pointsToBytes(m_blockPtCnt);
+        size_t size = pointsToBytes(blockPtCnt);
         char *buf = new char[size];
         memset(buf, 0, size);
         m_blocks.push_back(buf);
@@ -101,8 +121,8 @@ PointId PointTable::addPoint()
 
 char *PointTable::getPoint(PointId idx)
 {
-    char *buf = m_blocks[idx / m_blockPtCnt];
-    return buf + pointsToBytes(idx % m_blockPtCnt);
+    char *buf = m_blocks[idx >> m_blockShift];
+    return buf + pointsToBytes(idx & ((point_count_t(1) << m_blockShift) - 1));
 }
 
 
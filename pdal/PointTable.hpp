@@ -141,16 +141,28 @@ private:
 // to be used to process multiple point sets simultaneously.
 class PDAL_DLL PointTable : public SimplePointTable
 {
+    FRIEND_TEST(PointTable, blockSize);
+    FRIEND_TEST(PipelineManagerTest, blockSize);
+
 private:
     // Point storage.
     std::vector<char *> m_blocks;
     point_count_t m_numPts;
-    static const point_count_t m_blockPtCnt = 65536;
+    // The number of points in each memory block is 1 << m_blockShift.
+    int m_blockShift;
 
 public:
-    PointTable() : SimplePointTable(m_layout), m_numPts(0)
+    /// Store points in blocks of 65536 points.
+    PointTable() : SimplePointTable(m_layout), m_numPts(0), m_blockShift(16)
         {}
+    /// Store points in blocks of at least \a blockPoints points, rounded up
+    /// to a power of two.  The points in a block are contiguous in memory.
+    /// Each block is allocated in full when its first point is added.
+    explicit PointTable(point_count_t blockPoints);
     virtual ~PointTable();
+    /// Change the number of points in each block, as for the constructor.
+    /// Throws if points have already been added.
+    void setBlockSize(point_count_t blockPoints);
     virtual bool supportsView() const
         { return true; }
 
@@ -91,6 +91,18 @@ void PointView::setFieldInternal(Dimension::Id dim, PointId idx,
 }
 
 
+void PointView::reorder(const std::vector<PointId>& order)
+{
+    assert(order.size() == size());
+
+    std::deque<PointId> index(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        index[i] = m_index[order[i]];
+    clearTemps();
+    m_index.swap(index);
+}
+
+
 void PointView::calculateBounds(BOX2D& output) const
 {
     for (PointId idx = 0; idx < size(); idx++)
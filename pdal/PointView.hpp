@@ -62,6 +62,7 @@ namespace plang
 struct PointViewLess;
 class PointView;
 class PointViewIter;
+class KnnGraph;
 
 typedef std::shared_ptr<PointView> PointViewPtr;
 typedef std::set<PointViewPtr, PointViewLess> PointViewSet;
@@ -69,6 +70,7 @@ typedef std::set<PointViewPtr, PointViewLess> PointViewSet;
 class PDAL_DLL PointView : public PointContainer
 {
     friend class plang::Invocation;
+    friend class KnnGraph;
     friend class PointIdxRef;
     friend struct PointViewLess;
 public:
@@ -91,6 +93,14 @@ public:
         { return m_size == 0; }
 
     inline void appendPoint(const PointView& buffer, PointId id);
+    /// Add a point to the end of the view by its index in the point table.
+    /// This allows views of the points in a block of a StreamPointTable.
+    void appendTablePoint(PointId tableId)
+    {
+        m_index.push_back(tableId);
+        m_size++;
+        assert(m_temps.empty());
+    }
     void append(const PointView& buf)
     {
         // We use size() instead of the index end because temp points
@@ -243,6 +253,12 @@ public:
     }
 
 
+    /// Reorder the points in the view.
+    /// \param order  Permutation of the point IDs in the view.  After the
+    ///    call, the point at position \c i is the point that was at
+    ///    position \c order[i].
+    void reorder(const std::vector<PointId>& order);
+
     /// Provides access to the memory storing the point data.  Though this
     /// function is public, other access methods are safer and preferred.
     char *getPoint(PointId id)
@@ -281,6 +297,8 @@ protected:
     int m_id;
     std::queue<PointId> m_temps;
     SpatialReference m_spatialReference;
+    // Cached neighbors of the points.  See KnnGraph.
+    std::shared_ptr<const KnnGraph> m_knnGraph;
 
 private:
     static int m_lastId;
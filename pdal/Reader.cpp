@@ -45,4 +45,46 @@ void Reader::readerAddArgs(ProgramArgs& args)
         std::numeric_limits<point_count_t>::max());
 }
 
+
+namespace
+{
+
+// Dimension names are matched without regard to case, and alternate
+// names of standard dimensions match the standard name.
+std::string dimKey(const std::string& name)
+{
+    Dimension::Id id = Dimension::id(name);
+    return Utils::toupper(id == Dimension::Id::Unknown ?
+        name : Dimension::name(id));
+}
+
+} // unnamed namespace
+
+
+void Reader::readerClearUsedDimensions()
+{
+    m_allDimsUsed = false;
+    m_usedDims.clear();
+}
+
+
+void Reader::readerAddUsedDimensions(const StringList *dims)
+{
+    if (!dims)
+        m_allDimsUsed = true;
+    else
+        for (const std::string& name : *dims)
+            m_usedDims.insert(dimKey(name));
+}
+
+
+// X, Y and Z are always considered used so that points have a position.
+bool Reader::dimensionUsed(const std::string& name) const
+{
+    if (m_allDimsUsed)
+        return true;
+    std::string key = dimKey(name);
+    return key == "X" || key == "Y" || key == "Z" || m_usedDims.count(key);
+}
+
 } // namespace pdal
@@ -38,6 +38,7 @@
 #include <pdal/Options.hpp>
 
 #include <functional>
+#include <set>
 
 namespace pdal
 {
@@ -49,7 +50,7 @@ class PDAL_DLL Reader : public Stage
 public:
     typedef std::function<void(PointView&, PointId)> PointReadFunc;
 
-    Reader()
+    Reader() : m_allDimsUsed(true)
     {}
 
     void setReadCb(PointReadFunc cb)
@@ -62,7 +63,23 @@ protected:
     Arg *m_filenameArg;
     Arg *m_countArg;
 
+    /**
+      Determine whether a dimension may be used by the stages that follow
+      the reader in the pipeline.  Readers may skip registering and loading
+      dimensions that aren't used.  X, Y and Z are always reported as used.
+      Valid once options have been processed.
+
+      \param name  Name of the dimension.
+      \return  Whether the dimension may be used.
+    */
+    bool dimensionUsed(const std::string& name) const;
+
 private:
+    bool m_allDimsUsed;
+    std::set<std::string> m_usedDims;
+
+    virtual void readerClearUsedDimensions();
+    virtual void readerAddUsedDimensions(const StringList *dims);
     virtual PointViewSet run(PointViewPtr view)
     {
         PointViewSet viewSet;
@@ -38,9 +38,13 @@
 #include <pdal/PointView.hpp>
 #include <pdal/Segmentation.hpp>
 #include <pdal/pdal_types.hpp>
+#include <pdal/util/ThreadPool.hpp>
 
 #include "../filters/private/DimRange.hpp"
 
+#include <atomic>
+#include <functional>
+#include <limits>
 #include <vector>
 
 namespace pdal
@@ -49,68 +53,175 @@ namespace pdal
 namespace Segmentation
 {
 
+namespace
+{
+
+// Union-find over PointIds that can be updated from multiple threads.
+// Roots are always linked to the lower of the two roots, so the root of
+// each set is its lowest PointId and parent links never form a cycle.
+class ConcurrentUnionFind
+{
+public:
+    ConcurrentUnionFind(point_count_t size) : m_parents(size)
+    {
+        for (PointId i = 0; i < size; ++i)
+            m_parents[i].store(i, std::memory_order_relaxed);
+    }
+
+    PointId find(PointId i)
+    {
+        while (true)
+        {
+            PointId p = m_parents[i].load(std::memory_order_relaxed);
+            if (p == i)
+                return i;
+            // Path halving.  A failed exchange just means another thread
+            // has already shortened the path.
+            PointId gp = m_parents[p].load(std::memory_order_relaxed);
+            m_parents[i].compare_exchange_weak(p, gp,
+                std::memory_order_relaxed);
+            i = gp;
+        }
+    }
+
+    void unite(PointId a, PointId b)
+    {
+        while (true)
+        {
+            a = find(a);
+            b = find(b);
+            if (a == b)
+                return;
+            if (a < b)
+                std::swap(a, b);
+            // Link the higher root to the lower one, provided it's still
+            // a root.
+            PointId expected = a;
+            if (m_parents[a].compare_exchange_strong(expected, b))
+                return;
+        }
+    }
+
+private:
+    std::vector<std::atomic<PointId>> m_parents;
+};
+
+
+// Fewest points worth searching on a separate thread.
+const point_count_t MinRangeSize = 1024;
+
+
+// Gather the sets of the union-find into clusters.  Points for which
+// include() is false are not added to any cluster.
+std::vector<std::vector<PointId>> gatherClusters(ConcurrentUnionFind& uf,
+    point_count_t count, uint64_t min_points, uint64_t max_points,
+    const std::function<bool(PointId)>& include)
+{
+    // Since a root is the lowest PointId of its set, visiting points in
+    // order finds each root before any other member of its set.
+    std::vector<std::vector<PointId>> sets;
+    std::vector<PointId> setIndex(count);
+    for (PointId i = 0; i < count; ++i)
+    {
+        if (!include(i))
+            continue;
+        PointId root = uf.find(i);
+        if (root == i)
+        {
+            setIndex[i] = sets.size();
+            sets.push_back(std::vector<PointId>());
+        }
+        sets[setIndex[root]].push_back(i);
+    }
+
+    // Keep clusters that are within the min/max number of points.
+    std::vector<std::vector<PointId>> clusters;
+    for (auto& s : sets)
+        if (s.size() >= min_points && s.size() <= max_points)
+            clusters.push_back(std::move(s));
+    return clusters;
+}
+
+} // unnamed namespace
+
 std::vector<std::vector<PointId>> extractClusters(PointView& view,
                                                   uint64_t min_points,
                                                   uint64_t max_points,
-                                                  double tolerance)
+                                                  double tolerance,
+                                                  size_t threads)
 {
     // Index the incoming PointView for subsequent radius searches.
     KD3Index kdi(view);
     kdi.build();
 
-    // Create variables to track PointIds that have already been added to
-    // clusters and to build the list of cluster indices.
-    std::vector<PointId> processed(view.size(), 0);
-    std::vector<std::vector<PointId>> clusters;
-
-    for (PointId i = 0; i < view.size(); ++i)
+    // Join each point with its neighbors.  Each pair is seen twice, so
+    // only join with neighbors that have a higher PointId.
+    ConcurrentUnionFind uf(view.size());
+    ThreadPool::parallelFor(threads, view.size(), MinRangeSize,
+        [&](PointId begin, PointId end)
     {
-        // Points can only belong to a single cluster.
-        if (processed[i])
-            continue;
+        for (PointId i = begin; i < end; ++i)
+            for (PointId j : kdi.radius(i, tolerance))
+                if (j > i)
+                    uf.unite(i, j);
+    });
 
-        // Initialize list of indices belonging to current cluster, marking the
-        // seed point as processed.
-        std::vector<PointId> seed_queue;
-        size_t sq_idx = 0;
-        seed_queue.push_back(i);
-        processed[i] = 1;
-
-        // Check each point in the cluster for additional neighbors within the
-        // given tolerance, remembering that the list can grow if we add points
-        // to the cluster.
-        while (sq_idx < seed_queue.size())
-        {
-            // Find neighbors of the next cluster point.
-            PointId j = seed_queue[sq_idx];
-            std::vector<PointId> ids = kdi.radius(j, tolerance);
+    return gatherClusters(uf, view.size(), min_points, max_points,
+        [](PointId){ return true; });
+}
 
-            // The case where the only neighbor is the query point.
-            if (ids.size() == 1)
-            {
-                sq_idx++;
-                continue;
-            }
+std::vector<std::vector<PointId>> extractDbscanClusters(PointView& view,
+    uint64_t core_points, uint64_t min_points, uint64_t max_points,
+    double tolerance, size_t threads)
+{
+    KD3Index kdi(view);
+    kdi.build();
+
+    // Find the core points.
+    std::vector<char> core(view.size());
+    ThreadPool::parallelFor(threads, view.size(), MinRangeSize,
+        [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+            core[i] = (kdi.radius(i, tolerance).size() >= core_points);
+    });
 
-            // Skip neighbors that already belong to a cluster and add the rest
-            // to this cluster.
-            for (auto const& k : ids)
+    // Join core points with their core neighbors and attach each non-core
+    // point to its lowest-numbered core neighbor.  Non-core points with no
+    // core neighbor are noise.
+    const PointId Noise = (std::numeric_limits<PointId>::max)();
+    ConcurrentUnionFind uf(view.size());
+    std::vector<PointId> border(view.size(), Noise);
+    ThreadPool::parallelFor(threads, view.size(), MinRangeSize,
+        [&](PointId begin, PointId end)
+    {
+        for (PointId i = begin; i < end; ++i)
+        {
+            std::vector<PointId> ids = kdi.radius(i, tolerance);
+            for (PointId j : ids)
             {
-                if (processed[k])
+                if (!core[j])
                     continue;
-                seed_queue.push_back(k);
-                processed[k] = 1;
+                if (core[i])
+                {
+                    if (j > i)
+                        uf.unite(i, j);
+                }
+                else
+                    border[i] = (std::min)(border[i], j);
             }
-
-            sq_idx++;
         }
+    });
 
-        // Keep clusters that are within the min/max number of points.
-        if (seed_queue.size() >= min_points && seed_queue.size() <= max_points)
-            clusters.push_back(seed_queue);
-    }
+    // Border points are joined after all core points so that a border
+    // point never connects two clusters.
+    for (PointId i = 0; i < view.size(); ++i)
+        if (border[i] != Noise)
+            uf.unite(i, border[i]);
 
-    return clusters;
+    return gatherClusters(uf, view.size(), min_points, max_points,
+        [&core, &border, Noise](PointId i)
+            { return core[i] || border[i] != Noise; });
 }
 
 void ignoreDimRange(DimRange dr, PointViewPtr input, PointViewPtr keep,
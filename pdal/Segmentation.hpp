@@ -52,21 +52,46 @@ namespace Segmentation
 /**
   Extract clusters of points from input PointView.
 
-  For each point, find neighbors within a given tolerance (Euclidean distance).
-  If a neighbor already belongs to another cluster, skip it. Otherwise, add it
-  to the current cluster. Recursively visit newly added cluster points, looking
-  for neighbors to add to the cluster.
+  Points are in the same cluster if they are connected by a chain of points,
+  each within a given tolerance (Euclidean distance) of the next.  Neighbors
+  of each point are found in parallel and joined with a concurrent
+  union-find.  Clusters are ordered by their lowest PointId and the PointIds
+  of each cluster are in ascending order.
 
   \param[in] view the input PointView.
   \param[in] min_points the minimum number of points in a cluster.
   \param[in] max_points the maximum number of points in a cluster.
   \param[in] tolerance the tolerance for adding points to a cluster.
+  \param[in] threads the number of threads to use.
   \returns a vector of clusters (themselves vectors of PointIds).
 */
 PDAL_DLL std::vector<std::vector<PointId>> extractClusters(PointView& view,
                                                            uint64_t min_points,
                                                            uint64_t max_points,
-                                                           double tolerance);
+                                                           double tolerance,
+                                                           size_t threads = 1);
+
+/**
+  Extract clusters of points from input PointView using DBSCAN.
+
+  A core point has at least core_points points (including itself) within
+  the tolerance.  Core points within the tolerance of one another are in the
+  same cluster.  A non-core point within the tolerance of a core point
+  belongs to the cluster of its lowest-numbered core neighbor.  Other points
+  are noise and belong to no cluster.  Clusters are ordered and filtered
+  as in extractClusters().
+
+  \param[in] view the input PointView.
+  \param[in] core_points the minimum number of neighbors of a core point.
+  \param[in] min_points the minimum number of points in a cluster.
+  \param[in] max_points the maximum number of points in a cluster.
+  \param[in] tolerance the neighborhood radius.
+  \param[in] threads the number of threads to use.
+  \returns a vector of clusters (themselves vectors of PointIds).
+*/
+PDAL_DLL std::vector<std::vector<PointId>> extractDbscanClusters(
+    PointView& view, uint64_t core_points, uint64_t min_points,
+    uint64_t max_points, double tolerance, size_t threads = 1);
 
 PDAL_DLL void ignoreDimRange(DimRange dr, PointViewPtr input, PointViewPtr keep,
                              PointViewPtr ignore);
@@ -34,8 +34,10 @@
 
 #include <pdal/GDALUtils.hpp>
 #include <pdal/GEOSUtils.hpp>
+#include <pdal/KnnGraph.hpp>
 #include <pdal/PipelineManager.hpp>
 #include <pdal/Stage.hpp>
+#include <pdal/Writer.hpp>
 #include <pdal/SpatialReference.hpp>
 #include <pdal/PDALUtils.hpp>
 #include <pdal/util/Algorithm.hpp>
@@ -43,6 +45,7 @@
 
 #include "private/StageRunner.hpp"
 
+#include <functional>
 #include <iterator>
 #include <memory>
 
@@ -123,13 +126,61 @@ QuickInfo Stage::preview()
 
 void Stage::prepare(PointTableRef table)
 {
-    m_args.reset(new ProgramArgs);
+    prepareOptions();
+
+    // A writer uses only the dimensions it writes.  Any other stage at the
+    // end of a pipeline hands all of its dimensions to the caller.
+    StringList none;
+    pushUsedDimensions(dynamic_cast<Writer *>(this) ? &none : nullptr);
+
+    prepareStage(table);
+}
+
+
+// Process the options of this stage and its inputs.
+void Stage::prepareOptions()
+{
     for (size_t i = 0; i < m_inputs.size(); ++i)
     {
         Stage *prev = m_inputs[i];
-        prev->prepare(table);
+        prev->prepareOptions();
     }
+    m_args.reset(new ProgramArgs);
     handleOptions();
+    readerClearUsedDimensions();
+}
+
+
+// Pass the dimensions used by the stages that follow this one back to the
+// readers.  A null list means that any dimension may be used.  A reader
+// that feeds more than one stage gets the dimensions used along each path.
+void Stage::pushUsedDimensions(const StringList *dims)
+{
+    if (m_inputs.empty())
+    {
+        readerAddUsedDimensions(dims);
+        return;
+    }
+
+    StringList used;
+    bool all = !dims || !usedDimensions(used);
+    if (!all)
+        used.insert(used.end(), dims->begin(), dims->end());
+    for (size_t i = 0; i < m_inputs.size(); ++i)
+    {
+        Stage *prev = m_inputs[i];
+        prev->pushUsedDimensions(all ? nullptr : &used);
+    }
+}
+
+
+void Stage::prepareStage(PointTableRef table)
+{
+    for (size_t i = 0; i < m_inputs.size(); ++i)
+    {
+        Stage *prev = m_inputs[i];
+        prev->prepareStage(table);
+    }
     pushLogLeader();
     l_initialize(table);
     initialize(table);
@@ -161,6 +212,12 @@ PointViewSet Stage::execute(PointTableRef table)
         }
     }
 
+    // Neighbor graphs cached by earlier stages are of no further use
+    // unless this stage reads them.
+    if (!usesKnnGraph())
+        for (auto const& v : views)
+            KnnGraph::release(*v);
+
     PointViewSet outViews;
     std::vector<StageRunnerPtr> runners;
 
@@ -261,12 +318,28 @@ void Stage::execute(StreamPointTable& table)
 
     table.finalize();
 
+    // A blocking stage must see the points from every path through it
+    // before it emits any, so count the paths from readers to each
+    // blocking stage.
+    std::map<Stage *, point_count_t> pendingPaths;
+    std::function<point_count_t(Stage *)> countPaths = [&](Stage *s)
+    {
+        point_count_t count = s->m_inputs.empty() ? 1 : 0;
+        for (auto s2 : s->m_inputs)
+            count += countPaths(s2);
+        if (s->blocking())
+            pendingPaths[s] = count;
+        return count;
+    };
+    countPaths(this);
+
     // Walk from the current stage backwards.  As we add each input, copy
     // the list of stages and push it on a list.  We then pull a list from the
-    // back of list and keep going.  Pushing on the front and pulling from the
-    // back insures that the stages will be executed in the order that they
-    // were added.  If we hit stage with no previous stages, we execute
-    // the stage list.
+    // front of list and keep going.  Pushing the inputs on the front in
+    // reverse order and pulling from the front insures that the stages will
+    // be executed in the order that they were added, and that all the paths
+    // through a stage are run one after another.  If we hit stage with no
+    // previous stages, we execute the stage list.
     // All this often amounts to a bunch of list copying for
     // no reason, but it's more simple than what we might otherwise do and
     // this should be a nit in the grand scheme of execution time.
@@ -285,15 +358,16 @@ void Stage::execute(StreamPointTable& table)
             (lastRunStages - stages).done(table);
             // Call ready on all the stages we didn't run last time.
             (stages - lastRunStages).ready(table);
-            execute(table, stages);
+            execute(table, stages, pendingPaths);
             lastRunStages = stages;
         }
         else
         {
-            for (auto s2 : s->m_inputs)
+            for (auto si = s->m_inputs.rbegin(); si != s->m_inputs.rend();
+                ++si)
             {
                 StageList newStages(stages);
-                newStages.push_front(s2);
+                newStages.push_front(*si);
                 lists.push_front(newStages);
             }
         }
@@ -302,79 +376,64 @@ void Stage::execute(StreamPointTable& table)
             lastRunStages.done(table);
             break;
         }
-        stages = lists.back();
-        lists.pop_back();
+        stages = lists.front();
+        lists.pop_front();
         s = stages.front();
     }
 }
 
 
-void Stage::execute(StreamPointTable& table, std::list<Stage *>& stages)
+void Stage::processBlock(StreamPointTable& table, std::vector<bool>& skips,
+    point_count_t count)
+{
+    PointRef point(table, 0);
+    for (PointId idx = 0; idx < count; idx++)
+    {
+        if (skips[idx])
+            continue;
+        point.setPointId(idx);
+        if (!processOne(point))
+            skips[idx] = true;
+    }
+}
+
+
+void Stage::execute(StreamPointTable& table, std::list<Stage *>& stages,
+    std::map<Stage *, point_count_t>& pendingPaths)
 {
     std::vector<bool> skips(table.capacity());
-    std::list<Stage *> filters;
     SpatialReference srs;
     std::map<Stage *, SpatialReference> srsMap;
 
     // Separate out the first stage.
     Stage *reader = stages.front();
 
-    // Build a list of all stages except the first.  We may have a writer in
-    // this list in addition to filters, but we treat them in the same way.
-    auto begin = stages.begin();
-    begin++;
-    std::copy(begin, stages.end(), std::back_inserter(filters));
-
-    // Loop until we're finished.  We handle the number of points up to
-    // the capacity of the StreamPointTable that we've been provided.
-
-    bool finished = false;
-    while (!finished)
+    // The stages are run in segments.  Each segment ends at a blocking
+    // stage or at the end of the list.  When a segment ending in a
+    // blocking stage has been run to completion, the blocking stage
+    // becomes the source of points for the next segment.  If other paths
+    // into the blocking stage have yet to be run, the rest of the list is
+    // left to the last of them.
+    Stage *source = reader;
+    SpatialReference sourceSrs;
+
+    // When we get a false back from a filter, we're filtering out a
+    // point, so add it to the list of skips so that it doesn't get
+    // processed by subsequent filters.
+    using StageIter = std::list<Stage *>::iterator;
+    auto processFilters = [&](StageIter fi, StageIter fend,
+        point_count_t count)
     {
-        // Clear the spatial reference when processing starts.
-        table.clearSpatialReferences();
-        PointId idx = 0;
-        PointRef point(table, idx);
-        point_count_t pointLimit = table.capacity();
-
-        reader->pushLogLeader();
-        // When we get false back from a reader, we're done, so set
-        // the point limit to the number of points processed in this loop
-        // of the table.
-        if (!pointLimit)
-            finished = true;
-
-        for (PointId idx = 0; idx < pointLimit; idx++)
-        {
-            point.setPointId(idx);
-            finished = !reader->processOne(point);
-            if (finished)
-                pointLimit = idx;
-        }
-        reader->popLogLeader();
-        srs = reader->getSpatialReference();
-        if (!srs.empty())
-            table.setSpatialReference(srs);
-
-        // When we get a false back from a filter, we're filtering out a
-        // point, so add it to the list of skips so that it doesn't get
-        // processed by subsequent filters.
-        for (Stage *s : filters)
+        for (; fi != fend; ++fi)
         {
+            Stage *s = *fi;
             if (srsMap[s] != srs)
             {
                 s->spatialReferenceChanged(srs);
                 srsMap[s] = srs;
             }
             s->pushLogLeader();
-            for (PointId idx = 0; idx < pointLimit; idx++)
-            {
-                if (skips[idx])
-                    continue;
-                point.setPointId(idx);
-                if (!s->processOne(point))
-                    skips[idx] = true;
-            }
+            s->processBlock(table, skips, count);
             srs = s->getSpatialReference();
             if (!srs.empty())
                 table.setSpatialReference(srs);
@@ -385,6 +444,107 @@ void Stage::execute(StreamPointTable& table, std::list<Stage *>& stages)
         for (size_t i = 0; i < skips.size(); ++i)
             skips[i] = false;
         table.reset();
+    };
+
+    auto begin = stages.begin();
+    begin++;
+    while (true)
+    {
+        // Build a list of the stages in this segment.  We may have a writer
+        // in this list in addition to filters, but we treat them in the
+        // same way.
+        std::list<Stage *> filters;
+        auto end = begin;
+        while (end != stages.end())
+        {
+            Stage *s = *end++;
+            filters.push_back(s);
+            if (s->blocking())
+                break;
+        }
+        Stage *blocker = nullptr;
+        if (filters.size() && filters.back()->blocking())
+            blocker = filters.back();
+
+        // Loop until we're finished.  We handle the number of points up to
+        // the capacity of the StreamPointTable that we've been provided.
+        bool finished = false;
+        while (!finished)
+        {
+            // Clear the spatial reference when processing starts.
+            table.clearSpatialReferences();
+            PointId idx = 0;
+            PointRef point(table, idx);
+            point_count_t pointLimit = table.capacity();
+
+            source->pushLogLeader();
+            // When we get false back from a reader, we're done, so set
+            // the point limit to the number of points processed in this loop
+            // of the table.
+            if (!pointLimit)
+                finished = true;
+
+            for (PointId idx = 0; idx < pointLimit; idx++)
+            {
+                point.setPointId(idx);
+                if (source == reader)
+                    finished = !source->processOne(point);
+                else
+                    finished = !source->emitOne(point);
+                if (finished)
+                    pointLimit = idx;
+            }
+            source->popLogLeader();
+            srs = source->getSpatialReference();
+            if (srs.empty())
+                srs = sourceSrs;
+            if (!srs.empty())
+                table.setSpatialReference(srs);
+
+            processFilters(filters.begin(), filters.end(), pointLimit);
+        }
+
+        // Non-blocking stages may have held points back.  Once the
+        // source is exhausted, release them, in stage order, to the
+        // stages that follow in the segment.
+        for (auto fi = filters.begin(); fi != filters.end(); ++fi)
+        {
+            Stage *s = *fi;
+            if (s == blocker)
+                break;
+            finished = false;
+            while (!finished)
+            {
+                table.clearSpatialReferences();
+                PointRef point(table, 0);
+                point_count_t pointLimit = table.capacity();
+
+                s->pushLogLeader();
+                for (PointId idx = 0; idx < pointLimit; idx++)
+                {
+                    point.setPointId(idx);
+                    finished = !s->emitOne(point);
+                    if (finished)
+                        pointLimit = idx;
+                }
+                s->popLogLeader();
+                if (!pointLimit)
+                    break;
+                srs = srsMap[s];
+                if (!srs.empty())
+                    table.setSpatialReference(srs);
+                processFilters(std::next(fi), filters.end(), pointLimit);
+            }
+        }
+
+        if (!blocker || --pendingPaths[blocker])
+            break;
+
+        // Points emitted by the blocking stage carry the spatial reference
+        // of the points it received.
+        sourceSrs = table.anySpatialReference();
+        source = blocker;
+        begin = end;
     }
 }
 
@@ -35,6 +35,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 
 #include <pdal/pdal_internal.hpp>
 
@@ -104,6 +105,10 @@ public:
       terminal stage of a pipeline (linked set of stages) before \ref execute
       can be called.  Prepare recurses through all input stages.
 
+      Before any stage is initialized, the dimensions used by the stages
+      of the pipeline are collected (see \ref usedDimensions) and passed
+      to the readers, which may skip dimensions that aren't used.
+
       \param table  PointTable being used for stage pipeline.
     */
     void prepare(PointTableRef table);
@@ -321,6 +326,14 @@ private:
 
     void setupLog();
     void handleOptions();
+    void prepareOptions();
+    void prepareStage(PointTableRef table);
+    void pushUsedDimensions(const StringList *dims);
+
+    virtual void readerClearUsedDimensions()
+        {}
+    virtual void readerAddUsedDimensions(const StringList * /*dims*/)
+        {}
 
     virtual void readerAddArgs(ProgramArgs& /*args*/)
         {}
@@ -374,6 +387,31 @@ private:
     virtual void initialize()
         {}
 
+    /**
+      Report the dimensions of the points passed to the stage that the
+      stage uses.  Called after options have been processed and before
+      \ref initialize.  Implement in subclass.  The default reports that
+      any dimension may be used, which keeps readers from skipping
+      dimensions.
+
+      \param dims  List to which the names of used dimensions should be
+        added.
+      \return  Whether \ref dims lists all the dimensions the stage uses.
+    */
+    virtual bool usedDimensions(StringList& /*dims*/) const
+        { return false; }
+
+    /**
+      Report whether the stage reads the neighbor graph cached on the
+      views passed to it (see KnnGraph).  Cached graphs are released before
+      views are passed to a stage that doesn't, so a graph is kept only
+      while consecutive stages share it.  Implement in subclass.
+
+      \return  Whether the stage uses cached neighbor graphs.
+    */
+    virtual bool usesKnnGraph() const
+        { return false; }
+
     /**
       Add dimensions to a layout.
 
@@ -415,6 +453,49 @@ private:
         throw pdal_error(oss.str());
     }
 
+    /**
+      (Streaming mode)  Process a block of points.  The default calls
+      \ref processOne for each point that hasn't been filtered-out.
+      Stages that process many points at once more efficiently than one
+      at a time may override this.
+
+      \param table  Table holding the block of points.
+      \param skips  Whether each point of the block has been filtered-out.
+        Set an entry to filter-out the point.
+      \param count  Number of points in the block.
+    */
+    virtual void processBlock(StreamPointTable& table,
+        std::vector<bool>& skips, point_count_t count);
+
+    /**
+      (Streaming mode)  Whether the stage must see all of its input before
+      it can produce any output (a sort, for example).  Points passed to
+      \ref processOne of a blocking stage are retained by the stage and
+      should be filtered-out.  Once all input has been processed, points are
+      pulled from the stage with \ref emitOne and passed to the subsequent
+      stages, as if the blocking stage were a reader.  When there are
+      several paths from readers to a blocking stage, points are pulled
+      only after the points from all of the paths have been processed.
+
+      \return  Whether the stage is blocking.
+    */
+    virtual bool blocking() const
+        { return false; }
+
+    /**
+      (Streaming mode)  Produce a single point from a blocking stage.
+      Implement in subclass if \ref blocking returns true.
+
+      A non-blocking stage that holds points back while processing
+      may also implement this to release the held points once its input
+      is exhausted.  Released points are passed to the subsequent stages.
+
+      \param point  Point to fill.
+      \return  False when no more points are to be emitted.
+    */
+    virtual bool emitOne(PointRef& /*point*/)
+        { return false; }
+
     /**
       (Streaming mode)  Notification that the points that will follow in
       processing are from a spatial reference different than the previous
@@ -444,7 +525,8 @@ private:
     virtual void done(PointTableRef /*table*/)
         {}
 
-    void execute(StreamPointTable& table, std::list<Stage *>& stages);
+    void execute(StreamPointTable& table, std::list<Stage *>& stages,
+        std::map<Stage *, point_count_t>& pendingPaths);
 
     /*
       Test hook.
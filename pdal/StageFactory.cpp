@@ -72,8 +72,10 @@
 #include <filters/SplitterFilter.hpp>
 #include <filters/StatsFilter.hpp>
 #include <filters/TransformationFilter.hpp>
+#include <filters/VoxelDownsizeFilter.hpp>
 
 // readers
+#include <io/ArrowReader.hpp>
 #include <io/BpfReader.hpp>
 #include <io/FauxReader.hpp>
 #include <io/GDALReader.hpp>
@@ -90,12 +92,14 @@
 #include <io/TIndexReader.hpp>
 
 // writers
+#include <io/ArrowWriter.hpp>
 #include <io/BpfWriter.hpp>
 #include <io/GDALWriter.hpp>
 #include <io/LasWriter.hpp>
 #include <io/PlyWriter.hpp>
 #include <io/SbetWriter.hpp>
 #include <io/TextWriter.hpp>
+#include <io/TileWriter.hpp>
 #include <io/NullWriter.hpp>
 
 #include <sstream>
@@ -109,6 +113,7 @@ StringList StageFactory::extensions(const std::string& driver)
 {
     static std::map<std::string, StringList> exts =
     {
+        { "readers.arrow", { "arrow", "feather" } },
         { "readers.terrasolid", { "bin" } },
         { "readers.bpf", { "bpf" }  },
         { "readers.optech", { "csd" } },
@@ -128,6 +133,7 @@ StringList StageFactory::extensions(const std::string& driver)
         { "readers.text", { "txt" } },
         { "readers.icebridge", { "h5" } },
 
+        { "writers.arrow", { "arrow", "feather" } },
         { "writers.bpf", { "bpf" } },
         { "writers.text", { "csv", "json", "txt", "xyz" } },
         { "writers.las", { "las", "laz" } },
@@ -148,9 +154,11 @@ std::string StageFactory::inferReaderDriver(const std::string& filename)
 {
     static std::map<std::string, std::string> drivers =
     {
+        { "arrow", "readers.arrow" },
         { "bin", "readers.terrasolid" },
         { "bpf", "readers.bpf" },
         { "csd", "readers.optech" },
+        { "feather", "readers.arrow" },
         { "greyhound", "readers.greyhound" },
         { "icebridge", "readers.icebridge" },
         { "las", "readers.las" },
@@ -199,6 +207,7 @@ std::string StageFactory::inferWriterDriver(const std::string& filename)
 
     static std::map<std::string, std::string> drivers =
     {
+        { "arrow", "writers.arrow" },
         { "bpf", "writers.bpf" },
         { "csv", "writers.text" },
         { "json", "writers.text" },
@@ -210,6 +219,7 @@ std::string StageFactory::inferWriterDriver(const std::string& filename)
         { "ply", "writers.ply" },
         { "sbet", "writers.sbet" },
         { "derivative", "writers.derivative" },
+        { "feather", "writers.arrow" },
         { "sqlite", "writers.sqlite" },
         { "txt", "writers.text" },
         { "xyz", "writers.text" },
@@ -272,8 +282,10 @@ StageFactory::StageFactory(bool no_plugins)
     PluginManager::initializePlugin(SplitterFilter_InitPlugin);
     PluginManager::initializePlugin(StatsFilter_InitPlugin);
     PluginManager::initializePlugin(TransformationFilter_InitPlugin);
+    PluginManager::initializePlugin(VoxelDownsizeFilter_InitPlugin);
 
     // readers
+    PluginManager::initializePlugin(ArrowReader_InitPlugin);
     PluginManager::initializePlugin(BpfReader_InitPlugin);
     PluginManager::initializePlugin(FauxReader_InitPlugin);
     PluginManager::initializePlugin(GDALReader_InitPlugin);
@@ -289,12 +301,14 @@ StageFactory::StageFactory(bool no_plugins)
     PluginManager::initializePlugin(TIndexReader_InitPlugin);
 
     // writers
+    PluginManager::initializePlugin(ArrowWriter_InitPlugin);
     PluginManager::initializePlugin(BpfWriter_InitPlugin);
     PluginManager::initializePlugin(GDALWriter_InitPlugin);
     PluginManager::initializePlugin(LasWriter_InitPlugin);
     PluginManager::initializePlugin(PlyWriter_InitPlugin);
     PluginManager::initializePlugin(SbetWriter_InitPlugin);
     PluginManager::initializePlugin(TextWriter_InitPlugin);
+    PluginManager::initializePlugin(TileWriter_InitPlugin);
     PluginManager::initializePlugin(NullWriter_InitPlugin);
 }
 
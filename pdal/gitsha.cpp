@@ -0,0 +1,3 @@
+#include <pdal/gitsha.h>
+#define GIT_SHA1 "439029bbdc32bb3374c6e1c6fa49a722c1ecc1ae"
+const char g_GIT_SHA1[] = GIT_SHA1;
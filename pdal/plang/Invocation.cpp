@@ -68,6 +68,66 @@ int argCount(PyObject *function)
     return (int) PyList_Size(arglist);
 }
 
+
+// Check that an output variable is a one dimensional numpy array whose
+// type is compatible with a PDAL dimension type.
+PyArrayObject *checkArray(PyObject *xarr, const std::string& name,
+    pdal::Dimension::Type t)
+{
+    using namespace pdal;
+
+    if (!xarr)
+        throw pdal::pdal_error("plang output variable '" + name + "' not found.");
+    if (!PyArray_Check(xarr))
+        throw pdal::pdal_error("Plang output variable  '" + name +
+            "' is not a numpy array");
+
+    PyArrayObject* arr = (PyArrayObject*)xarr;
+    if (PyArray_NDIM(arr) != 1)
+        throw pdal::pdal_error("Plang output variable '" + name +
+            "' is not a one dimensional array.");
+
+    PyArray_Descr *dtype = PyArray_DESCR(arr);
+
+    if (static_cast<uint32_t>(dtype->elsize) != Dimension::size(t))
+    {
+        std::ostringstream oss;
+        oss << "dtype of array has size " << dtype->elsize
+            << " but PDAL dimension '" << name << "' has byte size of "
+            << Dimension::size(t) << " bytes.";
+        throw pdal::pdal_error(oss.str());
+    }
+
+    using namespace Dimension;
+    BaseType b = Dimension::base(t);
+    if (dtype->kind == 'i' && b != BaseType::Signed)
+    {
+        std::ostringstream oss;
+        oss << "dtype of array has a signed integer type but the " <<
+            "dimension data type of '" << name <<
+            "' is not pdal::Signed.";
+        throw pdal::pdal_error(oss.str());
+    }
+
+    if (dtype->kind == 'u' && b != BaseType::Unsigned)
+    {
+        std::ostringstream oss;
+        oss << "dtype of array has a unsigned integer type but the " <<
+            "dimension data type of '" << name <<
+            "' is not pdal::Unsigned.";
+        throw pdal::pdal_error(oss.str());
+    }
+
+    if (dtype->kind == 'f' && b != BaseType::Floating)
+    {
+        std::ostringstream oss;
+        oss << "dtype of array has a float type but the " <<
+            "dimension data type of '" << name << "' is not pdal::Floating.";
+        throw pdal::pdal_error(oss.str());
+    }
+    return arr;
+}
+
 }
 
 namespace pdal
@@ -85,6 +145,7 @@ Invocation::Invocation(const Script& script)
     , m_varsOut(NULL)
     , m_scriptArgs(NULL)
     , m_scriptResult(NULL)
+    , m_pointData(NULL)
     , m_metadata_PyObject(NULL)
     , m_schema_PyObject(NULL)
     , m_srs_PyObject(NULL)
@@ -151,18 +212,22 @@ void Invocation::resetArguments()
 
 
 void Invocation::insertArgument(std::string const& name, uint8_t* data,
-    Dimension::Type t, point_count_t count)
+    Dimension::Type t, point_count_t count, size_t stride)
 {
     npy_intp mydims = count;
     int nd = 1;
     npy_intp* dims = &mydims;
-    npy_intp stride = Dimension::size(t);
-    npy_intp* strides = &stride;
-
-#ifdef NPY_ARRAY_CARRAY
-    int flags = NPY_ARRAY_CARRAY;
+    npy_intp mystride = stride ? stride : Dimension::size(t);
+    npy_intp* strides = &mystride;
+
+    // Input arrays are read-only, whether they're copies or refer to the
+    // point data, so that changes are made only through the outputs.
+    // Values that aren't packed are neither contiguous nor necessarily
+    // aligned.  Numpy handles both, given the correct flags.
+#ifdef NPY_ARRAY_CARRAY_RO
+    int flags = stride ? 0 : NPY_ARRAY_CARRAY_RO;
 #else
-    int flags = NPY_CARRAY;
+    int flags = stride ? 0 : NPY_CARRAY_RO;
 #endif
 
     const int pyDataType = plang::Environment::getPythonDataType(t);
@@ -177,56 +242,20 @@ void Invocation::insertArgument(std::string const& name, uint8_t* data,
 void *Invocation::extractResult(std::string const& name,
     Dimension::Type t)
 {
-    PyObject* xarr = PyDict_GetItemString(m_varsOut, name.c_str());
-    if (!xarr)
-        throw pdal::pdal_error("plang output variable '" + name + "' not found.");
-    if (!PyArray_Check(xarr))
-        throw pdal::pdal_error("Plang output variable  '" + name +
-            "' is not a numpy array");
-
-    PyArrayObject* arr = (PyArrayObject*)xarr;
+    PyArrayObject* arr =
+        checkArray(PyDict_GetItemString(m_varsOut, name.c_str()), name, t);
 
-    npy_intp one = 0;
-    const int pyDataType = pdal::plang::Environment::getPythonDataType(t);
-    PyArray_Descr *dtype = PyArray_DESCR(arr);
-
-    if (static_cast<uint32_t>(dtype->elsize) != Dimension::size(t))
-    {
-        std::ostringstream oss;
-        oss << "dtype of array has size " << dtype->elsize
-            << " but PDAL dimension '" << name << "' has byte size of "
-            << Dimension::size(t) << " bytes.";
-        throw pdal::pdal_error(oss.str());
-    }
-
-    using namespace Dimension;
-    BaseType b = Dimension::base(t);
-    if (dtype->kind == 'i' && b != BaseType::Signed)
-    {
-        std::ostringstream oss;
-        oss << "dtype of array has a signed integer type but the " <<
-            "dimension data type of '" << name <<
-            "' is not pdal::Signed.";
-        throw pdal::pdal_error(oss.str());
-    }
-
-    if (dtype->kind == 'u' && b != BaseType::Unsigned)
+    // Callers expect packed data, so make a packed copy of a strided array
+    // (one that refers to point data, for example).  The copy is released
+    // with the input arrays.
+    if (!PyArray_ISCARRAY_RO(arr))
     {
-        std::ostringstream oss;
-        oss << "dtype of array has a unsigned integer type but the " <<
-            "dimension data type of '" << name <<
-            "' is not pdal::Unsigned.";
-        throw pdal::pdal_error(oss.str());
+        arr = (PyArrayObject *)PyArray_GETCONTIGUOUS(arr);
+        if (!arr)
+            throw pdal::pdal_error(getTraceback());
+        m_pyInputArrays.push_back((PyObject *)arr);
     }
-
-    if (dtype->kind == 'f' && b != BaseType::Floating)
-    {
-        std::ostringstream oss;
-        oss << "dtype of array has a float type but the " <<
-            "dimension data type of '" << name << "' is not pdal::Floating.";
-        throw pdal::pdal_error(oss.str());
-    }
-    return PyArray_GetPtr(arr, &one);
+    return PyArray_DATA(arr);
 }
 
 
@@ -362,15 +391,44 @@ void Invocation::setKWargs(std::string const& s)
     m_pdalargs_PyObject = getPyJSON(s);
 }
 
+// If the points of a view are stored one after another in memory,
+// return the address of the first point.  Otherwise return NULL.
+char *Invocation::contiguousPoints(PointView& view)
+{
+    if (!view.size() ||
+        !dynamic_cast<SimplePointTable *>(&view.m_pointTable))
+        return NULL;
+
+    const size_t pointSize = view.layout()->pointSize();
+    char *base = view.getPoint(0);
+    for (PointId idx = 1; idx < view.size(); ++idx)
+        if (view.getPoint(idx) != base + idx * pointSize)
+            return NULL;
+    return base;
+}
+
+
 void Invocation::begin(PointView& view, MetadataNode m)
 {
     PointLayoutPtr layout(view.m_pointTable.layout());
     Dimension::IdList const& dims = layout->dims();
 
+    // When the points are contiguous, each dimension is passed as a
+    // strided array that refers to the point data directly.
+    m_pointData = contiguousPoints(view);
+    const size_t pointSize = layout->pointSize();
     for (auto di = dims.begin(); di != dims.end(); ++di)
     {
         Dimension::Id d = *di;
         const Dimension::Detail *dd = layout->dimDetail(d);
+        std::string name = layout->dimName(*di);
+        if (m_pointData)
+        {
+            insertArgument(name, (uint8_t *)(m_pointData + dd->offset()),
+                dd->type(), view.size(), pointSize);
+            continue;
+        }
+
         void *data = malloc(dd->size() * view.size());
         m_buffers.push_back(data);  // Hold pointer for deallocation
         char *p = (char *)data;
@@ -379,7 +437,6 @@ void Invocation::begin(PointView& view, MetadataNode m)
             view.getFieldInternal(d, idx, (void *)p);
             p += dd->size();
         }
-        std::string name = layout->dimName(*di);
         insertArgument(name, (uint8_t *)data, dd->type(), view.size());
     }
 
@@ -415,6 +472,16 @@ void Invocation::end(PointView& view, MetadataNode m)
 
     PointLayoutPtr layout(view.m_pointTable.layout());
     Dimension::IdList const& dims = layout->dims();
+    const npy_intp pointSize = layout->pointSize();
+
+    struct Output
+    {
+        const Dimension::Detail *m_detail;
+        char *m_data;
+        npy_intp m_stride;
+    };
+    std::vector<Output> outputs;
+    std::vector<std::vector<char>> copies;
 
     for (auto di = dims.begin(); di != dims.end(); ++di)
     {
@@ -427,18 +494,72 @@ void Invocation::end(PointView& view, MetadataNode m)
         assert(name == *found);
         assert(hasOutputVariable(name));
 
-        size_t size = dd->size();
-        void *data = extractResult(name, dd->type());
-        char *p = (char *)data;
-        for (PointId idx = 0; idx < view.size(); ++idx)
+        PyArrayObject *arr = checkArray(
+            PyDict_GetItemString(m_varsOut, name.c_str()), name, dd->type());
+        if (PyArray_SIZE(arr) < (npy_intp)view.size())
+        {
+            std::ostringstream oss;
+            oss << "Plang output variable '" << name << "' has " <<
+                PyArray_SIZE(arr) << " values but there are " <<
+                view.size() << " points.";
+            throw pdal::pdal_error(oss.str());
+        }
+
+        Output out { dd, (char *)PyArray_DATA(arr), PyArray_STRIDE(arr, 0) };
+        if (m_pointData && out.m_data >= m_pointData &&
+            out.m_data < m_pointData + view.size() * pointSize)
+        {
+            // An input array that refers to the point data needs no
+            // copying.
+            if (out.m_data == m_pointData + dd->offset() &&
+                    out.m_stride == pointSize)
+                continue;
+
+            // Any other array that refers to point data (outs['X'] =
+            // ins['Y'], for example) must be copied before the points are
+            // updated.
+            copies.push_back(std::vector<char>(dd->size() * view.size()));
+            char *dest = copies.back().data();
+            char *src = out.m_data;
+            for (PointId idx = 0; idx < view.size(); ++idx)
+            {
+                memcpy(dest, src, dd->size());
+                dest += dd->size();
+                src += out.m_stride;
+            }
+            out.m_data = copies.back().data();
+            out.m_stride = dd->size();
+        }
+        outputs.push_back(out);
+    }
+
+    for (Output& out : outputs)
+    {
+        const Dimension::Detail *dd = out.m_detail;
+        char *p = out.m_data;
+        if (m_pointData)
+        {
+            char *dest = m_pointData + dd->offset();
+            for (PointId idx = 0; idx < view.size(); ++idx)
+            {
+                memcpy(dest, p, dd->size());
+                dest += pointSize;
+                p += out.m_stride;
+            }
+        }
+        else
         {
-            view.setField(d, dd->type(), idx, (void *)p);
-            p += size;
+            for (PointId idx = 0; idx < view.size(); ++idx)
+            {
+                view.setField(dd->id(), dd->type(), idx, (void *)p);
+                p += out.m_stride;
+            }
         }
     }
     for (auto bi = m_buffers.begin(); bi != m_buffers.end(); ++bi)
         free(*bi);
     m_buffers.clear();
+    m_pointData = NULL;
     if (m_metadata_PyObject)
         addMetadata(m_metadata_PyObject, m);
 }
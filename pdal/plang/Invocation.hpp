@@ -60,11 +60,15 @@ public:
 
 
     // creates a Python variable pointing to a (one dimensional) C array
-    // adds the new variable to the arguments dictionary
+    // adds the new variable to the arguments dictionary.  If 'stride' is
+    // non-zero, it is the distance in bytes between successive values,
+    // otherwise values are packed.
     void insertArgument(std::string const& name,
                         uint8_t* data,
                         Dimension::Type t,
-                        point_count_t count);
+                        point_count_t count,
+                        size_t stride = 0);
+    // returns a pointer to the packed data of an output variable
     void *extractResult(const std::string& name,
                         Dimension::Type dataType);
 
@@ -89,6 +93,7 @@ public:
 
 private:
     void cleanup();
+    char *contiguousPoints(PointView& view);
 
     Script m_script;
 
@@ -106,6 +111,9 @@ private:
     Invocation& operator=(Invocation const& rhs); // nope
 
     std::vector<void *> m_buffers;
+    // Address of the first point of the view when its dimensions are
+    // passed to Python without copying, or NULL.
+    char *m_pointData;
     PyObject* m_metadata_PyObject;
     PyObject* m_schema_PyObject;
     PyObject* m_srs_PyObject;
@@ -35,9 +35,13 @@
 #include <sys/stat.h>
 
 #include <iostream>
+#include <limits>
 #include <sstream>
 #ifndef WIN32
+#include <fcntl.h>
 #include <glob.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #else
 #include <Windows.h>
 #endif
@@ -395,7 +399,78 @@ std::vector<std::string> glob(std::string path)
     return filenames;
 }
 
+
+MapContext mapFile(const std::string& filename)
+{
+    MapContext ctx;
+
+    uintmax_t size = fileExists(filename) ? fileSize(filename) : 0;
+    if (size == 0)
+    {
+        ctx.m_error = "Can't map missing or empty file '" + filename + "'.";
+        return ctx;
+    }
+    if (size > (std::numeric_limits<size_t>::max)())
+    {
+        ctx.m_error = "File '" + filename + "' is too large to map.";
+        return ctx;
+    }
+#ifdef WIN32
+    HANDLE file = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        ctx.m_error = "Unable to open file '" + filename + "'.";
+        return ctx;
+    }
+    // The view keeps the file and the mapping open once it's created.
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping)
+    {
+        ctx.m_addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        ctx.m_error = "Unable to open file '" + filename + "'.";
+        return ctx;
+    }
+    // The mapping keeps the file open once it's created.
+    void *addr = ::mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr != MAP_FAILED)
+    {
+        ::madvise(addr, (size_t)size, MADV_SEQUENTIAL);
+        ctx.m_addr = addr;
+    }
+#endif
+    if (ctx.m_addr)
+        ctx.m_size = (size_t)size;
+    else
+        ctx.m_error = "Unable to map file '" + filename + "'.";
+    return ctx;
+}
+
+
+MapContext unmapFile(MapContext ctx)
+{
+    if (!ctx.m_addr)
+        return ctx;
+#ifdef WIN32
+    if (!UnmapViewOfFile(ctx.m_addr))
+        ctx.m_error = "Unable to unmap file.";
+#else
+    if (::munmap(ctx.m_addr, ctx.m_size) == -1)
+        ctx.m_error = "Unable to unmap file.";
+#endif
+    ctx.m_addr = nullptr;
+    ctx.m_size = 0;
+    return ctx;
+}
+
 } // namespace FileUtils
 
 } // namespace pdal
-
@@ -49,6 +49,37 @@ namespace pdal
 
 namespace FileUtils
 {
+    /**
+      State of a file mapped into memory with mapFile().
+    */
+    struct MapContext
+    {
+        MapContext() : m_addr(nullptr), m_size(0)
+        {}
+
+        /**
+          Return the address of the mapped file, or null if the map failed.
+        */
+        void *addr() const
+            { return m_addr; }
+
+        /**
+          Return the size of the mapped file.
+        */
+        size_t size() const
+            { return m_size; }
+
+        /**
+          Return a description of the last error.
+        */
+        std::string what() const
+            { return m_error; }
+
+        void *m_addr;
+        size_t m_size;
+        std::string m_error;
+    };
+
     /**
       Open an existing file for reading.
 
@@ -249,6 +280,24 @@ namespace FileUtils
       \return  List of files that correspond to provided file specification.
     */
     PDAL_DLL std::vector<std::string> glob(std::string filespec);
+
+    /**
+      Map an entire file into memory for reading.  The system is told that
+      the file will be read sequentially.
+
+      \param filename  Name of file to map.
+      \return  Context of the mapping.  addr() is null and what() describes
+        the problem if the file couldn't be mapped.
+    */
+    PDAL_DLL MapContext mapFile(const std::string& filename);
+
+    /**
+      Unmap a file mapped with mapFile().
+
+      \param ctx  Context returned by mapFile().
+      \return  Context of the (closed) mapping.  what() describes any error.
+    */
+    PDAL_DLL MapContext unmapFile(MapContext ctx);
 }
 
 } // namespace pdal
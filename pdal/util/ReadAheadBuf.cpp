@@ -0,0 +1,166 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/util/ReadAheadBuf.hpp>
+
+#include <algorithm>
+
+namespace pdal
+{
+
+namespace
+{
+
+// Size of the synchronous read that follows opening or seeking.
+const std::streamsize ProbeSize = 64 * 1024;
+
+}
+
+ReadAheadBuf::ReadAheadBuf(const std::string& filename, size_t bufSize) :
+    m_buf((std::max)(bufSize, (size_t)1)), m_next(m_buf.size()), m_pos(0),
+    m_size(0), m_sequential(false)
+{
+    // Reads go straight into our buffers.
+    m_file.pubsetbuf(nullptr, 0);
+    if (!m_file.open(filename, std::ios_base::in | std::ios_base::binary))
+        return;
+    m_size = m_file.pubseekoff(0, std::ios_base::end, std::ios_base::in);
+    m_file.pubseekpos(0, std::ios_base::in);
+    setg(m_buf.data(), m_buf.data(), m_buf.data());
+}
+
+
+ReadAheadBuf::~ReadAheadBuf()
+{
+    cancel();
+}
+
+
+// Wait for and discard any read in progress.
+void ReadAheadBuf::cancel()
+{
+    if (m_pending.valid())
+        m_pending.get();
+}
+
+
+ReadAheadBuf::int_type ReadAheadBuf::underflow()
+{
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if (!isOpen())
+        return traits_type::eof();
+
+    m_pos += egptr() - eback();
+
+    std::streamsize count;
+    if (m_pending.valid())
+    {
+        count = m_pending.get();
+        m_buf.swap(m_next);
+    }
+    else
+    {
+        std::streamsize size = (std::streamsize)m_buf.size();
+        if (!m_sequential)
+            size = (std::min)(size, ProbeSize);
+        count = m_file.sgetn(m_buf.data(), size);
+    }
+
+    char *start = m_buf.data();
+    if (count <= 0)
+    {
+        setg(start, start, start);
+        return traits_type::eof();
+    }
+    setg(start, start, start + count);
+
+    // Fill the other buffer while this one is consumed.
+    if (m_sequential && m_pos + count < m_size)
+    {
+        char *next = m_next.data();
+        std::streamsize size = (std::streamsize)m_next.size();
+        m_pending = std::async(std::launch::async, [this, next, size]()
+            { return m_file.sgetn(next, size); });
+    }
+    m_sequential = true;
+    return traits_type::to_int_type(*gptr());
+}
+
+
+ReadAheadBuf::pos_type ReadAheadBuf::seekpos(pos_type pos,
+    std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in) || !isOpen())
+        return pos_type(off_type(-1));
+
+    std::streamoff off(pos);
+    if (off >= m_pos && off <= m_pos + (egptr() - eback()))
+    {
+        setg(eback(), eback() + (off - m_pos), egptr());
+        return pos;
+    }
+
+    cancel();
+    if (m_file.pubseekpos(pos, std::ios_base::in) == pos_type(off_type(-1)))
+        return pos_type(off_type(-1));
+    m_pos = off;
+    m_sequential = false;
+    setg(m_buf.data(), m_buf.data(), m_buf.data());
+    return pos;
+}
+
+
+ReadAheadBuf::pos_type ReadAheadBuf::seekoff(off_type off,
+    std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    switch (dir)
+    {
+    case std::ios_base::beg:
+        break;
+    case std::ios_base::cur:
+        off += m_pos + (gptr() - eback());
+        break;
+    case std::ios_base::end:
+        off += m_size;
+        break;
+    default:
+        return pos_type(off_type(-1));
+    }
+    if (off < 0)
+        return pos_type(off_type(-1));
+    return seekpos(pos_type(off), which);
+}
+
+} // namespace pdal
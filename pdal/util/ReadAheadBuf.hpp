@@ -0,0 +1,108 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <future>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "pdal_util_export.hpp"
+
+namespace pdal
+{
+
+/**
+  A read-only streambuf over a file that reads ahead in the background.
+
+  Two buffers are used.  While the consumer drains one, a background task
+  fills the other with the next part of the file, so reading from the
+  file overlaps with whatever the consumer does with the data.
+
+  Seeking is supported.  A seek that lands in the current buffer just
+  moves the get pointer.  Other seeks drop the buffered data.  The first
+  read after opening or seeking is small and doesn't start a read-ahead,
+  so reading a header or jumping around the file stays cheap; read-ahead
+  starts once the consumer reads past that first block.
+*/
+class ReadAheadBuf : public std::streambuf
+{
+public:
+    static const size_t DefaultBufSize = 4 << 20;
+
+    /**
+      Open a file for reading.
+
+      \param filename  Name of file to open.
+      \param bufSize  Size of each of the two buffers.
+    */
+    PDAL_DLL ReadAheadBuf(const std::string& filename,
+        size_t bufSize = DefaultBufSize);
+    PDAL_DLL ~ReadAheadBuf();
+
+    /**
+      Determine if the file was opened successfully.
+
+      \return  Whether the file is open.
+    */
+    PDAL_DLL bool isOpen() const
+        { return m_file.is_open(); }
+
+protected:
+    PDAL_DLL int_type underflow();
+    PDAL_DLL pos_type seekpos(pos_type pos,
+        std::ios_base::openmode which = std::ios_base::in);
+    PDAL_DLL pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+        std::ios_base::openmode which = std::ios_base::in);
+
+private:
+    std::filebuf m_file;
+    std::vector<char> m_buf;
+    std::vector<char> m_next;
+    std::future<std::streamsize> m_pending;
+    /// File position of the start of the current buffer.
+    std::streamoff m_pos;
+    std::streamoff m_size;
+    /// Whether the consumer has read sequentially since the last seek.
+    bool m_sequential;
+
+    void cancel();
+
+    ReadAheadBuf(const ReadAheadBuf&) = delete;
+    ReadAheadBuf& operator=(const ReadAheadBuf&) = delete;
+};
+
+} // namespace pdal
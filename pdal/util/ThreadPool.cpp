@@ -0,0 +1,198 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/util/ThreadPool.hpp>
+
+#include <algorithm>
+
+namespace pdal
+{
+
+ThreadPool::ThreadPool(std::size_t numThreads) :
+    m_numThreads((std::max)(numThreads, (std::size_t)1)), m_outstanding(0),
+    m_stop(false)
+{
+    if (m_numThreads > 1)
+        for (std::size_t i = 0; i < m_numThreads; ++i)
+            m_threads.emplace_back([this](){ work(); });
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this](){ return m_outstanding == 0; });
+        m_stop = true;
+    }
+    m_taskCv.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+
+void ThreadPool::add(std::function<void()> task)
+{
+    if (m_threads.empty())
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            setError(std::current_exception());
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+        m_outstanding++;
+    }
+    m_taskCv.notify_one();
+}
+
+
+void ThreadPool::await()
+{
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this](){ return m_outstanding == 0; });
+        std::swap(error, m_error);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t minRange,
+    const std::function<void(std::size_t, std::size_t)>& f)
+{
+    std::size_t ranges = numRanges(count, minRange);
+    if (ranges <= 1)
+    {
+        if (count)
+            f(0, count);
+        return;
+    }
+
+    std::size_t rangeSize = (count + ranges - 1) / ranges;
+    for (std::size_t begin = 0; begin < count; begin += rangeSize)
+    {
+        std::size_t end = (std::min)(begin + rangeSize, count);
+        add([&f, begin, end](){ f(begin, end); });
+    }
+    await();
+}
+
+
+void ThreadPool::parallelFor(std::size_t threads, std::size_t count,
+    std::size_t minRange,
+    const std::function<void(std::size_t, std::size_t)>& f)
+{
+    std::size_t ranges = numRanges(threads, count, minRange);
+    if (ranges <= 1)
+    {
+        if (count)
+            f(0, count);
+        return;
+    }
+
+    ThreadPool pool(ranges);
+    pool.parallelFor(count, minRange, f);
+}
+
+
+std::size_t ThreadPool::numRanges(std::size_t threads, std::size_t count,
+    std::size_t minRange)
+{
+    minRange = (std::max)(minRange, (std::size_t)1);
+    std::size_t ranges = (count + minRange - 1) / minRange;
+    return (std::min)(ranges, (std::max)(threads, (std::size_t)1));
+}
+
+
+std::size_t ThreadPool::defaultThreadCount()
+{
+    std::size_t count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+
+void ThreadPool::setError(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_error)
+        m_error = error;
+}
+
+
+void ThreadPool::work()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskCv.wait(lock, [this](){ return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            setError(std::current_exception());
+        }
+
+        bool done;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            done = (--m_outstanding == 0);
+        }
+        if (done)
+            m_doneCv.notify_all();
+    }
+}
+
+} // namespace pdal
+
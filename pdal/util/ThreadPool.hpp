@@ -0,0 +1,154 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "pdal_util_export.hpp"
+
+namespace pdal
+{
+
+/**
+  A fixed-size pool of worker threads that run queued tasks.
+
+  Tasks are added with add() and run in no particular order.  await()
+  blocks until every task added so far has completed.  If a task throws,
+  the first exception is captured and rethrown from await().
+
+  A pool created with a single thread runs tasks inline in add(), so
+  callers don't need a separate code path for the serial case.
+*/
+class PDAL_DLL ThreadPool
+{
+public:
+    /**
+      Create a pool and start the worker threads.
+
+      \param numThreads  Number of worker threads.  Zero is treated as one.
+    */
+    ThreadPool(std::size_t numThreads);
+
+    /**
+      Wait for outstanding tasks and stop the worker threads.  Exceptions
+      from tasks not yet retrieved with await() are discarded.
+    */
+    ~ThreadPool();
+
+    /**
+      Queue a task to be run by a worker thread.
+
+      \param task  Task to run.
+    */
+    void add(std::function<void()> task);
+
+    /**
+      Wait for all queued tasks to complete.  If any task threw an
+      exception, the first one is rethrown.
+    */
+    void await();
+
+    /**
+      Split [0, count) into contiguous ranges and run a function on each
+      range on the pool's threads, then wait for them as with await().
+      Each range but the last has ceil(count / numRanges()) items, so
+      there are at most numRanges() of them.  A single range is run
+      inline.
+
+      \param count  Number of items.
+      \param minRange  Smallest number of items worth a separate task.
+      \param f  Function called with the [begin, end) of each range.
+    */
+    void parallelFor(std::size_t count, std::size_t minRange,
+        const std::function<void(std::size_t, std::size_t)>& f);
+
+    /**
+      As parallelFor() on a pool of \a threads threads, except that no pool
+      is created when the items make up only one range.
+    */
+    static void parallelFor(std::size_t threads, std::size_t count,
+        std::size_t minRange,
+        const std::function<void(std::size_t, std::size_t)>& f);
+
+    /**
+      Number of ranges parallelFor() plans for \a count items: one per
+      thread, but no more than ceil(count / minRange).  Zero only when
+      \a count is zero.
+    */
+    std::size_t numRanges(std::size_t count, std::size_t minRange) const
+        { return numRanges(m_numThreads, count, minRange); }
+
+    static std::size_t numRanges(std::size_t threads, std::size_t count,
+        std::size_t minRange);
+
+    /**
+      Number of worker threads in the pool.
+    */
+    std::size_t numThreads() const
+        { return m_numThreads; }
+
+    /**
+      Number of threads to use when the user hasn't specified a count:
+      the number of hardware threads, or one if that can't be determined.
+    */
+    static std::size_t defaultThreadCount();
+
+private:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void work();
+    void setError(std::exception_ptr error);
+
+    std::size_t m_numThreads;
+    std::vector<std::thread> m_threads;
+    std::queue<std::function<void()>> m_tasks;
+    std::size_t m_outstanding;
+    bool m_stop;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_taskCv;
+    std::condition_variable m_doneCv;
+};
+
+} // namespace pdal
+
@@ -76,12 +76,14 @@ void PredicateFilter::ready(PointTableRef table)
 }
 
 
-PointViewSet PredicateFilter::run(PointViewPtr view)
+// Run the function on the points of a view and return its mask, which
+// has a non-zero value for each point to be kept.
+const char *PredicateFilter::evaluate(PointView& view)
 {
     MetadataNode n;
 
     m_pythonMethod->resetArguments();
-    m_pythonMethod->begin(*view, n);
+    m_pythonMethod->begin(view, n);
 
     if (!m_pdalargs.empty())
     {
@@ -95,11 +97,16 @@ PointViewSet PredicateFilter::run(PointViewPtr view)
     if (!m_pythonMethod->hasOutputVariable("Mask"))
         throwError("Mask variable not set in filter function.");
 
+    return (const char *)
+        m_pythonMethod->extractResult("Mask", Dimension::Type::Unsigned8);
+}
+
+
+PointViewSet PredicateFilter::run(PointViewPtr view)
+{
     PointViewPtr outview = view->makeNew();
 
-    void *pydata =
-        m_pythonMethod->extractResult("Mask", Dimension::Type::Unsigned8);
-    char *ok = (char *)pydata;
+    const char *ok = evaluate(*view);
     for (PointId idx = 0; idx < view->size(); ++idx)
         if (*ok++)
             outview->appendPoint(*view, idx);
@@ -110,6 +117,29 @@ PointViewSet PredicateFilter::run(PointViewPtr view)
 }
 
 
+// When streaming, the function is called once for each block of points
+// and points are filtered-out according to the mask.
+void PredicateFilter::processBlock(StreamPointTable& table,
+    std::vector<bool>& skips, point_count_t count)
+{
+    std::vector<PointId> ids;
+    PointView view(table, table.anySpatialReference());
+    for (PointId idx = 0; idx < count; ++idx)
+        if (!skips[idx])
+        {
+            view.appendTablePoint(idx);
+            ids.push_back(idx);
+        }
+    if (!view.size())
+        return;
+
+    const char *ok = evaluate(view);
+    for (PointId id : ids)
+        if (!*ok++)
+            skips[id] = true;
+}
+
+
 void PredicateFilter::done(PointTableRef table)
 {
     plang::Environment::get()->reset_stdout();
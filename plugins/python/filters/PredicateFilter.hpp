@@ -66,8 +66,12 @@ private:
     virtual void addArgs(ProgramArgs& args);
     virtual void ready(PointTableRef table);
     virtual PointViewSet run(PointViewPtr view);
+    virtual void processBlock(StreamPointTable& table,
+        std::vector<bool>& skips, point_count_t count);
     virtual void done(PointTableRef table);
 
+    const char *evaluate(PointView& view);
+
     PredicateFilter& operator=(const PredicateFilter&); // not implemented
     PredicateFilter(const PredicateFilter&); // not implemented
 };
@@ -102,6 +102,19 @@ void ProgrammableFilter::filter(PointView& view)
 }
 
 
+// When streaming, the function is called once for each block of points.
+void ProgrammableFilter::processBlock(StreamPointTable& table,
+    std::vector<bool>& skips, point_count_t count)
+{
+    PointView view(table, table.anySpatialReference());
+    for (PointId idx = 0; idx < count; ++idx)
+        if (!skips[idx])
+            view.appendTablePoint(idx);
+    if (view.size())
+        filter(view);
+}
+
+
 void ProgrammableFilter::done(PointTableRef table)
 {
     plang::Environment::get()->reset_stdout();
@@ -69,6 +69,8 @@ private:
     virtual void addDimensions(PointLayoutPtr layout);
     virtual void ready(PointTableRef table);
     virtual void filter(PointView& view);
+    virtual void processBlock(StreamPointTable& table,
+        std::vector<bool>& skips, point_count_t count);
     virtual void done(PointTableRef table);
 
     ProgrammableFilter& operator=(const ProgrammableFilter&); // not implemented
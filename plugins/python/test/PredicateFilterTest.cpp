@@ -39,6 +39,7 @@
 #include <pdal/StageWrapper.hpp>
 #include <io/FauxReader.hpp>
 #include <filters/StatsFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
 
 #include "Support.hpp"
 
@@ -115,6 +116,51 @@ TEST_F(PredicateFilterTest, PredicateFilterTest_test1)
     EXPECT_TRUE(Utils::compare_approx(statsZ.maximum(), 1.0, 0.01));
 }
 
+TEST_F(PredicateFilterTest, streaming)
+{
+    StageFactory f;
+
+    BOX3D bounds(0.0, 0.0, 0.0, 2.0, 2.0, 2.0);
+    Options readerOps;
+    readerOps.add("bounds", bounds);
+    readerOps.add("count", 1000);
+    readerOps.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(readerOps);
+
+    // keep all points where x less than 1.0
+    Options opts;
+    opts.add("source",
+        "import numpy as np\n"
+        "def yow1(ins,outs):\n"
+        "  outs['Mask'] = np.less(ins['X'], 1.0)\n"
+        "  return True\n"
+    );
+    opts.add("module", "MyModule1");
+    opts.add("function", "yow1");
+
+    Stage* filter(f.createStage("filters.predicate"));
+    filter->setOptions(opts);
+    filter->setInput(reader);
+
+    point_count_t count = 0;
+    auto cb = [&count](PointRef& point)
+    {
+        EXPECT_LT(point.getFieldAs<double>(Dimension::Id::X), 1.0);
+        count++;
+        return true;
+    };
+    StreamCallbackFilter c;
+    c.setCallback(cb);
+    c.setInput(*filter);
+
+    FixedPointTable table(64);
+    c.prepare(table);
+    c.execute(table);
+    EXPECT_EQ(count, 500u);
+}
+
 TEST_F(PredicateFilterTest, PredicateFilterTest_test2)
 {
     StageFactory f;
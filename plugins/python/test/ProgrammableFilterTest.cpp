@@ -38,6 +38,9 @@
 #include <pdal/StageFactory.hpp>
 #include <io/FauxReader.hpp>
 #include <filters/StatsFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+
+#include <sstream>
 
 #include "Support.hpp"
 
@@ -189,6 +192,185 @@ TEST_F(ProgrammableFilterTest, add_dimension)
 }
 
 
+// Input arrays may refer to the point data directly.  Make sure that
+// outputs that are other inputs work.
+TEST_F(ProgrammableFilterTest, sharedArrays)
+{
+    StageFactory f;
+
+    BOX3D bounds(0.0, 10.0, 0.0, 1.0, 11.0, 1.0);
+
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("count", 10);
+    ops.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    Option source("source", "import numpy as np\n"
+        "def myfunc(ins,outs):\n"
+        "  outs['Z'] = ins['Z'] + 5.0\n"
+        "  outs['X'] = ins['Y']\n"
+        "  outs['Y'] = ins['X']\n"
+        "  return True\n"
+    );
+    Options opts;
+    opts.add(source);
+    opts.add("module", "MyModule");
+    opts.add("function", "myfunc");
+
+    Stage* filter(f.createStage("filters.programmable"));
+    filter->setOptions(opts);
+    filter->setInput(reader);
+
+    PointTable table;
+    filter->prepare(table);
+    PointViewSet viewSet = filter->execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double ramp = i / 9.0;
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::X, i),
+            10.0 + ramp, 1e-6);
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Y, i),
+            ramp, 1e-6);
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Z, i),
+            5.0 + ramp, 1e-6);
+    }
+}
+
+
+// Input arrays are read-only, whether or not they're copies.
+TEST_F(ProgrammableFilterTest, readOnlyInputs)
+{
+    StageFactory f;
+
+    BOX3D bounds(0.0, 0.0, 0.0, 1.0, 1.0, 1.0);
+
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("count", 10);
+    ops.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    Option source("source", "import numpy as np\n"
+        "def myfunc(ins,outs):\n"
+        "  Z = ins['Z']\n"
+        "  Z += 5.0\n"
+        "  return True\n"
+    );
+    Options opts;
+    opts.add(source);
+    opts.add("module", "MyModule");
+    opts.add("function", "myfunc");
+
+    Stage* filter(f.createStage("filters.programmable"));
+    filter->setOptions(opts);
+    filter->setInput(reader);
+
+    PointTable table;
+    filter->prepare(table);
+    EXPECT_THROW(filter->execute(table), pdal_error);
+}
+
+
+// A view larger than the default 65536-point block is passed without
+// copying when the pipeline's block size holds it in one block.  An input
+// array that refers to the point data is strided by the size of a point.
+TEST_F(ProgrammableFilterTest, largeViewNoCopy)
+{
+    std::istringstream json(
+        "{\n"
+        "  \"block_size\": 131072,\n"
+        "  \"pipeline\": [\n"
+        "    {\n"
+        "      \"type\": \"readers.faux\",\n"
+        "      \"bounds\": \"([0, 1], [0, 1], [0, 1])\",\n"
+        "      \"count\": 100000,\n"
+        "      \"mode\": \"ramp\"\n"
+        "    },\n"
+        "    {\n"
+        "      \"type\": \"filters.programmable\",\n"
+        "      \"module\": \"MyModule\",\n"
+        "      \"function\": \"myfunc\",\n"
+        "      \"source\": \"import numpy as np\\n"
+        "def myfunc(ins,outs):\\n"
+        "  Z = ins['Z']\\n"
+        "  if Z.flags.writeable or Z.strides[0] == Z.itemsize:\\n"
+        "    return False\\n"
+        "  outs['Z'] = Z + 5.0\\n"
+        "  return True\\n\"\n"
+        "    }\n"
+        "  ]\n"
+        "}\n");
+
+    PipelineManager manager;
+    manager.readPipeline(json);
+    manager.execute();
+    PointViewSet viewSet = manager.views();
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 100000u);
+
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        double ramp = i / 99999.0;
+        EXPECT_NEAR(view->getFieldAs<double>(Dimension::Id::Z, i),
+            5.0 + ramp, 1e-6);
+    }
+}
+
+
+TEST_F(ProgrammableFilterTest, streaming)
+{
+    StageFactory f;
+
+    BOX3D bounds(0.0, 0.0, 0.0, 1.0, 1.0, 1.0);
+
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("count", 1000);
+    ops.add("mode", "ramp");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    Options opts;
+    opts.add("source", "import numpy as np\n"
+        "def myfunc(ins,outs):\n"
+        "  outs['Z'] = ins['Z'] * 10.0\n"
+        "  return True\n"
+    );
+    opts.add("module", "MyModule");
+    opts.add("function", "myfunc");
+
+    Stage* filter(f.createStage("filters.programmable"));
+    filter->setOptions(opts);
+    filter->setInput(reader);
+
+    point_count_t count = 0;
+    auto cb = [&count](PointRef& point)
+    {
+        EXPECT_NEAR(point.getFieldAs<double>(Dimension::Id::Z),
+            count * 10.0 / 999, 1e-6);
+        count++;
+        return true;
+    };
+    StreamCallbackFilter c;
+    c.setCallback(cb);
+    c.setInput(*filter);
+
+    FixedPointTable table(100);
+    c.prepare(table);
+    c.execute(table);
+    EXPECT_EQ(count, 1000u);
+}
+
 TEST_F(ProgrammableFilterTest, metadata)
 {
     StageFactory f;
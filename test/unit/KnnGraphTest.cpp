@@ -0,0 +1,226 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/EigenUtils.hpp>
+#include <pdal/KDIndex.hpp>
+#include <pdal/KnnGraph.hpp>
+#include <filters/NormalFilter.hpp>
+#include <filters/EigenvaluesFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <io/BufferReader.hpp>
+
+#include <random>
+
+using namespace pdal;
+
+namespace
+{
+
+void fillRandom(PointView& view, point_count_t count)
+{
+    std::default_random_engine generator;
+    std::uniform_real_distribution<double> dist(0.0, 100.0);
+    for (PointId i = 0; i < count; ++i)
+    {
+        view.setField(Dimension::Id::X, i, dist(generator));
+        view.setField(Dimension::Id::Y, i, dist(generator));
+        view.setField(Dimension::Id::Z, i, dist(generator));
+    }
+}
+
+} // unnamed namespace
+
+TEST(KnnGraphTest, neighbors)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    fillRandom(*view, 10000);
+
+    KD3Index kdi(*view);
+    kdi.build();
+
+    KnnGraphPtr graph = KnnGraph::get(*view, 8, 4);
+    EXPECT_EQ(graph->size(), view->size());
+    EXPECT_EQ(graph->k(), 8u);
+    for (PointId i = 0; i < view->size(); ++i)
+    {
+        std::vector<PointId> ids = kdi.neighbors(i, 8);
+        const uint32_t *neighbors = graph->neighbors(i);
+        for (size_t j = 0; j < ids.size(); ++j)
+            EXPECT_EQ(ids[j], neighbors[j]);
+
+        Eigen::Matrix3f expected = eigen::computeCovariance(*view, ids);
+        Eigen::Matrix3d cov = graph->covariance(i, 8);
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                EXPECT_NEAR(expected(r, c), cov(r, c),
+                    1e-4 * (std::max)(1.0, std::fabs(cov(r, c))));
+    }
+}
+
+TEST(KnnGraphTest, cache)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    fillRandom(*view, 1000);
+
+    // A graph with as many or more neighbors is reused.
+    KnnGraphPtr graph = KnnGraph::get(*view, 8);
+    EXPECT_EQ(graph, KnnGraph::get(*view, 8));
+    EXPECT_EQ(graph, KnnGraph::get(*view, 4));
+
+    // More neighbors require a new graph.
+    KnnGraphPtr bigger = KnnGraph::get(*view, 12);
+    EXPECT_NE(graph, bigger);
+    EXPECT_EQ(bigger->k(), 12u);
+    EXPECT_EQ(bigger, KnnGraph::get(*view, 8));
+
+    // A released graph is recomputed.
+    view->setField(Dimension::Id::X, 0, 500.0);
+    KnnGraph::release(*view);
+    KnnGraphPtr moved = KnnGraph::get(*view, 8);
+    EXPECT_NE(bigger, moved);
+    EXPECT_EQ(moved, KnnGraph::get(*view, 8));
+
+    // A view of different size gets a new graph.
+    view->setField(Dimension::Id::X, 1000, 1.0);
+    view->setField(Dimension::Id::Y, 1000, 1.0);
+    view->setField(Dimension::Id::Z, 1000, 1.0);
+    EXPECT_NE(moved, KnnGraph::get(*view, 8));
+}
+
+// A cached graph is kept while consecutive stages use it and released
+// when the points reach any other stage.
+TEST(KnnGraphTest, release)
+{
+    for (bool otherStage : { false, true })
+    {
+        PointTable table;
+        PointLayoutPtr layout(table.layout());
+        layout->registerDim(Dimension::Id::X);
+        layout->registerDim(Dimension::Id::Y);
+        layout->registerDim(Dimension::Id::Z);
+
+        PointViewPtr view(new PointView(table));
+        BufferReader r;
+        r.addView(view);
+
+        NormalFilter n;
+        n.setInput(r);
+        EigenvaluesFilter e;
+        e.setInput(n);
+        StreamCallbackFilter c;
+        c.setInput(e);
+
+        Stage& last = otherStage ? (Stage&)c : (Stage&)e;
+        last.prepare(table);
+        fillRandom(*view, 1000);
+
+        // Both filters use the default of eight neighbors, so they share
+        // this graph.  Only the view holds on to it.
+        std::weak_ptr<const KnnGraph> graph(KnnGraph::get(*view, 8));
+        last.execute(table);
+        EXPECT_EQ(graph.expired(), otherStage);
+    }
+}
+
+// Normals and eigenvalues of a plane computed from a shared neighbor graph.
+TEST(KnnGraphTest, features)
+{
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    BufferReader r;
+    r.addView(view);
+
+    Options opts;
+    opts.add("threads", 4);
+
+    NormalFilter n;
+    n.setOptions(opts);
+    n.setInput(r);
+
+    EigenvaluesFilter e;
+    e.setOptions(opts);
+    e.setInput(n);
+
+    e.prepare(table);
+
+    std::default_random_engine generator;
+    std::uniform_real_distribution<double> dist(0.0, 100.0);
+    for (PointId i = 0; i < 5000; ++i)
+    {
+        double x = dist(generator);
+        double y = dist(generator);
+        view->setField(Dimension::Id::X, i, x);
+        view->setField(Dimension::Id::Y, i, y);
+        view->setField(Dimension::Id::Z, i, 2 * x + 3 * y);
+    }
+
+    PointViewSet s = e.execute(table);
+    PointViewPtr out = *s.begin();
+
+    // The normal of the plane z = 2x + 3y is (2, 3, -1) / sqrt(14).
+    Dimension::Id nx = layout->findDim("NormalX");
+    Dimension::Id ny = layout->findDim("NormalY");
+    Dimension::Id nz = layout->findDim("NormalZ");
+    Dimension::Id e0 = layout->findDim("Eigenvalue0");
+    Dimension::Id e1 = layout->findDim("Eigenvalue1");
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double x = out->getFieldAs<double>(nx, i);
+        double y = out->getFieldAs<double>(ny, i);
+        double z = out->getFieldAs<double>(nz, i);
+        double dot = (2 * x + 3 * y - z) / std::sqrt(14.0);
+        EXPECT_NEAR(std::fabs(dot), 1.0, 1e-6);
+        EXPECT_NEAR(out->getFieldAs<double>(e0, i), 0.0,
+            1e-6 * out->getFieldAs<double>(e1, i));
+    }
+}
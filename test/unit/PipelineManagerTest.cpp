@@ -39,6 +39,8 @@
 #include <pdal/PipelineManager.hpp>
 #include <pdal/util/FileUtils.hpp>
 
+#include <sstream>
+
 using namespace pdal;
 
 TEST(PipelineManagerTest, basic)
@@ -155,3 +157,45 @@ TEST(PipelineManagerTest, InputGlobbing)
     FileUtils::deleteFile(Support::temppath("globbed.las"));
 }
 
+namespace pdal
+{
+
+// The pipeline's block size is used by the point table, so a view that
+// fits in a block is stored in one block.
+TEST(PipelineManagerTest, blockSize)
+{
+    auto pipeline = [](const std::string& blockSize)
+    {
+        return std::string("{\n") +
+            "  \"block_size\": " + blockSize + ",\n"
+            "  \"pipeline\": [\n"
+            "    {\n"
+            "      \"type\": \"readers.faux\",\n"
+            "      \"bounds\": \"([0, 1], [0, 1], [0, 1])\",\n"
+            "      \"count\": 100000,\n"
+            "      \"mode\": \"ramp\"\n"
+            "    }\n"
+            "  ]\n"
+            "}\n";
+    };
+
+    PipelineManager mgr;
+    std::istringstream json(pipeline("100000"));
+    mgr.readPipeline(json);
+    EXPECT_EQ(mgr.execute(), 100000u);
+
+    PointTable& table = dynamic_cast<PointTable&>(mgr.pointTable());
+    EXPECT_EQ(table.m_blockShift, 17);
+    EXPECT_EQ(table.m_blocks.size(), 1u);
+    EXPECT_THROW(mgr.setBlockSize(1000), pdal_error);
+
+    PipelineManager mgr2;
+    std::istringstream json2(pipeline("0"));
+    EXPECT_THROW(mgr2.readPipeline(json2), pdal_error);
+
+    PipelineManager mgr3;
+    std::istringstream json3(pipeline("\"big\""));
+    EXPECT_THROW(mgr3.readPipeline(json3), pdal_error);
+}
+
+} // namespace pdal
@@ -203,4 +203,56 @@ TEST(PointTable, srs)
     EXPECT_EQ(table.m_spatialRefs.size(), 2u);
 }
 
+TEST(PointTable, blockSize)
+{
+    const point_count_t count = 100000;
+
+    auto fill = [count](PointTable& table)
+    {
+        table.layout()->registerDim(Dimension::Id::X);
+        table.layout()->registerDim(Dimension::Id::Intensity);
+        table.finalize();
+
+        PointView view(table);
+        for (PointId i = 0; i < count; ++i)
+        {
+            view.setField(Dimension::Id::X, i, i * 2.5);
+            view.setField(Dimension::Id::Intensity, i, i % 65536);
+        }
+        for (PointId i = 0; i < count; ++i)
+        {
+            EXPECT_DOUBLE_EQ(view.getFieldAs<double>(Dimension::Id::X, i),
+                i * 2.5);
+            EXPECT_EQ(view.getFieldAs<uint16_t>(Dimension::Id::Intensity, i),
+                i % 65536);
+        }
+    };
+
+    auto contiguous = [count](PointTable& table)
+    {
+        size_t pointSize = table.layout()->pointSize();
+        char *base = table.getPoint(0);
+        for (PointId i = 1; i < count; ++i)
+            if (table.getPoint(i) != base + i * pointSize)
+                return false;
+        return true;
+    };
+
+    PointTable defaultTable;
+    fill(defaultTable);
+    EXPECT_FALSE(contiguous(defaultTable));
+
+    // Rounded up to 1 << 17 points, so all points are in one block.
+    PointTable bigTable(count);
+    fill(bigTable);
+    EXPECT_EQ(bigTable.m_blockShift, 17);
+    EXPECT_EQ(bigTable.m_blocks.size(), 1u);
+    EXPECT_TRUE(contiguous(bigTable));
+
+    PointTable smallTable(1000);
+    fill(smallTable);
+    EXPECT_EQ(smallTable.m_blockShift, 10);
+    EXPECT_EQ(smallTable.m_blocks.size(), 98u);
+}
+
 } // namespace
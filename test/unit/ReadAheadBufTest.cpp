@@ -0,0 +1,140 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <fstream>
+#include <random>
+
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/ReadAheadBuf.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+std::vector<char> writeTestFile(const std::string& filename, size_t size)
+{
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; ++i)
+        data[i] = (char)(i * 7 + i / 251);
+
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    out.write(data.data(), data.size());
+    return data;
+}
+
+} // unnamed namespace
+
+TEST(ReadAheadBufTest, sequential)
+{
+    std::string filename(Support::temppath("readahead.dat"));
+    std::vector<char> data = writeTestFile(filename, 1000003);
+
+    for (size_t bufSize : { 1000, 65536, 300000, 4000000 })
+    {
+        ReadAheadBuf buf(filename, bufSize);
+        EXPECT_TRUE(buf.isOpen());
+        std::istream in(&buf);
+
+        std::vector<char> out(data.size());
+        size_t pos = 0;
+        size_t chunk = 1;
+        while (pos < out.size())
+        {
+            size_t count = (std::min)(chunk, out.size() - pos);
+            in.read(out.data() + pos, count);
+            EXPECT_EQ((size_t)in.gcount(), count);
+            pos += count;
+            chunk = chunk * 3 + 1;
+        }
+        EXPECT_TRUE(out == data);
+
+        char c;
+        in.read(&c, 1);
+        EXPECT_TRUE(in.eof());
+        EXPECT_EQ(in.gcount(), 0);
+    }
+    FileUtils::deleteFile(filename);
+}
+
+TEST(ReadAheadBufTest, seek)
+{
+    std::string filename(Support::temppath("readahead.dat"));
+    std::vector<char> data = writeTestFile(filename, 500000);
+
+    ReadAheadBuf buf(filename, 10000);
+    std::istream in(&buf);
+
+    in.seekg(0, std::ios::end);
+    EXPECT_EQ((size_t)in.tellg(), data.size());
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<size_t> dist(0, data.size() - 1);
+    std::vector<char> out(50000);
+    for (size_t i = 0; i < 200; ++i)
+    {
+        size_t pos = dist(gen);
+        size_t count = (std::min)(dist(gen) % out.size(), data.size() - pos);
+
+        // Alternate between absolute and relative seeks.
+        in.clear();
+        if (i % 2)
+            in.seekg(pos);
+        else
+            in.seekg((std::streamoff)pos - (std::streamoff)in.tellg(),
+                std::ios::cur);
+        EXPECT_EQ((size_t)in.tellg(), pos);
+
+        in.read(out.data(), count);
+        EXPECT_EQ((size_t)in.gcount(), count);
+        EXPECT_TRUE(std::equal(out.begin(), out.begin() + count,
+            data.begin() + pos));
+        EXPECT_EQ((size_t)in.tellg(), pos + count);
+    }
+    FileUtils::deleteFile(filename);
+}
+
+TEST(ReadAheadBufTest, missing)
+{
+    ReadAheadBuf buf(Support::temppath("this_file_does_not_exist.dat"));
+    EXPECT_FALSE(buf.isOpen());
+
+    std::istream in(&buf);
+    char c;
+    in.read(&c, 1);
+    EXPECT_FALSE((bool)in);
+}
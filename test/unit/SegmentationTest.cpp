@@ -38,8 +38,11 @@
 #include <pdal/PointTable.hpp>
 #include <pdal/PointView.hpp>
 
+#include <pdal/KDIndex.hpp>
 #include <pdal/Segmentation.hpp>
 
+#include <algorithm>
+#include <random>
 #include <vector>
 
 using namespace pdal;
@@ -95,3 +98,114 @@ TEST(SegmentationTest, BasicClustering)
     EXPECT_EQ(1u, clusters.size());
     EXPECT_EQ(1u, clusters[0].size());
 }
+
+namespace
+{
+
+// Cluster by growing each cluster breadth-first from its lowest point.
+std::vector<std::vector<PointId>> bfsClusters(PointView& view,
+    double tolerance)
+{
+    KD3Index kdi(view);
+    kdi.build();
+
+    std::vector<char> processed(view.size());
+    std::vector<std::vector<PointId>> clusters;
+    for (PointId i = 0; i < view.size(); ++i)
+    {
+        if (processed[i])
+            continue;
+        std::vector<PointId> queue { i };
+        processed[i] = 1;
+        for (size_t q = 0; q < queue.size(); ++q)
+            for (PointId k : kdi.radius(queue[q], tolerance))
+                if (!processed[k])
+                {
+                    processed[k] = 1;
+                    queue.push_back(k);
+                }
+        std::sort(queue.begin(), queue.end());
+        clusters.push_back(queue);
+    }
+    return clusters;
+}
+
+} // unnamed namespace
+
+TEST(SegmentationTest, ParallelClustering)
+{
+    using namespace Segmentation;
+
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr src(new PointView(table));
+
+    std::default_random_engine generator;
+    std::uniform_real_distribution<double> dist(0.0, 100.0);
+    for (PointId i = 0; i < 20000; ++i)
+    {
+        src->setField(Dimension::Id::X, i, dist(generator));
+        src->setField(Dimension::Id::Y, i, dist(generator));
+        src->setField(Dimension::Id::Z, i, dist(generator));
+    }
+
+    auto expected = bfsClusters(*src, 2.0);
+    EXPECT_EQ(expected, extractClusters(*src, 1, src->size(), 2.0, 1));
+    EXPECT_EQ(expected, extractClusters(*src, 1, src->size(), 2.0, 4));
+}
+
+TEST(SegmentationTest, DbscanClustering)
+{
+    using namespace Segmentation;
+
+    PointTable table;
+    PointLayoutPtr layout(table.layout());
+
+    layout->registerDim(Dimension::Id::X);
+    layout->registerDim(Dimension::Id::Y);
+    layout->registerDim(Dimension::Id::Z);
+
+    PointViewPtr src(new PointView(table));
+
+    // Two dense lines of points joined by a sparse bridge, and an isolated
+    // point.
+    PointId id = 0;
+    auto add = [&](double x)
+    {
+        src->setField(Dimension::Id::X, id, x);
+        src->setField(Dimension::Id::Y, id, 0.0);
+        src->setField(Dimension::Id::Z, id, 0.0);
+        id++;
+    };
+    for (int i = 0; i < 10; ++i)
+        add(i * 0.4);
+    add(4.5);
+    add(5.4);
+    for (int i = 0; i < 10; ++i)
+        add(6.3 + i * 0.4);
+    add(100.0);
+
+    // Euclidean clustering joins the lines through the bridge.
+    auto clusters = extractClusters(*src, 1, 100, 1.0);
+    EXPECT_EQ(2u, clusters.size());
+    EXPECT_EQ(22u, clusters[0].size());
+
+    // With DBSCAN, the bridge points aren't core points, so the lines are
+    // separate clusters, each with one bridge point as a border point.
+    // The isolated point is noise.
+    clusters = extractDbscanClusters(*src, 4, 1, 100, 1.0, 4);
+    EXPECT_EQ(2u, clusters.size());
+    EXPECT_EQ(11u, clusters[0].size());
+    EXPECT_EQ(11u, clusters[1].size());
+    EXPECT_EQ(10u, clusters[0].back());
+    EXPECT_EQ(11u, clusters[1].front());
+
+    // Rejecting small clusters.
+    clusters = extractDbscanClusters(*src, 4, 12, 100, 1.0, 4);
+    EXPECT_EQ(0u, clusters.size());
+}
@@ -0,0 +1,143 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <pdal/util/ThreadPool.hpp>
+
+using namespace pdal;
+
+TEST(ThreadPoolTest, run)
+{
+    for (size_t threads : { 1, 4 })
+    {
+        ThreadPool pool(threads);
+        EXPECT_EQ(pool.numThreads(), threads);
+
+        std::vector<int> vals(1000, 0);
+        for (size_t i = 0; i < vals.size(); ++i)
+            pool.add([&vals, i](){ vals[i] = (int)i * 2; });
+        pool.await();
+        for (size_t i = 0; i < vals.size(); ++i)
+            EXPECT_EQ(vals[i], (int)i * 2);
+
+        // The pool can be reused after await().
+        std::atomic<int> count(0);
+        for (size_t i = 0; i < 100; ++i)
+            pool.add([&count](){ count++; });
+        pool.await();
+        EXPECT_EQ(count, 100);
+    }
+}
+
+TEST(ThreadPoolTest, error)
+{
+    for (size_t threads : { 1, 4 })
+    {
+        ThreadPool pool(threads);
+
+        std::atomic<int> count(0);
+        for (size_t i = 0; i < 10; ++i)
+            pool.add([&count, i]()
+            {
+                if (i == 5)
+                    throw std::runtime_error("Task failed");
+                count++;
+            });
+        EXPECT_THROW(pool.await(), std::runtime_error);
+        EXPECT_EQ(count, 9);
+
+        // The error is cleared once reported.
+        pool.add([&count](){ count++; });
+        EXPECT_NO_THROW(pool.await());
+        EXPECT_EQ(count, 10);
+    }
+}
+
+TEST(ThreadPoolTest, parallelFor)
+{
+    for (size_t threads : { 1, 4 })
+    {
+        ThreadPool pool(threads);
+
+        // Every item is visited once, whatever the split.
+        for (size_t count : { 0, 1, 99, 100, 1001 })
+        {
+            std::vector<int> vals(count, 0);
+            pool.parallelFor(count, 10, [&vals](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    vals[i]++;
+            });
+            for (int v : vals)
+                EXPECT_EQ(v, 1);
+        }
+
+        EXPECT_EQ(pool.numRanges(0, 10), 0u);
+        EXPECT_EQ(pool.numRanges(5, 10), 1u);
+        EXPECT_EQ(pool.numRanges(1000, 10), threads);
+        EXPECT_EQ(ThreadPool::numRanges(4, 25, 10), 3u);
+    }
+
+    // Ranges are contiguous, in order and no more than numRanges().
+    std::mutex mutex;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ThreadPool::parallelFor(4, 1001, 10,
+        [&mutex, &ranges](size_t begin, size_t end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ranges.push_back({ begin, end });
+    });
+    std::sort(ranges.begin(), ranges.end());
+    EXPECT_LE(ranges.size(), 4u);
+    EXPECT_EQ(ranges.front().first, 0u);
+    EXPECT_EQ(ranges.back().second, 1001u);
+    for (size_t i = 1; i < ranges.size(); ++i)
+        EXPECT_EQ(ranges[i].first, ranges[i - 1].second);
+
+    // Errors from a range are rethrown.
+    EXPECT_THROW(ThreadPool::parallelFor(4, 1000, 10,
+        [](size_t begin, size_t)
+        {
+            if (begin == 0)
+                throw std::runtime_error("Range failed");
+        }), std::runtime_error);
+}
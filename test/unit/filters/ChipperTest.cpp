@@ -37,11 +37,14 @@
 #include <pdal/Options.hpp>
 #include <pdal/StageWrapper.hpp>
 #include <filters/ChipperFilter.hpp>
+#include <io/BufferReader.hpp>
 #include <io/LasWriter.hpp>
 #include <io/LasReader.hpp>
 
 #include "Support.hpp"
 
+#include <cmath>
+
 using namespace pdal;
 
 TEST(ChipperTest, test_construction)
@@ -120,6 +123,66 @@ TEST(ChipperTest, empty_buffer)
     EXPECT_EQ(viewSet.size(), 0u);
 }
 
+namespace
+{
+
+PointViewSet chip(PointTable& table, uint32_t threads)
+{
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    BufferReader reader;
+    reader.addView(view);
+
+    Options ops;
+    ops.add("capacity", 1000);
+    ops.add("threads", threads);
+    ChipperFilter chipper;
+    chipper.setInput(reader);
+    chipper.setOptions(ops);
+    chipper.prepare(table);
+
+    // Enough scattered points that sorting and splitting run in parallel.
+    for (PointId i = 0; i < 300000; ++i)
+    {
+        view->setField(Dimension::Id::X, i, std::fmod(i * 61.803, 5000));
+        view->setField(Dimension::Id::Y, i, std::fmod(i * 41.421, 3000));
+        view->setField(Dimension::Id::Z, i, i);
+    }
+    return chipper.execute(table);
+}
+
+} // unnamed namespace
+
+// Chips are the same regardless of the number of threads.
+TEST(ChipperTest, threads)
+{
+    PointTable t1;
+    PointTable t2;
+    PointViewSet s1 = chip(t1, 1);
+    PointViewSet s2 = chip(t2, 4);
+    ASSERT_EQ(s1.size(), 300u);
+    ASSERT_EQ(s1.size(), s2.size());
+
+    std::vector<bool> seen(300000);
+    for (auto i1 = s1.begin(), i2 = s2.begin(); i1 != s1.end(); ++i1, ++i2)
+    {
+        PointViewPtr v1 = *i1;
+        PointViewPtr v2 = *i2;
+        ASSERT_EQ(v1->size(), 1000u);
+        ASSERT_EQ(v1->size(), v2->size());
+        for (PointId i = 0; i < v1->size(); ++i)
+        {
+            PointId z = v1->getFieldAs<PointId>(Dimension::Id::Z, i);
+            EXPECT_EQ(z, v2->getFieldAs<PointId>(Dimension::Id::Z, i));
+            EXPECT_FALSE(seen[z]);
+            seen[z] = true;
+        }
+    }
+}
+
 //ABELL
 /**
 TEST(ChipperTest, test_ordering)
@@ -0,0 +1,166 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <io/BufferReader.hpp>
+#include <filters/HAGFilter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+double ground(double x, double y)
+{
+    return 0.3 * x + 0.2 * y;
+}
+
+// Ground points on a grid over a tilted plane, with a non-ground point
+// 5 units above the plane in each grid cell.
+PointViewPtr hag(PointTable& t, const std::string& method, uint32_t threads)
+{
+    using namespace Dimension;
+
+    t.layout()->registerDim(Id::X);
+    t.layout()->registerDim(Id::Y);
+    t.layout()->registerDim(Id::Z);
+    t.layout()->registerDim(Id::Classification);
+
+    PointViewPtr input(new PointView(t));
+    BufferReader r;
+    r.addView(input);
+
+    Options o;
+    o.add("method", method);
+    o.add("threads", threads);
+    HAGFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(t);
+
+    PointId id = 0;
+    for (int i = 0; i <= 20; ++i)
+        for (int j = 0; j <= 20; ++j)
+        {
+            input->setField(Id::X, id, i);
+            input->setField(Id::Y, id, j);
+            input->setField(Id::Z, id, ground(i, j));
+            input->setField(Id::Classification, id, 2);
+            id++;
+            if (i == 20 || j == 20)
+                continue;
+            double x = i + .2;
+            double y = j + .2;
+            input->setField(Id::X, id, x);
+            input->setField(Id::Y, id, y);
+            input->setField(Id::Z, id, ground(x, y) + 5);
+            input->setField(Id::Classification, id, 1);
+            id++;
+        }
+
+    PointViewSet s = f.execute(t);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+void check(const PointView& v, double expected, double tolerance)
+{
+    using namespace Dimension;
+
+    for (PointId i = 0; i < v.size(); ++i)
+    {
+        double h = v.getFieldAs<double>(Id::HeightAboveGround, i);
+        if (v.getFieldAs<int>(Id::Classification, i) == 2)
+            EXPECT_EQ(h, 0.0);
+        else
+            EXPECT_NEAR(h, expected, tolerance);
+    }
+}
+
+} // unnamed namespace
+
+TEST(HAGFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.hag"));
+    EXPECT_TRUE(filter);
+}
+
+// The nearest ground point is at the lower-left corner of each cell.
+TEST(HAGFilterTest, nearest)
+{
+    PointTable t;
+    check(*hag(t, "nearest", 4), 5 + .3 * .2 + .2 * .2, 1e-9);
+}
+
+// A TIN of a plane is exact.
+TEST(HAGFilterTest, tin)
+{
+    PointTable t;
+    check(*hag(t, "tin", 4), 5, 1e-9);
+}
+
+// DEM cell centers are offset by half a cell from the ground points.
+TEST(HAGFilterTest, dem)
+{
+    PointTable t;
+    check(*hag(t, "dem", 4), 5, .25 + 1e-9);
+}
+
+TEST(HAGFilterTest, threads)
+{
+    using namespace Dimension;
+
+    PointTable t1;
+    PointTable t2;
+    PointViewPtr v1 = hag(t1, "tin", 1);
+    PointViewPtr v2 = hag(t2, "tin", 4);
+    ASSERT_EQ(v1->size(), v2->size());
+    for (PointId i = 0; i < v1->size(); ++i)
+        EXPECT_EQ(v1->getFieldAs<double>(Id::HeightAboveGround, i),
+            v2->getFieldAs<double>(Id::HeightAboveGround, i));
+}
+
+TEST(HAGFilterTest, badMethod)
+{
+    PointTable t;
+    Options o;
+    o.add("method", "spline");
+    HAGFilter f;
+    f.setOptions(o);
+    EXPECT_THROW(f.prepare(t), pdal_error);
+}
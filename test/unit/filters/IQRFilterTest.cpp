@@ -0,0 +1,280 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <filters/IQRFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <io/BufferReader.hpp>
+#include <io/FauxReader.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace pdal;
+
+namespace
+{
+
+// Fences as computed by sorting the values.
+void fences(std::vector<double> vals, double k, double& low, double& high)
+{
+    std::sort(vals.begin(), vals.end());
+    double pc25 = vals[size_t(vals.size() * 0.25)];
+    double pc75 = vals[size_t(vals.size() * 0.75)];
+    low = pc25 - k * (pc75 - pc25);
+    high = pc75 + k * (pc75 - pc25);
+}
+
+} // unnamed namespace
+
+TEST(IQRFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.iqr"));
+    EXPECT_TRUE(filter);
+}
+
+// Enough points, with distant outliers, that the quartiles are found with
+// several histogram scans.
+TEST(IQRFilterTest, standard)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    std::vector<double> vals;
+    for (PointId i = 0; i < 1500000; ++i)
+    {
+        double z = (i % 1000) ? std::fmod(i * 7.31, 100) : 1e6 + i;
+        view->setField(Dimension::Id::Z, i, z);
+        vals.push_back(z);
+    }
+    BufferReader r;
+    r.addView(view);
+
+    Options o;
+    o.add("dimension", "Z");
+    o.add("threads", 4);
+    IQRFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(table);
+    PointViewSet s = f.execute(table);
+    PointViewPtr out = *s.begin();
+
+    double low, high;
+    fences(vals, 1.5, low, high);
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [low, high](double v){ return v > low && v < high; });
+    EXPECT_EQ(out->size(), expected);
+    EXPECT_LT(out->size(), view->size());
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double z = out->getFieldAs<double>(Dimension::Id::Z, i);
+        EXPECT_GT(z, low);
+        EXPECT_LT(z, high);
+    }
+}
+
+// NaN values are ignored when finding the quartiles, and their points are
+// dropped.
+TEST(IQRFilterTest, nan)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    std::vector<double> vals;
+    for (PointId i = 0; i < 1500000; ++i)
+    {
+        double z = std::numeric_limits<double>::quiet_NaN();
+        if (i % 10)
+        {
+            z = (i % 1000 == 1) ? 1e6 + i : std::fmod(i * 7.31, 100);
+            vals.push_back(z);
+        }
+        view->setField(Dimension::Id::Z, i, z);
+    }
+    BufferReader r;
+    r.addView(view);
+
+    Options o;
+    o.add("dimension", "Z");
+    o.add("k", 0.1);
+    o.add("threads", 4);
+    IQRFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(table);
+    PointViewSet s = f.execute(table);
+    PointViewPtr out = *s.begin();
+
+    double low, high;
+    fences(vals, 0.1, low, high);
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [low, high](double v){ return v > low && v < high; });
+    EXPECT_EQ(out->size(), expected);
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double z = out->getFieldAs<double>(Dimension::Id::Z, i);
+        EXPECT_GT(z, low);
+        EXPECT_LT(z, high);
+    }
+}
+
+// Stream more points than fit in the memory limit so that points are
+// written to a temporary file.
+TEST(IQRFilterTest, stream)
+{
+    Options ro;
+    ro.add("mode", "random");
+    ro.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro.add("count", 100000);
+    FauxReader r;
+    r.setOptions(ro);
+
+    std::vector<double> vals;
+    StreamCallbackFilter in;
+    in.setCallback([&vals](PointRef& point)
+    {
+        vals.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    in.setInput(r);
+
+    Options fo;
+    fo.add("dimension", "Z");
+    fo.add("k", 0.5);
+    fo.add("memory_limit", 1);
+    IQRFilter f;
+    f.setOptions(fo);
+    f.setInput(in);
+
+    std::vector<double> kept;
+    StreamCallbackFilter out;
+    out.setCallback([&kept](PointRef& point)
+    {
+        kept.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    out.setInput(f);
+
+    FixedPointTable t(1000);
+    out.prepare(t);
+    out.execute(t);
+
+    ASSERT_EQ(vals.size(), 100000u);
+    double low, high;
+    fences(vals, 0.5, low, high);
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [low, high](double v){ return v > low && v < high; });
+    EXPECT_EQ(kept.size(), expected);
+    EXPECT_LT(kept.size(), vals.size());
+    for (double z : kept)
+    {
+        EXPECT_GT(z, low);
+        EXPECT_LT(z, high);
+    }
+}
+
+// The quartiles are those of the points from all inputs together.  The
+// second input holds outliers that the quartiles of its own points
+// alone would keep.
+TEST(IQRFilterTest, streamTwoInputs)
+{
+    Options ro1;
+    ro1.add("mode", "ramp");
+    ro1.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro1.add("count", 1000);
+    FauxReader r1;
+    r1.setOptions(ro1);
+
+    Options ro2;
+    ro2.add("mode", "ramp");
+    ro2.add("bounds", BOX3D(0, 0, 10000, 1000, 1000, 10100));
+    ro2.add("count", 100);
+    FauxReader r2;
+    r2.setOptions(ro2);
+
+    std::vector<double> vals;
+    auto collect = [&vals](PointRef& point)
+    {
+        vals.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    };
+    StreamCallbackFilter in1;
+    in1.setCallback(collect);
+    in1.setInput(r1);
+    StreamCallbackFilter in2;
+    in2.setCallback(collect);
+    in2.setInput(r2);
+
+    Options fo;
+    fo.add("dimension", "Z");
+    IQRFilter f;
+    f.setOptions(fo);
+    f.setInput(in1);
+    f.setInput(in2);
+
+    std::vector<double> kept;
+    StreamCallbackFilter out;
+    out.setCallback([&kept](PointRef& point)
+    {
+        kept.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    out.setInput(f);
+
+    FixedPointTable t(100);
+    out.prepare(t);
+    out.execute(t);
+
+    ASSERT_EQ(vals.size(), 1100u);
+    double low, high;
+    fences(vals, 1.5, low, high);
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [low, high](double v){ return v > low && v < high; });
+    EXPECT_EQ(kept.size(), expected);
+    for (double z : kept)
+    {
+        EXPECT_GT(z, low);
+        EXPECT_LT(z, high);
+        EXPECT_LT(z, 10000);
+    }
+}
@@ -0,0 +1,234 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <filters/MADFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <io/BufferReader.hpp>
+#include <io/FauxReader.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace pdal;
+
+namespace
+{
+
+// Median and MAD as computed by sorting the values.
+void mad(std::vector<double> vals, double& median, double& mad)
+{
+    std::sort(vals.begin(), vals.end());
+    median = vals[vals.size() / 2];
+    for (double& v : vals)
+        v = std::fabs(v - median);
+    std::sort(vals.begin(), vals.end());
+    mad = vals[vals.size() / 2] * 1.4862;
+}
+
+} // unnamed namespace
+
+TEST(MADFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.mad"));
+    EXPECT_TRUE(filter);
+}
+
+// Enough points, with distant outliers, that the median and MAD are found
+// with several histogram scans.
+TEST(MADFilterTest, standard)
+{
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    PointViewPtr view(new PointView(table));
+    std::vector<double> vals;
+    for (PointId i = 0; i < 1500000; ++i)
+    {
+        double z = (i % 1000) ? std::fmod(i * 7.31, 100) : 1e6 + i;
+        view->setField(Dimension::Id::Z, i, z);
+        vals.push_back(z);
+    }
+    BufferReader r;
+    r.addView(view);
+
+    Options o;
+    o.add("dimension", "Z");
+    o.add("threads", 4);
+    MADFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(table);
+    PointViewSet s = f.execute(table);
+    PointViewPtr out = *s.begin();
+
+    double median, m;
+    mad(vals, median, m);
+    double low = median - 2.0 * m;
+    double high = median + 2.0 * m;
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [median, m](double v){ return std::fabs(v - median) / m < 2.0; });
+    EXPECT_EQ(out->size(), expected);
+    EXPECT_LT(out->size(), view->size());
+    for (PointId i = 0; i < out->size(); ++i)
+    {
+        double z = out->getFieldAs<double>(Dimension::Id::Z, i);
+        EXPECT_GE(z, low);
+        EXPECT_LE(z, high);
+    }
+}
+
+// Stream more points than fit in the memory limit so that points are
+// written to a temporary file.
+TEST(MADFilterTest, stream)
+{
+    Options ro;
+    ro.add("mode", "random");
+    ro.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro.add("count", 100000);
+    FauxReader r;
+    r.setOptions(ro);
+
+    std::vector<double> vals;
+    StreamCallbackFilter in;
+    in.setCallback([&vals](PointRef& point)
+    {
+        vals.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    in.setInput(r);
+
+    Options fo;
+    fo.add("dimension", "Z");
+    fo.add("k", 0.5);
+    fo.add("memory_limit", 1);
+    MADFilter f;
+    f.setOptions(fo);
+    f.setInput(in);
+
+    std::vector<double> kept;
+    StreamCallbackFilter out;
+    out.setCallback([&kept](PointRef& point)
+    {
+        kept.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    out.setInput(f);
+
+    FixedPointTable t(1000);
+    out.prepare(t);
+    out.execute(t);
+
+    ASSERT_EQ(vals.size(), 100000u);
+    double median, m;
+    mad(vals, median, m);
+    double low = median - 0.5 * m;
+    double high = median + 0.5 * m;
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [median, m](double v){ return std::fabs(v - median) / m < 0.5; });
+    EXPECT_EQ(kept.size(), expected);
+    EXPECT_LT(kept.size(), vals.size());
+    for (double z : kept)
+    {
+        EXPECT_GE(z, low);
+        EXPECT_LE(z, high);
+    }
+}
+
+// The median and MAD are those of the points from all inputs together.
+// The second input holds outliers that the MAD of its own points alone
+// would keep.
+TEST(MADFilterTest, streamTwoInputs)
+{
+    Options ro1;
+    ro1.add("mode", "ramp");
+    ro1.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro1.add("count", 1000);
+    FauxReader r1;
+    r1.setOptions(ro1);
+
+    Options ro2;
+    ro2.add("mode", "ramp");
+    ro2.add("bounds", BOX3D(0, 0, 10000, 1000, 1000, 10100));
+    ro2.add("count", 100);
+    FauxReader r2;
+    r2.setOptions(ro2);
+
+    std::vector<double> vals;
+    auto collect = [&vals](PointRef& point)
+    {
+        vals.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    };
+    StreamCallbackFilter in1;
+    in1.setCallback(collect);
+    in1.setInput(r1);
+    StreamCallbackFilter in2;
+    in2.setCallback(collect);
+    in2.setInput(r2);
+
+    Options fo;
+    fo.add("dimension", "Z");
+    MADFilter f;
+    f.setOptions(fo);
+    f.setInput(in1);
+    f.setInput(in2);
+
+    std::vector<double> kept;
+    StreamCallbackFilter out;
+    out.setCallback([&kept](PointRef& point)
+    {
+        kept.push_back(point.getFieldAs<double>(Dimension::Id::Z));
+        return true;
+    });
+    out.setInput(f);
+
+    FixedPointTable t(100);
+    out.prepare(t);
+    out.execute(t);
+
+    ASSERT_EQ(vals.size(), 1100u);
+    double median, m;
+    mad(vals, median, m);
+    point_count_t expected = std::count_if(vals.begin(), vals.end(),
+        [median, m](double v){ return std::fabs(v - median) / m < 2.0; });
+    EXPECT_EQ(kept.size(), expected);
+    for (double z : kept)
+        EXPECT_LT(z, 10000);
+}
@@ -0,0 +1,199 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc. (hobu@hobu.co)
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <io/BufferReader.hpp>
+#include <io/FauxReader.hpp>
+#include <filters/MortonOrderFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Order a 4x4 grid of points.  The table must outlive the returned view.
+PointViewPtr orderGrid(PointTable& table, Options opts)
+{
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+
+    BufferReader r;
+    MortonOrderFilter filter;
+    filter.setOptions(opts);
+    filter.setInput(r);
+
+    // Prepare before adding points, since the filter may add a dimension.
+    filter.prepare(table);
+
+    PointViewPtr view(new PointView(table));
+    PointId idx = 0;
+    for (int x = 3; x >= 0; --x)
+        for (int y = 3; y >= 0; --y)
+        {
+            view->setField(Dimension::Id::X, idx, x);
+            view->setField(Dimension::Id::Y, idx, y);
+            view->setField(Dimension::Id::Z, idx, 0);
+            idx++;
+        }
+    r.addView(view);
+
+    PointViewSet viewSet = filter.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+} // unnamed namespace
+
+TEST(MortonOrderFilterTest, morton)
+{
+    Options opts;
+    opts.add("code_dimension", "Code");
+    PointTable table;
+    PointViewPtr view = orderGrid(table, opts);
+
+    EXPECT_EQ(view->size(), 16u);
+
+    // X takes the more significant bit of each pair.
+    int expected[][2] = { {0, 0}, {0, 1}, {1, 0}, {1, 1}, {0, 2}, {0, 3} };
+    for (PointId i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::X, i), expected[i][0]);
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Y, i), expected[i][1]);
+    }
+
+    Dimension::Id code = view->layout()->findDim("Code");
+    EXPECT_EQ(view->dimType(code), Dimension::Type::Unsigned64);
+    // Codes near 2^64 don't survive conversion through double, so compare
+    // the raw values.
+    for (PointId i = 1; i < view->size(); ++i)
+    {
+        uint64_t prev, cur;
+        view->getRawField(code, i - 1, &prev);
+        view->getRawField(code, i, &cur);
+        EXPECT_LT(prev, cur);
+    }
+}
+
+TEST(MortonOrderFilterTest, hilbert)
+{
+    Options opts;
+    opts.add("curve", "hilbert");
+    PointTable table;
+    PointViewPtr view = orderGrid(table, opts);
+
+    EXPECT_EQ(view->size(), 16u);
+
+    // Each point on a Hilbert curve is a neighbor of the previous one.
+    for (PointId i = 1; i < view->size(); ++i)
+    {
+        int dx = view->getFieldAs<int>(Dimension::Id::X, i) -
+            view->getFieldAs<int>(Dimension::Id::X, i - 1);
+        int dy = view->getFieldAs<int>(Dimension::Id::Y, i) -
+            view->getFieldAs<int>(Dimension::Id::Y, i - 1);
+        EXPECT_EQ(std::abs(dx) + std::abs(dy), 1);
+    }
+}
+
+TEST(MortonOrderFilterTest, badCurve)
+{
+    Options opts;
+    opts.add("curve", "peano");
+
+    MortonOrderFilter filter;
+    filter.setOptions(opts);
+
+    PointTable table;
+    EXPECT_THROW(filter.prepare(table), pdal_error);
+}
+
+TEST(MortonOrderFilterTest, streaming)
+{
+    Options ro;
+    ro.add("mode", "random");
+    ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+    ro.add("count", 50000);
+
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options fo;
+    fo.add("code_dimension", "Code");
+    fo.add("bounds", BOX3D(0, 0, 0, 100, 100, 100));
+    fo.add("memory_limit", 1);
+
+    MortonOrderFilter f;
+    f.setOptions(fo);
+    f.setInput(r);
+
+    point_count_t count = 0;
+    uint64_t lastCode = 0;
+    Dimension::Id code = Dimension::Id::Unknown;
+    auto cb = [&](PointRef& point)
+    {
+        uint64_t c;
+        point.getField((char *)&c, code, Dimension::Type::Unsigned64);
+        EXPECT_LE(lastCode, c);
+        lastCode = c;
+        count++;
+        return true;
+    };
+
+    StreamCallbackFilter c;
+    c.setCallback(cb);
+    c.setInput(f);
+
+    FixedPointTable t(1000);
+    c.prepare(t);
+    code = t.layout()->findDim("Code");
+    c.execute(t);
+    EXPECT_EQ(count, 50000u);
+}
+
+TEST(MortonOrderFilterTest, streamingNoBounds)
+{
+    FauxReader r;
+    Options ro;
+    ro.add("count", 10);
+    r.setOptions(ro);
+
+    MortonOrderFilter f;
+    f.setInput(r);
+
+    FixedPointTable t(10);
+    f.prepare(t);
+    EXPECT_THROW(f.execute(t), pdal_error);
+}
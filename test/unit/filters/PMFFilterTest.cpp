@@ -0,0 +1,210 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <io/BufferReader.hpp>
+#include <filters/PMFFilter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Jittered points over gently rolling ground, with a few flat-roofed
+// "buildings" standing on it.
+void fill(PointView& v, int cols, int rows)
+{
+    using namespace Dimension;
+
+    PointId id = 0;
+    for (int i = 0; i < cols; ++i)
+        for (int j = 0; j < rows; ++j)
+        {
+            double x = i + 0.3 * std::sin(i * 7.0 + j * 3.0);
+            double y = j + 0.3 * std::cos(i * 5.0 + j * 11.0);
+            double z = 2 * std::sin(x / 15) + 0.05 * std::sin(x * y);
+            if ((i % 40 > 10 && i % 40 < 18) && (j % 30 > 5 && j % 30 < 12))
+                z += 8;
+            v.setField(Id::X, id, x);
+            v.setField(Id::Y, id, y);
+            v.setField(Id::Z, id, z);
+            id++;
+        }
+}
+
+std::vector<int> pmf(int cols, int rows, Options o)
+{
+    using namespace Dimension;
+
+    PointTable t;
+    t.layout()->registerDim(Id::X);
+    t.layout()->registerDim(Id::Y);
+    t.layout()->registerDim(Id::Z);
+
+    PointViewPtr input(new PointView(t));
+    BufferReader r;
+    r.addView(input);
+
+    PMFFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(t);
+    fill(*input, cols, rows);
+
+    PointViewSet s = f.execute(t);
+    EXPECT_EQ(s.size(), 1u);
+    PointViewPtr v = *s.begin();
+
+    std::vector<int> classes;
+    for (PointId i = 0; i < v->size(); ++i)
+        classes.push_back(v->getFieldAs<int>(Id::Classification, i));
+    return classes;
+}
+
+// The progressive morphological filter, testing every pair of points.
+std::vector<int> bruteForce(int cols, int rows)
+{
+    using namespace Dimension;
+
+    PointTable t;
+    t.layout()->registerDim(Id::X);
+    t.layout()->registerDim(Id::Y);
+    t.layout()->registerDim(Id::Z);
+    PointView v(t);
+    fill(v, cols, rows);
+
+    const size_t n = v.size();
+    std::vector<double> x(n), y(n), z(n);
+    for (PointId i = 0; i < n; ++i)
+    {
+        x[i] = v.getFieldAs<double>(Id::X, i);
+        y[i] = v.getFieldAs<double>(Id::Y, i);
+        z[i] = v.getFieldAs<double>(Id::Z, i);
+    }
+
+    // Default options.
+    std::vector<float> windows { 3, 5, 9, 17, 33 };
+    std::vector<char> ground(n, 1);
+    float prev = 0;
+    for (float ws : windows)
+    {
+        float ht = (prev == 0) ? 0.15 : (std::min)(ws - prev + 0.15, 2.5);
+        prev = ws;
+        float r = ws * 0.5;
+
+        auto inside = [&](size_t i, size_t j)
+        {
+            return ground[j] && x[j] >= x[i] - r && x[j] < x[i] + r &&
+                y[j] >= y[i] - r && y[j] < y[i] + r;
+        };
+
+        std::vector<double> minZ(n), maxZ(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            minZ[i] = (std::numeric_limits<double>::max)();
+            for (size_t j = 0; j < n; ++j)
+                if (inside(i, j))
+                    minZ[i] = (std::min)(minZ[i], z[j]);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            maxZ[i] = (std::numeric_limits<double>::lowest)();
+            for (size_t j = 0; j < n; ++j)
+                if (inside(i, j))
+                    maxZ[i] = (std::max)(maxZ[i], minZ[j]);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            float diff = z[i] - maxZ[i];
+            if (ground[i] && !(diff < ht))
+                ground[i] = 0;
+        }
+    }
+
+    std::vector<int> classes;
+    for (size_t i = 0; i < n; ++i)
+        classes.push_back(ground[i] ? 2 : 1);
+    return classes;
+}
+
+} // unnamed namespace
+
+TEST(PMFFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.pmf"));
+    EXPECT_TRUE(filter);
+}
+
+TEST(PMFFilterTest, exact)
+{
+    const int cols = 70;
+    const int rows = 40;
+
+    std::vector<int> expected = bruteForce(cols, rows);
+    size_t ground = std::count(expected.begin(), expected.end(), 2);
+    EXPECT_GT(ground, expected.size() / 2);
+    EXPECT_LT(ground, expected.size());
+
+    EXPECT_EQ(pmf(cols, rows, Options()), expected);
+}
+
+TEST(PMFFilterTest, threads)
+{
+    // Wide enough that the points and the raster are split among threads.
+    const int cols = 400;
+    const int rows = 30;
+
+    for (bool approximate : { false, true })
+    {
+        Options o;
+        o.add("approximate", approximate);
+        o.add("threads", 1);
+        std::vector<int> serial = pmf(cols, rows, o);
+
+        size_t ground = std::count(serial.begin(), serial.end(), 2);
+        EXPECT_GT(ground, serial.size() / 2);
+        EXPECT_LT(ground, serial.size());
+
+        o.replace("threads", 4);
+        EXPECT_EQ(pmf(cols, rows, o), serial);
+    }
+}
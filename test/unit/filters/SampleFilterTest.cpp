@@ -0,0 +1,139 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <io/BufferReader.hpp>
+#include <filters/SampleFilter.hpp>
+
+#include <cmath>
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr sample(PointTable& t, uint32_t seed, uint32_t threads,
+    PointViewPtr& input)
+{
+    t.layout()->registerDim(Dimension::Id::X);
+    t.layout()->registerDim(Dimension::Id::Y);
+    t.layout()->registerDim(Dimension::Id::Z);
+
+    input.reset(new PointView(t));
+    BufferReader r;
+    r.addView(input);
+
+    Options o;
+    o.add("radius", 2.0);
+    o.add("seed", seed);
+    o.add("threads", threads);
+    SampleFilter f;
+    f.setOptions(o);
+    f.setInput(r);
+    f.prepare(t);
+
+    // Scattered, but repeatable, points in a 50 x 50 x 10 box.
+    for (PointId i = 0; i < 5000; ++i)
+    {
+        input->setField(Dimension::Id::X, i, std::fmod(i * 61.803, 50));
+        input->setField(Dimension::Id::Y, i, std::fmod(i * 41.421, 50));
+        input->setField(Dimension::Id::Z, i, std::fmod(i * 7.3205, 10));
+    }
+
+    PointViewSet s = f.execute(t);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+double sqrDist(const PointView& v1, PointId i1, const PointView& v2,
+    PointId i2)
+{
+    using namespace Dimension;
+
+    double dx = v1.getFieldAs<double>(Id::X, i1) -
+        v2.getFieldAs<double>(Id::X, i2);
+    double dy = v1.getFieldAs<double>(Id::Y, i1) -
+        v2.getFieldAs<double>(Id::Y, i2);
+    double dz = v1.getFieldAs<double>(Id::Z, i1) -
+        v2.getFieldAs<double>(Id::Z, i2);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+} // unnamed namespace
+
+TEST(SampleFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.sample"));
+    EXPECT_TRUE(filter);
+}
+
+// No two samples are within the radius, and every input point is within
+// the radius of a sample.
+TEST(SampleFilterTest, spacing)
+{
+    PointTable t;
+    PointViewPtr input;
+    PointViewPtr v = sample(t, 1234, 4, input);
+    EXPECT_GT(v->size(), 100u);
+    EXPECT_LT(v->size(), input->size());
+
+    for (PointId i = 0; i < v->size(); ++i)
+        for (PointId j = i + 1; j < v->size(); ++j)
+            EXPECT_GT(sqrDist(*v, i, *v, j), 4.0);
+
+    for (PointId i = 0; i < input->size(); ++i)
+    {
+        bool covered = false;
+        for (PointId j = 0; !covered && j < v->size(); ++j)
+            covered = sqrDist(*input, i, *v, j) <= 4.0;
+        EXPECT_TRUE(covered);
+    }
+}
+
+TEST(SampleFilterTest, repeatable)
+{
+    PointTable t1;
+    PointTable t2;
+    PointViewPtr input;
+    PointViewPtr v1 = sample(t1, 1234, 1, input);
+    PointViewPtr v2 = sample(t2, 1234, 4, input);
+
+    ASSERT_EQ(v1->size(), v2->size());
+    for (PointId i = 0; i < v1->size(); ++i)
+        EXPECT_EQ(sqrDist(*v1, i, *v2, i), 0.0);
+}
@@ -38,9 +38,12 @@
 
 #include <pdal/PipelineManager.hpp>
 #include <pdal/StageWrapper.hpp>
+#include <io/FauxReader.hpp>
 #include <io/LasReader.hpp>
 #include <io/LasWriter.hpp>
 #include <filters/SortFilter.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <filters/private/ExternalSort.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -169,3 +172,220 @@ TEST(SortFilterTest, issue1121_simpleSortOrderDesc)
     }
 }
 
+
+TEST(SortFilterTest, multipleDimensions)
+{
+    Options opts;
+    opts.add("dimension", "Classification, X, Y");
+    opts.add("order", "ASC, DESC, ASC");
+
+    SortFilter filter;
+    filter.setOptions(opts);
+
+    PointTable table;
+    PointViewPtr view(new PointView(table));
+
+    table.layout()->registerDim(Dimension::Id::Classification);
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+
+    std::default_random_engine generator;
+    std::uniform_int_distribution<int> classDist(0, 5);
+    std::uniform_int_distribution<int> xDist(-10, 10);
+    std::uniform_real_distribution<double> yDist(-100.0, 100.0);
+
+    point_count_t count = 200000;
+    for (PointId i = 0; i < count; ++i)
+    {
+        view->setField(Dimension::Id::Classification, i,
+            classDist(generator));
+        view->setField(Dimension::Id::X, i, xDist(generator));
+        view->setField(Dimension::Id::Y, i, yDist(generator));
+    }
+
+    filter.prepare(table);
+    FilterWrapper::ready(filter, table);
+    FilterWrapper::filter(filter, *view.get());
+    FilterWrapper::done(filter, table);
+
+    EXPECT_EQ(count, view->size());
+    for (PointId i = 1; i < count; ++i)
+    {
+        int c1 = view->getFieldAs<int>(Dimension::Id::Classification, i - 1);
+        int c2 = view->getFieldAs<int>(Dimension::Id::Classification, i);
+        double x1 = view->getFieldAs<double>(Dimension::Id::X, i - 1);
+        double x2 = view->getFieldAs<double>(Dimension::Id::X, i);
+        double y1 = view->getFieldAs<double>(Dimension::Id::Y, i - 1);
+        double y2 = view->getFieldAs<double>(Dimension::Id::Y, i);
+
+        EXPECT_LE(c1, c2);
+        if (c1 == c2)
+        {
+            EXPECT_GE(x1, x2);
+            if (x1 == x2)
+            {
+                EXPECT_LE(y1, y2);
+            }
+        }
+    }
+}
+
+TEST(SortFilterTest, badOrderCount)
+{
+    Options opts;
+    opts.add("dimension", "X, Y");
+    opts.add("order", "ASC, DESC, ASC");
+
+    SortFilter filter;
+    filter.setOptions(opts);
+
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    EXPECT_THROW(filter.prepare(table), pdal_error);
+}
+
+// Sort more points than fit in the memory limit so that runs are written
+// to temporary files and merged.
+TEST(SortFilterTest, streaming)
+{
+    Options ro;
+    ro.add("mode", "random");
+    ro.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro.add("count", 100000);
+
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options fo;
+    fo.add("dimension", "Z, X");
+    fo.add("order", "DESC, ASC");
+    fo.add("memory_limit", 1);
+
+    SortFilter f;
+    f.setOptions(fo);
+    f.setInput(r);
+
+    point_count_t count = 0;
+    double lastX = 0;
+    double lastZ = 0;
+    auto cb = [&](PointRef& point)
+    {
+        double x = point.getFieldAs<double>(Dimension::Id::X);
+        double z = point.getFieldAs<double>(Dimension::Id::Z);
+        if (count)
+        {
+            EXPECT_GE(lastZ, z);
+            if (lastZ == z)
+            {
+                EXPECT_LE(lastX, x);
+            }
+        }
+        lastX = x;
+        lastZ = z;
+        count++;
+        return true;
+    };
+
+    StreamCallbackFilter c;
+    c.setCallback(cb);
+    c.setInput(f);
+
+    FixedPointTable t(1000);
+    c.prepare(t);
+    c.execute(t);
+    EXPECT_EQ(count, 100000u);
+}
+
+// Points from all inputs must be sorted together, not an input at a time.
+TEST(SortFilterTest, streamingTwoInputs)
+{
+    Options ro;
+    ro.add("mode", "random");
+    ro.add("bounds", BOX3D(0, 0, 0, 1000, 1000, 1000));
+    ro.add("count", 1000);
+
+    FauxReader r1;
+    r1.setOptions(ro);
+    FauxReader r2;
+    r2.setOptions(ro);
+
+    Options fo;
+    fo.add("dimension", "X");
+
+    SortFilter f;
+    f.setOptions(fo);
+    f.setInput(r1);
+    f.setInput(r2);
+
+    point_count_t count = 0;
+    double lastX = 0;
+    auto cb = [&](PointRef& point)
+    {
+        double x = point.getFieldAs<double>(Dimension::Id::X);
+        if (count)
+        {
+            EXPECT_LE(lastX, x);
+        }
+        lastX = x;
+        count++;
+        return true;
+    };
+
+    StreamCallbackFilter c;
+    c.setCallback(cb);
+    c.setInput(f);
+
+    FixedPointTable t(100);
+    c.prepare(t);
+    c.execute(t);
+    EXPECT_EQ(count, 2000u);
+}
+
+// A tiny memory limit makes a run of every few points.  The runs must be
+// merged as they accumulate so that the number of temporary files stays
+// bounded, and points with equal keys must keep their insertion order.
+TEST(SortFilterTest, manyRuns)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    table.layout()->registerDim(Id::X);
+    table.finalize();
+    PointView in(table);
+    PointView out(table);
+
+    const point_count_t count = 10000;
+    DimTypeList dims { DimType(Id::X, Type::Double) };
+    ExternalSorter sorter(dims, 1, 10 * (sizeof(uint64_t) + sizeof(double)));
+    for (PointId i = 0; i < count; ++i)
+    {
+        in.setField(Id::X, i, i);
+        uint64_t key = (count - i) % 100;
+        sorter.add(&key, in.point(i));
+        EXPECT_LT(sorter.numRuns(), ExternalSorter::MaxRuns);
+    }
+
+    for (PointId i = 0; i < count; ++i)
+    {
+        out.setField(Id::X, i, 0);
+        PointRef point(out.point(i));
+        EXPECT_TRUE(sorter.next(point));
+    }
+    out.setField(Id::X, count, 0);
+    PointRef extra(out.point(count));
+    EXPECT_FALSE(sorter.next(extra));
+
+    for (PointId i = 1; i < count; ++i)
+    {
+        PointId x1 = out.getFieldAs<PointId>(Id::X, i - 1);
+        PointId x2 = out.getFieldAs<PointId>(Id::X, i);
+        uint64_t k1 = (count - x1) % 100;
+        uint64_t k2 = (count - x2) % 100;
+        EXPECT_LE(k1, k2);
+        if (k1 == k2)
+        {
+            EXPECT_LT(x1, x2);
+        }
+    }
+}
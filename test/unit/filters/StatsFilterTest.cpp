@@ -37,6 +37,7 @@
 #include <pdal/PDALUtils.hpp>
 #include <pdal/StageFactory.hpp>
 #include <filters/StatsFilter.hpp>
+#include <io/BufferReader.hpp>
 #include <io/FauxReader.hpp>
 
 #include "Support.hpp"
@@ -131,6 +132,54 @@ TEST(Stats, stream)
 }
 
 
+TEST(Stats, moments)
+{
+    // Deviations from the mean of 5 are -3, -1, -1, -1, 0, 0, 2, 4, so
+    // the second, third and fourth central sums are 32, 42 and 356.
+    std::vector<double> values { 2, 4, 4, 4, 5, 5, 7, 9 };
+    const double variance = 32.0 / 7.0;
+    const double skewness = std::sqrt(8.0) * 42.0 / std::pow(32.0, 1.5);
+    const double kurtosis = 8.0 * 356.0 / (32.0 * 32.0) - 3.0;
+
+    auto check = [&](const stats::Summary& s)
+    {
+        EXPECT_EQ(s.count(), values.size());
+        EXPECT_DOUBLE_EQ(s.average(), 5.0);
+        EXPECT_DOUBLE_EQ(s.variance(), variance);
+        EXPECT_DOUBLE_EQ(s.skewness(), skewness);
+        EXPECT_DOUBLE_EQ(s.kurtosis(), kurtosis);
+    };
+
+    // One value at a time, as in streaming mode.
+    stats::Summary streamed("X", stats::Summary::NoEnum);
+    for (double v : values)
+        streamed.insert(v);
+    check(streamed);
+
+    // A block at a time, as in standard mode.
+    PointTable table;
+    table.layout()->registerDim(Dimension::Id::X);
+    table.layout()->registerDim(Dimension::Id::Y);
+    table.layout()->registerDim(Dimension::Id::Z);
+    PointViewPtr view(new PointView(table));
+    for (PointId i = 0; i < values.size(); ++i)
+    {
+        view->setField(Dimension::Id::X, i, values[i]);
+        view->setField(Dimension::Id::Y, i, 0);
+        view->setField(Dimension::Id::Z, i, 0);
+    }
+
+    BufferReader reader;
+    reader.addView(view);
+
+    StatsFilter filter;
+    filter.setInput(reader);
+    filter.prepare(table);
+    filter.execute(table);
+    check(filter.getStats(Dimension::Id::X));
+}
+
+
 TEST(Stats, dimset)
 {
     BOX3D bounds(1.0, 2.0, 3.0, 101.0, 102.0, 103.0);
@@ -304,3 +353,59 @@ TEST(Stats, global)
 	EXPECT_DOUBLE_EQ(statsZ.maximum(), 1000.0);
 
 }
+
+TEST(Stats, threads)
+{
+    BOX3D bounds(0.0, 0.0, 0.0, 1000.0, 1000.0, 1000.0);
+    Options ops;
+    ops.add("bounds", bounds);
+    ops.add("count", 300000);
+    ops.add("mode", "random");
+
+    FauxReader reader;
+    reader.setOptions(ops);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    PointViewPtr view = *viewSet.begin();
+
+    // Run the same points through the filter serially and in parallel.
+    auto run = [&table, &view](StatsFilter& filter, int threads)
+    {
+        BufferReader r;
+        r.addView(view);
+
+        Options filterOps;
+        filterOps.add("threads", threads);
+        filterOps.add("global", "Z");
+
+        filter.setInput(r);
+        filter.setOptions(filterOps);
+        filter.prepare(table);
+        filter.execute(table);
+    };
+
+    StatsFilter serial;
+    run(serial, 1);
+    StatsFilter parallel;
+    run(parallel, 4);
+
+    for (Dimension::Id dim : { Dimension::Id::X, Dimension::Id::Y,
+        Dimension::Id::Z })
+    {
+        const stats::Summary& s1 = serial.getStats(dim);
+        const stats::Summary& s4 = parallel.getStats(dim);
+
+        EXPECT_EQ(s1.count(), 300000u);
+        EXPECT_EQ(s1.count(), s4.count());
+        EXPECT_DOUBLE_EQ(s1.minimum(), s4.minimum());
+        EXPECT_DOUBLE_EQ(s1.maximum(), s4.maximum());
+        EXPECT_NEAR(s1.average(), s4.average(), 1e-9);
+        EXPECT_NEAR(s1.stddev(), s4.stddev(), 1e-9);
+        EXPECT_NEAR(s1.skewness(), s4.skewness(), 1e-9);
+        EXPECT_NEAR(s1.kurtosis(), s4.kurtosis(), 1e-9);
+    }
+    EXPECT_DOUBLE_EQ(serial.getStats(Dimension::Id::Z).median(),
+        parallel.getStats(Dimension::Id::Z).median());
+}
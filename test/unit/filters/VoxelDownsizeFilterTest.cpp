@@ -0,0 +1,202 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <cmath>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <io/BufferReader.hpp>
+#include <io/FauxReader.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <filters/VoxelDownsizeFilter.hpp>
+
+using namespace pdal;
+
+namespace
+{
+
+// Points 0, 1, ..., 99 along the diagonal: ten points per 10-unit voxel.
+Options rampOptions()
+{
+    Options ops;
+    ops.add("bounds", BOX3D(0, 0, 0, 99, 99, 99));
+    ops.add("mode", "ramp");
+    ops.add("count", 100);
+    return ops;
+}
+
+std::vector<double> expected(const std::string& mode)
+{
+    std::vector<double> xs;
+    for (int i = 0; i < 10; ++i)
+    {
+        if (mode == "first")
+            xs.push_back(i * 10);
+        else if (mode == "center")
+            xs.push_back(i * 10 + 5);
+        else
+            xs.push_back(i * 10 + 4.5);
+    }
+    return xs;
+}
+
+} // unnamed namespace
+
+TEST(VoxelDownsizeFilterTest, create)
+{
+    StageFactory f;
+    Stage* filter(f.createStage("filters.voxeldownsize"));
+    EXPECT_TRUE(filter);
+}
+
+TEST(VoxelDownsizeFilterTest, modes)
+{
+    for (std::string mode : { "first", "center", "centroid" })
+    {
+        FauxReader r;
+        r.setOptions(rampOptions());
+
+        Options fo;
+        fo.add("cell", 10.0);
+        fo.add("mode", mode);
+
+        VoxelDownsizeFilter f;
+        f.setOptions(fo);
+        f.setInput(r);
+
+        PointTable t;
+        f.prepare(t);
+        PointViewSet s = f.execute(t);
+        EXPECT_EQ(s.size(), 1u);
+        PointViewPtr v = *s.begin();
+
+        std::vector<double> xs = expected(mode);
+        ASSERT_EQ(v->size(), xs.size());
+        for (PointId i = 0; i < v->size(); ++i)
+        {
+            EXPECT_DOUBLE_EQ(v->getFieldAs<double>(Dimension::Id::X, i),
+                xs[i]);
+            EXPECT_DOUBLE_EQ(v->getFieldAs<double>(Dimension::Id::Z, i),
+                xs[i]);
+        }
+    }
+}
+
+// Ramp input is spatially ordered, so holding a single voxel at a time
+// gives the same result as standard mode.
+TEST(VoxelDownsizeFilterTest, stream)
+{
+    for (std::string mode : { "first", "center", "centroid" })
+    {
+        FauxReader r;
+        r.setOptions(rampOptions());
+
+        Options fo;
+        fo.add("cell", 10.0);
+        fo.add("mode", mode);
+        fo.add("max_voxels", 1);
+
+        VoxelDownsizeFilter f;
+        f.setOptions(fo);
+        f.setInput(r);
+
+        std::vector<double> xs;
+        auto cb = [&xs](PointRef& point)
+        {
+            xs.push_back(point.getFieldAs<double>(Dimension::Id::X));
+            return true;
+        };
+        StreamCallbackFilter c;
+        c.setCallback(cb);
+        c.setInput(f);
+
+        // A capacity that doesn't divide the voxels evenly.
+        FixedPointTable t(7);
+        c.prepare(t);
+        c.execute(t);
+
+        EXPECT_EQ(xs, expected(mode));
+    }
+}
+
+TEST(VoxelDownsizeFilterTest, threads)
+{
+    auto run = [](const std::string& mode, int threads)
+    {
+        PointTable t;
+        t.layout()->registerDim(Dimension::Id::X);
+        t.layout()->registerDim(Dimension::Id::Y);
+        t.layout()->registerDim(Dimension::Id::Z);
+
+        // Scattered, but repeatable, points in a 100-unit cube.
+        PointViewPtr input(new PointView(t));
+        for (PointId i = 0; i < 200000; ++i)
+        {
+            input->setField(Dimension::Id::X, i, std::fmod(i * 61.803, 100));
+            input->setField(Dimension::Id::Y, i, std::fmod(i * 41.421, 100));
+            input->setField(Dimension::Id::Z, i, std::fmod(i * 73.205, 100));
+        }
+        BufferReader r;
+        r.addView(input);
+
+        Options fo;
+        fo.add("cell", 5.0);
+        fo.add("mode", mode);
+        fo.add("threads", threads);
+        VoxelDownsizeFilter f;
+        f.setOptions(fo);
+        f.setInput(r);
+
+        f.prepare(t);
+        PointViewSet s = f.execute(t);
+        PointViewPtr v = *s.begin();
+
+        std::vector<double> xs;
+        for (PointId i = 0; i < v->size(); ++i)
+            xs.push_back(v->getFieldAs<double>(Dimension::Id::X, i));
+        return xs;
+    };
+
+    for (std::string mode : { "first", "center", "centroid" })
+    {
+        std::vector<double> serial = run(mode, 1);
+        std::vector<double> parallel = run(mode, 4);
+        EXPECT_GT(serial.size(), 1000u);
+        ASSERT_EQ(serial.size(), parallel.size());
+        for (size_t i = 0; i < serial.size(); ++i)
+            EXPECT_NEAR(serial[i], parallel[i], 1e-9);
+    }
+}
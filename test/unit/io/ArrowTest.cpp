@@ -0,0 +1,314 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <fstream>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/portable_endian.hpp>
+#include <filters/StreamCallbackFilter.hpp>
+#include <io/ArrowReader.hpp>
+#include <io/ArrowWriter.hpp>
+#include <io/FauxReader.hpp>
+
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+PointViewPtr readArrow(PointTableRef table, const std::string& filename,
+    const std::string& dims = "")
+{
+    Options options;
+    options.add("filename", filename);
+    if (dims.size())
+        options.add("dimensions", dims);
+
+    ArrowReader reader;
+    reader.setOptions(options);
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    return *viewSet.begin();
+}
+
+// Write faux points to an Arrow file and return the file contents.
+std::string writeFaux(const std::string& filename, bool streaming)
+{
+    FileUtils::deleteFile(filename);
+
+    Options readerOptions;
+    readerOptions.add("count", 1000);
+    readerOptions.add("mode", "ramp");
+    readerOptions.add("bounds", BOX3D(-1000, 0, 1, 1000, 10, 2));
+    readerOptions.add("number_of_returns", 3);
+    FauxReader reader;
+    reader.setOptions(readerOptions);
+
+    Options writerOptions;
+    writerOptions.add("filename", filename);
+    writerOptions.add("batch_size", 300);
+    ArrowWriter writer;
+    writer.setOptions(writerOptions);
+    writer.setInput(reader);
+
+    if (streaming)
+    {
+        FixedPointTable table(128);
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    else
+    {
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    return FileUtils::readFileIntoString(filename);
+}
+
+void writeLe32(std::ostream& out, uint32_t v)
+{
+    v = htole32(v);
+    out.write((const char *)&v, sizeof(v));
+}
+
+// Write an Arrow file with a single double column and one record batch
+// whose length and data buffer are given.
+void writeBatch(const std::string& filename, uint64_t length,
+    const ArrowBuffer& data)
+{
+    ArrowColumn column;
+    column.m_name = "X";
+    column.m_type = Dimension::Type::Double;
+    ArrowColumnList columns { column };
+
+    ArrowRecordBatch batch;
+    batch.m_length = length;
+    batch.m_nodes.emplace_back(length, 0);
+    batch.m_buffers.emplace_back(0, 0);
+    batch.m_buffers.push_back(data);
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out.write(ArrowFormat::Magic, ArrowFormat::PaddedMagicSize);
+    std::vector<char> metadata = ArrowFormat::recordBatchMessage(batch);
+    writeLe32(out, ArrowFormat::Continuation);
+    writeLe32(out, (uint32_t)metadata.size());
+    out.write(metadata.data(), metadata.size());
+
+    ArrowBlockList batches;
+    batches.emplace_back(ArrowFormat::PaddedMagicSize,
+        (int32_t)(8 + metadata.size()), 0);
+    std::vector<char> footer = ArrowFormat::footer(columns,
+        le16toh(1) == 1, batches);
+    out.write(footer.data(), footer.size());
+    writeLe32(out, (uint32_t)footer.size());
+    out.write(ArrowFormat::Magic, ArrowFormat::MagicSize);
+}
+
+} // unnamed namespace
+
+TEST(ArrowTest, create)
+{
+    StageFactory f;
+
+    EXPECT_TRUE(f.createStage("readers.arrow"));
+    EXPECT_TRUE(f.createStage("writers.arrow"));
+    EXPECT_EQ(f.inferReaderDriver("foo.feather"), "readers.arrow");
+    EXPECT_EQ(f.inferWriterDriver("foo.arrow"), "writers.arrow");
+}
+
+// simple.feather was written by pyarrow in three record batches.  It has
+// string and list columns, which are skipped, and a null value.
+TEST(ArrowTest, read)
+{
+    PointTable table;
+    PointViewPtr view = readArrow(table,
+        Support::datapath("arrow/simple.feather"));
+    PointLayoutPtr layout = table.layout();
+
+    EXPECT_EQ(view->size(), 10u);
+    EXPECT_EQ(layout->findDim("Name"), Dimension::Id::Unknown);
+    EXPECT_EQ(layout->findDim("Tags"), Dimension::Id::Unknown);
+    EXPECT_EQ(layout->dimType(Dimension::Id::Z), Dimension::Type::Float);
+    EXPECT_EQ(layout->dimType(Dimension::Id::PointSourceId),
+        Dimension::Type::Signed64);
+    for (PointId i = 0; i < 10; ++i)
+    {
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, i),
+            i * 1.5);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Y, i),
+            i * -.25);
+        EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::Z, i),
+            i / 4.0);
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Intensity, i),
+            (int)i * 100);
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Classification, i),
+            (int)i % 5);
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::PointSourceId, i),
+            i == 3 ? 0 : 1000 + (int)i);
+    }
+}
+
+TEST(ArrowTest, projection)
+{
+    PointTable table;
+    PointViewPtr view = readArrow(table,
+        Support::datapath("arrow/simple.feather"), "Intensity, X");
+    PointLayoutPtr layout = table.layout();
+
+    EXPECT_EQ(layout->dims().size(), 2u);
+    EXPECT_TRUE(layout->hasDim(Dimension::Id::X));
+    EXPECT_TRUE(layout->hasDim(Dimension::Id::Intensity));
+    EXPECT_EQ(view->size(), 10u);
+    EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Intensity, 9), 900);
+    EXPECT_DOUBLE_EQ(view->getFieldAs<double>(Dimension::Id::X, 9), 13.5);
+
+    PointTable table2;
+    EXPECT_THROW(readArrow(table2, Support::datapath("arrow/simple.feather"),
+        "Name"), pdal_error);
+    PointTable table3;
+    EXPECT_THROW(readArrow(table3, Support::datapath("arrow/simple.feather"),
+        "Red"), pdal_error);
+}
+
+TEST(ArrowTest, roundtrip)
+{
+    std::string filename(Support::temppath("roundtrip.arrow"));
+
+    // Streamed output must match standard output.
+    std::string standard = writeFaux(filename, false);
+    std::string streamed = writeFaux(filename, true);
+    EXPECT_EQ(standard, streamed);
+
+    FauxReader faux;
+    Options fauxOptions;
+    fauxOptions.add("count", 1000);
+    fauxOptions.add("mode", "ramp");
+    fauxOptions.add("bounds", BOX3D(-1000, 0, 1, 1000, 10, 2));
+    fauxOptions.add("number_of_returns", 3);
+    faux.setOptions(fauxOptions);
+    PointTable fauxTable;
+    faux.prepare(fauxTable);
+    PointViewPtr expected = *faux.execute(fauxTable).begin();
+
+    PointTable table;
+    PointViewPtr view = readArrow(table, filename);
+    ASSERT_EQ(view->size(), expected->size());
+    Dimension::IdList dims = fauxTable.layout()->dims();
+    EXPECT_EQ(table.layout()->dims().size(), dims.size());
+    for (Dimension::Id dim : dims)
+    {
+        EXPECT_EQ(table.layout()->dimType(dim),
+            fauxTable.layout()->dimType(dim));
+        for (PointId i = 0; i < view->size(); ++i)
+            EXPECT_EQ(expected->getFieldAs<double>(dim, i),
+                view->getFieldAs<double>(dim, i));
+    }
+
+    // Read the file back in streaming mode.
+    Options options;
+    options.add("filename", filename);
+    options.add("dimensions", "X, ReturnNumber");
+    ArrowReader reader;
+    reader.setOptions(options);
+
+    PointId i = 0;
+    auto cb = [&i, &expected](PointRef& point)
+    {
+        EXPECT_EQ(point.getFieldAs<double>(Dimension::Id::X),
+            expected->getFieldAs<double>(Dimension::Id::X, i));
+        EXPECT_EQ(point.getFieldAs<int>(Dimension::Id::ReturnNumber),
+            expected->getFieldAs<int>(Dimension::Id::ReturnNumber, i));
+        i++;
+        return true;
+    };
+    StreamCallbackFilter stream;
+    stream.setCallback(cb);
+    stream.setInput(reader);
+
+    FixedPointTable streamTable(100);
+    stream.prepare(streamTable);
+    stream.execute(streamTable);
+    EXPECT_EQ(i, 1000u);
+}
+
+TEST(ArrowTest, badFile)
+{
+    std::string filename(Support::temppath("bad.arrow"));
+    writeFaux(filename, false);
+
+    // Truncate the file so that the footer is missing.
+    std::string data = FileUtils::readFileIntoString(filename);
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    out << data.substr(0, data.size() / 2);
+    out.close();
+
+    PointTable table;
+    EXPECT_THROW(readArrow(table, filename), pdal_error);
+
+    Options options;
+    options.add("filename", filename);
+    options.add("batch_size", 0);
+    ArrowWriter writer;
+    writer.setOptions(options);
+    PointTable table2;
+    EXPECT_THROW(writer.prepare(table2), pdal_error);
+}
+
+// Buffer sizes and offsets in a record batch must lie within the file.
+TEST(ArrowTest, badBatch)
+{
+    std::string filename(Support::temppath("badbatch.arrow"));
+
+    // The data size overflows.
+    writeBatch(filename, (uint64_t)1 << 61, ArrowBuffer(0, 0));
+    PointTable table;
+    EXPECT_THROW(readArrow(table, filename), pdal_error);
+
+    // The data is much larger than the file.
+    writeBatch(filename, (uint64_t)1 << 40, ArrowBuffer(0, (uint64_t)1 << 43));
+    PointTable table2;
+    EXPECT_THROW(readArrow(table2, filename), pdal_error);
+
+    // The data starts past the end of the file.
+    writeBatch(filename, 10, ArrowBuffer((uint64_t)1 << 62, 80));
+    PointTable table3;
+    EXPECT_THROW(readArrow(table3, filename), pdal_error);
+}
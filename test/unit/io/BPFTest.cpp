@@ -708,3 +708,275 @@ TEST(BPFTest, outputdims)
     
 }
 
+
+namespace
+{
+
+// Write a compressed file large enough that its blocks are inflated both
+// whole and incrementally, and check the points read back in standard and
+// streaming mode.
+void test_large_compressed(const std::string& format)
+{
+    using namespace Dimension;
+
+    const point_count_t count = 1200000;
+    std::string outfile(Support::temppath("large.bpf"));
+    FileUtils::deleteFile(outfile);
+
+    auto expected = [](PointId i, Id dim) -> double
+    {
+        switch (dim)
+        {
+        case Id::X:
+            return (double)(i % 1000);
+        case Id::Y:
+            return (double)(i / 1000);
+        case Id::Z:
+            return (double)(i % 7);
+        default:
+            return (double)(i % 65536);
+        }
+    };
+    const Id dims[] = { Id::X, Id::Y, Id::Z, Id::Intensity };
+
+    {
+        PointTable table;
+        for (Id dim : dims)
+            table.layout()->registerDim(dim);
+        PointViewPtr view(new PointView(table));
+        for (PointId i = 0; i < count; ++i)
+            for (Id dim : dims)
+                view->setField(dim, i, expected(i, dim));
+
+        BufferReader r;
+        r.addView(view);
+
+        Options ops;
+        ops.add("filename", outfile);
+        ops.add("format", format);
+        ops.add("compression", true);
+        BpfWriter w;
+        w.setOptions(ops);
+        w.setInput(r);
+        w.prepare(table);
+        w.execute(table);
+    }
+
+    class Checker : public Filter
+    {
+    public:
+        Checker(std::function<double(PointId, Id)> expected) :
+            m_cnt(0), m_bad(0), m_expected(expected)
+        {}
+
+        std::string getName() const
+            { return "checker"; }
+
+        bool processOne(PointRef& p)
+        {
+            for (Id dim : { Id::X, Id::Y, Id::Z, Id::Intensity })
+                if (p.getFieldAs<double>(dim) != m_expected(m_cnt, dim))
+                    m_bad++;
+            m_cnt++;
+            return true;
+        }
+
+        point_count_t m_cnt;
+        point_count_t m_bad;
+
+    private:
+        std::function<double(PointId, Id)> m_expected;
+    };
+
+    for (int threads : { 1, 4 })
+    {
+        Options ops;
+        ops.add("filename", outfile);
+        ops.add("threads", threads);
+
+        {
+            BpfReader r;
+            r.setOptions(ops);
+
+            PointTable table;
+            r.prepare(table);
+            PointViewSet s = r.execute(table);
+            PointViewPtr view = *s.begin();
+            EXPECT_EQ(view->size(), count);
+
+            point_count_t bad = 0;
+            for (PointId i = 0; i < view->size(); ++i)
+                for (Id dim : dims)
+                    if (view->getFieldAs<double>(dim, i) != expected(i, dim))
+                        bad++;
+            EXPECT_EQ(bad, 0u) << format << " with " << threads << " threads";
+        }
+
+        {
+            BpfReader r;
+            r.setOptions(ops);
+
+            Checker c(expected);
+            c.setInput(r);
+
+            FixedPointTable table(1000);
+            c.prepare(table);
+            c.execute(table);
+            EXPECT_GT(c.m_cnt, 0u);
+            EXPECT_EQ(c.m_bad, 0u) << format << " with " << threads <<
+                " threads, streaming";
+        }
+    }
+}
+
+} // unnamed namespace
+
+TEST(BPFTest, large_compressed_point)
+{
+    test_large_compressed("POINT");
+}
+
+TEST(BPFTest, large_compressed_dimension)
+{
+    test_large_compressed("DIMENSION");
+}
+
+TEST(BPFTest, large_compressed_byte)
+{
+    test_large_compressed("BYTE");
+}
+
+// Compressed output must not depend on the number of threads and must be
+// readable at every compression level.
+TEST(BPFTest, compression_threads)
+{
+    std::string infile(
+        Support::datapath("bpf/autzen-utm-chipped-25-v3-interleaved.bpf"));
+
+    for (std::string format : { "POINT", "DIMENSION", "BYTE" })
+    {
+        std::string outfiles[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            outfiles[i] = Support::temppath("threads" +
+                std::to_string(i) + ".bpf");
+            FileUtils::deleteFile(outfiles[i]);
+
+            Options readerOps;
+            readerOps.add("filename", infile);
+            BpfReader reader;
+            reader.setOptions(readerOps);
+
+            Options writerOps;
+            writerOps.add("filename", outfiles[i]);
+            writerOps.add("format", format);
+            writerOps.add("compression", true);
+            writerOps.add("threads", i == 0 ? 1 : 4);
+            BpfWriter writer;
+            writer.setOptions(writerOps);
+            writer.setInput(reader);
+
+            PointTable table;
+            writer.prepare(table);
+            writer.execute(table);
+        }
+        EXPECT_TRUE(Support::compare_files(outfiles[0], outfiles[1])) <<
+            format;
+    }
+
+    for (int level : { 0, 1, 9 })
+    {
+        Options ops;
+        ops.add("format", "DIMENSION");
+        ops.add("compression", true);
+        ops.add("compression_level", level);
+        test_roundtrip(ops);
+    }
+
+    Options ops;
+    ops.add("filename", Support::temppath("tmp.bpf"));
+    ops.add("compression", true);
+    ops.add("compression_level", 10);
+    BpfWriter writer;
+    writer.setOptions(ops);
+    PointTable table;
+    EXPECT_THROW(writer.prepare(table), pdal_error);
+}
+
+// With 'output_dims', dimensions that aren't written aren't read.  The
+// points written must be the same as when every dimension is read.
+TEST(BPFTest, used_dimensions)
+{
+    auto write = [](const std::string& infile, const std::string& outfile,
+        const std::string& dims, PointTableRef table)
+    {
+        Options ro;
+        ro.add("filename", Support::datapath(infile));
+        BpfReader r;
+        r.setOptions(ro);
+
+        Options wo;
+        wo.add("filename", outfile);
+        if (dims.size())
+            wo.add("output_dims", dims);
+        BpfWriter w;
+        w.setOptions(wo);
+        w.setInput(r);
+
+        FileUtils::deleteFile(outfile);
+        w.prepare(table);
+        w.execute(table);
+    };
+
+    auto read = [](const std::string& filename, PointTableRef t)
+    {
+        Options ro;
+        ro.add("filename", filename);
+        BpfReader r;
+        r.setOptions(ro);
+
+        r.prepare(t);
+        PointViewSet s = r.execute(t);
+        return *s.begin();
+    };
+
+    const std::vector<std::string> files
+    {
+        "bpf/autzen-utm-chipped-25-v3-interleaved.bpf",
+        "bpf/autzen-utm-chipped-25-v3.bpf",
+        "bpf/autzen-utm-chipped-25-v3-segregated.bpf",
+        "bpf/autzen-utm-chipped-25-v3-deflate-interleaved.bpf",
+        "bpf/autzen-utm-chipped-25-v3-deflate.bpf",
+        "bpf/autzen-utm-chipped-25-v3-deflate-segregated.bpf"
+    };
+    const Dimension::Id dims[] = { Dimension::Id::X, Dimension::Id::Y,
+        Dimension::Id::Z, Dimension::Id::Green,
+        Dimension::Id::Classification };
+
+    std::string outfile(Support::temppath("used_dims.bpf"));
+    std::string fullfile(Support::temppath("used_dims_full.bpf"));
+    for (const std::string& file : files)
+    {
+        PointTable t;
+        write(file, outfile, "X,Y,Z,Green,Classification", t);
+        EXPECT_EQ(t.layout()->dims().size(), 5u) << file;
+        EXPECT_FALSE(t.layout()->hasDim(Dimension::Id::Red)) << file;
+
+        PointTable t2;
+        write(file, fullfile, "", t2);
+        EXPECT_TRUE(t2.layout()->hasDim(Dimension::Id::Red)) << file;
+
+        PointTable t3;
+        PointViewPtr v = read(outfile, t3);
+        PointTable t4;
+        PointViewPtr full = read(fullfile, t4);
+        ASSERT_EQ(v->size(), full->size()) << file;
+        EXPECT_GT(v->size(), 0u);
+        for (PointId i = 0; i < v->size(); ++i)
+            for (Dimension::Id dim : dims)
+                ASSERT_EQ(v->getFieldAs<double>(dim, i),
+                    full->getFieldAs<double>(dim, i)) << file;
+    }
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteFile(fullfile);
+}
@@ -37,7 +37,10 @@
 #include <pdal/Filter.hpp>
 #include <pdal/PointView.hpp>
 #include <pdal/StageFactory.hpp>
+#include <filters/RangeFilter.hpp>
+#include <io/BufferReader.hpp>
 #include <io/LasReader.hpp>
+#include <io/TextWriter.hpp>
 #include "Support.hpp"
 
 using namespace pdal;
@@ -507,3 +510,172 @@ TEST(LasReaderTest, EmptyGeotiffVlr)
     EXPECT_EQ(43u, view->size());
 
 }
+
+namespace
+{
+
+PointViewPtr readMapped(PointTable& table, const std::string& filename,
+    bool map)
+{
+    Options o;
+    o.add("filename", Support::datapath(filename));
+    o.add("memory_map", map);
+    LasReader reader;
+    reader.setOptions(o);
+    reader.prepare(table);
+    PointViewSet s = reader.execute(table);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+} // unnamed namespace
+
+// Points read from a memory-mapped file match those read from a stream.
+TEST(LasReaderTest, memory_map)
+{
+    StringList files { "las/1.2-with-color.las", "las/test1_4.las",
+        "las/extrabytes.las", "las/1.2-with-color-clipped.las",
+        "las/permutations/1.0_0.las", "las/permutations/1.2_3.las" };
+#if defined(PDAL_HAVE_LASZIP) || defined(PDAL_HAVE_LAZPERF)
+    // The option is ignored for compressed files.
+    files.push_back("laz/autzen_trim.laz");
+#endif
+
+    for (const std::string& file : files)
+    {
+        PointTable t1;
+        PointTable t2;
+        PointViewPtr v1 = readMapped(t1, file, false);
+        PointViewPtr v2 = readMapped(t2, file, true);
+        ASSERT_EQ(v1->size(), v2->size()) << file;
+
+        DimTypeList dims = v1->dimTypes();
+        std::vector<char> buf1(v1->pointSize());
+        std::vector<char> buf2(v2->pointSize());
+        for (PointId i = 0; i < v1->size(); ++i)
+        {
+            v1->getPackedPoint(dims, i, buf1.data());
+            v2->getPackedPoint(dims, i, buf2.data());
+            EXPECT_EQ(memcmp(buf1.data(), buf2.data(), buf1.size()), 0) <<
+                file << " point " << i;
+        }
+    }
+
+    // Stream a mapped file.
+    class Counter : public Filter
+    {
+    public:
+        Counter() : m_cnt(0)
+            {}
+        std::string getName() const
+            { return "counter"; }
+
+        point_count_t m_cnt;
+
+    private:
+        bool processOne(PointRef&)
+        {
+            m_cnt++;
+            return true;
+        }
+    };
+
+    Options o;
+    o.add("filename", Support::datapath("las/autzen_trim.las"));
+    o.add("memory_map", true);
+    LasReader reader;
+    reader.setOptions(o);
+
+    Counter c;
+    c.setInput(reader);
+
+    FixedPointTable fixed(100);
+    c.prepare(fixed);
+    c.execute(fixed);
+    EXPECT_EQ(c.m_cnt, 110000u);
+}
+
+
+// Dimensions that aren't used by the stages following the reader aren't
+// loaded.  The points written must be the same as when every dimension
+// is loaded.
+TEST(LasReaderTest, used_dimensions)
+{
+    std::string infile(Support::datapath("las/simple.las"));
+    std::string outfile(Support::temppath("used_dims.txt"));
+    std::string fullfile(Support::temppath("used_dims_full.txt"));
+    std::string streamfile(Support::temppath("used_dims_stream.txt"));
+
+    Options ro;
+    ro.add("filename", infile);
+    Options fo;
+    fo.add("limits", "Classification[2:2]");
+
+    auto write = [&fo](Stage& input, PointTableRef table,
+        const std::string& filename)
+    {
+        RangeFilter f;
+        f.setOptions(fo);
+        f.setInput(input);
+
+        Options wo;
+        wo.add("filename", filename);
+        wo.add("order", "X,Y,Z,Intensity");
+        wo.add("keep_unspecified", false);
+        TextWriter w;
+        w.setOptions(wo);
+        w.setInput(f);
+
+        w.prepare(table);
+        if (FixedPointTable *ft = dynamic_cast<FixedPointTable *>(&table))
+            w.execute(*ft);
+        else
+            w.execute(table);
+    };
+
+    {
+        LasReader r;
+        r.setOptions(ro);
+
+        PointTable t;
+        write(r, t, outfile);
+        PointLayoutPtr layout(t.layout());
+        EXPECT_TRUE(layout->hasDim(Dimension::Id::X));
+        EXPECT_TRUE(layout->hasDim(Dimension::Id::Intensity));
+        EXPECT_TRUE(layout->hasDim(Dimension::Id::Classification));
+        EXPECT_FALSE(layout->hasDim(Dimension::Id::GpsTime));
+        EXPECT_FALSE(layout->hasDim(Dimension::Id::Red));
+        EXPECT_FALSE(layout->hasDim(Dimension::Id::PointSourceId));
+    }
+
+    {
+        LasReader r;
+        r.setOptions(ro);
+
+        FixedPointTable t(100);
+        write(r, t, streamfile);
+    }
+
+    {
+        LasReader r;
+        r.setOptions(ro);
+
+        // A reader at the end of a pipeline loads every dimension.
+        PointTable t;
+        r.prepare(t);
+        PointViewSet s = r.execute(t);
+        EXPECT_TRUE(t.layout()->hasDim(Dimension::Id::GpsTime));
+        EXPECT_TRUE(t.layout()->hasDim(Dimension::Id::Red));
+
+        BufferReader b;
+        b.addView(*s.begin());
+        write(b, t, fullfile);
+    }
+
+    EXPECT_TRUE(Support::compare_text_files(outfile, fullfile));
+    EXPECT_TRUE(Support::compare_text_files(streamfile, fullfile));
+    EXPECT_GT(FileUtils::fileSize(outfile), 100u);
+    FileUtils::deleteFile(outfile);
+    FileUtils::deleteFile(fullfile);
+    FileUtils::deleteFile(streamfile);
+}
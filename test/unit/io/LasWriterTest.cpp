@@ -864,6 +864,134 @@ TEST(LasWriterTest, forward_spec_3)
 }
 
 
+namespace
+{
+
+const Dimension::Id lasDims[] =
+{
+    Dimension::Id::X, Dimension::Id::Y, Dimension::Id::Z,
+    Dimension::Id::Intensity, Dimension::Id::ReturnNumber,
+    Dimension::Id::NumberOfReturns, Dimension::Id::ScanDirectionFlag,
+    Dimension::Id::EdgeOfFlightLine, Dimension::Id::Classification,
+    Dimension::Id::ScanAngleRank, Dimension::Id::UserData,
+    Dimension::Id::PointSourceId, Dimension::Id::GpsTime,
+    Dimension::Id::Red, Dimension::Id::Green, Dimension::Id::Blue,
+    Dimension::Id::Infrared, Dimension::Id::ScanChannel,
+    Dimension::Id::ClassFlags
+};
+
+// Write points with every LAS dimension.  If 'widen' is set, Intensity is
+// stored as a double, which keeps the writer from using the codec for the
+// point format.
+void writeCodec(const std::string& filename, int format, bool widen)
+{
+    using namespace Dimension;
+
+    PointTable table;
+    for (Id id : lasDims)
+        table.layout()->registerDim(id);
+    if (widen)
+        table.layout()->registerDim(Id::Intensity, Type::Double);
+
+    PointViewPtr view(new PointView(table));
+    BufferReader reader;
+    reader.addView(view);
+
+    Options o;
+    o.add("filename", filename);
+    o.add("dataformat_id", format);
+    o.add("minor_version", format > 5 ? 4 : 2);
+    o.add("creation_year", 2017);
+    o.add("creation_doy", 100);
+    LasWriter writer;
+    writer.setOptions(o);
+    writer.setInput(reader);
+    writer.prepare(table);
+
+    for (PointId i = 0; i < 1000; ++i)
+    {
+        view->setField(Id::X, i, 100 + i * .01);
+        view->setField(Id::Y, i, 200 - i * .01);
+        view->setField(Id::Z, i, i * .05);
+        view->setField(Id::Intensity, i, (i * 77) % 65536);
+        view->setField(Id::ReturnNumber, i, 1 + i % 5);
+        view->setField(Id::NumberOfReturns, i, 5);
+        view->setField(Id::ScanDirectionFlag, i, i % 2);
+        view->setField(Id::EdgeOfFlightLine, i, (i / 2) % 2);
+        view->setField(Id::Classification, i, i % 20);
+        view->setField(Id::ScanAngleRank, i, (int)(i % 181) - 90);
+        view->setField(Id::UserData, i, i % 256);
+        view->setField(Id::PointSourceId, i, i * 3);
+        view->setField(Id::GpsTime, i, i * 1.5);
+        view->setField(Id::Red, i, i);
+        view->setField(Id::Green, i, i * 2);
+        view->setField(Id::Blue, i, i * 3);
+        view->setField(Id::Infrared, i, i * 4);
+        view->setField(Id::ScanChannel, i, i % 4);
+        view->setField(Id::ClassFlags, i, i % 16);
+    }
+    writer.execute(table);
+}
+
+// Read points.  If 'widen' is set, Intensity is stored as a double, which
+// keeps the reader from using the codec for the point format.
+PointViewPtr readCodec(PointTable& table, const std::string& filename,
+    bool widen)
+{
+    if (widen)
+        table.layout()->registerDim(Dimension::Id::Intensity,
+            Dimension::Type::Double);
+
+    Options o;
+    o.add("filename", filename);
+    LasReader reader;
+    reader.setOptions(o);
+    reader.prepare(table);
+    PointViewSet s = reader.execute(table);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+} // unnamed namespace
+
+// Points written and read by the codecs for each point format match those
+// written and read dimension by dimension.
+TEST(LasWriterTest, codec)
+{
+    for (int format : { 0, 1, 2, 3, 6, 7, 8 })
+    {
+        std::string fast(Support::temppath("codec_fast.las"));
+        std::string slow(Support::temppath("codec_slow.las"));
+        writeCodec(fast, format, false);
+        writeCodec(slow, format, true);
+        EXPECT_EQ(FileUtils::fileSize(fast), FileUtils::fileSize(slow));
+        EXPECT_TRUE(Support::compare_files(fast, slow)) << format;
+
+        PointTable t1;
+        PointTable t2;
+        PointViewPtr v1 = readCodec(t1, fast, false);
+        PointViewPtr v2 = readCodec(t2, fast, true);
+        ASSERT_EQ(v1->size(), 1000u);
+        ASSERT_EQ(v2->size(), 1000u);
+        for (PointId i = 0; i < v1->size(); ++i)
+        {
+            for (Dimension::Id id : lasDims)
+                EXPECT_EQ(v1->getFieldAs<double>(id, i),
+                    v2->getFieldAs<double>(id, i)) << format << " " <<
+                    Dimension::name(id) << " " << i;
+            EXPECT_DOUBLE_EQ(v1->getFieldAs<double>(Dimension::Id::X, i),
+                100 + i * .01);
+            EXPECT_EQ(v1->getFieldAs<int>(Dimension::Id::Intensity, i),
+                (int)((i * 77) % 65536));
+            EXPECT_EQ(v1->getFieldAs<int>(Dimension::Id::ReturnNumber, i),
+                (int)(1 + i % 5));
+        }
+        FileUtils::deleteFile(fast);
+        FileUtils::deleteFile(slow);
+    }
+}
+
+
 /**
 
 namespace
@@ -34,6 +34,10 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <algorithm>
+#include <fstream>
+
+#include <filters/StreamCallbackFilter.hpp>
 #include <io/PlyReader.hpp>
 #include "Support.hpp"
 
@@ -140,4 +144,182 @@ TEST(PlyReader, NoVertex)
     EXPECT_THROW(reader.prepare(table), pdal_error);
 }
 
+
+// Append 'v' to 'out' in big-endian byte order.
+template<typename T>
+void putBe(std::string& out, T v)
+{
+    char buf[sizeof(T)];
+    memcpy(buf, &v, sizeof(T));
+    const uint16_t one(1);
+    if (*reinterpret_cast<const uint8_t *>(&one) == 1)
+        std::reverse(buf, buf + sizeof(T));
+    out.append(buf, sizeof(T));
+}
+
+
+// Big-endian data with an element containing lists ahead of the vertices
+// and a list property in the vertex element itself.
+TEST(PlyReader, ReadBinaryBigEndian)
+{
+    std::string filename(Support::temppath("big_endian.ply"));
+
+    std::string data("ply\r\n"
+        "format binary_big_endian 1.0\r\n"
+        "comment Written by PDAL test\r\n"
+        "element face 2\r\n"
+        "property list uchar int vertex_indices\r\n"
+        "property ushort flags\r\n"
+        "element vertex 3\r\n"
+        "property double x\r\n"
+        "property double y\r\n"
+        "property float z\r\n"
+        "property list ushort uint8 tags\r\n"
+        "property uchar red\r\n"
+        "end_header\r\n");
+    putBe<uint8_t>(data, 3);
+    for (int32_t i : { 0, 1, 2 })
+        putBe(data, i);
+    putBe<uint16_t>(data, 7);
+    putBe<uint8_t>(data, 0);
+    putBe<uint16_t>(data, 8);
+    for (int i = 0; i < 3; ++i)
+    {
+        putBe<double>(data, i * 1.5 - 1);
+        putBe<double>(data, 1e6 + i);
+        putBe<float>(data, -.25f * i);
+        putBe<uint16_t>(data, (uint16_t)i);
+        for (int j = 0; j < i; ++j)
+            putBe<uint8_t>(data, 99);
+        putBe<uint8_t>(data, (uint8_t)(200 + i));
+    }
+    std::ofstream(filename, std::ios::binary) << data;
+
+    Options options;
+    options.add("filename", filename);
+
+    PlyReader reader;
+    reader.setOptions(options);
+
+    PointTable table;
+    reader.prepare(table);
+    PointViewSet viewSet = reader.execute(table);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), 3u);
+    EXPECT_EQ(table.layout()->findDim("tags"), Dimension::Id::Unknown);
+
+    for (PointId i = 0; i < 3; ++i)
+    {
+        checkPoint(view, i, i * 1.5 - 1, 1e6 + i, -.25 * i);
+        EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Red, i), 200 + (int)i);
+    }
+
+    // Truncated data is an error.
+    data.resize(data.size() - 1);
+    std::ofstream(filename, std::ios::binary) << data;
+
+    PlyReader reader2;
+    reader2.setOptions(options);
+    PointTable table2;
+    reader2.prepare(table2);
+    EXPECT_THROW(reader2.execute(table2), pdal_error);
+}
+
+
+// Fixed-size records are decoded a block at a time, across refills of the
+// input buffer.  They're decoded a property at a time when the layout has
+// a different type for a property's dimension.
+TEST(PlyReader, ReadBinaryRecords)
+{
+    std::string filename(Support::temppath("records.ply"));
+
+    const int count = 200000;
+    std::string data("ply\n"
+        "format binary_big_endian 1.0\n"
+        "element vertex " + std::to_string(count) + "\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "property uchar red\n"
+        "end_header\n");
+    for (int i = 0; i < count; ++i)
+    {
+        putBe<float>(data, i * .5f);
+        putBe<float>(data, -1.0f * i);
+        putBe<float>(data, 3.0f);
+        putBe<uint8_t>(data, (uint8_t)i);
+    }
+    std::ofstream(filename, std::ios::binary) << data;
+
+    Options options;
+    options.add("filename", filename);
+
+    for (bool doubleX : { false, true })
+    {
+        PlyReader reader;
+        reader.setOptions(options);
+
+        PointTable table;
+        if (doubleX)
+            table.layout()->registerDim(Dimension::Id::X,
+                Dimension::Type::Double);
+        reader.prepare(table);
+        PointViewSet viewSet = reader.execute(table);
+        EXPECT_EQ(viewSet.size(), 1u);
+        PointViewPtr view = *viewSet.begin();
+        ASSERT_EQ(view->size(), (point_count_t)count);
+
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            checkPoint(view, i, i * .5, -1.0 * i, 3);
+            EXPECT_EQ(view->getFieldAs<int>(Dimension::Id::Red, i),
+                (int)(i % 256));
+        }
+    }
+}
+
+
+TEST(PlyReader, Stream)
+{
+    Options options;
+    options.add("filename", Support::datapath("ply/simple_binary.ply"));
+
+    PlyReader reader;
+    reader.setOptions(options);
+
+    std::vector<double> xs;
+    auto cb = [&xs](PointRef& point)
+    {
+        xs.push_back(point.getFieldAs<double>(Dimension::Id::X));
+        EXPECT_DOUBLE_EQ(point.getFieldAs<double>(Dimension::Id::Z), 0);
+        return true;
+    };
+
+    StreamCallbackFilter stream;
+    stream.setCallback(cb);
+    stream.setInput(reader);
+
+    // A small table so that the points are streamed in several passes.
+    FixedPointTable table(2);
+    stream.prepare(table);
+    stream.execute(table);
+    EXPECT_EQ(xs, std::vector<double>({ -1, 0, 1 }));
+
+    // ASCII files are still read through rply, which can't stream.
+    Options textOptions;
+    textOptions.add("filename", Support::datapath("ply/simple_text.ply"));
+
+    PlyReader textReader;
+    textReader.setOptions(textOptions);
+
+    StreamCallbackFilter textStream;
+    textStream.setCallback(cb);
+    textStream.setInput(textReader);
+
+    FixedPointTable textTable(2);
+    textStream.prepare(textTable);
+    EXPECT_THROW(textStream.execute(textTable), pdal_error);
+}
+
 }
@@ -34,8 +34,12 @@
 
 #include <pdal/pdal_test_main.hpp>
 
+#include <cmath>
+
 #include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
 #include <io/FauxReader.hpp>
+#include <io/PlyReader.hpp>
 #include <io/PlyWriter.hpp>
 #include "Support.hpp"
 
@@ -74,4 +78,114 @@ TEST(PlyWriter, Write)
 }
 
 
+// Write faux points with the given storage mode, read them back and check
+// that every dimension survives.  Returns the file contents.
+std::string roundtrip(const std::string& storageMode, bool streaming)
+{
+    std::string filename(Support::temppath("roundtrip.ply"));
+    FileUtils::deleteFile(filename);
+
+    Options readerOptions;
+    readerOptions.add("count", 750);
+    readerOptions.add("mode", "ramp");
+    readerOptions.add("bounds", BOX3D(-1000, 0, 1, 1000, 10, 2));
+    FauxReader reader;
+    reader.setOptions(readerOptions);
+
+    Options writerOptions;
+    writerOptions.add("filename", filename);
+    writerOptions.add("storage_mode", storageMode);
+    PlyWriter writer;
+    writer.setOptions(writerOptions);
+    writer.setInput(reader);
+
+    if (streaming)
+    {
+        FixedPointTable table(100);
+        writer.prepare(table);
+        writer.execute(table);
+    }
+    else
+    {
+        PointTable table;
+        writer.prepare(table);
+        writer.execute(table);
+    }
+
+    PointTable fauxTable;
+    reader.prepare(fauxTable);
+    PointViewPtr expected = *reader.execute(fauxTable).begin();
+
+    Options plyOptions;
+    plyOptions.add("filename", filename);
+    PlyReader ply;
+    ply.setOptions(plyOptions);
+    PointTable plyTable;
+    ply.prepare(plyTable);
+    PointViewSet viewSet = ply.execute(plyTable);
+    EXPECT_EQ(viewSet.size(), 1u);
+    PointViewPtr view = *viewSet.begin();
+    EXPECT_EQ(view->size(), expected->size());
+
+    // rply writes ASCII values with six significant digits.
+    double tolerance = (storageMode == "ascii" ? 1e-5 : 0);
+    for (Dimension::Id dim : fauxTable.layout()->dims())
+    {
+        EXPECT_TRUE(plyTable.layout()->hasDim(dim));
+        for (PointId i = 0; i < view->size(); ++i)
+        {
+            double d = expected->getFieldAs<double>(dim, i);
+            EXPECT_NEAR(d, view->getFieldAs<double>(dim, i),
+                std::abs(d) * tolerance) << storageMode << " " <<
+                Dimension::name(dim) << " " << i;
+        }
+    }
+    return FileUtils::readFileIntoString(filename);
+}
+
+
+TEST(PlyWriter, Roundtrip)
+{
+    std::string ascii = roundtrip("ascii", false);
+    std::string little = roundtrip("little endian", false);
+    std::string big = roundtrip("big endian", false);
+    std::string def = roundtrip("default", false);
+
+    EXPECT_NE(ascii, little);
+    EXPECT_NE(little, big);
+    EXPECT_TRUE(def == little || def == big);
+    EXPECT_NE(little.find("format binary_little_endian 1.0"),
+        std::string::npos);
+    EXPECT_NE(big.find("format binary_big_endian 1.0"), std::string::npos);
+
+    // The vertex count of binary files is padded to a fixed width.
+    EXPECT_NE(little.find("element vertex 00000000000000000750\n"),
+        std::string::npos);
+}
+
+
+TEST(PlyWriter, Stream)
+{
+    for (std::string mode : { "little endian", "big endian" })
+        EXPECT_EQ(roundtrip(mode, false), roundtrip(mode, true)) << mode;
+
+    // ASCII output is still written through rply, which can't stream.
+    Options readerOptions;
+    readerOptions.add("count", 10);
+    readerOptions.add("mode", "constant");
+    FauxReader reader;
+    reader.setOptions(readerOptions);
+
+    Options writerOptions;
+    writerOptions.add("filename", Support::temppath("out.ply"));
+    writerOptions.add("storage_mode", "ascii");
+    PlyWriter writer;
+    writer.setOptions(writerOptions);
+    writer.setInput(reader);
+
+    FixedPointTable table(5);
+    writer.prepare(table);
+    EXPECT_THROW(writer.execute(table), pdal_error);
+}
+
 }
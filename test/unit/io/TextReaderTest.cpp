@@ -36,6 +36,10 @@
 
 #include "Support.hpp"
 
+#include <cstdio>
+#include <fstream>
+
+#include <pdal/Filter.hpp>
 #include <io/LasReader.hpp>
 #include <io/LasWriter.hpp>
 #include <io/TextReader.hpp>
@@ -211,3 +215,132 @@ TEST(TextReaderTest, strip_whitespace_from_dimension_names)
             i, pointViewPtr->getFieldAs<uint16_t>(Dimension::Id::Intensity, i));
     }
 }
+
+namespace
+{
+
+PointViewPtr readText(PointTable& table, const std::string& filename,
+    int threads, char separator = ' ')
+{
+    TextReader reader;
+    Options options;
+    options.add("filename", filename);
+    options.add("threads", threads);
+    if (separator != ' ')
+        options.add("separator", separator);
+    reader.setOptions(options);
+
+    reader.prepare(table);
+    PointViewSet s = reader.execute(table);
+    EXPECT_EQ(s.size(), 1u);
+    return *s.begin();
+}
+
+} // unnamed namespace
+
+// Values converted in parallel match those converted by Utils::fromString(),
+// in order, whatever the separator and the formatting of the numbers.
+TEST(TextReaderTest, threads)
+{
+    std::string filename(Support::temppath("threads.txt"));
+
+    const std::vector<std::string> formats { "%.2f", "%.17g", "%g", "%e",
+        "%.0f", "%+.3E", "%.25f", "  %.4f ", "%.1f\r" };
+    for (char separator : { ',', ' ' })
+    {
+        std::vector<std::string> text;
+        {
+            std::ofstream out(filename);
+            out << "X" << separator << "Y" << separator << "Z\n";
+            char buf[100];
+            for (size_t i = 0; i < 300000; ++i)
+            {
+                double v[] = { i * 1.37 - 1e5, i / 7.0, 1e6 / (i + 1) };
+                std::string line;
+                for (size_t d = 0; d < 3; ++d)
+                {
+                    const std::string& f = formats[(i + d) % formats.size()];
+                    sprintf(buf, f.data(), v[d]);
+                    text.push_back(buf);
+                    line += buf;
+                    if (d < 2)
+                        line += separator;
+                }
+                out << line << "\n";
+                if (i % 1000 == 999)
+                    out << "\n";
+            }
+        }
+
+        PointTable t1;
+        PointTable t4;
+        PointViewPtr v1 = readText(t1, filename, 1, separator);
+        PointViewPtr v4 = readText(t4, filename, 4, separator);
+        ASSERT_EQ(v1->size(), 300000u);
+        ASSERT_EQ(v4->size(), 300000u);
+
+        using namespace Dimension;
+        const Id dims[] = { Id::X, Id::Y, Id::Z };
+        for (PointId i = 0; i < v1->size(); ++i)
+            for (size_t d = 0; d < 3; ++d)
+            {
+                double expected;
+                std::string s = text[i * 3 + d];
+                if (separator != ' ')
+                    Utils::remove(s, ' ');
+                Utils::fromString(s, expected);
+                EXPECT_EQ(v1->getFieldAs<double>(dims[d], i), expected);
+                EXPECT_EQ(v4->getFieldAs<double>(dims[d], i), expected);
+            }
+    }
+    FileUtils::deleteFile(filename);
+}
+
+// Streaming reads the same points, in order.
+TEST(TextReaderTest, threads_stream)
+{
+    std::string filename(Support::temppath("threads_stream.txt"));
+    {
+        std::ofstream out(filename);
+        out << "X,Y,Z\n";
+        for (size_t i = 0; i < 200000; ++i)
+            out << i << "," << i * .5 << "," << -(double)i << "\n";
+    }
+
+    class Checker : public Filter
+    {
+    public:
+        Checker() : m_cnt(0)
+            {}
+        std::string getName() const
+            { return "checker"; }
+
+        point_count_t m_cnt;
+
+    private:
+        bool processOne(PointRef& point)
+        {
+            EXPECT_EQ(point.getFieldAs<double>(Dimension::Id::X), m_cnt);
+            EXPECT_EQ(point.getFieldAs<double>(Dimension::Id::Y), m_cnt * .5);
+            EXPECT_EQ(point.getFieldAs<double>(Dimension::Id::Z),
+                -(double)m_cnt);
+            m_cnt++;
+            return true;
+        }
+    };
+
+    TextReader reader;
+    Options options;
+    options.add("filename", filename);
+    options.add("threads", 4);
+    reader.setOptions(options);
+
+    Checker c;
+    c.setInput(reader);
+
+    FixedPointTable table(1000);
+    c.prepare(table);
+    c.execute(table);
+    EXPECT_EQ(c.m_cnt, 200000u);
+    FileUtils::deleteFile(filename);
+}
@@ -36,11 +36,41 @@
 
 #include "Support.hpp"
 
+#include <io/BufferReader.hpp>
 #include <io/TextReader.hpp>
 #include <io/TextWriter.hpp>
 
+#include <iomanip>
+#include <sstream>
+
 using namespace pdal;
 
+namespace
+{
+
+// Write the points of 'view' as CSV text with the given options and return
+// the file's contents.
+std::string writeView(PointTableRef table, PointViewPtr view,
+    Options wo)
+{
+    std::string outfile(Support::temppath("textwriter.txt"));
+    FileUtils::deleteFile(outfile);
+
+    BufferReader r;
+    r.addView(view);
+
+    TextWriter w;
+    wo.add("filename", outfile);
+    w.setOptions(wo);
+    w.setInput(r);
+
+    w.prepare(table);
+    w.execute(table);
+    return FileUtils::readFileIntoString(outfile);
+}
+
+} // unnamed namespace
+
 TEST(TextWriterTest, t1)
 {
     std::string outfile(Support::temppath("utm17.txt"));
@@ -103,3 +133,109 @@ TEST(TextWriterTest, t2)
 
     EXPECT_EQ(Support::compare_text_files(infile, outfile), true);
 }
+
+// Values must be formatted exactly as std::fixed would format them.
+TEST(TextWriterTest, precision)
+{
+    std::vector<double> values { 0, -0.0, 1, -1, 0.5, 1.5, 2.5, 0.0005,
+        0.0015, 0.0025, -0.0004, 1.0005, 123456.789, -987654.3215,
+        4320978.6149999999, 289814.15, 1e-300, 5e-324, 1e15, 123e16,
+        -2.5e18, 1e19, 3e100, 0.1, 0.2, 0.3, 2.675, 1.005, 1234.56785 };
+    for (int i = 0; i < 1000; ++i)
+        values.push_back(i / 8.0 - 50 + i * 1e-4);
+
+    for (int precision : { 0, 1, 2, 3, 6, 9, 15, 17 })
+    {
+        PointTable table;
+        table.layout()->registerDim(Dimension::Id::X);
+        PointViewPtr view(new PointView(table));
+        for (PointId i = 0; i < values.size(); ++i)
+            view->setField(Dimension::Id::X, i, values[i]);
+
+        std::ostringstream expected;
+        expected << std::fixed << std::setprecision(precision);
+        expected << "\"X\"\n";
+        for (double d : values)
+            expected << d << "\n";
+
+        Options wo;
+        wo.add("precision", precision);
+        EXPECT_EQ(writeView(table, view, wo), expected.str()) <<
+            "Precision " << precision;
+    }
+}
+
+// Output must not depend on the number of threads used to format points.
+TEST(TextWriterTest, threads)
+{
+    for (std::string format : { "csv", "geojson" })
+    {
+        std::string outputs[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            PointTable table;
+            table.layout()->registerDim(Dimension::Id::X);
+            table.layout()->registerDim(Dimension::Id::Y);
+            table.layout()->registerDim(Dimension::Id::Z);
+            table.layout()->registerDim(Dimension::Id::Intensity);
+            PointViewPtr view(new PointView(table));
+            for (PointId idx = 0; idx < 100000; ++idx)
+            {
+                view->setField(Dimension::Id::X, idx, idx * .01);
+                view->setField(Dimension::Id::Y, idx, -(double)idx);
+                view->setField(Dimension::Id::Z, idx, idx / 7.0);
+                view->setField(Dimension::Id::Intensity, idx, idx % 65536);
+            }
+
+            Options wo;
+            wo.add("format", format);
+            wo.add("threads", i == 0 ? 1 : 4);
+            outputs[i] = writeView(table, view, wo);
+        }
+        EXPECT_EQ(outputs[0], outputs[1]) << "Format " << format;
+    }
+}
+
+// Streaming output must match output written from a point view.
+TEST(TextWriterTest, stream)
+{
+    std::string infile(Support::datapath("text/utm17_1.txt"));
+
+    for (std::string format : { "csv", "geojson" })
+    {
+        std::string outputs[2];
+        for (int i = 0; i < 2; ++i)
+        {
+            std::string outfile(Support::temppath("utm17.txt"));
+            FileUtils::deleteFile(outfile);
+
+            TextReader r;
+            Options ro;
+            ro.add("filename", infile);
+            r.setOptions(ro);
+
+            TextWriter w;
+            Options wo;
+            wo.add("filename", outfile);
+            wo.add("format", format);
+            w.setOptions(wo);
+            w.setInput(r);
+
+            if (i == 0)
+            {
+                PointTable t;
+                w.prepare(t);
+                w.execute(t);
+            }
+            else
+            {
+                // A small table so that several blocks are streamed.
+                FixedPointTable t(3);
+                w.prepare(t);
+                w.execute(t);
+            }
+            outputs[i] = FileUtils::readFileIntoString(outfile);
+        }
+        EXPECT_EQ(outputs[0], outputs[1]) << "Format " << format;
+    }
+}
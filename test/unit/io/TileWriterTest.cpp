@@ -0,0 +1,191 @@
+/******************************************************************************
+* Copyright (c) 2017, Hobu Inc.
+*
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following
+* conditions are met:
+*
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above copyright
+*       notice, this list of conditions and the following disclaimer in
+*       the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of Hobu, Inc. or Flaxen Geo Consulting nor the
+*       names of its contributors may be used to endorse or promote
+*       products derived from this software without specific prior
+*       written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+* LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+* FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+* COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+* INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+* BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+* OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+* AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+* OF SUCH DAMAGE.
+****************************************************************************/
+
+#include <pdal/pdal_test_main.hpp>
+
+#include <pdal/PointView.hpp>
+#include <pdal/StageFactory.hpp>
+#include <pdal/util/FileUtils.hpp>
+#include <pdal/util/Utils.hpp>
+#include <io/FauxReader.hpp>
+#include <io/TileWriter.hpp>
+#include "Support.hpp"
+
+using namespace pdal;
+
+namespace
+{
+
+std::string tileFilename(int col, int row)
+{
+    return Support::temppath("tile_" + std::to_string(col) + "_" +
+        std::to_string(row) + ".txt");
+}
+
+// Write a 100 x 100 grid of points to 25 x 25 tiles.  The small buffer and
+// file limits force spilling and closing of spill files.
+template<typename TABLE>
+void writeTiles(TABLE& table, const Options& extraOpts = Options())
+{
+    for (int col = 0; col < 4; ++col)
+        for (int row = 0; row < 4; ++row)
+            FileUtils::deleteFile(tileFilename(col, row));
+
+    Options ro;
+    ro.add("bounds", BOX3D(0, 0, 0, 100, 100, 0));
+    ro.add("count", 10000);
+    ro.add("mode", "grid");
+    FauxReader r;
+    r.setOptions(ro);
+
+    Options wo;
+    wo.add("filename", Support::temppath("tile_#.txt"));
+    wo.add("length", 25);
+    wo.add("origin_x", 0);
+    wo.add("origin_y", 0);
+    wo.add("buffer_size", 500);
+    wo.add("max_open_files", 3);
+    wo.add(extraOpts);
+    TileWriter w;
+    w.setOptions(wo);
+    w.setInput(r);
+
+    w.prepare(table);
+    w.execute(table);
+}
+
+// Check that each tile holds only points inside it and that no points
+// were lost.  If 'numFields' is set, check the number of fields per point.
+void checkTiles(size_t numFields = 0)
+{
+    point_count_t total = 0;
+    for (int col = 0; col < 4; ++col)
+        for (int row = 0; row < 4; ++row)
+        {
+            std::string filename(tileFilename(col, row));
+            EXPECT_TRUE(FileUtils::fileExists(filename));
+            EXPECT_FALSE(FileUtils::fileExists(filename + ".spill"));
+
+            std::istream *in = FileUtils::openFile(filename, false);
+            ASSERT_TRUE(in);
+            std::string line;
+            std::getline(*in, line);    // Header
+            point_count_t count = 0;
+            while (std::getline(*in, line))
+            {
+                StringList fields = Utils::split(line, ',');
+                ASSERT_GE(fields.size(), 2u);
+                if (numFields)
+                {
+                    EXPECT_EQ(fields.size(), numFields);
+                }
+                double x = std::stod(fields[0]);
+                double y = std::stod(fields[1]);
+                EXPECT_GE(x, col * 25.0);
+                EXPECT_LT(x, (col + 1) * 25.0);
+                EXPECT_GE(y, row * 25.0);
+                EXPECT_LT(y, (row + 1) * 25.0);
+                count++;
+            }
+            FileUtils::closeFile(in);
+            EXPECT_EQ(count, 625u);
+            total += count;
+            FileUtils::deleteFile(filename);
+        }
+    EXPECT_EQ(total, 10000u);
+}
+
+} // unnamed namespace
+
+TEST(TileWriterTest, create)
+{
+    StageFactory f;
+    Stage* writer(f.createStage("writers.tile"));
+    EXPECT_TRUE(writer);
+}
+
+TEST(TileWriterTest, standard)
+{
+    PointTable t;
+    writeTiles(t);
+    checkTiles();
+}
+
+TEST(TileWriterTest, stream)
+{
+    FixedPointTable t(100);
+    writeTiles(t);
+    checkTiles();
+}
+
+TEST(TileWriterTest, noTemplate)
+{
+    Options o;
+    o.add("filename", Support::temppath("tile.txt"));
+    TileWriter w;
+    w.setOptions(o);
+
+    PointTable t;
+    EXPECT_THROW(w.prepare(t), pdal_error);
+}
+
+TEST(TileWriterTest, writerOptions)
+{
+    Options o;
+    o.add("writer_options",
+        "{ \"order\": \"X,Y\", \"keep_unspecified\": false }");
+
+    PointTable t;
+    writeTiles(t, o);
+    checkTiles(2);
+}
+
+TEST(TileWriterTest, badWriterOptions)
+{
+    auto prepare = [](const std::string& writerOpts)
+    {
+        Options o;
+        o.add("filename", Support::temppath("tile_#.txt"));
+        o.add("writer_options", writerOpts);
+        TileWriter w;
+        w.setOptions(o);
+
+        PointTable t;
+        w.prepare(t);
+    };
+
+    EXPECT_THROW(prepare("[ \"order\" ]"), pdal_error);
+    EXPECT_THROW(prepare("{ \"filename\": \"foo.txt\" }"), pdal_error);
+    EXPECT_THROW(prepare("{ \"order\": { \"X\": 1 } }"), pdal_error);
+}